@@ -273,10 +273,23 @@ enum elf_dynamic_tag {
 	DT_TEXTREL  = 22,
 	DT_JMPREL   = 23,
 	DT_BIND_NOW = 24,
+	DT_FLAGS    = 30,
+	DT_GNU_HASH = 0x6ffffef5,
+	DT_FLAGS_1  = 0x6ffffffb,
 	DT_LOPROC   = 0x70000000,
 	DT_HIPROC   = 0x7fffffff,
 };
 
+/**
+ * Dynamic flags (DT_FLAGS and DT_FLAGS_1)
+ */
+enum {
+	DF_SYMBOLIC = 0x2,
+	DF_TEXTREL  = 0x4,
+	DF_BIND_NOW = 0x8,
+	DF_1_NOW    = 0x1,
+};
+
 /**
  * Special section indexes
  */
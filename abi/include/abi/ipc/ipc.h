@@ -57,6 +57,15 @@ enum {
 	 * IPC_M_DATA_READ requests.
 	 */
 	DATA_XFER_LIMIT = 64 * 1024,
+
+	/**
+	 * Maximum buffer size allowed for IPC_M_DATA_WRITE and
+	 * IPC_M_DATA_READ requests whose buffer can be accessed by the kernel
+	 * directly, i.e. it does not reside in a physical memory area.
+	 * Requests restricted by IPC_XF_RESTRICT fall back to DATA_XFER_LIMIT
+	 * otherwise.
+	 */
+	DATA_XFER_LARGE_LIMIT = 4 * 1024 * 1024,
 };
 
 /* Flags for calls */
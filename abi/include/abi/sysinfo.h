@@ -49,6 +49,10 @@ enum {
 	/** Maximum name sizes */
 	TASK_NAME_BUFLEN = 64,
 	EXC_NAME_BUFLEN  = 20,
+	LOCK_NAME_BUFLEN = 32,
+
+	/** Maximum number of stack frames in a profiler sample */
+	SAMPLE_STACK_DEPTH = 8,
 };
 
 /** Item value type
@@ -71,6 +75,14 @@ typedef struct {
 	uint16_t frequency_mhz;  /**< Frequency in MHz */
 	uint64_t idle_cycles;    /**< Number of idle cycles */
 	uint64_t busy_cycles;    /**< Number of busy cycles */
+	uint64_t frame_hits;     /**< Frame cache hits */
+	uint64_t frame_misses;   /**< Frame cache misses */
+	uint64_t frame_drains;   /**< Frame cache batches returned to zones */
+	uint64_t frame_cached;   /**< Number of frames in frame cache */
+	uint64_t steals;         /**< Threads stolen when going idle */
+	uint64_t migrations;     /**< Threads migrated by load balancing */
+	uint64_t page_faults;    /**< Page faults serviced */
+	uint64_t large_pages;    /**< Large pages mapped */
 } stats_cpu_t;
 
 /** Physical memory statistics
@@ -83,6 +95,33 @@ typedef struct {
 	uint64_t free;     /**< Free physical memory (bytes) */
 } stats_physmem_t;
 
+/** Spinlock statistics
+ *
+ * Aggregated over all spinlocks of the same name.
+ *
+ */
+typedef struct {
+	char name[LOCK_NAME_BUFLEN];  /**< Lock name */
+	uint64_t acquisitions;        /**< Number of acquisitions */
+	uint64_t contended;           /**< Acquisitions which had to spin */
+	uint64_t max_hold_cycles;     /**< Longest hold time in cycles */
+} stats_lock_t;
+
+/** Profiler sample
+ *
+ * Taken by the clock interrupt on the CPU it was running on.
+ *
+ */
+typedef struct {
+	uint64_t seq;            /**< Sequence number within the CPU */
+	unsigned int cpu;        /**< CPU ID */
+	task_id_t task_id;       /**< Interrupted task ID */
+	thread_id_t thread_id;   /**< Interrupted thread ID */
+	bool uspace;             /**< Interrupted in user space */
+	unsigned int depth;      /**< Number of valid entries in pcs */
+	uint64_t pcs[SAMPLE_STACK_DEPTH];  /**< Program counter and return addresses */
+} stats_sample_t;
+
 /** IPC statistics
  *
  * Associated with a task.
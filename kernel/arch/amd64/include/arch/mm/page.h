@@ -142,6 +142,18 @@
 #define SET_FRAME_PRESENT_ARCH(ptl3, i) \
 	set_pt_present((pte_t *) (ptl3), (size_t) (i))
 
+/*
+ * PTL2 entries can map 2 MiB pages directly. The page size bit of such an
+ * entry is at the position of the PAT bit of a last-level PTE, which is not
+ * used otherwise.
+ */
+#define LARGE_PAGE_WIDTH_ARCH  21
+
+#define GET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].pat != 0)
+#define SET_FRAME_LARGE_ARCH(ptl, i, large) \
+	(((pte_t *) (ptl))[(i)].pat = ((large) ? 1 : 0))
+
 /* Macros for querying the last-level PTE entries. */
 #define PTE_VALID_ARCH(p) \
 	((p)->soft_valid != 0)
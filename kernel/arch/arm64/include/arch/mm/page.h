@@ -146,6 +146,19 @@ extern uintptr_t physmem_base;
 #define SET_FRAME_PRESENT_ARCH(ptl3, i) \
 	set_pt_present((pte_t *) (ptl3), (size_t) (i))
 
+/*
+ * Level 2 block descriptors map 2 MiB pages directly. Apart from the type
+ * bit, they have the same format as level 3 page descriptors.
+ */
+#define LARGE_PAGE_WIDTH_ARCH  21
+
+#define GET_PTL3_LARGE_ARCH(ptl2, i) \
+	((((pte_t *) (ptl2))[(i)].valid != 0) && \
+	(((pte_t *) (ptl2))[(i)].type == PTE_L012_TYPE_BLOCK))
+#define SET_FRAME_LARGE_ARCH(ptl, i, large) \
+	(((pte_t *) (ptl))[(i)].type = \
+	((large) ? PTE_L012_TYPE_BLOCK : PTE_L3_TYPE_PAGE))
+
 /* Macros for querying the last-level PTE entries. */
 #define PTE_VALID_ARCH(pte) \
 	(((pte_t *) (pte))->valid != 0)
@@ -209,8 +222,8 @@ extern uintptr_t physmem_base;
 #define PTE_L3_TYPE_PAGE  1
 
 /** HelenOS descriptor type. Table for level 0, 1, 2 page translation tables,
- * page for level 3 tables. Block descriptors are not used by HelenOS during
- * normal processing.
+ * page for level 3 tables. Block descriptors are only used in level 2 tables
+ * for large pages.
  */
 #define PTE_L0123_TYPE_HELENOS  1
 
@@ -244,8 +257,8 @@ extern uintptr_t physmem_base;
 /** Page Table Entry.
  *
  * HelenOS model:
- * * Level 0, 1, 2 translation tables hold next-level table descriptors. Block
- *   descriptors are not used during normal processing.
+ * * Level 0, 1, 2 translation tables hold next-level table descriptors. Level 2
+ *   tables may also hold block descriptors of 2 MiB large pages.
  * * Level 3 tables store 4kB page descriptors.
  */
 typedef struct {
@@ -81,6 +81,11 @@ typedef struct {
 	tss_t *tss;
 
 	size_t iomapver_copy;  /** Copy of TASK's I/O Permission bitmap generation count. */
+
+	uint32_t apic_tick;     /** Local APIC timer count per clock tick. */
+	uint32_t apic_rem;      /** Timer count to the next tick when ticks were suspended. */
+	uint32_t apic_oneshot;  /** Initial count of the suspended timer. */
+	bool apic_rephase;      /** One-shot timer aligning the resumed periodic ticks. */
 } cpu_arch_t;
 
 #endif
@@ -40,6 +40,8 @@
 #include <assert.h>
 #include <mm/page.h>
 #include <time/delay.h>
+#include <time/clock.h>
+#include <macros.h>
 #include <interrupt.h>
 #include <arch/interrupt.h>
 #include <log.h>
@@ -168,8 +170,25 @@ static irq_ownership_t l_apic_timer_claim(irq_t *irq)
 	return IRQ_ACCEPT;
 }
 
+/** Set the local APIC timer mode and initial count. */
+static void l_apic_timer_program(uint32_t mode, uint32_t count)
+{
+	lvt_tm_t tm;
+
+	tm.value = l_apic[LVT_Tm];
+	tm.mode = mode;
+	l_apic[LVT_Tm] = tm.value;
+	l_apic[ICRT] = count;
+}
+
 static void l_apic_timer_irq_handler(irq_t *irq)
 {
+	/* Go on with periodic ticks once they are back in phase. */
+	if (CPU->arch.apic_rephase) {
+		CPU->arch.apic_rephase = false;
+		l_apic_timer_program(TIMER_PERIODIC, CPU->arch.apic_tick);
+	}
+
 	/*
 	 * Holding a spinlock could prevent clock() from preempting
 	 * the current thread. In this case, we don't need to hold the
@@ -180,6 +199,89 @@ static void l_apic_timer_irq_handler(irq_t *irq)
 	irq_spinlock_lock(&irq->lock, false);
 }
 
+/** Suspend periodic ticks of the local APIC timer.
+ *
+ * The timer is switched to one-shot mode so that it expires on the
+ * tick boundary @a ticks ticks from the last tick.
+ *
+ * @param ticks Number of ticks to suspend for.
+ *
+ * @return Number of ticks programmed or zero if the ticks were not
+ *         suspended.
+ *
+ */
+static uint64_t l_apic_dyntick_suspend(uint64_t ticks)
+{
+	uint32_t tick = CPU->arch.apic_tick;
+
+	ticks = min(ticks, UINT32_MAX / tick);
+
+	uint32_t rem = l_apic[CCRT];
+	if (rem == 0) {
+		/* The interrupt of the current tick is yet to be handled. */
+		return 0;
+	}
+
+	uint32_t count = rem + (ticks - 1) * tick;
+
+	CPU->arch.apic_rem = rem;
+	CPU->arch.apic_oneshot = count;
+	CPU->arch.apic_rephase = false;
+	l_apic_timer_program(TIMER_ONESHOT, count);
+
+	return ticks;
+}
+
+/** Resume periodic ticks of the local APIC timer.
+ *
+ * @return Number of ticks which passed since the ticks were suspended,
+ *         not counting the tick of the expired one-shot timer, which is
+ *         accounted for by its own interrupt.
+ *
+ */
+static uint64_t l_apic_dyntick_resume(void)
+{
+	uint32_t tick = CPU->arch.apic_tick;
+	uint32_t rem = CPU->arch.apic_rem;
+	uint32_t left = l_apic[CCRT];
+
+	if (left == 0) {
+		/* The timer expired right on a tick boundary. */
+		l_apic_timer_program(TIMER_PERIODIC, tick);
+		return (CPU->arch.apic_oneshot - rem) / tick;
+	}
+
+	uint32_t elapsed = CPU->arch.apic_oneshot - left;
+	uint64_t ticks;
+	uint32_t phase;
+
+	if (elapsed < rem) {
+		ticks = 0;
+		phase = rem - elapsed;
+	} else {
+		ticks = (elapsed - rem) / tick + 1;
+		phase = tick - (elapsed - rem) % tick;
+	}
+
+	/* Expire on the next tick boundary and go periodic from there. */
+	CPU->arch.apic_rephase = true;
+	l_apic_timer_program(TIMER_ONESHOT, phase);
+
+	return ticks;
+}
+
+/** Wake up a CPU sleeping with its local APIC timer suspended. */
+static void l_apic_dyntick_kick(cpu_t *cpu)
+{
+	(void) l_apic_send_custom_ipi(cpu->arch.id, VECTOR_WAKEUP_IPI);
+}
+
+static const clock_dyntick_ops_t l_apic_dyntick_ops = {
+	.suspend = l_apic_dyntick_suspend,
+	.resume = l_apic_dyntick_resume,
+	.kick = l_apic_dyntick_kick
+};
+
 /** Get Local APIC ID.
  *
  * @return Local APIC ID.
@@ -511,6 +613,10 @@ void l_apic_init(void)
 	uint32_t t2 = l_apic[CCRT];
 
 	l_apic[ICRT] = t1 - t2;
+	CPU->arch.apic_tick = t1 - t2;
+
+	/* The timer can be suspended on idle CPUs. */
+	clock_dyntick_register(&l_apic_dyntick_ops);
 
 	/* Program Logical Destination Register. */
 	assert(CPU->id < 8);
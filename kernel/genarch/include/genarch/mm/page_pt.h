@@ -128,6 +128,17 @@
 #define SET_PTL3_PRESENT(ptl2, i)   SET_PTL3_PRESENT_ARCH(ptl2, i)
 #define SET_FRAME_PRESENT(ptl3, i)  SET_FRAME_PRESENT_ARCH(ptl3, i)
 
+/*
+ * Architectures which can map a large page by a single PTL2 entry define
+ * LARGE_PAGE_WIDTH_ARCH. Such an entry has the format of a last-level PTE
+ * with the large page bit set.
+ *
+ */
+#ifdef LARGE_PAGE_WIDTH_ARCH
+#define GET_PTL3_LARGE(ptl2, i)         GET_PTL3_LARGE_ARCH(ptl2, i)
+#define SET_FRAME_LARGE(ptl, i, large)  SET_FRAME_LARGE_ARCH(ptl, i, large)
+#endif
+
 /*
  * Macros for querying the last-level PTEs.
  *
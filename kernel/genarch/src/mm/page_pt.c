@@ -41,6 +41,7 @@
 #include <mm/frame.h>
 #include <mm/km.h>
 #include <mm/as.h>
+#include <mm/tlb.h>
 #include <arch/mm/page.h>
 #include <arch/mm/as.h>
 #include <barrier.h>
@@ -56,28 +57,34 @@ static void pt_mapping_remove(as_t *, uintptr_t);
 static bool pt_mapping_find(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_update(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_make_global(uintptr_t, size_t);
+#ifdef LARGE_PAGE_WIDTH_ARCH
+static void pt_mapping_insert_large(as_t *, uintptr_t, uintptr_t, unsigned int);
+static bool pt_mapping_remove_large(as_t *, uintptr_t);
+static void pt_mapping_split(as_t *, uintptr_t);
+#endif
 
 const page_mapping_operations_t pt_mapping_operations = {
 	.mapping_insert = pt_mapping_insert,
 	.mapping_remove = pt_mapping_remove,
 	.mapping_find = pt_mapping_find,
 	.mapping_update = pt_mapping_update,
-	.mapping_make_global = pt_mapping_make_global
+	.mapping_make_global = pt_mapping_make_global,
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	.mapping_insert_large = pt_mapping_insert_large,
+	.mapping_remove_large = pt_mapping_remove_large,
+	.mapping_split = pt_mapping_split
+#endif
 };
 
-/** Map page to frame using hierarchical page tables.
+/** Get the PTL2 table covering a page, allocating missing tables.
  *
- * Map virtual address page to physical address frame
- * using flags.
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page.
  *
- * @param as    Address space to wich page belongs.
- * @param page  Virtual address of the page to be mapped.
- * @param frame Physical address of memory frame to which the mapping is done.
- * @param flags Flags to be used for mapping.
+ * @return Kernel address of the PTL2 table.
  *
  */
-void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
-    unsigned int flags)
+static pte_t *pt_ptl2_get(as_t *as, uintptr_t page)
 {
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
 
@@ -117,7 +124,178 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 		SET_PTL2_PRESENT(ptl1, PTL1_INDEX(page));
 	}
 
-	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+	return (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+}
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+
+/** Find the PTL2 table covering a page.
+ *
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page.
+ *
+ * @return Kernel address of the PTL2 table or NULL if there is none.
+ *
+ */
+static pte_t *pt_ptl2_find(as_t *as, uintptr_t page)
+{
+	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
+	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT)
+		return NULL;
+
+	pte_t *ptl1 = (pte_t *) PA2KA(GET_PTL1_ADDRESS(ptl0, PTL0_INDEX(page)));
+	if (GET_PTL2_FLAGS(ptl1, PTL1_INDEX(page)) & PAGE_NOT_PRESENT)
+		return NULL;
+
+	return (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+}
+
+/** Check whether a page is mapped by a large page.
+ *
+ * @param ptl2 PTL2 table covering the page or NULL.
+ * @param page Virtual address of the page.
+ *
+ */
+static bool pt_large_mapped(pte_t *ptl2, uintptr_t page)
+{
+	return (ptl2 != NULL) &&
+	    !(GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) &&
+	    GET_PTL3_LARGE(ptl2, PTL2_INDEX(page));
+}
+
+/** Replace a large page mapping by a PTL3 table mapping the same frames.
+ *
+ * This is done before a part of a large page is remapped or unmapped.
+ * A TLB must never hold the large page translation together with the
+ * small page translations of the same addresses, so the large page is
+ * shot down after its mapping is broken and before the table is
+ * installed (break-before-make). The PTL3 table is allocated before the
+ * shootdown starts, as the allocation may block.
+ *
+ * Must not be called within a TLB shootdown sequence.
+ *
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page which must not be mapped by a
+ *             large page.
+ *
+ */
+static void pt_large_split(as_t *as, uintptr_t page)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_find(as, page);
+	if (!pt_large_mapped(ptl2, page))
+		return;
+
+	size_t i = PTL2_INDEX(page);
+	uintptr_t lpage = ALIGN_DOWN(page, LARGE_PAGE_SIZE);
+	pte_t *newpt = (pte_t *)
+	    PA2KA(frame_alloc(PTL3_FRAMES, FRAME_LOWMEM, PTL3_SIZE - 1));
+	uintptr_t frame = PTE_GET_FRAME(&ptl2[i]);
+
+	for (size_t j = 0; j < PTL3_ENTRIES; j++) {
+		newpt[j] = ptl2[i];
+		SET_FRAME_LARGE(newpt, j, false);
+		SET_FRAME_ADDRESS(newpt, j, frame + FRAMES2SIZE(j));
+	}
+
+	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, lpage,
+	    LARGE_PAGE_PAGES);
+
+	/*
+	 * Break the large page mapping before installing the table. Anyone
+	 * faulting on it meanwhile waits for the page table lock and finds
+	 * the new table.
+	 */
+	memsetb(&ptl2[i], sizeof(pte_t), 0);
+	write_barrier();
+
+	tlb_invalidate_pages(as->asid, lpage, LARGE_PAGE_PAGES);
+
+	SET_PTL3_ADDRESS(ptl2, i, KA2PA(newpt));
+	SET_PTL3_FLAGS(ptl2, i,
+	    PAGE_NOT_PRESENT | PAGE_USER | PAGE_EXEC | PAGE_CACHEABLE |
+	    PAGE_WRITE);
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, i);
+
+	tlb_shootdown_finalize(ipl);
+}
+
+/** Split a large page straddling a page boundary.
+ *
+ * Must not be called within a TLB shootdown sequence.
+ *
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the boundary.
+ *
+ */
+void pt_mapping_split(as_t *as, uintptr_t page)
+{
+	if (!IS_ALIGNED(page, LARGE_PAGE_SIZE))
+		pt_large_split(as, page);
+}
+
+/** Map a large page to a run of frames using hierarchical page tables.
+ *
+ * The large page is mapped by a single PTL2 entry instead of a PTL3 table.
+ * Both @a page and @a frame must be aligned to LARGE_PAGE_SIZE and the
+ * range must not be mapped yet.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame of the run.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert_large(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(IS_ALIGNED(page, LARGE_PAGE_SIZE));
+	assert(IS_ALIGNED(frame, LARGE_PAGE_SIZE));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+	size_t i = PTL2_INDEX(page);
+
+	if (!(GET_PTL3_FLAGS(ptl2, i) & PAGE_NOT_PRESENT)) {
+		/*
+		 * An empty PTL3 table may be left behind only if the range
+		 * was mapped before, which the caller rules out.
+		 */
+		panic("Large page %p overlaps a mapping.", (void *) page);
+	}
+
+	SET_PTL3_ADDRESS(ptl2, i, frame);
+	SET_FRAME_FLAGS(ptl2, i, flags | PAGE_NOT_PRESENT);
+	SET_FRAME_LARGE(ptl2, i, true);
+	/*
+	 * Make the new mapping visible only after it is fully initialized.
+	 */
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, i);
+}
+
+#endif /* LARGE_PAGE_WIDTH_ARCH */
+
+/** Map page to frame using hierarchical page tables.
+ *
+ * Map virtual address page to physical address frame
+ * using flags.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the page to be mapped.
+ * @param frame Physical address of memory frame to which the mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	pt_large_split(as, page);
+#endif
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
 
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
@@ -145,11 +323,88 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	SET_FRAME_PRESENT(ptl3, PTL3_INDEX(page));
 }
 
+/** Free empty PTL2 and PTL1 tables on the way to a page.
+ *
+ * Called after the PTL2 entry covering the page was cleared. Tables
+ * needed for sharing the kernel non-identity mappings are kept.
+ *
+ * @param ptl0 PTL0 table.
+ * @param ptl1 PTL1 table covering the page.
+ * @param ptl2 PTL2 table covering the page.
+ * @param page Virtual address of the page.
+ *
+ */
+static void pt_upper_release(pte_t *ptl0, pte_t *ptl1, pte_t *ptl2,
+    uintptr_t page)
+{
+	bool empty = true;
+	unsigned int i;
+
+	/* Check PTL2, empty is still true */
+#if (PTL2_ENTRIES != 0)
+	for (i = 0; i < PTL2_ENTRIES; i++) {
+		if (PTE_VALID(&ptl2[i])) {
+			empty = false;
+			break;
+		}
+	}
+
+	if (empty) {
+		/*
+		 * PTL2 is empty.
+		 * Release the frame and remove PTL2 pointer from the parent
+		 * table.
+		 */
+#if (PTL1_ENTRIES != 0)
+		memsetb(&ptl1[PTL1_INDEX(page)], sizeof(pte_t), 0);
+#else
+		if (km_is_non_identity(page))
+			return;
+
+		memsetb(&ptl0[PTL0_INDEX(page)], sizeof(pte_t), 0);
+#endif
+		frame_free(KA2PA((uintptr_t) ptl2), PTL2_FRAMES);
+	} else {
+		/*
+		 * PTL2 is not empty.
+		 * Therefore, there must be a path from PTL0 to PTL2 and
+		 * thus nothing to free in higher levels.
+		 *
+		 */
+		return;
+	}
+#endif /* PTL2_ENTRIES != 0 */
+
+	/* check PTL1, empty is still true */
+#if (PTL1_ENTRIES != 0)
+	for (i = 0; i < PTL1_ENTRIES; i++) {
+		if (PTE_VALID(&ptl1[i])) {
+			empty = false;
+			break;
+		}
+	}
+
+	if (empty) {
+		/*
+		 * PTL1 is empty.
+		 * Release the frame and remove PTL1 pointer from the parent
+		 * table.
+		 */
+		if (km_is_non_identity(page))
+			return;
+
+		memsetb(&ptl0[PTL0_INDEX(page)], sizeof(pte_t), 0);
+		frame_free(KA2PA((uintptr_t) ptl1), PTL1_FRAMES);
+	}
+#endif /* PTL1_ENTRIES != 0 */
+}
+
 /** Remove mapping of page from hierarchical page tables.
  *
  * Remove any mapping of page within address space as.
  * TLB shootdown should follow in order to make effects of
- * this call visible.
+ * this call visible. A page inside a large page can only be
+ * removed after the large page was split by pt_mapping_split().
  *
  * Empty page tables except PTL0 are freed.
  *
@@ -177,6 +432,17 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return;
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	/*
+	 * Splitting would need to allocate memory, which is not possible
+	 * within the TLB shootdown sequence the caller is in.
+	 */
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		panic("Unmapping page %p of a large page which was not split.",
+		    (void *) page);
+	}
+#endif
+
 	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
 
 	/*
@@ -232,66 +498,55 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 		return;
 	}
 
-	/* Check PTL2, empty is still true */
-#if (PTL2_ENTRIES != 0)
-	for (i = 0; i < PTL2_ENTRIES; i++) {
-		if (PTE_VALID(&ptl2[i])) {
-			empty = false;
-			break;
-		}
-	}
+	pt_upper_release(ptl0, ptl1, ptl2, page);
+}
 
-	if (empty) {
-		/*
-		 * PTL2 is empty.
-		 * Release the frame and remove PTL2 pointer from the parent
-		 * table.
-		 */
-#if (PTL1_ENTRIES != 0)
-		memsetb(&ptl1[PTL1_INDEX(page)], sizeof(pte_t), 0);
-#else
-		if (km_is_non_identity(page))
-			return;
+#ifdef LARGE_PAGE_WIDTH_ARCH
 
-		memsetb(&ptl0[PTL0_INDEX(page)], sizeof(pte_t), 0);
-#endif
-		frame_free(KA2PA((uintptr_t) ptl2), PTL2_FRAMES);
-	} else {
-		/*
-		 * PTL2 is not empty.
-		 * Therefore, there must be a path from PTL0 to PTL2 and
-		 * thus nothing to free in higher levels.
-		 *
-		 */
-		return;
-	}
-#endif /* PTL2_ENTRIES != 0 */
+/** Remove a whole large page mapping.
+ *
+ * TLB shootdown should follow in order to make effects of this call
+ * visible.
+ *
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the large page.
+ *
+ * @return True if the large page was unmapped, false if @a page is not
+ *         mapped by a large page.
+ *
+ */
+bool pt_mapping_remove_large(as_t *as, uintptr_t page)
+{
+	assert(page_table_locked(as));
+	assert(IS_ALIGNED(page, LARGE_PAGE_SIZE));
 
-	/* check PTL1, empty is still true */
-#if (PTL1_ENTRIES != 0)
-	for (i = 0; i < PTL1_ENTRIES; i++) {
-		if (PTE_VALID(&ptl1[i])) {
-			empty = false;
-			break;
-		}
-	}
+	pte_t *ptl2 = pt_ptl2_find(as, page);
+	if (!pt_large_mapped(ptl2, page))
+		return false;
 
-	if (empty) {
-		/*
-		 * PTL1 is empty.
-		 * Release the frame and remove PTL1 pointer from the parent
-		 * table.
-		 */
-		if (km_is_non_identity(page))
-			return;
+	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
+	pte_t *ptl1 = (pte_t *) PA2KA(GET_PTL1_ADDRESS(ptl0, PTL0_INDEX(page)));
 
-		memsetb(&ptl0[PTL0_INDEX(page)], sizeof(pte_t), 0);
-		frame_free(KA2PA((uintptr_t) ptl1), PTL1_FRAMES);
-	}
-#endif /* PTL1_ENTRIES != 0 */
+	SET_FRAME_FLAGS(ptl2, PTL2_INDEX(page), PAGE_NOT_PRESENT);
+	memsetb(&ptl2[PTL2_INDEX(page)], sizeof(pte_t), 0);
+
+	pt_upper_release(ptl0, ptl1, ptl2, page);
+	return true;
 }
 
-static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
+#endif /* LARGE_PAGE_WIDTH_ARCH */
+
+/** Find the PTE mapping a page.
+ *
+ * @param as          Address space to which page belongs.
+ * @param page        Virtual page.
+ * @param nolock      True if the page tables need not be locked.
+ * @param[out] large  Set to true if the PTE maps a whole large page.
+ *
+ * @return Pointer to the PTE or NULL if there is none.
+ */
+static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock,
+    bool *large)
 {
 	assert(nolock || page_table_locked(as));
 
@@ -316,6 +571,15 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		*large = true;
+		return &ptl2[PTL2_INDEX(page)];
+	}
+#endif
+
+	*large = false;
+
 #if (PTL2_ENTRIES != 0)
 	/*
 	 * Always read ptl3 only after we are sure it is present.
@@ -339,10 +603,23 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
  */
 bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
-	if (t)
-		*pte = *t;
-	return t != NULL;
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
+	if (!t)
+		return false;
+
+	*pte = *t;
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if (large) {
+		/* Present the page as if it was mapped on its own. */
+		SET_FRAME_LARGE(pte, 0, false);
+		SET_FRAME_ADDRESS(pte, 0, PTE_GET_FRAME(t) +
+		    ALIGN_DOWN(page & (LARGE_PAGE_SIZE - 1), PAGE_SIZE));
+	}
+#endif
+
+	return true;
 }
 
 /** Update mapping for virtual page in hierarchical page tables.
@@ -354,17 +631,28 @@ bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
  */
 void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
 	if (!t)
 		panic("Updating non-existent PTE");
 
-	assert(PTE_VALID(t) == PTE_VALID(pte));
-	assert(PTE_PRESENT(t) == PTE_PRESENT(pte));
-	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(pte));
-	assert(PTE_WRITABLE(t) == PTE_WRITABLE(pte));
-	assert(PTE_EXECUTABLE(t) == PTE_EXECUTABLE(pte));
+	pte_t new_pte = *pte;
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if (large) {
+		/* The update applies to the whole large page. */
+		SET_FRAME_ADDRESS(&new_pte, 0, PTE_GET_FRAME(t));
+		SET_FRAME_LARGE(&new_pte, 0, true);
+	}
+#endif
+
+	assert(PTE_VALID(t) == PTE_VALID(&new_pte));
+	assert(PTE_PRESENT(t) == PTE_PRESENT(&new_pte));
+	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(&new_pte));
+	assert(PTE_WRITABLE(t) == PTE_WRITABLE(&new_pte));
+	assert(PTE_EXECUTABLE(t) == PTE_EXECUTABLE(&new_pte));
 
-	*t = *pte;
+	*t = new_pte;
 }
 
 /** Return the size of the region mapped by a single PTL0 entry.
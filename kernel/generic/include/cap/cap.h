@@ -38,8 +38,6 @@
 #include <abi/cap.h>
 #include <typedefs.h>
 #include <adt/list.h>
-#include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <lib/ra.h>
 #include <synch/mutex.h>
 #include <atomic.h>
@@ -96,32 +94,60 @@ typedef struct kobject {
 } kobject_t;
 
 /*
- * A cap_t may only be accessed under the protection of the cap_info_t lock.
+ * A cap_t may only be modified under the protection of the cap_info_t lock.
+ * The state, task, handle and kobject members may also be read locklessly,
+ * validated by the sequence counter.
  */
 typedef struct cap {
-	cap_state_t state;
+	/*
+	 * Link to the kobject's list of capabilities.
+	 *
+	 * This comes first, as the slab allocator overwrites the first word of
+	 * a free cap_t, which may still be read by lockless lookups.
+	 */
+	link_t kobj_link;
 
-	struct task *task;
-	cap_handle_t handle;
+	/** Sequence counter, odd while the capability is being modified. */
+	atomic_uint seq;
 
-	/** Link to the kobject's list of capabilities. */
-	link_t kobj_link;
+	_Atomic cap_state_t state;
+
+	_Atomic(struct task *) task;
+	_Atomic cap_handle_t handle;
 
 	/* Link to the task's capabilities of the same kobject type. */
 	link_t type_link;
 
-	ht_link_t caps_link;
-
 	/* The underlying kernel object. */
-	kobject_t *kobject;
+	_Atomic(kobject_t *) kobject;
 } cap_t;
 
+/** Number of bits of a capability handle resolved by a table leaf */
+#define CAP_LEAF_BITS	10
+/** Number of capabilities in a table leaf */
+#define CAP_LEAF_SIZE	(1 << CAP_LEAF_BITS)
+/** Number of leaves in the capability table */
+#define CAP_DIR_SIZE	1024
+/** Number of capability handles covered by the capability table */
+#define CAP_TABLE_SIZE	(CAP_DIR_SIZE * CAP_LEAF_SIZE)
+
+/** Leaf of the capability table */
+typedef struct cap_leaf {
+	_Atomic(cap_t *) caps[CAP_LEAF_SIZE];
+} cap_leaf_t;
+
 typedef struct cap_info {
 	mutex_t lock;
 
 	list_t type_list[KOBJECT_TYPE_MAX];
 
-	hash_table_t caps;
+	/**
+	 * Two-level table of capabilities indexed by handle. Leaves are
+	 * allocated on demand and only freed with the table, so that the
+	 * table can be read without holding the lock.
+	 */
+	_Atomic(cap_leaf_t *) table[CAP_DIR_SIZE];
+
 	ra_arena_t *handles;
 } cap_info_t;
 
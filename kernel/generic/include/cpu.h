@@ -40,6 +40,7 @@
 #include <proc/scheduler.h>
 #include <arch/cpu.h>
 #include <arch/context.h>
+#include <time/timeout_wheel.h>
 #include <adt/list.h>
 #include <arch.h>
 
@@ -77,6 +78,11 @@ typedef struct cpu_local {
 	context_t scheduler_context;
 
 	struct thread *prev_thread;
+
+#ifdef CONFIG_SAMPLING_PROFILER
+	/** State saved by the most recently dispatched exception. */
+	struct istate *istate;
+#endif
 } cpu_local_t;
 
 /** CPU structure.
@@ -93,7 +99,10 @@ typedef struct cpu {
 	runq_t rq[RQ_COUNT];
 
 	IRQ_SPINLOCK_DECLARE(timeoutlock);
-	list_t timeout_active_list;
+	timeout_wheel_t timeout_wheel;
+
+	/** The CPU is idle with its clock ticks suspended. */
+	atomic_bool tickless;
 
 	/**
 	 * Processor cycle accounting.
@@ -101,6 +110,16 @@ typedef struct cpu {
 	atomic_time_stat_t idle_cycles;
 	atomic_time_stat_t busy_cycles;
 
+	/** Threads stolen by this CPU when it was about to go idle. */
+	atomic_size_t steals;
+	/** Threads migrated to this CPU by kcpulb. */
+	atomic_size_t migrations;
+
+	/** Page faults serviced by address space area backends. */
+	atomic_size_t page_faults;
+	/** Large pages mapped, each saving LARGE_PAGE_PAGES page faults. */
+	atomic_size_t large_pages;
+
 	/**
 	 * Processor ID assigned by kernel.
 	 */
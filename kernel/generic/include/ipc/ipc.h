@@ -43,6 +43,7 @@
 #include <typedefs.h>
 #include <mm/slab.h>
 #include <cap/cap.h>
+#include <mm/as.h>
 
 struct answerbox;
 struct task;
@@ -165,8 +166,23 @@ typedef struct call {
 
 	/** Buffer for IPC_M_DATA_WRITE and IPC_M_DATA_READ. */
 	uint8_t *buffer;
+
+	/**
+	 * Pinned frames of the caller's buffer for IPC_M_DATA_WRITE and
+	 * IPC_M_DATA_READ transferred without the intermediate buffer.
+	 */
+	uintptr_t *frames;
+	/** Number of pinned frames. */
+	size_t frames_count;
 } call_t;
 
+/**
+ * Minimum size of IPC_M_DATA_WRITE and IPC_M_DATA_READ transfers which copy
+ * the data directly between the address spaces instead of going through
+ * an intermediate buffer.
+ */
+#define DATA_XFER_DIRECT_MIN	(4 * PAGE_SIZE)
+
 extern slab_cache_t *phone_cache;
 
 extern answerbox_t *ipc_box_0;
@@ -176,6 +192,7 @@ extern kobject_ops_t call_kobject_ops;
 extern void ipc_init(void);
 
 extern call_t *ipc_call_alloc(void);
+extern errno_t ipc_call_pin(call_t *, uspace_addr_t, size_t, pf_access_t);
 
 extern errno_t ipc_call_sync(phone_t *, call_t *);
 extern errno_t ipc_call(phone_t *, call_t *);
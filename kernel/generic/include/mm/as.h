@@ -126,6 +126,12 @@ typedef struct as {
 	 */
 	odict_t as_areas;
 
+	/** Number of pages in all address space areas. */
+	atomic_size_t virt_pages;
+
+	/** Number of used pages in all address space areas. */
+	atomic_size_t used_pages;
+
 	/** Non-generic content. */
 	as_genarch_t genarch;
 
@@ -183,6 +189,8 @@ typedef struct used_space {
 	odict_t ivals;
 	/** Total number of used pages. */
 	size_t pages;
+	/** Address space whose used page count is to be kept in sync. */
+	struct as *as;
 } used_space_t;
 
 /**
@@ -337,6 +345,8 @@ extern void as_pagemap_remove(as_page_mapping_t *);
 
 extern unsigned int as_area_get_flags(as_area_t *);
 extern bool as_area_check_access(as_area_t *, pf_access_t);
+extern errno_t as_pin_pages(uintptr_t, size_t, pf_access_t, uintptr_t *);
+extern void as_unpin_pages(uintptr_t *, size_t);
 extern size_t as_area_get_size(uintptr_t);
 extern used_space_ival_t *used_space_first(used_space_t *);
 extern used_space_ival_t *used_space_next(used_space_ival_t *);
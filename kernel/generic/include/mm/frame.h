@@ -38,6 +38,7 @@
 
 #include <typedefs.h>
 #include <trace.h>
+#include <atomic.h>
 #include <adt/bitmap.h>
 #include <adt/list.h>
 #include <synch/spinlock.h>
@@ -89,9 +90,18 @@ typedef uint8_t zone_flags_t;
 	(((((zf) & ZONE_EF_MASK)) == ((f) & ZONE_EF_MASK)) && \
 	    (((zf) & ~ZONE_EF_MASK) & (f)))
 
+/** Number of free block orders tracked in zones. */
+#define FRAME_ORDERS  20
+
 typedef struct {
-	size_t refcount;  /**< Tracking of shared frames */
-	void *parent;     /**< If allocated by slab, this points there */
+	atomic_size_t refcount;  /**< Tracking of shared frames */
+	void *parent;            /**< If allocated by slab, this points there */
+#ifdef CONFIG_FRAME_BUDDY
+	size_t buddy_next;       /**< Next free block of the same order */
+	size_t buddy_prev;       /**< Previous free block of the same order */
+	uint8_t buddy_order;     /**< Order of the free block */
+	bool buddy_free;         /**< Frame is the first frame of a free block */
+#endif
 } frame_t;
 
 typedef struct {
@@ -115,6 +125,15 @@ typedef struct {
 
 	/** Array of frame_t structures in this zone */
 	frame_t *frames;
+
+#ifdef CONFIG_FRAME_BUDDY
+	/** First and last free blocks of each order (frame indices) */
+	size_t buddy_head[FRAME_ORDERS];
+	size_t buddy_tail[FRAME_ORDERS];
+
+	/** Number of free blocks of each order */
+	size_t buddy_blocks[FRAME_ORDERS];
+#endif
 } zone_t;
 
 /*
@@ -129,6 +148,42 @@ typedef struct {
 
 extern zones_t zones;
 
+/** Number of run sizes (1, 2, 4, ... frames) kept in per-CPU frame caches. */
+#define FRAME_CACHE_ORDERS  3
+
+/** Maximum number of runs in one per-CPU frame cache stack. */
+#define FRAME_CACHE_SIZE  32
+
+/** Number of runs moved between a per-CPU cache and the zones at once. */
+#define FRAME_CACHE_BATCH  8
+
+/** Per-CPU frame cache classes (low memory and high memory frames). */
+#define FRAME_CACHE_CLASSES  2
+
+/** Stack of free runs of 2^order frames. */
+typedef struct {
+	size_t count;
+	pfn_t pfn[FRAME_CACHE_SIZE];
+} frame_cache_stack_t;
+
+/** Per-CPU cache of free frames
+ *
+ * Frames in the cache have zero reference count, but they are still
+ * marked as busy in their zone.
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	frame_cache_stack_t stack[FRAME_CACHE_CLASSES][FRAME_CACHE_ORDERS];
+
+	/** Number of frames held in the cache. */
+	size_t frames;
+
+	/* Statistics */
+	uint64_t hits;    /**< Allocations satisfied from the cache */
+	uint64_t misses;  /**< Allocations which needed to refill the cache */
+	uint64_t drains;  /**< Batches returned to the zones */
+} frame_cache_t;
+
 extern void frame_init(void);
 extern bool frame_adjust_zone_bounds(bool, uintptr_t *, size_t *);
 extern uintptr_t frame_alloc_generic(size_t, frame_flags_t, uintptr_t,
@@ -152,6 +207,10 @@ extern void zone_merge_all(void);
 extern uint64_t zones_total_size(void);
 extern void zones_stats(uint64_t *, uint64_t *, uint64_t *, uint64_t *);
 
+extern void frame_enable_cpucache(void);
+extern void frame_cache_stats(unsigned int, uint64_t *, uint64_t *, uint64_t *,
+    uint64_t *);
+
 /*
  * Console functions
  */
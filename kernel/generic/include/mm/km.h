@@ -54,6 +54,7 @@ extern uintptr_t km_map(uintptr_t, size_t, size_t, unsigned int);
 extern void km_unmap(uintptr_t, size_t);
 
 extern uintptr_t km_temporary_page_get(uintptr_t *, frame_flags_t);
+extern uintptr_t km_temporary_frame_get(uintptr_t);
 extern void km_temporary_page_put(uintptr_t);
 
 #endif
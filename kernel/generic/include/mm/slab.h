@@ -63,6 +63,12 @@
 #define SLAB_CACHE_SLINSIDE     0x02
 /** We add magazine cache later, if we have this flag */
 #define SLAB_CACHE_MAGDEFERRED  (0x04 | SLAB_CACHE_NOMAGAZINE)
+/**
+ * Never return slabs to the frame allocator, so that memory of a freed
+ * object is only ever reused for an object of the same cache. Except for
+ * the first word, a freed object is left intact.
+ */
+#define SLAB_CACHE_TYPESAFE     0x08
 
 typedef struct {
 	link_t link;
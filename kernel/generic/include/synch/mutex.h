@@ -37,6 +37,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <synch/semaphore.h>
 #include <abi/synch.h>
 
@@ -52,6 +54,11 @@ typedef struct {
 	int nesting;
 	semaphore_t sem;
 	_Atomic(struct thread *) owner;
+
+	/** Number of acquisitions which found the mutex locked */
+	atomic_size_t contended;
+	/** Number of contended acquisitions which had to sleep */
+	atomic_size_t slept;
 } mutex_t;
 
 #define MUTEX_INITIALIZER(name, mtype) (mutex_t) { \
@@ -59,6 +66,8 @@ typedef struct {
 	.nesting = 0, \
 	.sem = SEMAPHORE_INITIALIZER((name).sem, 1), \
 	.owner = NULL, \
+	.contended = 0, \
+	.slept = 0, \
 }
 
 #define MUTEX_INITIALIZE(name, mtype) \
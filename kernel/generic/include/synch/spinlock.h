@@ -42,6 +42,10 @@
 #include <arch/types.h>
 #include <assert.h>
 
+#ifdef CONFIG_SPINLOCK_STATS
+#include <abi/sysinfo.h>
+#endif
+
 #define DEADLOCK_THRESHOLD  100000000
 
 #if defined(CONFIG_SMP) && defined(CONFIG_DEBUG_SPINLOCK)
@@ -66,13 +70,37 @@
 
 #endif /* CONFIG_DEBUG_SPINLOCK */
 
+#ifdef CONFIG_SPINLOCK_STATS
+
+/** Statistics shared by all spinlocks of the same name */
+typedef struct spinlock_class {
+	const char *name;
+	atomic_size_t acquisitions;  /**< Number of acquisitions */
+	atomic_size_t contended;     /**< Acquisitions which had to spin */
+	atomic_size_t max_hold;      /**< Longest hold time in cycles */
+} spinlock_class_t;
+
+#endif /* CONFIG_SPINLOCK_STATS */
+
 typedef struct spinlock {
 #ifdef CONFIG_SMP
+#ifdef CONFIG_TICKET_SPINLOCK
+	atomic_uint next;   /**< Ticket of the next locker */
+	atomic_uint owner;  /**< Ticket of the lock holder */
+#else
 	atomic_flag flag;
+#endif /* CONFIG_TICKET_SPINLOCK */
 
-#ifdef CONFIG_DEBUG_SPINLOCK
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_SPINLOCK_STATS)
 	const char *name;
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif
+
+#ifdef CONFIG_SPINLOCK_STATS
+	/** Statistics of the lock, looked up on first acquisition */
+	_Atomic(spinlock_class_t *) cls;
+	/** Cycle count at the time the lock was acquired */
+	uint64_t acquired;
+#endif /* CONFIG_SPINLOCK_STATS */
 #endif
 } spinlock_t;
 
@@ -84,10 +112,15 @@ typedef struct spinlock {
 #define SPINLOCK_EXTERN(lock_name)   extern spinlock_t lock_name
 
 #ifdef CONFIG_SMP
-#ifdef CONFIG_DEBUG_SPINLOCK
-#define SPINLOCK_INITIALIZER(desc_name) { .name = (desc_name), .flag = ATOMIC_FLAG_INIT }
+#ifdef CONFIG_TICKET_SPINLOCK
+#define SPINLOCK_STATE_INITIALIZER  .next = 0, .owner = 0
 #else
-#define SPINLOCK_INITIALIZER(desc_name) { .flag = ATOMIC_FLAG_INIT }
+#define SPINLOCK_STATE_INITIALIZER  .flag = ATOMIC_FLAG_INIT
+#endif
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_SPINLOCK_STATS)
+#define SPINLOCK_INITIALIZER(desc_name) { .name = (desc_name), SPINLOCK_STATE_INITIALIZER }
+#else
+#define SPINLOCK_INITIALIZER(desc_name) { SPINLOCK_STATE_INITIALIZER }
 #endif
 #else
 #define SPINLOCK_INITIALIZER(desc_name) {}
@@ -124,6 +157,11 @@ extern void spinlock_lock(spinlock_t *);
 extern void spinlock_unlock(spinlock_t *);
 extern bool spinlock_locked(spinlock_t *);
 
+#ifdef CONFIG_SPINLOCK_STATS
+extern size_t spinlock_stats_get(stats_lock_t *, size_t);
+extern void spinlock_stats_print(void);
+#endif /* CONFIG_SPINLOCK_STATS */
+
 #else
 
 #include <preemption.h>
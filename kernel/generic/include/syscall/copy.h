@@ -45,6 +45,10 @@ extern char memcpy_to_uspace_failover_address;
 
 extern errno_t copy_from_uspace(void *dst, uspace_addr_t uspace_src, size_t size);
 extern errno_t copy_to_uspace(uspace_addr_t dst_uspace, const void *src, size_t size);
+extern errno_t copy_from_uspace_to_frames(uintptr_t *frames, size_t offset,
+    uspace_addr_t uspace_src, size_t size);
+extern errno_t copy_to_uspace_from_frames(uspace_addr_t uspace_dst,
+    uintptr_t *frames, size_t offset, size_t size);
 
 /*
  * This interface must be implemented by each architecture.
@@ -48,9 +48,40 @@ typedef struct {
 
 extern uptime_t *uptime;
 
+struct cpu;
+
+/** Hardware clock operations for the dynamic tick
+ *
+ * The operations act on the clock of the current CPU and are called with
+ * interrupts disabled.
+ */
+typedef struct {
+	/**
+	 * Stop periodic ticks and program a single clock interrupt the given
+	 * number of ticks after the last tick. Return the number of ticks
+	 * actually programmed, which may be lower, or zero if the ticks
+	 * could not be suspended.
+	 */
+	uint64_t (*suspend)(uint64_t);
+	/**
+	 * Resume periodic ticks in phase with the ticks before suspend().
+	 * Return the number of ticks which passed in the meantime, not
+	 * counting the programmed clock interrupt if it already fired.
+	 */
+	uint64_t (*resume)(void);
+	/** Wake up another CPU sleeping with its ticks suspended. */
+	void (*kick)(struct cpu *);
+} clock_dyntick_ops_t;
+
 extern void clock(void);
 extern void clock_counter_init(void);
 
+extern void clock_dyntick_register(const clock_dyntick_ops_t *);
+extern void clock_idle_enter(void);
+extern void clock_idle_exit(void);
+extern void clock_kick(struct cpu *);
+extern void clock_kick_idle(struct cpu *);
+
 #endif
 
 /** @}
@@ -45,7 +45,7 @@ typedef uint64_t deadline_t;
 #define DEADLINE_NEVER ((deadline_t) UINT64_MAX)
 
 typedef struct {
-	/** Link to the list of active timeouts on timeout->cpu */
+	/** Link to the timing wheel slot of timeout->cpu */
 	link_t link;
 	/** Timeout will be activated when current clock tick reaches this value. */
 	deadline_t deadline;
@@ -68,6 +68,8 @@ extern void timeout_initialize(timeout_t *);
 extern void timeout_register(timeout_t *, uint64_t, timeout_handler_t, void *);
 extern void timeout_register_deadline(timeout_t *, deadline_t, timeout_handler_t, void *);
 extern bool timeout_unregister(timeout_t *);
+extern void timeout_process(uint64_t);
+extern uint64_t timeout_next_tick(void);
 
 #endif
 
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_time
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_TIMEOUT_WHEEL_H_
+#define KERN_TIMEOUT_WHEEL_H_
+
+#include <adt/list.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Number of bits of the expiration tick resolved by one wheel level. */
+#define TIMEOUT_WHEEL_BITS    6
+/** Number of slots in one wheel level. */
+#define TIMEOUT_WHEEL_SLOTS   (1 << TIMEOUT_WHEEL_BITS)
+/** Number of wheel levels. */
+#define TIMEOUT_WHEEL_LEVELS  4
+
+/** Hierarchical timing wheel of the active timeouts of one CPU.
+ *
+ * Level 0 has one slot per clock tick. Each slot of level n covers
+ * TIMEOUT_WHEEL_SLOTS^n ticks and its timeouts are moved to the lower
+ * levels when the wheel reaches the slot. Timeouts too far in the future
+ * for the top level are kept on the overflow list.
+ */
+typedef struct {
+	/** The next clock tick to be processed. */
+	uint64_t tick;
+	/** Number of timeouts in the wheel. */
+	size_t count;
+	list_t slot[TIMEOUT_WHEEL_LEVELS][TIMEOUT_WHEEL_SLOTS];
+	list_t overflow;
+} timeout_wheel_t;
+
+#endif
+
+/** @}
+ */
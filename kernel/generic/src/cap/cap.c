@@ -73,6 +73,16 @@
  * kobject_get() or kobject_add_ref(). When the kernel object is removed from
  * the container, the reference count should go down via a call to
  * kobject_put().
+ *
+ * Capabilities of a task are kept in a two-level table indexed by the
+ * capability handle. Modifications are serialized by the task's capability
+ * lock, but kobject_get() looks up capabilities without taking it. Each
+ * capability has a sequence counter which is odd while the capability is
+ * being modified, so that a lockless lookup can tell whether it has seen a
+ * consistent state. Capabilities and kernel objects are allocated from
+ * type-safe slab caches, which makes it safe for a lockless lookup to
+ * access them even after they have been freed. A reference to a kernel
+ * object is only taken while its reference count is non-zero.
  */
 
 #include <cap/cap.h>
@@ -92,7 +102,7 @@
 #include <stdlib.h>
 
 #define CAPS_START	((intptr_t) CAP_NIL + 1)
-#define CAPS_SIZE	(INT_MAX - (int) CAPS_START)
+#define CAPS_SIZE	(CAP_TABLE_SIZE - (int) CAPS_START)
 #define CAPS_LAST	(CAPS_SIZE - 1)
 
 static slab_cache_t *cap_cache;
@@ -105,37 +115,29 @@ kobject_ops_t *kobject_ops[KOBJECT_TYPE_MAX] = {
 	[KOBJECT_TYPE_WAITQ] = &waitq_kobject_ops
 };
 
-static size_t caps_hash(const ht_link_t *item)
+/** Slab constructor of capabilities
+ *
+ * The sequence counter survives freeing and reallocation of the
+ * capability, but memory fresh from the frame allocator may contain
+ * anything.
+ */
+static errno_t cap_ctor(void *obj, unsigned int flags)
 {
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return hash_mix(cap_handle_raw(cap->handle));
-}
+	cap_t *cap = (cap_t *) obj;
+	unsigned int seq = atomic_load_explicit(&cap->seq, memory_order_relaxed);
 
-static size_t caps_key_hash(const void *key)
-{
-	const cap_handle_t *handle = key;
-	return hash_mix(cap_handle_raw(*handle));
-}
+	if (seq & 1)
+		atomic_store_explicit(&cap->seq, seq + 1, memory_order_relaxed);
 
-static bool caps_key_equal(const void *key, size_t hash, const ht_link_t *item)
-{
-	const cap_handle_t *handle = key;
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return *handle == cap->handle;
+	return EOK;
 }
 
-static const hash_table_ops_t caps_ops = {
-	.hash = caps_hash,
-	.key_hash = caps_key_hash,
-	.key_equal = caps_key_equal
-};
-
 void caps_init(void)
 {
-	cap_cache = slab_cache_create("cap_t", sizeof(cap_t), 0, NULL,
-	    NULL, 0);
+	cap_cache = slab_cache_create("cap_t", sizeof(cap_t), 0, cap_ctor,
+	    NULL, SLAB_CACHE_TYPESAFE);
 	kobject_cache = slab_cache_create("kobject_t", sizeof(kobject_t), 0,
-	    NULL, NULL, 0);
+	    NULL, NULL, SLAB_CACHE_TYPESAFE);
 }
 
 /** Allocate the capability info structure
@@ -152,8 +154,9 @@ errno_t caps_task_alloc(task_t *task)
 		goto error_handles;
 	if (!ra_span_add(task->cap_info->handles, CAPS_START, CAPS_SIZE))
 		goto error_span;
-	if (!hash_table_create(&task->cap_info->caps, 0, 0, &caps_ops))
-		goto error_span;
+	for (size_t i = 0; i < CAP_DIR_SIZE; i++)
+		atomic_store_explicit(&task->cap_info->table[i], NULL,
+		    memory_order_relaxed);
 	return EOK;
 
 error_span:
@@ -181,7 +184,9 @@ void caps_task_init(task_t *task)
  */
 void caps_task_free(task_t *task)
 {
-	hash_table_destroy(&task->cap_info->caps);
+	for (size_t i = 0; i < CAP_DIR_SIZE; i++)
+		free(atomic_load_explicit(&task->cap_info->table[i],
+		    memory_order_relaxed));
 	ra_arena_destroy(task->cap_info->handles);
 	free(task->cap_info);
 }
@@ -214,6 +219,27 @@ bool caps_apply_to_kobject_type(task_t *task, kobject_type_t type,
 	return done;
 }
 
+/** Start modifying a capability
+ *
+ * Lockless readers which overlap with the modification will retry.
+ *
+ * @param cap  Capability to be modified.
+ */
+static void cap_write_begin(cap_t *cap)
+{
+	atomic_fetch_add_explicit(&cap->seq, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+/** Finish modifying a capability
+ *
+ * @param cap  Modified capability.
+ */
+static void cap_write_end(cap_t *cap)
+{
+	atomic_fetch_add_explicit(&cap->seq, 1, memory_order_release);
+}
+
 /** Initialize capability and associate it with its handle
  *
  * @param cap     Address of the capability.
@@ -222,11 +248,37 @@ bool caps_apply_to_kobject_type(task_t *task, kobject_type_t type,
  */
 static void cap_initialize(cap_t *cap, task_t *task, cap_handle_t handle)
 {
+	cap_write_begin(cap);
 	cap->state = CAP_STATE_FREE;
 	cap->task = task;
 	cap->handle = handle;
+	cap->kobject = NULL;
 	link_initialize(&cap->kobj_link);
 	link_initialize(&cap->type_link);
+	cap_write_end(cap);
+}
+
+/** Get the capability table slot of a capability handle
+ *
+ * @param task    Task whose capability table to search.
+ * @param handle  Capability handle.
+ *
+ * @return Table slot or NULL if the handle is out of range or the leaf
+ *         covering it has not been allocated.
+ */
+static _Atomic(cap_t *) *cap_slot(task_t *task, cap_handle_t handle)
+{
+	intptr_t raw = cap_handle_raw(handle);
+
+	if ((raw < CAPS_START) || (raw > CAPS_LAST))
+		return NULL;
+
+	cap_leaf_t *leaf = atomic_load_explicit(
+	    &task->cap_info->table[raw >> CAP_LEAF_BITS], memory_order_acquire);
+	if (!leaf)
+		return NULL;
+
+	return &leaf->caps[raw & (CAP_LEAF_SIZE - 1)];
 }
 
 /** Get capability using capability handle
@@ -242,13 +294,12 @@ static cap_t *cap_get(task_t *task, cap_handle_t handle, cap_state_t state)
 {
 	assert(mutex_locked(&task->cap_info->lock));
 
-	if ((cap_handle_raw(handle) < CAPS_START) ||
-	    (cap_handle_raw(handle) > CAPS_LAST))
+	_Atomic(cap_t *) *slot = cap_slot(task, handle);
+	if (!slot)
 		return NULL;
-	ht_link_t *link = hash_table_find(&task->cap_info->caps, &handle);
-	if (!link)
+	cap_t *cap = atomic_load_explicit(slot, memory_order_relaxed);
+	if (!cap)
 		return NULL;
-	cap_t *cap = hash_table_get_inst(link, cap_t, caps_link);
 	if (cap->state != state)
 		return NULL;
 	return cap;
@@ -276,10 +327,29 @@ errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 		mutex_unlock(&task->cap_info->lock);
 		return ENOMEM;
 	}
+	size_t dir = hbase >> CAP_LEAF_BITS;
+	if (!atomic_load_explicit(&task->cap_info->table[dir],
+	    memory_order_relaxed)) {
+		cap_leaf_t *leaf = malloc(sizeof(cap_leaf_t));
+		if (!leaf) {
+			ra_free(task->cap_info->handles, hbase, 1);
+			slab_free(cap_cache, cap);
+			mutex_unlock(&task->cap_info->lock);
+			return ENOMEM;
+		}
+		for (size_t i = 0; i < CAP_LEAF_SIZE; i++)
+			atomic_store_explicit(&leaf->caps[i], NULL,
+			    memory_order_relaxed);
+		atomic_store_explicit(&task->cap_info->table[dir], leaf,
+		    memory_order_release);
+	}
 	cap_initialize(cap, task, (cap_handle_t) hbase);
-	hash_table_insert(&task->cap_info->caps, &cap->caps_link);
 
+	cap_write_begin(cap);
 	cap->state = CAP_STATE_ALLOCATED;
+	cap_write_end(cap);
+	atomic_store_explicit(cap_slot(task, (cap_handle_t) hbase), cap,
+	    memory_order_release);
 	*handle = cap->handle;
 	mutex_unlock(&task->cap_info->lock);
 
@@ -303,9 +373,11 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 	mutex_lock(&task->cap_info->lock);
 	cap_t *cap = cap_get(task, handle, CAP_STATE_ALLOCATED);
 	assert(cap);
+	cap_write_begin(cap);
 	cap->state = CAP_STATE_PUBLISHED;
 	/* Hand over kobj's reference to cap */
 	cap->kobject = kobj;
+	cap_write_end(cap);
 	list_append(&cap->kobj_link, &kobj->caps_list);
 	list_append(&cap->type_link, &task->cap_info->type_list[kobj->type]);
 	mutex_unlock(&task->cap_info->lock);
@@ -314,10 +386,12 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 
 static void cap_unpublish_unsafe(cap_t *cap)
 {
+	cap_write_begin(cap);
 	cap->kobject = NULL;
+	cap->state = CAP_STATE_ALLOCATED;
+	cap_write_end(cap);
 	list_remove(&cap->kobj_link);
 	list_remove(&cap->type_link);
-	cap->state = CAP_STATE_ALLOCATED;
 }
 
 /** Unpublish published capability
@@ -401,7 +475,12 @@ void cap_free(task_t *task, cap_handle_t handle)
 
 	assert(cap);
 
-	hash_table_remove_item(&task->cap_info->caps, &cap->caps_link);
+	atomic_store_explicit(cap_slot(task, handle), NULL,
+	    memory_order_relaxed);
+	cap_write_begin(cap);
+	cap->state = CAP_STATE_FREE;
+	cap->task = NULL;
+	cap_write_end(cap);
 	ra_free(task->cap_info->handles, cap_handle_raw(handle), 1);
 	slab_free(cap_cache, cap);
 	mutex_unlock(&task->cap_info->lock);
@@ -434,6 +513,85 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw)
 	kobj->raw = raw;
 }
 
+/** Get new reference to kernel object unless it is being destroyed
+ *
+ * @param kobj  Kernel object, possibly already freed.
+ *
+ * @return True if a reference was taken.
+ */
+static bool kobject_tryget(kobject_t *kobj)
+{
+	size_t refcnt = atomic_load_explicit(&kobj->refcnt, memory_order_relaxed);
+
+	do {
+		if (refcnt == 0)
+			return false;
+	} while (!atomic_compare_exchange_weak_explicit(&kobj->refcnt, &refcnt,
+	    refcnt + 1, memory_order_acquire, memory_order_relaxed));
+
+	return true;
+}
+
+/** Get new reference to kernel object without taking the capability lock
+ *
+ * @param task    Task from which to get the reference.
+ * @param handle  Capability handle.
+ * @param type    Kernel object type.
+ * @param kobj    Place to store the kernel object or NULL if there is no
+ *                matching capability or kernel object.
+ *
+ * @return True if the lookup succeeded, false if it raced with a
+ *         modification of the capability.
+ */
+static bool kobject_get_lockless(task_t *task, cap_handle_t handle,
+    kobject_type_t type, kobject_t **kobj)
+{
+	*kobj = NULL;
+
+	_Atomic(cap_t *) *slot = cap_slot(task, handle);
+	if (!slot)
+		return true;
+	cap_t *cap = atomic_load_explicit(slot, memory_order_acquire);
+	if (!cap)
+		return true;
+
+	unsigned int seq = atomic_load_explicit(&cap->seq, memory_order_acquire);
+	if (seq & 1)
+		return false;
+
+	cap_state_t state = atomic_load_explicit(&cap->state,
+	    memory_order_relaxed);
+	task_t *owner = atomic_load_explicit(&cap->task, memory_order_relaxed);
+	cap_handle_t h = atomic_load_explicit(&cap->handle, memory_order_relaxed);
+	kobject_t *obj = atomic_load_explicit(&cap->kobject,
+	    memory_order_relaxed);
+
+	if ((state != CAP_STATE_PUBLISHED) || (owner != task) ||
+	    (h != handle) || (!obj)) {
+		atomic_thread_fence(memory_order_acquire);
+		return atomic_load_explicit(&cap->seq,
+		    memory_order_relaxed) == seq;
+	}
+
+	if (!kobject_tryget(obj))
+		return false;
+
+	atomic_thread_fence(memory_order_acquire);
+	if (atomic_load_explicit(&cap->seq, memory_order_relaxed) != seq) {
+		kobject_put(obj);
+		return false;
+	}
+
+	/* The capability was published with obj, which is alive now. */
+	if (obj->type != type) {
+		kobject_put(obj);
+		return true;
+	}
+
+	*kobj = obj;
+	return true;
+}
+
 /** Get new reference to kernel object from capability
  *
  * @param task    Task from which to get the reference.
@@ -449,6 +607,9 @@ kobject_get(struct task *task, cap_handle_t handle, kobject_type_t type)
 {
 	kobject_t *kobj = NULL;
 
+	if (kobject_get_lockless(task, handle, type, &kobj))
+		return kobj;
+
 	mutex_lock(&task->cap_info->lock);
 	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
 	if (cap) {
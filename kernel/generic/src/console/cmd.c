@@ -583,6 +583,17 @@ cmd_info_t cpus_info = {
 	.argv = NULL
 };
 
+#ifdef CONFIG_SPINLOCK_STATS
+/* Data and methods for 'locks' command. */
+static int cmd_locks(cmd_arg_t *argv);
+static cmd_info_t locks_info = {
+	.name = "locks",
+	.description = "List spinlock contention statistics.",
+	.func = cmd_locks,
+	.argc = 0
+};
+#endif
+
 /* Data and methods for 'version' command. */
 static int cmd_version(cmd_arg_t *argv);
 cmd_info_t version_info = {
@@ -608,6 +619,9 @@ static cmd_info_t *basic_commands[] = {
 	&help_info,
 	&ipc_info,
 	&kill_info,
+#ifdef CONFIG_SPINLOCK_STATS
+	&locks_info,
+#endif
 	&physmem_info,
 	&reboot_info,
 	&sched_info,
@@ -1354,6 +1368,20 @@ int cmd_cpus(cmd_arg_t *argv)
 	return 1;
 }
 
+#ifdef CONFIG_SPINLOCK_STATS
+/** Command for printing spinlock statistics
+ *
+ * @param argv Ignored
+ *
+ * @return Always 1
+ */
+int cmd_locks(cmd_arg_t *argv)
+{
+	spinlock_stats_print();
+	return 1;
+}
+#endif
+
 /** Command for printing kernel version.
  *
  * @param argv Ignored.
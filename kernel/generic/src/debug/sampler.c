@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Sampling profiler.
+ *
+ * On every clock tick, the sampler records where the interrupted thread
+ * was executing into a ring buffer private to the CPU. For kernel code, a
+ * short stack trace is recorded as well. User stacks are not walked, since
+ * that could fault on memory which is not resident and the clock interrupt
+ * must not sleep.
+ *
+ * The rings are exported as a snapshot through the "system.samples" sysinfo
+ * item. Readers tell new samples from the ones they have already seen using
+ * the per-CPU sequence numbers.
+ */
+
+#include <debug/sampler.h>
+#include <stacktrace.h>
+#include <interrupt.h>
+#include <config.h>
+#include <cpu.h>
+#include <proc/task.h>
+#include <proc/thread.h>
+#include <synch/spinlock.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/** Number of samples kept by each CPU */
+#define SAMPLER_RING_SIZE  512
+
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Number of samples taken so far */
+	uint64_t seq;
+
+	stats_sample_t samples[SAMPLER_RING_SIZE];
+} sampler_ring_t;
+
+/** Array of config.cpu_count rings */
+static sampler_ring_t *rings = NULL;
+
+/** Check that a frame lies within the kernel stack of THREAD.
+ *
+ * The interrupted code may be using the frame pointer register for
+ * something else, so anything outside of the stack must not be followed.
+ *
+ */
+static bool sampler_context_validate(stack_trace_context_t *ctx)
+{
+	uintptr_t base = (uintptr_t) THREAD->kstack;
+
+	if ((ctx->fp < base) || (ctx->fp >= base + STACK_SIZE) ||
+	    (ctx->fp % sizeof(uintptr_t) != 0))
+		return false;
+
+	return kernel_stack_trace_context_validate(ctx);
+}
+
+static stack_trace_ops_t sampler_ops = {
+	.stack_trace_context_validate = sampler_context_validate,
+	.frame_pointer_prev = kernel_frame_pointer_prev,
+	.return_address_get = kernel_return_address_get,
+	.symbol_resolve = NULL,
+};
+
+/** Allocate the per-CPU sample rings */
+void sampler_init(void)
+{
+	sampler_ring_t *new_rings =
+	    malloc(sizeof(sampler_ring_t) * config.cpu_count);
+	if (!new_rings) {
+		printf("Not enough memory for the sampling profiler.\n");
+		return;
+	}
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_initialize(&new_rings[i].lock, "sampler_ring_lock");
+		new_rings[i].seq = 0;
+	}
+
+	rings = new_rings;
+}
+
+/** Take a sample of the thread interrupted by the clock
+ *
+ * Called from clock() with interrupts disabled.
+ *
+ */
+void sampler_tick(void)
+{
+	istate_t *istate = CPU_LOCAL->istate;
+
+	/* Idle ticks are not interesting. */
+	if ((!rings) || (!THREAD) || (!istate))
+		return;
+
+	uintptr_t pcs[SAMPLE_STACK_DEPTH];
+	size_t depth = 0;
+	bool uspace = istate_from_uspace(istate);
+
+	if (!uspace) {
+		stack_trace_context_t ctx = {
+			.fp = istate_get_fp(istate),
+			.pc = istate_get_pc(istate),
+			.istate = istate
+		};
+
+		depth = stack_trace_collect(&sampler_ops, &ctx, pcs,
+		    SAMPLE_STACK_DEPTH);
+	}
+
+	if (depth == 0) {
+		pcs[0] = istate_get_pc(istate);
+		depth = 1;
+	}
+
+	sampler_ring_t *ring = &rings[CPU->id];
+
+	irq_spinlock_lock(&ring->lock, false);
+
+	stats_sample_t *sample = &ring->samples[ring->seq % SAMPLER_RING_SIZE];
+	sample->seq = ring->seq++;
+	sample->cpu = CPU->id;
+	sample->task_id = TASK->taskid;
+	sample->thread_id = THREAD->tid;
+	sample->uspace = uspace;
+	sample->depth = depth;
+
+	for (size_t i = 0; i < depth; i++)
+		sample->pcs[i] = pcs[i];
+
+	irq_spinlock_unlock(&ring->lock, false);
+}
+
+/** Copy out the samples currently held by all CPUs
+ *
+ * Samples of each CPU are stored from the oldest to the newest.
+ *
+ * @param samples Array to store the samples to. May be NULL.
+ * @param count   Capacity of @a samples.
+ *
+ * @return Number of samples held by all CPUs. This may be more than
+ *         @a count, in which case only the first @a count are stored.
+ *
+ */
+size_t sampler_snapshot(stats_sample_t *samples, size_t count)
+{
+	if (!rings)
+		return 0;
+
+	size_t total = 0;
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		sampler_ring_t *ring = &rings[i];
+
+		irq_spinlock_lock(&ring->lock, true);
+
+		size_t held = (ring->seq < SAMPLER_RING_SIZE) ?
+		    ring->seq : SAMPLER_RING_SIZE;
+		uint64_t first = ring->seq - held;
+
+		for (size_t j = 0; j < held; j++) {
+			if (total + j >= count)
+				break;
+
+			samples[total + j] =
+			    ring->samples[(first + j) % SAMPLER_RING_SIZE];
+		}
+
+		irq_spinlock_unlock(&ring->lock, true);
+
+		total += held;
+	}
+
+	return total;
+}
+
+/** @}
+ */
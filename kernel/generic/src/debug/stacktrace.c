@@ -97,6 +97,43 @@ void stack_trace_ctx(stack_trace_ops_t *ops, stack_trace_context_t *ctx)
 	}
 }
 
+/** Collect return addresses without resolving or printing them.
+ *
+ * Unlike stack_trace_ctx(), this neither prints nor takes any locks, so it
+ * can be used from interrupt context.
+ *
+ * @param ops   Stack trace operations.
+ * @param ctx   Stack trace context of the innermost frame.
+ * @param pcs   Array to store the program counters to, innermost first.
+ * @param count Capacity of @a pcs.
+ *
+ * @return Number of program counters stored in @a pcs.
+ *
+ */
+size_t stack_trace_collect(stack_trace_ops_t *ops, stack_trace_context_t *ctx,
+    uintptr_t *pcs, size_t count)
+{
+	size_t depth = 0;
+
+	uintptr_t fp;
+	uintptr_t pc;
+
+	while ((depth < count) && (ops->stack_trace_context_validate(ctx))) {
+		pcs[depth++] = ctx->pc;
+
+		if (!ops->return_address_get(ctx, &pc))
+			break;
+
+		if (!ops->frame_pointer_prev(ctx, &fp))
+			break;
+
+		ctx->fp = fp;
+		ctx->pc = pc;
+	}
+
+	return depth;
+}
+
 void stack_trace(void)
 {
 	stack_trace_context_t ctx = {
@@ -131,6 +131,16 @@ _NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 		THREAD->udebug.uspace_state = istate;
 #endif
 
+#ifdef CONFIG_SAMPLING_PROFILER
+	/*
+	 * Let the sampler see where the clock interrupt struck. Nested
+	 * exceptions overwrite this, so it is only valid until the handler
+	 * first blocks or yields.
+	 */
+	if (CPU)
+		CPU_LOCAL->istate = istate;
+#endif
+
 	exc_table[n].handler(n + IVT_FIRST, istate);
 
 #ifdef CONFIG_UDEBUG
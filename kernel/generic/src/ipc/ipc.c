@@ -61,6 +61,8 @@
 #include <ipc/irq.h>
 #include <cap/cap.h>
 #include <stdlib.h>
+#include <align.h>
+#include <macros.h>
 
 static void ipc_forget_call(call_t *);
 
@@ -86,6 +88,8 @@ static void _ipc_call_init(call_t *call)
 	call->sender = NULL;
 	call->callerbox = NULL;
 	call->buffer = NULL;
+	call->frames = NULL;
+	call->frames_count = 0;
 }
 
 static void call_destroy(void *arg)
@@ -94,6 +98,10 @@ static void call_destroy(void *arg)
 
 	if (call->buffer)
 		free(call->buffer);
+	if (call->frames) {
+		as_unpin_pages(call->frames, call->frames_count);
+		free(call->frames);
+	}
 	if (call->caller_phone)
 		kobject_put(call->caller_phone->kobject);
 	slab_free(call_cache, call);
@@ -132,6 +140,41 @@ call_t *ipc_call_alloc(void)
 	return call;
 }
 
+/** Pin the caller's buffer of a data transfer call.
+ *
+ * Must be called in the context of the caller. Once pinned, the buffer can
+ * be accessed from the context of the callee without an intermediate copy.
+ * The frames are released when the call is destroyed.
+ *
+ * @param call   Call which transfers the data.
+ * @param addr   Address of the caller's buffer.
+ * @param size   Size of the caller's buffer.
+ * @param access Access to the buffer needed by the transfer.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t ipc_call_pin(call_t *call, uspace_addr_t addr, size_t size,
+    pf_access_t access)
+{
+	assert(!call->frames);
+
+	size_t count = SIZE2FRAMES(addr + size - ALIGN_DOWN(addr, PAGE_SIZE));
+	uintptr_t *frames = malloc(count * sizeof(uintptr_t));
+	if (!frames)
+		return ENOMEM;
+
+	errno_t rc = as_pin_pages(addr, size, access, frames);
+	if (rc != EOK) {
+		free(frames);
+		return rc;
+	}
+
+	call->frames = frames;
+	call->frames_count = count;
+	return EOK;
+}
+
 /** Initialize an answerbox structure.
  *
  * @param box  Answerbox structure to be initialized.
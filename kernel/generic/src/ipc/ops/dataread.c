@@ -39,26 +39,46 @@
 #include <abi/errno.h>
 #include <syscall/copy.h>
 #include <config.h>
+#include <align.h>
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
+	uspace_addr_t dst = ipc_get_arg1(&call->data);
 	size_t size = ipc_get_arg2(&call->data);
+	int flags = ipc_get_arg3(&call->data);
 
-	if (size > DATA_XFER_LIMIT) {
-		int flags = ipc_get_arg3(&call->data);
-
-		if (flags & IPC_XF_RESTRICT)
-			ipc_set_arg2(&call->data, DATA_XFER_LIMIT);
-		else
+	if (size > DATA_XFER_LARGE_LIMIT) {
+		if (flags & IPC_XF_RESTRICT) {
+			size = DATA_XFER_LARGE_LIMIT;
+			ipc_set_arg2(&call->data, size);
+		} else
 			return ELIMIT;
 	}
 
-	return EOK;
+	if (size < DATA_XFER_DIRECT_MIN)
+		return EOK;
+
+	/*
+	 * Pin the destination buffer so that the recipient can copy the data
+	 * right into it.
+	 */
+	errno_t rc = ipc_call_pin(call, dst, size, PF_ACCESS_WRITE);
+	if ((rc == EOK) || (size <= DATA_XFER_LIMIT))
+		return EOK;
+
+	/* Only an intermediate buffer can be used for this buffer. */
+	if (flags & IPC_XF_RESTRICT) {
+		ipc_set_arg2(&call->data, DATA_XFER_LIMIT);
+		return EOK;
+	}
+
+	return rc;
 }
 
 static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 {
 	assert(!answer->buffer);
+	errno_t rc;
 
 	if (!ipc_get_retval(&answer->data)) {
 		/* The recipient agreed to send data. */
@@ -74,12 +94,20 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 			 */
 			ipc_set_arg1(&answer->data, dst);
 
+			if (answer->frames) {
+				rc = copy_from_uspace_to_frames(answer->frames,
+				    dst - ALIGN_DOWN(dst, PAGE_SIZE), src, size);
+				if (rc)
+					ipc_set_retval(&answer->data, rc);
+				return EOK;
+			}
+
 			answer->buffer = malloc(size);
 			if (!answer->buffer) {
 				ipc_set_retval(&answer->data, ENOMEM);
 				return EOK;
 			}
-			errno_t rc = copy_from_uspace(answer->buffer,
+			rc = copy_from_uspace(answer->buffer,
 			    src, size);
 			if (rc) {
 				ipc_set_retval(&answer->data, rc);
@@ -39,22 +39,41 @@
 #include <abi/errno.h>
 #include <syscall/copy.h>
 #include <config.h>
+#include <align.h>
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
 	uspace_addr_t src = ipc_get_arg1(&call->data);
 	size_t size = ipc_get_arg2(&call->data);
+	int flags = ipc_get_arg3(&call->data);
 
-	if (size > DATA_XFER_LIMIT) {
-		int flags = ipc_get_arg3(&call->data);
-
+	if (size > DATA_XFER_LARGE_LIMIT) {
 		if (flags & IPC_XF_RESTRICT) {
-			size = DATA_XFER_LIMIT;
+			size = DATA_XFER_LARGE_LIMIT;
 			ipc_set_arg2(&call->data, size);
 		} else
 			return ELIMIT;
 	}
 
+	if (size >= DATA_XFER_DIRECT_MIN) {
+		/*
+		 * Pin the source buffer so that the recipient can copy the
+		 * data right out of it.
+		 */
+		errno_t rc = ipc_call_pin(call, src, size, PF_ACCESS_READ);
+		if (rc == EOK)
+			return EOK;
+
+		/* Only an intermediate buffer can be used for this buffer. */
+		if (size > DATA_XFER_LIMIT) {
+			if (!(flags & IPC_XF_RESTRICT))
+				return rc;
+
+			size = DATA_XFER_LIMIT;
+			ipc_set_arg2(&call->data, size);
+		}
+	}
+
 	call->buffer = (uint8_t *) malloc(size);
 	if (!call->buffer)
 		return ENOMEM;
@@ -72,17 +91,25 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 
 static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 {
-	assert(answer->buffer);
+	assert(answer->buffer || answer->frames);
 
 	if (!ipc_get_retval(&answer->data)) {
 		/* The recipient agreed to receive data. */
 		uspace_addr_t dst = ipc_get_arg1(&answer->data);
 		size_t size = ipc_get_arg2(&answer->data);
+		uspace_addr_t src = ipc_get_arg1(olddata);
 		size_t max_size = ipc_get_arg2(olddata);
 
 		if (size <= max_size) {
-			errno_t rc = copy_to_uspace(dst,
-			    answer->buffer, size);
+			errno_t rc;
+
+			if (answer->frames) {
+				rc = copy_to_uspace_from_frames(dst,
+				    answer->frames,
+				    src - ALIGN_DOWN(src, PAGE_SIZE), size);
+			} else {
+				rc = copy_to_uspace(dst, answer->buffer, size);
+			}
 			if (rc)
 				ipc_set_retval(&answer->data, rc);
 		} else {
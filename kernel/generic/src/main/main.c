@@ -87,6 +87,7 @@
 #include <ipc/event.h>
 #include <sysinfo/sysinfo.h>
 #include <sysinfo/stats.h>
+#include <debug/sampler.h>
 #include <lib/ra.h>
 #include <cap/cap.h>
 
@@ -232,6 +233,7 @@ void main_bsp_separated_stack(void)
 
 	/* Slab must be initialized after we know the number of processors. */
 	slab_enable_cpucache();
+	frame_enable_cpucache();
 
 	uint64_t size;
 	const char *size_suffix;
@@ -266,6 +268,9 @@ void main_bsp_separated_stack(void)
 	kio_init();
 	log_init();
 	stats_init();
+#ifdef CONFIG_SAMPLING_PROFILER
+	sampler_init();
+#endif
 
 	/*
 	 * Create kernel task.
@@ -72,6 +72,7 @@
 #include <macros.h>
 #include <bitops.h>
 #include <arch.h>
+#include <cpu.h>
 #include <errno.h>
 #include <config.h>
 #include <align.h>
@@ -118,7 +119,7 @@ as_t *AS_KERNEL = NULL;
 static void *as_areas_getkey(odlink_t *);
 static int as_areas_cmp(void *, void *);
 
-static void used_space_initialize(used_space_t *);
+static void used_space_initialize(used_space_t *, as_t *);
 static void used_space_finalize(used_space_t *);
 static void *used_space_getkey(odlink_t *);
 static int used_space_cmp(void *, void *);
@@ -183,6 +184,8 @@ as_t *as_create(unsigned int flags)
 
 	refcount_init(&as->refcount);
 	as->cpu_refcount = 0;
+	atomic_store(&as->virt_pages, 0);
+	atomic_store(&as->used_pages, 0);
 
 #ifdef AS_PAGE_TABLE
 	as->genarch.page_table = page_table_create(flags);
@@ -261,6 +264,9 @@ retry:
 		area = as_area_first(as);
 	}
 
+	assert(atomic_load(&as->virt_pages) == 0);
+	assert(atomic_load(&as->used_pages) == 0);
+
 	odict_finalize(&as->as_areas);
 
 #ifdef AS_PAGE_TABLE
@@ -459,22 +465,50 @@ _NO_TRACE static bool check_area_conflicts(as_t *as, uintptr_t addr,
 	return true;
 }
 
+/** Move an address up so that an area there can be mapped by large pages
+ *
+ * @param addr  Candidate address of the area.
+ * @param size  Size of the area.
+ * @param phase Preferred offset of the area within a large page.
+ *
+ * @return The lowest address not smaller than @a addr with the preferred
+ *         offset, or @a addr if the area is too small to benefit.
+ *
+ */
+_NO_TRACE static uintptr_t as_large_page_align(uintptr_t addr, size_t size,
+    uintptr_t phase)
+{
+#ifdef LARGE_PAGE_SIZE
+	if (size >= LARGE_PAGE_SIZE) {
+		uintptr_t aligned = addr + ((phase - addr) & (LARGE_PAGE_SIZE - 1));
+		if (aligned >= addr)
+			return aligned;
+	}
+#endif
+
+	return addr;
+}
+
 /** Return pointer to unmapped address space area
  *
  * The address space must be already locked when calling
  * this function.
  *
+ * Areas big enough to be mapped by large pages are preferably placed
+ * at the offset @a phase within a large page.
+ *
  * @param as      Address space.
  * @param bound   Lowest address bound.
  * @param size    Requested size of the allocation.
  * @param guarded True if the allocation must be protected by guard pages.
+ * @param phase   Preferred offset of the area within a large page.
  *
  * @return Address of the beginning of unmapped address space area.
  * @return -1 if no suitable address space area was found.
  *
  */
 _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
-    size_t size, bool guarded)
+    size_t size, bool guarded, uintptr_t phase)
 {
 	assert(mutex_locked(&as->lock));
 
@@ -505,6 +539,11 @@ _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
 			addr += P2SZ(1);
 		}
 
+		uintptr_t large = as_large_page_align(addr, size, phase);
+		if ((large != addr) &&
+		    (check_area_conflicts(as, large, pages, guarded, NULL)))
+			return large;
+
 		if (check_area_conflicts(as, addr, pages, guarded, NULL))
 			return addr;
 	}
@@ -524,9 +563,15 @@ _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
 			addr += P2SZ(1);
 		}
 
-		bool avail =
-		    ((addr >= bound) && (addr >= area->base) &&
-		    (check_area_conflicts(as, addr, pages, guarded, area)));
+		bool avail = ((addr >= bound) && (addr >= area->base));
+		uintptr_t large = as_large_page_align(addr, size, phase);
+
+		if ((avail) && (large != addr) &&
+		    (check_area_conflicts(as, large, pages, guarded, area)))
+			addr = large;
+		else
+			avail = ((avail) &&
+			    (check_area_conflicts(as, addr, pages, guarded, area)));
 
 		mutex_unlock(&area->lock);
 
@@ -761,7 +806,15 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 	mutex_lock(&as->lock);
 
 	if (*base == (uintptr_t) AS_AREA_ANY) {
-		*base = as_get_unmapped_area(as, bound, size, guarded);
+		/*
+		 * Physical memory can only be mapped by large pages if it is
+		 * placed at the same offset within a large page.
+		 */
+		uintptr_t phase = 0;
+		if ((backend == &phys_backend) && (backend_data != NULL))
+			phase = backend_data->base;
+
+		*base = as_get_unmapped_area(as, bound, size, guarded, phase);
 		if (*base == (uintptr_t) -1) {
 			mutex_unlock(&as->lock);
 			return NULL;
@@ -843,8 +896,9 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 		}
 	}
 
-	used_space_initialize(&area->used_space);
+	used_space_initialize(&area->used_space, as);
 	odict_insert(&area->las_areas, &as->as_areas, NULL);
+	atomic_fetch_add_explicit(&as->virt_pages, pages, memory_order_relaxed);
 
 	mutex_unlock(&as->lock);
 
@@ -950,6 +1004,12 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 
 		page_table_lock(as, false);
 
+		/*
+		 * A large page straddling the new end of the area has to be
+		 * split before the TLB shootdown sequence starts.
+		 */
+		page_mapping_split(as, start_free);
+
 		/*
 		 * Start TLB shootdown sequence.
 		 */
@@ -1004,10 +1064,10 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 				used_space_remove_ival(ival);
 			}
 
-			for (; i < pcount; i++) {
+			for (size_t j = i; j < pcount; j++) {
 				pte_t pte;
 				bool found = page_mapping_find(as,
-				    ptr + P2SZ(i), false, &pte);
+				    ptr + P2SZ(j), false, &pte);
 
 				(void) found;
 				assert(found);
@@ -1017,13 +1077,13 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 				if ((area->backend) &&
 				    (area->backend->frame_free)) {
 					area->backend->frame_free(area,
-					    ptr + P2SZ(i),
+					    ptr + P2SZ(j),
 					    PTE_GET_FRAME(&pte));
 				}
-
-				page_mapping_remove(as, ptr + P2SZ(i));
 			}
 
+			page_mapping_remove_range(as, ptr + P2SZ(i),
+			    pcount - i);
 		}
 
 		/*
@@ -1071,6 +1131,13 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		}
 	}
 
+	if (pages > area->pages) {
+		atomic_fetch_add_explicit(&as->virt_pages, pages - area->pages,
+		    memory_order_relaxed);
+	} else {
+		atomic_fetch_sub_explicit(&as->virt_pages, area->pages - pages,
+		    memory_order_relaxed);
+	}
 	area->pages = pages;
 
 	mutex_unlock(&area->lock);
@@ -1130,10 +1197,9 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 				    ptr + P2SZ(size),
 				    PTE_GET_FRAME(&pte));
 			}
-
-			page_mapping_remove(as, ptr + P2SZ(size));
 		}
 
+		page_mapping_remove_range(as, ptr, ival->count);
 		used_space_remove_ival(ival);
 		ival = used_space_first(&area->used_space);
 	}
@@ -1163,6 +1229,8 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	 * Remove the empty area from address space.
 	 */
 	odict_remove(&area->las_areas);
+	atomic_fetch_sub_explicit(&as->virt_pages, area->pages,
+	    memory_order_relaxed);
 
 	free(area);
 
@@ -1429,11 +1497,11 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 			assert(PTE_PRESENT(&pte));
 
 			old_frame[frame_idx++] = PTE_GET_FRAME(&pte);
-
-			/* Remove old mapping */
-			page_mapping_remove(as, ptr + P2SZ(size));
 		}
 
+		/* Remove old mappings */
+		page_mapping_remove_range(as, ptr, ival->count);
+
 		ival = used_space_next(ival);
 	}
 
@@ -1584,6 +1652,8 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 	page_table_unlock(AS, false);
 	mutex_unlock(&area->lock);
 	mutex_unlock(&AS->lock);
+
+	atomic_inc(&CPU->page_faults);
 	return AS_PF_OK;
 
 page_fault:
@@ -1607,6 +1677,103 @@ page_fault:
 	return AS_PF_DEFER;
 }
 
+/** Pin pages backing a range of the current address space.
+ *
+ * Make the pages present, faulting them in if necessary, and take a
+ * reference to each of the backing frames so that they cannot be freed
+ * even if the range is unmapped in the meantime. The frames must be
+ * released by as_unpin_pages().
+ *
+ * @param address Start of the range.
+ * @param size    Size of the range.
+ * @param access  Access the pages must allow.
+ * @param frames  Array to receive the frames, one for each page touched by
+ *                the range.
+ *
+ * @return EOK on success.
+ * @return EFAULT if the range is not fully covered by address space areas
+ *         which allow the access and are backed by ordinary memory.
+ *
+ */
+errno_t as_pin_pages(uintptr_t address, size_t size, pf_access_t access,
+    uintptr_t *frames)
+{
+	uintptr_t page = ALIGN_DOWN(address, PAGE_SIZE);
+	size_t count = SIZE2FRAMES(address + size - page);
+	as_area_t *area = NULL;
+	errno_t rc = EOK;
+	size_t i;
+
+	mutex_lock(&AS->lock);
+
+	for (i = 0; i < count; i++, page += PAGE_SIZE) {
+		if ((!area) || (page >= area->base + P2SZ(area->pages))) {
+			if (area)
+				mutex_unlock(&area->lock);
+
+			area = find_area_and_lock(AS, page);
+			if (!area) {
+				rc = EFAULT;
+				break;
+			}
+
+			if ((area->attributes & AS_AREA_ATTR_PARTIAL) ||
+			    (area->backend == &phys_backend) ||
+			    (!area->backend) || (!area->backend->page_fault) ||
+			    (!as_area_check_access(area, access))) {
+				rc = EFAULT;
+				break;
+			}
+		}
+
+		page_table_lock(AS, false);
+
+		pte_t pte;
+		bool found = page_mapping_find(AS, page, false, &pte);
+		if ((!found) || (!PTE_PRESENT(&pte)) ||
+		    ((access == PF_ACCESS_WRITE) && (!PTE_WRITABLE(&pte)))) {
+			if (area->backend->page_fault(area, page, access) !=
+			    AS_PF_OK) {
+				page_table_unlock(AS, false);
+				rc = EFAULT;
+				break;
+			}
+
+			found = page_mapping_find(AS, page, false, &pte);
+			assert(found && PTE_PRESENT(&pte));
+		}
+
+		frames[i] = PTE_GET_FRAME(&pte);
+		frame_reference_add(ADDR2PFN(frames[i]));
+
+		page_table_unlock(AS, false);
+	}
+
+	if (area)
+		mutex_unlock(&area->lock);
+	mutex_unlock(&AS->lock);
+
+	if (rc != EOK)
+		as_unpin_pages(frames, i);
+
+	return rc;
+}
+
+/** Release frames pinned by as_pin_pages().
+ *
+ * Pinning only added a reference to each frame and reserved no memory, so
+ * dropping the last reference must not release any reservation either.
+ *
+ * @param frames Pinned frames.
+ * @param count  Number of pinned frames.
+ *
+ */
+void as_unpin_pages(uintptr_t *frames, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		frame_free_noreserve(frames[i], 1);
+}
+
 /** Switch address spaces.
  *
  * Note that this function cannot sleep as it is essentially a part of
@@ -1851,11 +2018,13 @@ size_t as_area_get_size(uintptr_t base)
 /** Initialize used space map.
  *
  * @param used_space Used space map
+ * @param as         Address space containing the area of the map
  */
-static void used_space_initialize(used_space_t *used_space)
+static void used_space_initialize(used_space_t *used_space, as_t *as)
 {
 	odict_initialize(&used_space->ivals, used_space_getkey, used_space_cmp);
 	used_space->pages = 0;
+	used_space->as = as;
 }
 
 /** Finalize used space map.
@@ -2000,6 +2169,8 @@ static int used_space_cmp(void *a, void *b)
 static void used_space_remove_ival(used_space_ival_t *ival)
 {
 	ival->used_space->pages -= ival->count;
+	atomic_fetch_sub_explicit(&ival->used_space->as->used_pages, ival->count,
+	    memory_order_relaxed);
 	odict_remove(&ival->lused_space);
 	slab_free(used_space_ival_cache, ival);
 }
@@ -2015,6 +2186,8 @@ static void used_space_shorten_ival(used_space_ival_t *ival, size_t count)
 	assert(count < ival->count);
 
 	ival->used_space->pages -= ival->count - count;
+	atomic_fetch_sub_explicit(&ival->used_space->as->used_pages,
+	    ival->count - count, memory_order_relaxed);
 	ival->count = count;
 }
 
@@ -2065,9 +2238,13 @@ bool used_space_insert(used_space_t *used_space, uintptr_t page, size_t count)
 	adj_b = (b != NULL) && page + P2SZ(count) == b->page;
 
 	if (adj_a && adj_b) {
-		/* Fuse into a single interval */
+		/*
+		 * Fuse into a single interval. The pages of B stay in use,
+		 * so the page counts are not touched.
+		 */
 		a->count += count + b->count;
-		used_space_remove_ival(b);
+		odict_remove(&b->lused_space);
+		slab_free(used_space_ival_cache, b);
 	} else if (adj_a) {
 		/* Append to A */
 		a->count += count;
@@ -2088,6 +2265,8 @@ bool used_space_insert(used_space_t *used_space, uintptr_t page, size_t count)
 	}
 
 	used_space->pages += count;
+	atomic_fetch_add_explicit(&used_space->as->used_pages, count,
+	    memory_order_relaxed);
 	return true;
 }
 
@@ -170,6 +170,72 @@ bool anon_is_shareable(as_area_t *area)
 	return !(area->flags & AS_AREA_LATE_RESERVE);
 }
 
+#ifdef LARGE_PAGE_SIZE
+
+/** Try to service a page fault by mapping the whole large page around it.
+ *
+ * Only private areas covering the whole naturally aligned large page, none
+ * of whose pages is mapped yet, qualify. The large page is backed by a run
+ * of naturally aligned frames, so it fails whenever physical memory is too
+ * fragmented.
+ *
+ * The address space area, its share info and page tables must be already
+ * locked.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if the large page was mapped, false if the faulting page
+ *         needs to be mapped on its own.
+ */
+static bool anon_page_fault_large(as_area_t *area, uintptr_t upage)
+{
+	uintptr_t lpage = ALIGN_DOWN(upage, LARGE_PAGE_SIZE);
+
+	if ((lpage < area->base) ||
+	    (lpage + LARGE_PAGE_SIZE > area->base + P2SZ(area->pages)))
+		return false;
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space,
+	    lpage);
+	if ((ival != NULL) && (ival->page < lpage + LARGE_PAGE_SIZE))
+		return false;
+
+	if (area->flags & AS_AREA_LATE_RESERVE) {
+		if (!reserve_try_alloc(LARGE_PAGE_PAGES))
+			return false;
+	}
+
+	uintptr_t frame = frame_alloc(LARGE_PAGE_PAGES, FRAME_HIGHMEM |
+	    FRAME_ATOMIC | FRAME_NO_RECLAIM | FRAME_NO_RESERVE,
+	    LARGE_PAGE_SIZE - 1);
+	if (frame == 0) {
+		if (area->flags & AS_AREA_LATE_RESERVE)
+			reserve_free(LARGE_PAGE_PAGES);
+		return false;
+	}
+
+	for (size_t i = 0; i < LARGE_PAGE_PAGES; i++) {
+		uintptr_t kpage = km_temporary_frame_get(frame + P2SZ(i));
+		memsetb((void *) kpage, PAGE_SIZE, 0);
+		km_temporary_page_put(kpage);
+	}
+
+	if (!page_mapping_insert_large(AS, lpage, frame,
+	    as_area_get_flags(area))) {
+		frame_free_generic(frame, LARGE_PAGE_PAGES,
+		    (area->flags & AS_AREA_LATE_RESERVE) ? 0 : FRAME_NO_RESERVE);
+		return false;
+	}
+
+	if (!used_space_insert(&area->used_space, lpage, LARGE_PAGE_PAGES))
+		panic("Cannot insert used space.");
+
+	return true;
+}
+
+#endif /* LARGE_PAGE_SIZE */
+
 /** Service a page fault in the anonymous memory address space area.
  *
  * The address space area and page tables must be already locked.
@@ -236,6 +302,13 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		 *   the different causes
 		 */
 
+#ifdef LARGE_PAGE_SIZE
+		if (anon_page_fault_large(area, upage)) {
+			mutex_unlock(&area->sh_info->lock);
+			return AS_PF_OK;
+		}
+#endif
+
 		if (area->flags & AS_AREA_LATE_RESERVE) {
 			/*
 			 * Reserve the memory for this page now.
@@ -143,6 +143,32 @@ int phys_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	assert(upage - area->base < area->backend_data.frames * FRAME_SIZE);
+
+#ifdef LARGE_PAGE_SIZE
+	/*
+	 * Map the whole large page around upage at once if the area covers
+	 * it and the physical memory is aligned the same way. This is what
+	 * as_area_create() tries to arrange for big enough areas.
+	 */
+	uintptr_t lpage = ALIGN_DOWN(upage, LARGE_PAGE_SIZE);
+	if ((lpage >= area->base) && (lpage + LARGE_PAGE_SIZE <=
+	    area->base + FRAMES2SIZE(area->backend_data.frames)) &&
+	    IS_ALIGNED(base + (lpage - area->base), LARGE_PAGE_SIZE)) {
+		used_space_ival_t *ival =
+		    used_space_find_gteq(&area->used_space, lpage);
+
+		if (((ival == NULL) || (ival->page >= lpage + LARGE_PAGE_SIZE)) &&
+		    page_mapping_insert_large(AS, lpage,
+		    base + (lpage - area->base), as_area_get_flags(area))) {
+			if (!used_space_insert(&area->used_space, lpage,
+			    LARGE_PAGE_PAGES))
+				panic("Cannot insert used space.");
+
+			return AS_PF_OK;
+		}
+	}
+#endif
+
 	page_mapping_insert(AS, upage, base + (upage - area->base),
 	    as_area_get_flags(area));
 
@@ -39,6 +39,8 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <mm/frame.h>
+#include <mm/km.h>
+#include <mm/reserve.h>
 #include <abi/mm/as.h>
 #include <abi/ipc/methods.h>
 #include <ipc/sysipc.h>
@@ -46,8 +48,10 @@
 #include <typedefs.h>
 #include <align.h>
 #include <assert.h>
+#include <barrier.h>
 #include <errno.h>
 #include <log.h>
+#include <memw.h>
 #include <str.h>
 #include <str_error.h>
 
@@ -76,14 +80,37 @@ mem_backend_t user_backend = {
 	.destroy_shared_data = NULL
 };
 
+/** Create a user-paged address space area.
+ *
+ * Writable areas map private copies of the pages provided by the pager,
+ * so memory needs to be reserved for them.
+ *
+ * @param area Pointer to the address space area.
+ *
+ * @return True on success, false on failure.
+ */
 bool user_create(as_area_t *area)
 {
+	if (area->flags & AS_AREA_WRITE)
+		return reserve_try_alloc(area->pages);
+
 	return true;
 }
 
 void user_destroy(as_area_t *area)
 {
-	return;
+	if (area->flags & AS_AREA_WRITE)
+		reserve_free(area->pages);
+}
+
+/** Drop a reference to a frame provided by the pager.
+ *
+ * @param frame Frame to be released.
+ */
+static void user_pager_frame_put(uintptr_t frame)
+{
+	if (find_zone(ADDR2PFN(frame), 1, 0) != (size_t) -1)
+		frame_free(frame, 1);
 }
 
 bool user_is_resizable(as_area_t *area)
@@ -146,6 +173,34 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	 */
 
 	uintptr_t frame = ipc_get_arg1(&data);
+
+	if (area->flags & AS_AREA_WRITE) {
+		/*
+		 * The page provided by the pager may be mapped by other
+		 * tasks and by the pager itself. Copy it so that writes
+		 * to the area remain private.
+		 */
+		uintptr_t copy;
+		uintptr_t kpage = km_temporary_page_get(&copy,
+		    FRAME_NO_RESERVE);
+		uintptr_t src = km_temporary_frame_get(frame);
+
+		memcpy((void *) kpage, (void *) src, PAGE_SIZE);
+		km_temporary_page_put(src);
+
+		if (area->flags & AS_AREA_EXEC)
+			smc_coherence((void *) kpage, PAGE_SIZE);
+
+		km_temporary_page_put(kpage);
+		user_pager_frame_put(frame);
+		frame = copy;
+	} else if (area->flags & AS_AREA_EXEC) {
+		/* The pager has filled the page by ordinary stores. */
+		uintptr_t kpage = km_temporary_frame_get(frame);
+		smc_coherence((void *) kpage, PAGE_SIZE);
+		km_temporary_page_put(kpage);
+	}
+
 	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
 	if (!used_space_insert(&area->used_space, upage, 1))
 		panic("Cannot insert used space.");
@@ -157,7 +212,7 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
  *
  * The address space area and page tables must be already locked.
  *
- * @param area Ignored.
+ * @param area Pointer to the address space area.
  * @param page Virtual address of the page corresponding to the frame.
  * @param frame Frame to be released.
  */
@@ -166,13 +221,12 @@ void user_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame)
 	assert(page_table_locked(area->as));
 	assert(mutex_locked(&area->lock));
 
-	pfn_t pfn = ADDR2PFN(frame);
-	if (find_zone(pfn, 1, 0) != (size_t) -1) {
-		frame_free(frame, 1);
+	if (area->flags & AS_AREA_WRITE) {
+		/* Private copy, the area has reserved memory for it. */
+		frame_free_noreserve(frame, 1);
 	} else {
-		/* Nothing to do */
+		user_pager_frame_put(frame);
 	}
-
 }
 
 /** @}
@@ -60,6 +60,8 @@
 #include <macros.h>
 #include <config.h>
 #include <str.h>
+#include <stdlib.h>
+#include <cpu.h>
 #include <proc/thread.h> /* THREAD */
 
 zones_t zones = {
@@ -76,6 +78,25 @@ static CONDVAR_INITIALIZE(mem_avail_cv);
 static size_t mem_avail_req = 0;  /**< Number of frames requested. */
 static size_t mem_avail_gen = 0;  /**< Generation counter. */
 
+/*
+ * Per-CPU frame caches.
+ *
+ * Every CPU keeps stacks of free runs of 1, 2, ..., 2^(FRAME_CACHE_ORDERS - 1)
+ * frames in front of the zones, so that most small allocations and
+ * deallocations do not need to take the zones lock at all. The stacks are
+ * refilled from and drained to the zones in batches.
+ *
+ * Once the caches are enabled, the zone layout must not change, because
+ * the deallocation fast path looks up frames without the zones lock.
+ */
+static frame_cache_t *frame_cache = NULL;
+
+/** Number of frames held in all per-CPU frame caches. */
+static atomic_size_t frame_cache_total = 0;
+
+#define FRAME_CACHE_LOWMEM   0
+#define FRAME_CACHE_HIGHMEM  1
+
 /** Initialize frame structure.
  *
  * @param frame Frame structure to be initialized.
@@ -83,8 +104,11 @@ static size_t mem_avail_gen = 0;  /**< Generation counter. */
  */
 _NO_TRACE static void frame_initialize(frame_t *frame)
 {
-	frame->refcount = 0;
+	atomic_store(&frame->refcount, 0);
 	frame->parent = NULL;
+#ifdef CONFIG_FRAME_BUDDY
+	frame->buddy_free = false;
+#endif
 }
 
 /*
@@ -105,6 +129,8 @@ _NO_TRACE static void frame_initialize(frame_t *frame)
 _NO_TRACE static size_t zones_insert_zone(pfn_t base, size_t count,
     zone_flags_t flags)
 {
+	assert(frame_cache == NULL);
+
 	if (zones.count + 1 == ZONES_MAX) {
 		log(LF_OTHER, LVL_ERROR, "Maximum zone count %u exceeded!",
 		    ZONES_MAX);
@@ -166,7 +192,7 @@ _NO_TRACE static size_t frame_total_free_get_internal(void)
 	for (i = 0; i < zones.count; i++)
 		total += zones.info[i].free_count;
 
-	return total;
+	return total + atomic_load(&frame_cache_total);
 }
 
 _NO_TRACE size_t frame_total_free_get(void)
@@ -212,18 +238,286 @@ _NO_TRACE size_t find_zone(pfn_t frame, size_t count, size_t hint)
 	return (size_t) -1;
 }
 
+/** Return frame from zone. */
+_NO_TRACE static frame_t *zone_get_frame(zone_t *zone, size_t index)
+{
+	assert(index < zone->count);
+
+	return &zone->frames[index];
+}
+
+#ifdef CONFIG_FRAME_BUDDY
+
+/*
+ * Buddy free lists
+ *
+ * When the buddy allocator is configured, every available zone keeps
+ * doubly-linked lists of free blocks of 2^order frames in addition to its
+ * bitmap. Blocks are naturally aligned in the physical frame number space,
+ * not relative to the start of the zone, so that a block satisfies any
+ * alignment constraint up to its size. The bitmap remains authoritative and
+ * is used for merging zones and for statistics, while the free lists make
+ * finding a free block of a given size independent of the zone size.
+ *
+ * The lists are linked through frame indices rather than pointers so that
+ * zone_t structures can be freely copied around.
+ */
+
+#define BUDDY_NONE  ((size_t) -1)
+
+/** Insert a free block into the free list of its order.
+ *
+ * Blocks of high-priority memory are appended to the list so that they
+ * are used only when no low-priority memory is available.
+ *
+ */
+_NO_TRACE static void buddy_insert(zone_t *zone, size_t index,
+    unsigned int order)
+{
+	frame_t *frame = zone_get_frame(zone, index);
+
+	frame->buddy_order = order;
+	frame->buddy_free = true;
+
+	if (zone->base + index < FRAME_LOWPRIO) {
+		frame->buddy_next = BUDDY_NONE;
+		frame->buddy_prev = zone->buddy_tail[order];
+
+		if (frame->buddy_prev != BUDDY_NONE)
+			zone->frames[frame->buddy_prev].buddy_next = index;
+		else
+			zone->buddy_head[order] = index;
+
+		zone->buddy_tail[order] = index;
+	} else {
+		frame->buddy_prev = BUDDY_NONE;
+		frame->buddy_next = zone->buddy_head[order];
+
+		if (frame->buddy_next != BUDDY_NONE)
+			zone->frames[frame->buddy_next].buddy_prev = index;
+		else
+			zone->buddy_tail[order] = index;
+
+		zone->buddy_head[order] = index;
+	}
+
+	zone->buddy_blocks[order]++;
+}
+
+/** Remove a free block from the free list of its order. */
+_NO_TRACE static void buddy_remove(zone_t *zone, size_t index)
+{
+	frame_t *frame = zone_get_frame(zone, index);
+	unsigned int order = frame->buddy_order;
+
+	assert(frame->buddy_free);
+
+	if (frame->buddy_prev != BUDDY_NONE)
+		zone->frames[frame->buddy_prev].buddy_next = frame->buddy_next;
+	else
+		zone->buddy_head[order] = frame->buddy_next;
+
+	if (frame->buddy_next != BUDDY_NONE)
+		zone->frames[frame->buddy_next].buddy_prev = frame->buddy_prev;
+	else
+		zone->buddy_tail[order] = frame->buddy_prev;
+
+	frame->buddy_free = false;
+	zone->buddy_blocks[order]--;
+}
+
+/** Insert a range of free frames as maximal naturally aligned blocks. */
+_NO_TRACE static void buddy_insert_range(zone_t *zone, size_t index,
+    size_t count)
+{
+	while (count > 0) {
+		unsigned int order = 0;
+
+		while ((order + 1 < FRAME_ORDERS) &&
+		    (((zone->base + index) & (((pfn_t) 2 << order) - 1)) == 0) &&
+		    (((size_t) 2 << order) <= count))
+			order++;
+
+		buddy_insert(zone, index, order);
+
+		index += (size_t) 1 << order;
+		count -= (size_t) 1 << order;
+	}
+}
+
+/** Find the free block containing a frame.
+ *
+ * @param zone  Zone.
+ * @param index Frame index relative to zone.
+ * @param head  Place to store the index of the first frame of the block.
+ *
+ * @return True if the frame is in a free block.
+ *
+ */
+_NO_TRACE static bool buddy_find_block(zone_t *zone, size_t index,
+    size_t *head)
+{
+	pfn_t pfn = zone->base + index;
+
+	for (unsigned int order = 0; order < FRAME_ORDERS; order++) {
+		pfn_t first = pfn & ~(((pfn_t) 1 << order) - 1);
+		if (first < zone->base)
+			break;
+
+		frame_t *frame = zone_get_frame(zone, first - zone->base);
+		if ((frame->buddy_free) && (frame->buddy_order == order)) {
+			*head = first - zone->base;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Remove a range of free frames from the free lists.
+ *
+ * The parts of the affected blocks outside of the range
+ * are returned to the free lists.
+ *
+ */
+_NO_TRACE static void buddy_take_range(zone_t *zone, size_t index,
+    size_t count)
+{
+	while (count > 0) {
+		size_t head;
+		bool found = buddy_find_block(zone, index, &head);
+
+		(void) found;
+		assert(found);
+
+		size_t end = head +
+		    ((size_t) 1 << zone_get_frame(zone, head)->buddy_order);
+		size_t take = min(count, end - index);
+
+		buddy_remove(zone, head);
+		buddy_insert_range(zone, head, index - head);
+		buddy_insert_range(zone, index + take, end - index - take);
+
+		index += take;
+		count -= take;
+	}
+}
+
+/** Return a single frame to the free lists, coalescing it with its buddies. */
+_NO_TRACE static void buddy_free_frame(zone_t *zone, size_t index)
+{
+	pfn_t pfn = zone->base + index;
+	unsigned int order = 0;
+
+	while (order + 1 < FRAME_ORDERS) {
+		pfn_t buddy = pfn ^ ((pfn_t) 1 << order);
+
+		if ((buddy < zone->base) ||
+		    (buddy - zone->base + ((size_t) 1 << order) > zone->count))
+			break;
+
+		frame_t *frame = zone_get_frame(zone, buddy - zone->base);
+		if ((!frame->buddy_free) || (frame->buddy_order != order))
+			break;
+
+		buddy_remove(zone, buddy - zone->base);
+		pfn = min(pfn, buddy);
+		order++;
+	}
+
+	buddy_insert(zone, pfn - zone->base, order);
+}
+
+/** Find a free range in the free lists.
+ *
+ * The range is the beginning of the first free block of the smallest
+ * sufficient order. Without a constraint, this takes one look at each
+ * order. Every block is aligned to its size, so the first frame of a block
+ * has the fewest bits set of all its frames and is the only one that needs
+ * to be checked against the constraint. A range spanning several free
+ * blocks is never found.
+ *
+ * @param zone       Zone to search.
+ * @param count      Number of frames to find.
+ * @param constraint Indication of bits that cannot be set in the
+ *                   physical frame number of the first frame.
+ * @param index      Place to store the index of the first frame.
+ *
+ * @return True if a suitable range has been found.
+ *
+ */
+_NO_TRACE static bool buddy_find(zone_t *zone, size_t count,
+    pfn_t constraint, size_t *index)
+{
+	unsigned int order = fnzb(count);
+	if (((size_t) 1 << order) < count)
+		order++;
+
+	for (unsigned int cur = order; cur < FRAME_ORDERS; cur++) {
+		size_t head = zone->buddy_head[cur];
+
+		while ((head != BUDDY_NONE) &&
+		    (((zone->base + head) & constraint) != 0))
+			head = zone->frames[head].buddy_next;
+
+		if (head != BUDDY_NONE) {
+			*index = head;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Rebuild the free lists of a zone from its bitmap. */
+_NO_TRACE static void buddy_rebuild(zone_t *zone)
+{
+	for (unsigned int order = 0; order < FRAME_ORDERS; order++) {
+		zone->buddy_head[order] = BUDDY_NONE;
+		zone->buddy_tail[order] = BUDDY_NONE;
+		zone->buddy_blocks[order] = 0;
+	}
+
+	for (size_t i = 0; i < zone->count; i++)
+		zone->frames[i].buddy_free = false;
+
+	size_t i = 0;
+	while (i < zone->count) {
+		if (bitmap_get(&zone->bitmap, i)) {
+			i++;
+			continue;
+		}
+
+		size_t run = 1;
+		while ((i + run < zone->count) &&
+		    (!bitmap_get(&zone->bitmap, i + run)))
+			run++;
+
+		buddy_insert_range(zone, i, run);
+		i += run;
+	}
+}
+
+#endif /* CONFIG_FRAME_BUDDY */
+
 /** @return True if zone can allocate specified number of frames */
 _NO_TRACE static bool zone_can_alloc(zone_t *zone, size_t count,
     pfn_t constraint)
 {
+	if (!(zone->flags & ZONE_AVAILABLE))
+		return false;
+
+#ifdef CONFIG_FRAME_BUDDY
+	size_t index;
+	return buddy_find(zone, count, constraint, &index);
+#else
 	/*
 	 * The function bitmap_allocate_range() does not modify
 	 * the bitmap if the last argument is NULL.
 	 */
-
-	return ((zone->flags & ZONE_AVAILABLE) &&
-	    bitmap_allocate_range(&zone->bitmap, count, zone->base,
-	    FRAME_LOWPRIO, constraint, NULL));
+	return bitmap_allocate_range(&zone->bitmap, count, zone->base,
+	    FRAME_LOWPRIO, constraint, NULL);
+#endif
 }
 
 /** Find a zone that can allocate specified number of frames
@@ -347,14 +641,6 @@ _NO_TRACE static size_t find_free_zone(size_t count, zone_flags_t flags,
  * Zone functions
  */
 
-/** Return frame from zone. */
-_NO_TRACE static frame_t *zone_get_frame(zone_t *zone, size_t index)
-{
-	assert(index < zone->count);
-
-	return &zone->frames[index];
-}
-
 /** Allocate frame in particular zone.
  *
  * Assume zone is locked and is available for allocation.
@@ -376,8 +662,17 @@ _NO_TRACE static size_t zone_frame_alloc(zone_t *zone, size_t count,
 
 	/* Allocate frames from zone */
 	size_t index = (size_t) -1;
-	int avail = bitmap_allocate_range(&zone->bitmap, count, zone->base,
+
+#ifdef CONFIG_FRAME_BUDDY
+	bool avail = buddy_find(zone, count, constraint, &index);
+	if (avail) {
+		bitmap_set_range(&zone->bitmap, index, count);
+		buddy_take_range(zone, index, count);
+	}
+#else
+	bool avail = bitmap_allocate_range(&zone->bitmap, count, zone->base,
 	    FRAME_LOWPRIO, constraint, &index);
+#endif
 
 	(void) avail;
 	assert(avail);
@@ -387,8 +682,8 @@ _NO_TRACE static size_t zone_frame_alloc(zone_t *zone, size_t count,
 	for (size_t i = 0; i < count; i++) {
 		frame_t *frame = zone_get_frame(zone, index + i);
 
-		assert(frame->refcount == 0);
-		frame->refcount = 1;
+		assert(atomic_load(&frame->refcount) == 0);
+		atomic_store(&frame->refcount, 1);
 	}
 
 	/* Update zone information. */
@@ -413,12 +708,15 @@ _NO_TRACE static size_t zone_frame_free(zone_t *zone, size_t index)
 	assert(zone->flags & ZONE_AVAILABLE);
 
 	frame_t *frame = zone_get_frame(zone, index);
-	assert(frame->refcount > 0);
+	assert(atomic_load(&frame->refcount) > 0);
 
-	if (!--frame->refcount) {
+	if (atomic_predec(&frame->refcount) == 0) {
 		assert(zone->busy_count > 0);
 
 		bitmap_set(&zone->bitmap, index, 0);
+#ifdef CONFIG_FRAME_BUDDY
+		buddy_free_frame(zone, index);
+#endif
 
 		/* Update zone information. */
 		zone->free_count++;
@@ -436,15 +734,18 @@ _NO_TRACE static void zone_mark_unavailable(zone_t *zone, size_t index)
 	assert(zone->flags & ZONE_AVAILABLE);
 
 	frame_t *frame = zone_get_frame(zone, index);
-	assert(frame->refcount <= 1);
+	assert(atomic_load(&frame->refcount) <= 1);
 
-	if (frame->refcount > 0)
+	if (atomic_load(&frame->refcount) > 0)
 		return;
 
 	assert(zone->free_count > 0);
 
-	frame->refcount = 1;
+	atomic_store(&frame->refcount, 1);
 	bitmap_set_range(&zone->bitmap, index, 1);
+#ifdef CONFIG_FRAME_BUDDY
+	buddy_take_range(zone, index, 1);
+#endif
 
 	zone->free_count--;
 	reserve_force_alloc(1);
@@ -456,10 +757,13 @@ _NO_TRACE static void zone_mark_available(zone_t *zone, size_t index)
 	assert(zone->flags & ZONE_AVAILABLE);
 
 	frame_t *frame = zone_get_frame(zone, index);
-	assert(frame->refcount == 1);
+	assert(atomic_load(&frame->refcount) == 1);
 
-	frame->refcount = 0;
-	bitmap_set_range(&zone->bitmap, index, 0);
+	atomic_store(&frame->refcount, 0);
+	bitmap_clear_range(&zone->bitmap, index, 1);
+#ifdef CONFIG_FRAME_BUDDY
+	buddy_free_frame(zone, index);
+#endif
 
 	zone->free_count++;
 }
@@ -520,10 +824,16 @@ _NO_TRACE static void zone_merge_internal(size_t z1, size_t z2, zone_t *old_z1,
 	 * Mark the gap between the original zones as unavailable.
 	 */
 
-	for (size_t i = 0; i < gap; i++) {
+	for (size_t i = 0; i < gap; i++)
 		frame_initialize(&zones.info[z1].frames[old_z1->count + i]);
+
+#ifdef CONFIG_FRAME_BUDDY
+	/* The gap is free in the bitmap until marked below. */
+	buddy_rebuild(&zones.info[z1]);
+#endif
+
+	for (size_t i = 0; i < gap; i++)
 		zone_mark_unavailable(&zones.info[z1], old_z1->count + i);
-	}
 }
 
 /** Return old configuration frames into the zone.
@@ -576,6 +886,8 @@ bool zone_merge(size_t z1, size_t z2)
 	 * the zones have to be available and with the same
 	 * set of flags
 	 */
+	assert(frame_cache == NULL);
+
 	if ((z1 >= zones.count) || (z2 >= zones.count) || (z2 - z1 != 1) ||
 	    (zones.info[z1].flags != zones.info[z2].flags)) {
 		ret = false;
@@ -682,9 +994,21 @@ _NO_TRACE static void zone_construct(zone_t *zone, pfn_t start, size_t count,
 
 		for (size_t i = 0; i < count; i++)
 			frame_initialize(&zone->frames[i]);
+
+#ifdef CONFIG_FRAME_BUDDY
+		buddy_rebuild(zone);
+#endif
 	} else {
 		bitmap_initialize(&zone->bitmap, 0, NULL);
 		zone->frames = NULL;
+
+#ifdef CONFIG_FRAME_BUDDY
+		for (unsigned int order = 0; order < FRAME_ORDERS; order++) {
+			zone->buddy_head[order] = BUDDY_NONE;
+			zone->buddy_tail[order] = BUDDY_NONE;
+			zone->buddy_blocks[order] = 0;
+		}
+#endif
 	}
 }
 
@@ -813,6 +1137,380 @@ size_t zone_create(pfn_t start, size_t count, pfn_t confframe,
 	return znum;
 }
 
+/*
+ * Per-CPU frame cache functions
+ */
+
+/** Get the per-CPU frame cache order of a run of frames.
+ *
+ * @param count Number of frames in the run.
+ *
+ * @return Order of the run or FRAME_CACHE_ORDERS if runs of this
+ *         size are not cached.
+ *
+ */
+_NO_TRACE static unsigned int frame_cache_order(size_t count)
+{
+	if ((count == 0) || ((count & (count - 1)) != 0))
+		return FRAME_CACHE_ORDERS;
+
+	unsigned int order = fnzb(count);
+	if (order >= FRAME_CACHE_ORDERS)
+		return FRAME_CACHE_ORDERS;
+
+	return order;
+}
+
+/** Return a run of cached frames to its zone.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @param pfn   First frame of the run.
+ * @param count Number of frames in the run.
+ *
+ */
+_NO_TRACE static void zone_frame_release(pfn_t pfn, size_t count)
+{
+	size_t znum = find_zone(pfn, count, 0);
+	assert(znum != (size_t) -1);
+
+	zone_t *zone = &zones.info[znum];
+	size_t index = pfn - zone->base;
+
+	assert(zone->flags & ZONE_AVAILABLE);
+	assert(zone->busy_count >= count);
+
+	bitmap_clear_range(&zone->bitmap, index, count);
+#ifdef CONFIG_FRAME_BUDDY
+	for (size_t i = 0; i < count; i++)
+		buddy_free_frame(zone, index + i);
+#endif
+
+	/* Update zone information. */
+	zone->free_count += count;
+	zone->busy_count -= count;
+}
+
+/** Return runs from a per-CPU frame cache stack to the zones.
+ *
+ * The oldest runs are returned first, since the most recently
+ * freed runs are the most likely to be still cache-hot.
+ *
+ * Assume interrupts are disabled and the frame cache is locked.
+ *
+ * @param fc    Per-CPU frame cache.
+ * @param stack Stack to drain.
+ * @param order Order of the runs in the stack.
+ * @param runs  Maximum number of runs to return.
+ *
+ */
+_NO_TRACE static void frame_cache_drain(frame_cache_t *fc,
+    frame_cache_stack_t *stack, unsigned int order, size_t runs)
+{
+	runs = min(runs, stack->count);
+	if (runs == 0)
+		return;
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	for (size_t i = 0; i < runs; i++)
+		zone_frame_release(stack->pfn[i], 1 << order);
+
+	irq_spinlock_unlock(&zones.lock, false);
+
+	for (size_t i = runs; i < stack->count; i++)
+		stack->pfn[i - runs] = stack->pfn[i];
+
+	stack->count -= runs;
+	fc->frames -= runs << order;
+	fc->drains++;
+	atomic_fetch_sub(&frame_cache_total, runs << order);
+}
+
+/** Refill a per-CPU frame cache stack from the zones.
+ *
+ * Assume interrupts are disabled and the frame cache is locked.
+ *
+ * @param fc    Per-CPU frame cache.
+ * @param cls   Class of the stack (low or high memory).
+ * @param order Order of the runs in the stack.
+ *
+ */
+_NO_TRACE static void frame_cache_refill(frame_cache_t *fc, unsigned int cls,
+    unsigned int order)
+{
+	frame_cache_stack_t *stack = &fc->stack[cls][order];
+	size_t count = 1 << order;
+	zone_flags_t flags = ZONE_AVAILABLE |
+	    ((cls == FRAME_CACHE_HIGHMEM) ? ZONE_HIGHMEM : ZONE_LOWMEM);
+	size_t hint = 0;
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	while (stack->count < FRAME_CACHE_BATCH) {
+		size_t znum = find_free_zone(count, flags, 0, hint);
+		if (znum == (size_t) -1)
+			break;
+
+		zone_t *zone = &zones.info[znum];
+		size_t index = zone_frame_alloc(zone, count, 0);
+
+		/* Cached frames are not referenced by anyone. */
+		for (size_t i = 0; i < count; i++)
+			atomic_store(&zone_get_frame(zone, index + i)->refcount, 0);
+
+		stack->pfn[stack->count++] = zone->base + index;
+		fc->frames += count;
+		atomic_fetch_add(&frame_cache_total, count);
+
+		hint = znum;
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+}
+
+/** Put a run of free frames into a per-CPU frame cache.
+ *
+ * Assume interrupts are disabled and the frame cache is locked.
+ *
+ * @param fc    Per-CPU frame cache.
+ * @param znum  Zone containing the whole run.
+ * @param order Order of the run.
+ * @param pfn   First frame of the run.
+ *
+ */
+_NO_TRACE static void frame_cache_push(frame_cache_t *fc, size_t znum,
+    unsigned int order, pfn_t pfn)
+{
+	unsigned int cls = (zones.info[znum].flags & ZONE_HIGHMEM) ?
+	    FRAME_CACHE_HIGHMEM : FRAME_CACHE_LOWMEM;
+	frame_cache_stack_t *stack = &fc->stack[cls][order];
+
+	if (stack->count == FRAME_CACHE_SIZE)
+		frame_cache_drain(fc, stack, order, FRAME_CACHE_BATCH);
+
+	stack->pfn[stack->count++] = pfn;
+	fc->frames += 1 << order;
+	atomic_fetch_add(&frame_cache_total, 1 << order);
+}
+
+/** Allocate a run of frames from the current CPU's frame cache.
+ *
+ * Assume interrupts are disabled.
+ *
+ * @param order  Order of the run.
+ * @param lowmem Allocate only from low memory.
+ * @param pzone  If not NULL, receives the zone of the run.
+ *
+ * @return First frame of the allocated run.
+ * @return Zero if the cache is empty and cannot be refilled.
+ *
+ */
+_NO_TRACE static pfn_t frame_cache_alloc(unsigned int order, bool lowmem,
+    size_t *pzone)
+{
+	frame_cache_t *fc = &frame_cache[CPU->id];
+	size_t count = 1 << order;
+	pfn_t pfn = 0;
+
+	irq_spinlock_lock(&fc->lock, false);
+
+	/*
+	 * High memory requests fall back to low memory,
+	 * but never the other way around.
+	 */
+	unsigned int cls = lowmem ? FRAME_CACHE_LOWMEM : FRAME_CACHE_HIGHMEM;
+	while (true) {
+		frame_cache_stack_t *stack = &fc->stack[cls][order];
+
+		if (stack->count > 0) {
+			fc->hits++;
+		} else {
+			fc->misses++;
+			frame_cache_refill(fc, cls, order);
+		}
+
+		if (stack->count > 0) {
+			pfn = stack->pfn[--stack->count];
+			fc->frames -= count;
+			atomic_fetch_sub(&frame_cache_total, count);
+			break;
+		}
+
+		if (cls == FRAME_CACHE_LOWMEM)
+			break;
+
+		cls = FRAME_CACHE_LOWMEM;
+	}
+
+	irq_spinlock_unlock(&fc->lock, false);
+
+	if (pfn == 0)
+		return 0;
+
+	size_t znum = find_zone(pfn, count, 0);
+	assert(znum != (size_t) -1);
+
+	for (size_t i = 0; i < count; i++) {
+		frame_t *frame = zone_get_frame(&zones.info[znum],
+		    pfn + i - zones.info[znum].base);
+
+		assert(atomic_load(&frame->refcount) == 0);
+		atomic_store(&frame->refcount, 1);
+	}
+
+	if (pzone)
+		*pzone = znum;
+
+	return pfn;
+}
+
+/** Free a run of frames into the current CPU's frame cache.
+ *
+ * Assume interrupts are disabled.
+ *
+ * @param pfn   First frame of the run.
+ * @param order Order of the run.
+ *
+ * @return Number of frames whose reference count dropped to zero.
+ *
+ */
+_NO_TRACE static size_t frame_cache_free(pfn_t pfn, unsigned int order)
+{
+	frame_cache_t *fc = &frame_cache[CPU->id];
+	size_t count = 1 << order;
+	unsigned int released = 0;
+	size_t freed = 0;
+	size_t hint = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t znum = find_zone(pfn + i, 1, hint);
+		assert(znum != (size_t) -1);
+
+		frame_t *frame = zone_get_frame(&zones.info[znum],
+		    pfn + i - zones.info[znum].base);
+		assert(atomic_load(&frame->refcount) > 0);
+
+		if (atomic_predec(&frame->refcount) == 0) {
+			released |= 1 << i;
+			freed++;
+		}
+
+		hint = znum;
+	}
+
+	if (freed == 0)
+		return 0;
+
+	irq_spinlock_lock(&fc->lock, false);
+
+	size_t znum = find_zone(pfn, count, hint);
+	if ((freed == count) && (znum != (size_t) -1)) {
+		frame_cache_push(fc, znum, order, pfn);
+	} else {
+		/* Cache the released frames one by one. */
+		for (size_t i = 0; i < count; i++) {
+			if (!(released & (1 << i)))
+				continue;
+
+			znum = find_zone(pfn + i, 1, hint);
+			frame_cache_push(fc, znum, 0, pfn + i);
+		}
+	}
+
+	irq_spinlock_unlock(&fc->lock, false);
+
+	return freed;
+}
+
+/** Return all frames held in per-CPU frame caches to the zones. */
+_NO_TRACE static void frame_cache_drain_all(void)
+{
+	if (frame_cache == NULL)
+		return;
+
+	for (unsigned int cpu = 0; cpu < config.cpu_count; cpu++) {
+		frame_cache_t *fc = &frame_cache[cpu];
+
+		irq_spinlock_lock(&fc->lock, true);
+
+		for (unsigned int cls = 0; cls < FRAME_CACHE_CLASSES; cls++) {
+			for (unsigned int order = 0; order < FRAME_CACHE_ORDERS;
+			    order++) {
+				frame_cache_drain(fc, &fc->stack[cls][order],
+				    order, FRAME_CACHE_SIZE);
+			}
+		}
+
+		irq_spinlock_unlock(&fc->lock, true);
+	}
+}
+
+/** Enable per-CPU frame caches.
+ *
+ * Must be called after the number of processors is known
+ * and after all zones have been created and merged.
+ *
+ */
+void frame_enable_cpucache(void)
+{
+	frame_cache_t *fc = malloc(sizeof(frame_cache_t) * config.cpu_count);
+	if (!fc)
+		panic("Cannot allocate per-CPU frame caches.");
+
+	for (unsigned int cpu = 0; cpu < config.cpu_count; cpu++) {
+		irq_spinlock_initialize(&fc[cpu].lock, "frame.cache.lock");
+
+		for (unsigned int cls = 0; cls < FRAME_CACHE_CLASSES; cls++) {
+			for (unsigned int order = 0; order < FRAME_CACHE_ORDERS;
+			    order++)
+				fc[cpu].stack[cls][order].count = 0;
+		}
+
+		fc[cpu].frames = 0;
+		fc[cpu].hits = 0;
+		fc[cpu].misses = 0;
+		fc[cpu].drains = 0;
+	}
+
+	frame_cache = fc;
+}
+
+/** Get statistics of a per-CPU frame cache.
+ *
+ * @param cpu    CPU number.
+ * @param hits   Place to store the number of cache hits.
+ * @param misses Place to store the number of cache misses.
+ * @param drains Place to store the number of drained batches.
+ * @param frames Place to store the number of cached frames.
+ *
+ */
+void frame_cache_stats(unsigned int cpu, uint64_t *hits, uint64_t *misses,
+    uint64_t *drains, uint64_t *frames)
+{
+	assert(cpu < config.cpu_count);
+
+	if (frame_cache == NULL) {
+		*hits = 0;
+		*misses = 0;
+		*drains = 0;
+		*frames = 0;
+		return;
+	}
+
+	frame_cache_t *fc = &frame_cache[cpu];
+
+	irq_spinlock_lock(&fc->lock, true);
+
+	*hits = fc->hits;
+	*misses = fc->misses;
+	*drains = fc->drains;
+	*frames = fc->frames;
+
+	irq_spinlock_unlock(&fc->lock, true);
+}
+
 /*
  * Frame functions
  */
@@ -887,17 +1585,44 @@ uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_force_alloc(count);
 
-loop:
-	irq_spinlock_lock(&zones.lock, true);
-
 	// TODO: Print diagnostic if neither is explicitly specified.
 	bool lowmem = (flags & FRAME_LOWMEM) || !(flags & FRAME_HIGHMEM);
 
+	/*
+	 * Try the per-CPU frame cache first.
+	 */
+	unsigned int order = frame_cache_order(count);
+	if ((order < FRAME_CACHE_ORDERS) && (frame_constraint == 0)) {
+		pfn_t pfn = 0;
+
+		ipl_t ipl = interrupts_disable();
+		if ((frame_cache != NULL) && (CPU != NULL))
+			pfn = frame_cache_alloc(order, lowmem, pzone);
+		interrupts_restore(ipl);
+
+		if (pfn != 0)
+			return PFN2ADDR(pfn);
+	}
+
+loop:
+	irq_spinlock_lock(&zones.lock, true);
+
 	/*
 	 * First, find suitable frame zone.
 	 */
 	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint);
 
+	/*
+	 * If no memory, return frames held in per-CPU caches.
+	 */
+	if ((znum == (size_t) -1) && (frame_cache != NULL)) {
+		irq_spinlock_unlock(&zones.lock, true);
+		frame_cache_drain_all();
+		irq_spinlock_lock(&zones.lock, true);
+
+		znum = try_find_zone(count, lowmem, frame_constraint, hint);
+	}
+
 	/*
 	 * If no memory, reclaim some slab memory,
 	 * if it does not help, reclaim all.
@@ -1004,22 +1729,40 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 {
 	size_t freed = 0;
 
-	irq_spinlock_lock(&zones.lock, true);
-
-	for (size_t i = 0; i < count; i++) {
-		/*
-		 * First, find host frame zone for addr.
-		 */
-		pfn_t pfn = ADDR2PFN(start) + i;
-		size_t znum = find_zone(pfn, 1, 0);
+	/*
+	 * Small runs go to the per-CPU frame cache.
+	 */
+	unsigned int order = frame_cache_order(count);
+	bool cached = false;
 
-		assert(znum != (size_t) -1);
+	ipl_t ipl = interrupts_disable();
 
-		freed += zone_frame_free(&zones.info[znum],
-		    pfn - zones.info[znum].base);
+	if ((order < FRAME_CACHE_ORDERS) && (frame_cache != NULL) &&
+	    (CPU != NULL)) {
+		freed = frame_cache_free(ADDR2PFN(start), order);
+		cached = true;
 	}
 
-	irq_spinlock_unlock(&zones.lock, true);
+	interrupts_restore(ipl);
+
+	if (!cached) {
+		irq_spinlock_lock(&zones.lock, true);
+
+		for (size_t i = 0; i < count; i++) {
+			/*
+			 * First, find host frame zone for addr.
+			 */
+			pfn_t pfn = ADDR2PFN(start) + i;
+			size_t znum = find_zone(pfn, 1, 0);
+
+			assert(znum != (size_t) -1);
+
+			freed += zone_frame_free(&zones.info[znum],
+			    pfn - zones.info[znum].base);
+		}
+
+		irq_spinlock_unlock(&zones.lock, true);
+	}
 
 	/* Signal that some memory has been freed. */
 
@@ -1069,7 +1812,7 @@ _NO_TRACE void frame_reference_add(pfn_t pfn)
 
 	assert(znum != (size_t) -1);
 
-	zones.info[znum].frames[pfn - zones.info[znum].base].refcount++;
+	atomic_inc(&zones.info[znum].frames[pfn - zones.info[znum].base].refcount);
 
 	irq_spinlock_unlock(&zones.lock, true);
 }
@@ -1204,6 +1947,65 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 	}
 
 	irq_spinlock_unlock(&zones.lock, true);
+
+	/*
+	 * Frames held in per-CPU caches are accounted as busy in their
+	 * zones, but they are available for allocation.
+	 */
+	uint64_t cached = (uint64_t) FRAMES2SIZE(atomic_load(&frame_cache_total));
+	cached = min(cached, *busy);
+
+	*busy -= cached;
+	*free += cached;
+}
+
+/** Gather fragmentation statistics of a zone.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @param zone   Available zone.
+ * @param blocks Array of FRAME_ORDERS counters which receives the number
+ *               of free blocks of each order. Without the buddy allocator,
+ *               a free run of n frames is counted in order floor(log2(n)).
+ *
+ * @return Number of frames in the largest free block.
+ *
+ */
+_NO_TRACE static size_t zone_fragmentation(zone_t *zone, size_t *blocks)
+{
+	size_t largest = 0;
+
+#ifdef CONFIG_FRAME_BUDDY
+	for (unsigned int order = 0; order < FRAME_ORDERS; order++) {
+		blocks[order] = zone->buddy_blocks[order];
+
+		if (blocks[order] > 0)
+			largest = (size_t) 1 << order;
+	}
+#else
+	for (unsigned int order = 0; order < FRAME_ORDERS; order++)
+		blocks[order] = 0;
+
+	size_t i = 0;
+	while (i < zone->count) {
+		if (bitmap_get(&zone->bitmap, i)) {
+			i++;
+			continue;
+		}
+
+		size_t run = 1;
+		while ((i + run < zone->count) &&
+		    (!bitmap_get(&zone->bitmap, i + run)))
+			run++;
+
+		blocks[min(fnzb(run), FRAME_ORDERS - 1)]++;
+		largest = max(largest, run);
+		i += run;
+	}
+#endif
+
+	return largest;
 }
 
 /** Prints list of zones.
@@ -1325,6 +2127,51 @@ void zones_print_list(void)
 	    false);
 	printf("Available high priority: %zu frames (%" PRIu64 " %s)\n",
 	    free_highprio, size, size_suffix);
+
+	size_t cached = atomic_load(&frame_cache_total);
+	bin_order_suffix(FRAMES2SIZE(cached), &size, &size_suffix, false);
+	printf("Cached in CPUs:          %zu frames (%" PRIu64 " %s)\n",
+	    cached, size, size_suffix);
+
+	/*
+	 * Fragmentation report: the largest free block, the share of free
+	 * memory outside of the largest free block and the number of free
+	 * blocks of each order (order:count).
+	 */
+	printf("\n[nr] [largest free] [frag] [free blocks]\n");
+
+	for (size_t i = 0; ; i++) {
+		size_t blocks[FRAME_ORDERS];
+
+		irq_spinlock_lock(&zones.lock, true);
+
+		if (i >= zones.count) {
+			irq_spinlock_unlock(&zones.lock, true);
+			break;
+		}
+
+		if (!(zones.info[i].flags & ZONE_AVAILABLE)) {
+			irq_spinlock_unlock(&zones.lock, true);
+			continue;
+		}
+
+		size_t free_count = zones.info[i].free_count;
+		size_t largest = zone_fragmentation(&zones.info[i], blocks);
+
+		irq_spinlock_unlock(&zones.lock, true);
+
+		unsigned int frag = (free_count > largest) ?
+		    (unsigned int) (100 - (largest * 100) / free_count) : 0;
+
+		printf("%-4zu %14zu %5u%% ", i, largest, frag);
+
+		for (unsigned int order = 0; order < FRAME_ORDERS; order++) {
+			if (blocks[order] > 0)
+				printf(" %u:%zu", order, blocks[order]);
+		}
+
+		printf("\n");
+	}
 }
 
 /** Prints zone details.
@@ -269,6 +269,26 @@ uintptr_t km_temporary_page_get(uintptr_t *framep, frame_flags_t flags)
 	return page;
 }
 
+/** Create a temporary page mapping an existing frame.
+ *
+ * The page must be returned back to the system by a call to
+ * km_temporary_page_put().
+ *
+ * @param[in] frame	Physical address of the frame to map.
+ * @return		Virtual address of the frame.
+ */
+uintptr_t km_temporary_frame_get(uintptr_t frame)
+{
+	assert(THREAD);
+
+	if (frame >= config.identity_size) {
+		return km_map(frame, PAGE_SIZE, PAGE_SIZE,
+		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+	}
+
+	return PA2KA(frame);
+}
+
 /** Destroy a temporary page.
  *
  * This function destroys a temporary page previously created by
@@ -69,6 +69,7 @@
 #include <typedefs.h>
 #include <arch/asm.h>
 #include <arch.h>
+#include <cpu.h>
 #include <assert.h>
 #include <syscall/copy.h>
 #include <errno.h>
@@ -109,6 +110,40 @@ _NO_TRACE void page_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	memory_barrier();
 }
 
+/** Insert mapping of a large page to a run of frames.
+ *
+ * Both @a page and @a frame must be aligned to LARGE_PAGE_SIZE and no page
+ * of the large page may be mapped yet.
+ *
+ * @param as    Address space to which page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first of the frames to which the
+ *              mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return True if the large page was mapped, false if large pages are not
+ *         supported and the pages need to be mapped one by one.
+ *
+ */
+_NO_TRACE bool page_mapping_insert_large(as_t *as, uintptr_t page,
+    uintptr_t frame, unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_insert_large)
+		return false;
+
+	page_mapping_operations->mapping_insert_large(as, page, frame, flags);
+
+	/* Repel prefetched accesses to the old mapping. */
+	memory_barrier();
+
+	atomic_inc(&CPU->large_pages);
+	return true;
+}
+
 /** Remove mapping of page.
  *
  * Remove any mapping of page within address space as.
@@ -133,6 +168,69 @@ _NO_TRACE void page_mapping_remove(as_t *as, uintptr_t page)
 	memory_barrier();
 }
 
+/** Remove mappings of a run of pages.
+ *
+ * A large page lying wholly within the run is unmapped by a single page
+ * table update. A large page straddling either end of the run must have
+ * been split by page_mapping_split() before the TLB shootdown sequence
+ * started. TLB shootdown should follow in order to make effects of this
+ * call visible.
+ *
+ * @param as    Address space to which the pages belong.
+ * @param page  Virtual address of the first page to be demapped.
+ * @param count Number of pages to be demapped.
+ *
+ */
+_NO_TRACE void page_mapping_remove_range(as_t *as, uintptr_t page,
+    size_t count)
+{
+	assert(page_table_locked(as));
+	assert(IS_ALIGNED(page, PAGE_SIZE));
+
+	assert(page_mapping_operations);
+	assert(page_mapping_operations->mapping_remove);
+
+	for (size_t i = 0; i < count; i++) {
+		uintptr_t addr = page + P2SZ(i);
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+		if ((page_mapping_operations->mapping_remove_large) &&
+		    (IS_ALIGNED(addr, LARGE_PAGE_SIZE)) &&
+		    (count - i >= LARGE_PAGE_PAGES) &&
+		    (page_mapping_operations->mapping_remove_large(as, addr))) {
+			i += LARGE_PAGE_PAGES - 1;
+			continue;
+		}
+#endif
+
+		page_mapping_operations->mapping_remove(as, addr);
+	}
+
+	/* Repel prefetched accesses to the old mapping. */
+	memory_barrier();
+}
+
+/** Split a large page straddling a page boundary.
+ *
+ * Afterwards, the pages on either side of @a page can be unmapped
+ * separately. This may allocate memory and performs its own TLB
+ * shootdown, so it must not be called within a TLB shootdown sequence.
+ *
+ * @param as   Address space to which the page belongs.
+ * @param page Virtual address of the boundary.
+ *
+ */
+_NO_TRACE void page_mapping_split(as_t *as, uintptr_t page)
+{
+	assert(page_table_locked(as));
+
+	assert(page_mapping_operations);
+
+	if (page_mapping_operations->mapping_split)
+		page_mapping_operations->mapping_split(as,
+		    ALIGN_DOWN(page, PAGE_SIZE));
+}
+
 /** Find mapping for virtual page.
  *
  * @param as       Address space to which page belongs.
@@ -254,7 +254,8 @@ _NO_TRACE static size_t slab_obj_destroy(slab_cache_t *cache, void *obj,
 	slab->available++;
 
 	/* Move it to correct list */
-	if (slab->available == cache->objects) {
+	if ((slab->available == cache->objects) &&
+	    !(cache->flags & SLAB_CACHE_TYPESAFE)) {
 		/* Free associated memory */
 		list_remove(&slab->link);
 		irq_spinlock_unlock(&cache->slablock, true);
@@ -36,7 +36,9 @@
  * @brief Scheduler and load balancing.
  *
  * This file contains the scheduler and kcpulb kernel thread which
- * performs load-balancing of per-CPU run queues.
+ * performs load-balancing of per-CPU run queues. In addition, a CPU
+ * which runs out of ready threads steals one from another CPU before
+ * going idle.
  */
 
 #include <assert.h>
@@ -47,6 +49,7 @@
 #include <mm/frame.h>
 #include <mm/page.h>
 #include <mm/as.h>
+#include <time/clock.h>
 #include <time/timeout.h>
 #include <time/delay.h>
 #include <arch/asm.h>
@@ -67,6 +70,11 @@
 
 atomic_size_t nrdy;  /**< Number of ready threads in the system. */
 
+#ifdef CONFIG_SMP
+static bool surplus_work(void);
+static bool steal_work(void);
+#endif
+
 #ifdef CONFIG_FPU_LAZY
 void scheduler_fpu_lazy_request(void)
 {
@@ -171,6 +179,18 @@ static thread_t *find_best_thread(int *rq_index)
 		if (thread != NULL)
 			return thread;
 
+#ifdef CONFIG_SMP
+		/*
+		 * Before going idle, try to take over a thread which is
+		 * waiting in another CPU's run queue.
+		 */
+		if (steal_work()) {
+			thread = try_find_thread(rq_index);
+			if (thread != NULL)
+				return thread;
+		}
+#endif
+
 		/*
 		 * For there was nothing to run, the CPU goes to sleep
 		 * until a hardware interrupt or an IPI comes.
@@ -178,6 +198,28 @@ static thread_t *find_best_thread(int *rq_index)
 		 */
 		CPU_LOCAL->idle = true;
 
+		/*
+		 * Stop the clock ticks if there is nothing to do until the
+		 * next timeout. A thread could have been made ready on this
+		 * CPU, or in surplus on another one, before the CPU became
+		 * tickless, in which case the CPU was not kicked.
+		 */
+		clock_idle_enter();
+		if (atomic_load(&CPU->nrdy) > 0) {
+			clock_idle_exit();
+			continue;
+		}
+
+#ifdef CONFIG_SMP
+		/*
+		 * Keep ticking while there is work to steal, so that it is
+		 * retried on the next tick. The surplus threads might not be
+		 * able to migrate, so do not retry right away.
+		 */
+		if (surplus_work())
+			clock_idle_exit();
+#endif
+
 		/*
 		 * Go to sleep with interrupts enabled.
 		 * Ideally, this should be atomic, but this is not guaranteed on
@@ -185,6 +227,8 @@ static thread_t *find_best_thread(int *rq_index)
 		 * a thread has just become available.
 		 */
 		cpu_interruptible_sleep();
+
+		clock_idle_exit();
 	}
 }
 
@@ -376,6 +420,18 @@ static void add_to_rq(thread_t *thread, cpu_t *cpu, int i)
 
 	atomic_inc(&nrdy);
 	atomic_inc(&cpu->nrdy);
+
+	/* Make sure the CPU notices the thread if its clock is suspended. */
+	clock_kick(cpu);
+
+#ifdef CONFIG_SMP
+	/*
+	 * The thread has to wait behind another one, so let an idle CPU
+	 * steal it even if its clock is suspended.
+	 */
+	if (atomic_load(&cpu->nrdy) > 1)
+		clock_kick_idle(cpu);
+#endif
 }
 
 /** Requeue a thread that was just preempted on this CPU.
@@ -680,6 +736,96 @@ static thread_t *steal_thread_from(cpu_t *old_cpu, int i)
 	return NULL;
 }
 
+/** Check whether another CPU has more ready threads than it can run.
+ *
+ * @return True if some other CPU has at least two ready threads.
+ *
+ */
+static bool surplus_work(void)
+{
+	if (atomic_load(&nrdy) < 2)
+		return false;
+
+	for (size_t i = 0; i < config.cpu_active; i++) {
+		cpu_t *cpu = &cpus[i];
+
+		if (cpu != CPU && cpu->active && atomic_load(&cpu->nrdy) > 1)
+			return true;
+	}
+
+	return false;
+}
+
+/** Steal a ready thread for an idle CPU.
+ *
+ * The victim is the CPU with the most ready threads. The kernel has no
+ * knowledge of the cache topology, so among equally loaded CPUs the one
+ * whose ID is closest to ours is preferred, as neighbouring IDs tend to
+ * share caches (e.g. SMT siblings and cores of one package). The highest
+ * priority thread that can migrate is taken, since it is going to run
+ * right away.
+ *
+ * The stolen thread is put on the local run queue.
+ *
+ * @return True if a thread was stolen.
+ *
+ */
+static bool steal_work(void)
+{
+	assert(interrupts_disabled());
+
+	/* Cheap check whether there is anything to steal at all. */
+	if (atomic_load(&nrdy) == 0)
+		return false;
+
+	cpu_t *victim = NULL;
+	size_t victim_rdy = 0;
+
+	for (size_t dist = 1; dist < config.cpu_active; dist++) {
+		/* Look at the lower and the higher neighbour at this distance. */
+		for (unsigned int side = 0; side < 2; side++) {
+			size_t id;
+
+			if (side == 0) {
+				if (CPU->id < dist)
+					continue;
+				id = CPU->id - dist;
+			} else {
+				id = CPU->id + dist;
+				if (id >= config.cpu_active)
+					continue;
+			}
+
+			cpu_t *cpu = &cpus[id];
+			if (!cpu->active)
+				continue;
+
+			/*
+			 * Scanning by increasing distance with a strict
+			 * comparison keeps the nearest of the equally loaded
+			 * CPUs.
+			 */
+			size_t rdy = atomic_load(&cpu->nrdy);
+			if (rdy > victim_rdy) {
+				victim = cpu;
+				victim_rdy = rdy;
+			}
+		}
+	}
+
+	if (victim == NULL)
+		return false;
+
+	for (int rq = 0; rq < RQ_COUNT; rq++) {
+		if (steal_thread_from(victim, rq) != NULL) {
+			atomic_inc(&CPU->steals);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /** Load balancing thread
  *
  * SMP load balancing thread, supervising thread supplies
@@ -737,7 +883,11 @@ not_satisfied:
 			if (atomic_load(&cpu->nrdy) <= average)
 				continue;
 
-			if (steal_thread_from(cpu, rq) && --count == 0)
+			if (steal_thread_from(cpu, rq) == NULL)
+				continue;
+
+			atomic_inc(&CPU->migrations);
+			if (--count == 0)
 				goto satisfied;
 		}
 	}
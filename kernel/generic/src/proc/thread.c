@@ -183,7 +183,7 @@ void thread_init(void)
 
 	atomic_store(&nrdy, 0);
 	thread_cache = slab_cache_create("thread_t", sizeof(thread_t), _Alignof(thread_t),
-	    thr_constructor, thr_destructor, 0);
+	    thr_constructor, thr_destructor, SLAB_CACHE_TYPESAFE);
 
 	odict_initialize(&threads, threads_getkey, threads_cmp);
 }
@@ -42,6 +42,15 @@
 #include <stdatomic.h>
 #include <synch/mutex.h>
 #include <synch/semaphore.h>
+#include <arch/asm.h>
+#include <config.h>
+#include <cpu.h>
+
+/**
+ * Maximum number of iterations a thread spins waiting for a running owner
+ * to release the mutex before going to sleep.
+ */
+#define MUTEX_SPIN_LIMIT  10000
 
 /** Initialize mutex.
  *
@@ -70,6 +79,64 @@ static inline void _set_owner(mutex_t *mtx, thread_t *owner)
 	atomic_store_explicit(&mtx->owner, owner, memory_order_relaxed);
 }
 
+#ifdef CONFIG_SMP
+
+/** Find out whether a mutex owner is running on another CPU.
+ *
+ * The thread_t slab cache is type-stable, so the owner can be examined even
+ * if it has exited in the meantime. A stale answer only affects whether
+ * the caller spins or sleeps.
+ */
+static inline bool _owner_running(thread_t *owner)
+{
+	return (atomic_load_explicit(&owner->state, memory_order_relaxed) ==
+	    Running) &&
+	    (atomic_load_explicit(&owner->cpu, memory_order_relaxed) != CPU);
+}
+
+/** Spin while the mutex owner is running on another CPU.
+ *
+ * Critical sections protected by mutexes are often short enough for the
+ * owner to release the mutex sooner than it would take to put the caller
+ * to sleep and wake it up again.
+ *
+ * @param mtx  Mutex.
+ *
+ * @return True if the mutex was acquired, false if the caller should sleep.
+ */
+static bool _spin(mutex_t *mtx)
+{
+	if (config.cpu_active < 2)
+		return false;
+
+	for (size_t i = 0; i < MUTEX_SPIN_LIMIT; i++) {
+		thread_t *owner = _get_owner(mtx);
+
+		/*
+		 * The owner is not set right after the semaphore is taken,
+		 * so keep spinning until it shows up or the mutex is free.
+		 */
+		if ((owner != NULL) && !_owner_running(owner))
+			return false;
+
+		if ((owner == NULL) && (semaphore_trydown(&mtx->sem) == EOK))
+			return true;
+
+		cpu_spin_hint();
+	}
+
+	return false;
+}
+
+#else
+
+static inline bool _spin(mutex_t *mtx)
+{
+	return false;
+}
+
+#endif /* CONFIG_SMP */
+
 /** Find out whether the mutex is currently locked.
  *
  * @param mtx  Mutex.
@@ -104,7 +171,16 @@ void mutex_lock(mutex_t *mtx)
 		return;
 	}
 
-	semaphore_down(&mtx->sem);
+	if (semaphore_trydown(&mtx->sem) != EOK) {
+		atomic_fetch_add_explicit(&mtx->contended, 1,
+		    memory_order_relaxed);
+
+		if (!_spin(mtx)) {
+			atomic_fetch_add_explicit(&mtx->slept, 1,
+			    memory_order_relaxed);
+			semaphore_down(&mtx->sem);
+		}
+	}
 
 	_set_owner(mtx, THREAD);
 	assert(mtx->nesting == 0);
@@ -133,7 +209,19 @@ errno_t mutex_lock_timeout(mutex_t *mtx, uint32_t usec)
 		return EOK;
 	}
 
-	errno_t rc = semaphore_down_timeout(&mtx->sem, usec);
+	errno_t rc = semaphore_trydown(&mtx->sem);
+	if ((rc != EOK) && (usec != 0)) {
+		atomic_fetch_add_explicit(&mtx->contended, 1,
+		    memory_order_relaxed);
+
+		if (_spin(mtx)) {
+			rc = EOK;
+		} else {
+			atomic_fetch_add_explicit(&mtx->slept, 1,
+			    memory_order_relaxed);
+			rc = semaphore_down_timeout(&mtx->sem, usec);
+		}
+	}
 	if (rc != EOK)
 		return rc;
 
@@ -49,6 +49,228 @@
 #include <symtab.h>
 #include <stacktrace.h>
 #include <cpu.h>
+#include <str.h>
+#include <macros.h>
+#include <arch/cycle.h>
+
+#ifdef CONFIG_TICKET_SPINLOCK
+
+/*
+ * Ticket spinlocks hand the lock over in FIFO order, so a CPU cannot be
+ * starved by others repeatedly winning the race for a contended lock.
+ */
+
+static inline unsigned int spinlock_enter(spinlock_t *lock)
+{
+	return atomic_fetch_add_explicit(&lock->next, 1, memory_order_relaxed);
+}
+
+static inline bool spinlock_acquired(spinlock_t *lock, unsigned int ticket)
+{
+	return atomic_load_explicit(&lock->owner, memory_order_acquire) ==
+	    ticket;
+}
+
+static inline void spinlock_release(spinlock_t *lock)
+{
+	unsigned int owner = atomic_load_explicit(&lock->owner,
+	    memory_order_relaxed);
+	atomic_store_explicit(&lock->owner, owner + 1, memory_order_release);
+}
+
+#else
+
+static inline unsigned int spinlock_enter(spinlock_t *lock)
+{
+	return 0;
+}
+
+static inline bool spinlock_acquired(spinlock_t *lock, unsigned int ticket)
+{
+	return !atomic_flag_test_and_set_explicit(&lock->flag,
+	    memory_order_acquire);
+}
+
+static inline void spinlock_release(spinlock_t *lock)
+{
+	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+}
+
+#endif /* CONFIG_TICKET_SPINLOCK */
+
+#ifdef CONFIG_SPINLOCK_STATS
+
+/** Maximum number of distinct lock names tracked */
+#define SPINLOCK_CLASSES  512
+
+static spinlock_class_t spinlock_classes[SPINLOCK_CLASSES];
+static atomic_size_t spinlock_classes_count = 0;
+
+/** Class of the locks whose names did not fit in spinlock_classes */
+static spinlock_class_t spinlock_class_other = {
+	.name = "(other)"
+};
+
+/** Serializes registration of new lock classes. */
+static atomic_flag spinlock_classes_lock = ATOMIC_FLAG_INIT;
+
+static spinlock_class_t *spinlock_class_find(const char *name)
+{
+	size_t count = atomic_load_explicit(&spinlock_classes_count,
+	    memory_order_acquire);
+
+	for (size_t i = 0; i < count; i++) {
+		if (str_cmp(spinlock_classes[i].name, name) == 0)
+			return &spinlock_classes[i];
+	}
+
+	return NULL;
+}
+
+/** Get the statistics class of a spinlock
+ *
+ * Spinlocks are grouped into classes by their names. The class is looked up
+ * and cached in the lock on its first acquisition.
+ *
+ * @param lock Spinlock.
+ *
+ * @return Class of the spinlock.
+ *
+ */
+static spinlock_class_t *spinlock_class_get(spinlock_t *lock)
+{
+	spinlock_class_t *cls = atomic_load_explicit(&lock->cls,
+	    memory_order_relaxed);
+	if (cls)
+		return cls;
+
+	const char *name = lock->name ? lock->name : "(unnamed)";
+
+	cls = spinlock_class_find(name);
+	if (!cls) {
+		ipl_t ipl = interrupts_disable();
+
+		while (atomic_flag_test_and_set_explicit(&spinlock_classes_lock,
+		    memory_order_acquire))
+			cpu_spin_hint();
+
+		cls = spinlock_class_find(name);
+		if (!cls) {
+			size_t count = atomic_load_explicit(
+			    &spinlock_classes_count, memory_order_relaxed);
+
+			if (count < SPINLOCK_CLASSES) {
+				cls = &spinlock_classes[count];
+				cls->name = name;
+				atomic_store_explicit(&spinlock_classes_count,
+				    count + 1, memory_order_release);
+			} else {
+				cls = &spinlock_class_other;
+			}
+		}
+
+		atomic_flag_clear_explicit(&spinlock_classes_lock,
+		    memory_order_release);
+		interrupts_restore(ipl);
+	}
+
+	atomic_store_explicit(&lock->cls, cls, memory_order_relaxed);
+	return cls;
+}
+
+static void spinlock_stats_acquired(spinlock_t *lock, bool contended)
+{
+	spinlock_class_t *cls = spinlock_class_get(lock);
+
+	atomic_fetch_add_explicit(&cls->acquisitions, 1, memory_order_relaxed);
+	if (contended)
+		atomic_fetch_add_explicit(&cls->contended, 1,
+		    memory_order_relaxed);
+
+	lock->acquired = get_cycle();
+}
+
+static void spinlock_stats_released(spinlock_t *lock)
+{
+	spinlock_class_t *cls = atomic_load_explicit(&lock->cls,
+	    memory_order_relaxed);
+	uint64_t now = get_cycle();
+
+	/* Cycle counters of different CPUs need not be synchronized. */
+	if (now < lock->acquired)
+		return;
+
+	size_t hold = (size_t) min(now - lock->acquired, (uint64_t) SIZE_MAX);
+	size_t max = atomic_load_explicit(&cls->max_hold, memory_order_relaxed);
+
+	while ((hold > max) && !atomic_compare_exchange_weak_explicit(
+	    &cls->max_hold, &max, hold, memory_order_relaxed,
+	    memory_order_relaxed))
+		;
+}
+
+/** Get spinlock statistics
+ *
+ * @param stats Array to be filled with the statistics.
+ * @param count Number of entries in @a stats.
+ *
+ * @return Number of lock classes, which may be more than @a count.
+ *
+ */
+size_t spinlock_stats_get(stats_lock_t *stats, size_t count)
+{
+	size_t classes = atomic_load_explicit(&spinlock_classes_count,
+	    memory_order_acquire);
+
+	for (size_t i = 0; (i < classes) && (i < count); i++) {
+		spinlock_class_t *cls = &spinlock_classes[i];
+
+		str_cpy(stats[i].name, LOCK_NAME_BUFLEN, cls->name);
+		stats[i].acquisitions = atomic_load(&cls->acquisitions);
+		stats[i].contended = atomic_load(&cls->contended);
+		stats[i].max_hold_cycles = atomic_load(&cls->max_hold);
+	}
+
+	return classes;
+}
+
+/** Print spinlock statistics */
+void spinlock_stats_print(void)
+{
+	size_t classes = atomic_load_explicit(&spinlock_classes_count,
+	    memory_order_acquire);
+
+	printf("[name                          ] [acquisitions] [contended ]"
+	    " [max hold cycles]\n");
+
+	for (size_t i = 0; i < classes; i++) {
+		spinlock_class_t *cls = &spinlock_classes[i];
+
+		printf("%-32s %14zu %12zu %17zu\n", cls->name,
+		    atomic_load(&cls->acquisitions),
+		    atomic_load(&cls->contended),
+		    atomic_load(&cls->max_hold));
+	}
+
+	if (classes == SPINLOCK_CLASSES) {
+		printf("%-32s %14zu %12zu %17zu\n", spinlock_class_other.name,
+		    atomic_load(&spinlock_class_other.acquisitions),
+		    atomic_load(&spinlock_class_other.contended),
+		    atomic_load(&spinlock_class_other.max_hold));
+	}
+}
+
+#else
+
+static inline void spinlock_stats_acquired(spinlock_t *lock, bool contended)
+{
+}
+
+static inline void spinlock_stats_released(spinlock_t *lock)
+{
+}
+
+#endif /* CONFIG_SPINLOCK_STATS */
 
 /** Initialize spinlock
  *
@@ -57,10 +279,18 @@
  */
 void spinlock_initialize(spinlock_t *lock, const char *name)
 {
+#ifdef CONFIG_TICKET_SPINLOCK
+	atomic_init(&lock->next, 0);
+	atomic_init(&lock->owner, 0);
+#else
 	atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
-#ifdef CONFIG_DEBUG_SPINLOCK
+#endif
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_SPINLOCK_STATS)
 	lock->name = name;
 #endif
+#ifdef CONFIG_SPINLOCK_STATS
+	atomic_init(&lock->cls, NULL);
+#endif
 }
 
 /** Lock spinlock
@@ -73,9 +303,13 @@ void spinlock_lock(spinlock_t *lock)
 	preemption_disable();
 
 	bool deadlock_reported = false;
+	bool contended = false;
 	size_t i = 0;
 
-	while (atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire)) {
+	unsigned int ticket = spinlock_enter(lock);
+
+	while (!spinlock_acquired(lock, ticket)) {
+		contended = true;
 		cpu_spin_hint();
 
 #ifdef CONFIG_DEBUG_SPINLOCK
@@ -116,6 +350,8 @@ void spinlock_lock(spinlock_t *lock)
 	/* Avoid compiler warning with debug disabled. */
 	(void) i;
 
+	spinlock_stats_acquired(lock, contended);
+
 	if (deadlock_reported)
 		printf("cpu%u: not deadlocked\n", CPU->id);
 }
@@ -130,7 +366,8 @@ void spinlock_unlock(spinlock_t *lock)
 	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
 #endif
 
-	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+	spinlock_stats_released(lock);
+	spinlock_release(lock);
 	preemption_enable();
 }
 
@@ -147,9 +384,25 @@ bool spinlock_trylock(spinlock_t *lock)
 {
 	preemption_disable();
 
+#ifdef CONFIG_TICKET_SPINLOCK
+	unsigned int ticket = atomic_load_explicit(&lock->next,
+	    memory_order_relaxed);
+
+	/*
+	 * The lock is free if the next ticket would be served immediately.
+	 * Only take the ticket if nobody took it in the meantime.
+	 */
+	bool ret = (atomic_load_explicit(&lock->owner,
+	    memory_order_acquire) == ticket) &&
+	    atomic_compare_exchange_strong_explicit(&lock->next, &ticket,
+	    ticket + 1, memory_order_acquire, memory_order_relaxed);
+#else
 	bool ret = !atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire);
+#endif
 
-	if (!ret)
+	if (ret)
+		spinlock_stats_acquired(lock, false);
+	else
 		preemption_enable();
 
 	return ret;
@@ -162,6 +415,10 @@ bool spinlock_trylock(spinlock_t *lock)
  */
 bool spinlock_locked(spinlock_t *lock)
 {
+#ifdef CONFIG_TICKET_SPINLOCK
+	return atomic_load_explicit(&lock->owner, memory_order_relaxed) !=
+	    atomic_load_explicit(&lock->next, memory_order_relaxed);
+#else
 	// NOTE: Atomic flag doesn't support simple atomic read (by design),
 	//       so instead we test_and_set and then clear if necessary.
 	//       This function is only used inside assert, so we don't need
@@ -171,6 +428,7 @@ bool spinlock_locked(spinlock_t *lock)
 	if (!ret)
 		atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
 	return ret;
+#endif
 }
 
 #endif  /* CONFIG_SMP */
@@ -42,6 +42,7 @@
 #include <syscall/copy.h>
 #include <proc/thread.h>
 #include <mm/as.h>
+#include <mm/km.h>
 #include <macros.h>
 #include <arch.h>
 #include <errno.h>
@@ -148,5 +149,73 @@ errno_t copy_to_uspace(uspace_addr_t uspace_dst, const void *src, size_t size)
 	return rc;
 }
 
+/** Copy data from userspace to pinned frames.
+ *
+ * The frames are typically pinned in another address space by
+ * as_pin_pages(), which makes it possible to move data between two address
+ * spaces without an intermediate kernel buffer.
+ *
+ * @param frames Frames of the destination buffer.
+ * @param offset Offset of the destination buffer within the first frame.
+ * @param uspace_src Source userspace address.
+ * @param size Size of the data to be copied.
+ *
+ * @return EOK on success or an error code from @ref errno.h.
+ */
+errno_t copy_from_uspace_to_frames(uintptr_t *frames, size_t offset,
+    uspace_addr_t uspace_src, size_t size)
+{
+	while (size > 0) {
+		size_t chunk = min(size, PAGE_SIZE - offset);
+		uintptr_t page = km_temporary_frame_get(*frames);
+
+		errno_t rc = copy_from_uspace((void *) (page + offset),
+		    uspace_src, chunk);
+
+		km_temporary_page_put(page);
+		if (rc != EOK)
+			return rc;
+
+		uspace_src += chunk;
+		size -= chunk;
+		offset = 0;
+		frames++;
+	}
+
+	return EOK;
+}
+
+/** Copy data from pinned frames to userspace.
+ *
+ * @param uspace_dst Destination userspace address.
+ * @param frames Frames of the source buffer.
+ * @param offset Offset of the source buffer within the first frame.
+ * @param size Size of the data to be copied.
+ *
+ * @return EOK on success or an error code from @ref errno.h.
+ */
+errno_t copy_to_uspace_from_frames(uspace_addr_t uspace_dst,
+    uintptr_t *frames, size_t offset, size_t size)
+{
+	while (size > 0) {
+		size_t chunk = min(size, PAGE_SIZE - offset);
+		uintptr_t page = km_temporary_frame_get(*frames);
+
+		errno_t rc = copy_to_uspace(uspace_dst,
+		    (void *) (page + offset), chunk);
+
+		km_temporary_page_put(page);
+		if (rc != EOK)
+			return rc;
+
+		uspace_dst += chunk;
+		size -= chunk;
+		offset = 0;
+		frames++;
+	}
+
+	return EOK;
+}
+
 /** @}
  */
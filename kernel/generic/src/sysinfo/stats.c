@@ -52,6 +52,8 @@
 #include <cpu.h>
 #include <arch.h>
 #include <stdlib.h>
+#include <symtab.h>
+#include <debug/sampler.h>
 
 /** Bits of fixed-point precision for load */
 #define LOAD_FIXED_SHIFT  11
@@ -124,12 +126,23 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
 
 		stats_cpus[i].busy_cycles = atomic_time_read(&cpus[i].busy_cycles);
 		stats_cpus[i].idle_cycles = atomic_time_read(&cpus[i].idle_cycles);
+		stats_cpus[i].steals = atomic_load(&cpus[i].steals);
+		stats_cpus[i].migrations = atomic_load(&cpus[i].migrations);
+		stats_cpus[i].page_faults = atomic_load(&cpus[i].page_faults);
+		stats_cpus[i].large_pages = atomic_load(&cpus[i].large_pages);
+
+		frame_cache_stats(i, &stats_cpus[i].frame_hits,
+		    &stats_cpus[i].frame_misses, &stats_cpus[i].frame_drains,
+		    &stats_cpus[i].frame_cached);
 	}
 
 	return ((void *) stats_cpus);
 }
 
 /** Get the size of a virtual address space
+ *
+ * The page counts are maintained by the address space code, so the
+ * statistics can be read without locking the address space.
  *
  * @param as Address space.
  *
@@ -138,32 +151,8 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
  */
 static size_t get_task_virtmem(as_t *as)
 {
-	/*
-	 * We are holding spinlocks here and therefore are not allowed to
-	 * block. Only attempt to lock the address space and address space
-	 * area mutexes conditionally. If it is not possible to lock either
-	 * object, return inexact statistics by skipping the respective object.
-	 */
-
-	if (mutex_trylock(&as->lock) != EOK)
-		return 0;
-
-	size_t pages = 0;
-
-	/* Walk areas in the address space and count pages */
-	as_area_t *area = as_area_first(as);
-	while (area != NULL) {
-		if (mutex_trylock(&area->lock) != EOK)
-			continue;
-
-		pages += area->pages;
-		mutex_unlock(&area->lock);
-		area = as_area_next(area);
-	}
-
-	mutex_unlock(&as->lock);
-
-	return (pages << PAGE_WIDTH);
+	return (atomic_load_explicit(&as->virt_pages, memory_order_relaxed) <<
+	    PAGE_WIDTH);
 }
 
 /** Get the resident (used) size of a virtual address space
@@ -175,32 +164,8 @@ static size_t get_task_virtmem(as_t *as)
  */
 static size_t get_task_resmem(as_t *as)
 {
-	/*
-	 * We are holding spinlocks here and therefore are not allowed to
-	 * block. Only attempt to lock the address space and address space
-	 * area mutexes conditionally. If it is not possible to lock either
-	 * object, return inexact statistics by skipping the respective object.
-	 */
-
-	if (mutex_trylock(&as->lock) != EOK)
-		return 0;
-
-	size_t pages = 0;
-
-	/* Walk areas in the address space and count pages */
-	as_area_t *area = as_area_first(as);
-	while (area != NULL) {
-		if (mutex_trylock(&area->lock) != EOK)
-			continue;
-
-		pages += area->used_space.pages;
-		mutex_unlock(&area->lock);
-		area = as_area_next(area);
-	}
-
-	mutex_unlock(&as->lock);
-
-	return (pages << PAGE_WIDTH);
+	return (atomic_load_explicit(&as->used_pages, memory_order_relaxed) <<
+	    PAGE_WIDTH);
 }
 
 /** Produce task statistics
@@ -768,6 +733,135 @@ static void *get_stats_physmem(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_physmem);
 }
 
+#ifdef CONFIG_SPINLOCK_STATS
+
+/** Get spinlock statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_lock_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_locks(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	size_t count = spinlock_stats_get(NULL, 0);
+
+	*size = sizeof(stats_lock_t) * count;
+	if (dry_run)
+		return NULL;
+
+	stats_lock_t *stats_locks = (stats_lock_t *) malloc(*size);
+	if (stats_locks == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	/* New lock classes may have appeared in the meantime. */
+	(void) spinlock_stats_get(stats_locks, count);
+
+	return ((void *) stats_locks);
+}
+
+#endif /* CONFIG_SPINLOCK_STATS */
+
+#ifdef CONFIG_SAMPLING_PROFILER
+
+/** Get profiler samples
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_sample_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_samples(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	size_t count = sampler_snapshot(NULL, 0);
+
+	*size = sizeof(stats_sample_t) * count;
+	if (dry_run)
+		return NULL;
+
+	stats_sample_t *stats_samples = (stats_sample_t *) malloc(*size);
+	if (stats_samples == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	/*
+	 * The rings only fill up, they never shrink, so the second
+	 * snapshot cannot be shorter than the first one.
+	 */
+	(void) sampler_snapshot(stats_samples, count);
+
+	return ((void *) stats_samples);
+}
+
+/** Get kernel symbol name
+ *
+ * Resolve a kernel address for the profiler. The address is passed
+ * as a string (current limitation of the sysinfo interface).
+ *
+ * @param name    Address (string-encoded number).
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Sysinfo return holder. The data contain the name of the
+ *         symbol containing the address as a NULL-terminated string.
+ *         If the return value contains data, they should be freed
+ *         in the context of the sysinfo request.
+ */
+static sysinfo_return_t get_stats_symbol(const char *name, bool dry_run,
+    void *data)
+{
+	/* Initially no return value */
+	sysinfo_return_t ret = {
+		.tag = SYSINFO_VAL_UNDEFINED,
+	};
+
+	/* Parse the address */
+	uint64_t addr;
+	if (str_uint64_t(name, NULL, 0, true, &addr) != EOK)
+		return ret;
+
+	const char *symbol = symtab_name_lookup((uintptr_t) addr, NULL,
+	    &kernel_sections);
+	if (symbol == NULL)
+		return ret;
+
+	size_t symbol_size = str_size(symbol) + 1;
+
+	if (dry_run) {
+		ret.tag = SYSINFO_VAL_FUNCTION_DATA;
+		ret.data.data = NULL;
+		ret.data.size = symbol_size;
+	} else {
+		char *symbol_copy = malloc(symbol_size);
+
+		if (symbol_copy != NULL) {
+			memcpy(symbol_copy, symbol, symbol_size);
+
+			/* Correct return value */
+			ret.tag = SYSINFO_VAL_FUNCTION_DATA;
+			ret.data.data = symbol_copy;
+			ret.data.size = symbol_size;
+		}
+	}
+
+	return ret;
+}
+
+#endif /* CONFIG_SAMPLING_PROFILER */
+
 /** Get system load
  *
  * @param item    Sysinfo item (unused).
@@ -847,6 +941,13 @@ void stats_init(void)
 {
 	sysinfo_set_item_gen_data("system.cpus", NULL, get_stats_cpus, NULL);
 	sysinfo_set_item_gen_data("system.physmem", NULL, get_stats_physmem, NULL);
+#ifdef CONFIG_SPINLOCK_STATS
+	sysinfo_set_item_gen_data("system.locks", NULL, get_stats_locks, NULL);
+#endif
+#ifdef CONFIG_SAMPLING_PROFILER
+	sysinfo_set_item_gen_data("system.samples", NULL, get_stats_samples, NULL);
+	sysinfo_set_subtree_fn("system.symbols", NULL, get_stats_symbol, NULL);
+#endif
 	sysinfo_set_item_gen_data("system.load", NULL, get_stats_load, NULL);
 	sysinfo_set_item_gen_data("system.tasks", NULL, get_stats_tasks, NULL);
 	sysinfo_set_item_gen_data("system.threads", NULL, get_stats_threads, NULL);
@@ -39,8 +39,13 @@
  * of preemption. It is also responsible for executing expired
  * timeouts.
  *
+ * If the hardware clock supports it, an idle CPU suspends its periodic
+ * ticks until the next timeout is due. The ticks which passed meanwhile
+ * are accounted for as missed clock ticks when the CPU wakes up.
+ *
  */
 
+#include <assert.h>
 #include <time/clock.h>
 #include <time/timeout.h>
 #include <config.h>
@@ -54,6 +59,7 @@
 #include <atomic.h>
 #include <proc/thread.h>
 #include <sysinfo/sysinfo.h>
+#include <debug/sampler.h>
 #include <barrier.h>
 #include <mm/frame.h>
 #include <ddi/ddi.h>
@@ -63,6 +69,9 @@
 /* Pointer to variable with uptime */
 uptime_t *uptime;
 
+/** Hardware clock operations for the dynamic tick, if supported */
+static const clock_dyntick_ops_t *dyntick_ops = NULL;
+
 /** Physical memory area of the real time clock */
 static parea_t clock_parea;
 
@@ -137,6 +146,9 @@ static void cpu_update_accounting(void)
  */
 void clock(void)
 {
+	/* The clock interrupt might have been programmed by clock_idle_enter(). */
+	clock_idle_exit();
+
 	size_t missed_clock_ticks = CPU_LOCAL->missed_clock_ticks;
 	CPU_LOCAL->missed_clock_ticks = 0;
 
@@ -147,38 +159,13 @@ void clock(void)
 	/* Account CPU usage */
 	cpu_update_accounting();
 
-	/*
-	 * To avoid lock ordering problems,
-	 * run all expired timeouts as you visit them.
-	 *
-	 */
-
-	irq_spinlock_lock(&CPU->timeoutlock, false);
-
-	link_t *cur;
-	while ((cur = list_first(&CPU->timeout_active_list)) != NULL) {
-		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
-
-		if (current_clock_tick <= timeout->deadline) {
-			break;
-		}
-
-		list_remove(cur);
-		timeout_handler_t handler = timeout->handler;
-		void *arg = timeout->arg;
-		atomic_bool *finished = &timeout->finished;
-
-		irq_spinlock_unlock(&CPU->timeoutlock, false);
-
-		handler(arg);
-
-		/* Signal that the handler is finished. */
-		atomic_store_explicit(finished, true, memory_order_release);
-
-		irq_spinlock_lock(&CPU->timeoutlock, false);
-	}
+#ifdef CONFIG_SAMPLING_PROFILER
+	/* Sample the interrupted thread before it might get preempted. */
+	sampler_tick();
+#endif
 
-	irq_spinlock_unlock(&CPU->timeoutlock, false);
+	/* Run expired timeouts. */
+	timeout_process(current_clock_tick);
 
 	/*
 	 * Do CPU usage accounting and find out whether to preempt THREAD.
@@ -201,5 +188,105 @@ void clock(void)
 	}
 }
 
+/** Register hardware clock operations for the dynamic tick
+ *
+ * @param ops Clock operations.
+ *
+ */
+void clock_dyntick_register(const clock_dyntick_ops_t *ops)
+{
+	dyntick_ops = ops;
+}
+
+/** Suspend clock ticks of an idle CPU
+ *
+ * Called with interrupts disabled before the CPU goes to sleep. The clock
+ * is programmed to interrupt when the next timeout of this CPU is due.
+ *
+ */
+void clock_idle_enter(void)
+{
+	assert(interrupts_disabled());
+
+	if (dyntick_ops == NULL)
+		return;
+
+	/*
+	 * The uptime counter is maintained by CPU 0, so keep it ticking while
+	 * other CPUs may be reading it.
+	 */
+	if (CPU->id == 0 && config.cpu_active > 1)
+		return;
+
+	uint64_t now = CPU_LOCAL->current_clock_tick;
+	uint64_t next = timeout_next_tick();
+
+	/* Do not bother if a timeout is due on the next tick anyway. */
+	if (next <= now + 1)
+		return;
+
+	if (dyntick_ops->suspend(next - now) > 0)
+		atomic_store(&CPU->tickless, true);
+}
+
+/** Resume clock ticks after the CPU has woken up
+ *
+ * Called with interrupts disabled. The ticks which passed while the clock
+ * was suspended are accounted for as missed clock ticks.
+ *
+ */
+void clock_idle_exit(void)
+{
+	assert(interrupts_disabled());
+
+	if (!atomic_load_explicit(&CPU->tickless, memory_order_relaxed))
+		return;
+
+	atomic_store(&CPU->tickless, false);
+	CPU_LOCAL->missed_clock_ticks += dyntick_ops->resume();
+}
+
+/** Wake up a CPU if it is sleeping with its clock ticks suspended
+ *
+ * Called after a thread has been made ready on the CPU. A CPU with
+ * periodic ticks would notice the thread on its next tick.
+ *
+ * @param cpu CPU to wake up.
+ *
+ */
+void clock_kick(cpu_t *cpu)
+{
+	if (cpu != CPU && atomic_load(&cpu->tickless))
+		dyntick_ops->kick(cpu);
+}
+
+/** Wake up an idle CPU with its clock ticks suspended so that it steals work
+ *
+ * Called after a thread has been made ready on a CPU which already has
+ * ready threads. An idle CPU with periodic ticks tries to steal the thread
+ * on its next tick, a tickless one has to be woken up. Waking up one CPU is
+ * enough, as every further surplus thread wakes up another one.
+ *
+ * @param busy CPU whose run queues hold the surplus threads.
+ *
+ */
+void clock_kick_idle(cpu_t *busy)
+{
+	if (dyntick_ops == NULL)
+		return;
+
+	for (size_t i = 0; i < config.cpu_active; i++) {
+		cpu_t *cpu = &cpus[i];
+
+		if (cpu == CPU || cpu == busy || !cpu->active)
+			continue;
+
+		if (atomic_load(&cpu->tickless)) {
+			dyntick_ops->kick(cpu);
+			return;
+		}
+	}
+}
+
 /** @}
  */
@@ -34,6 +34,10 @@
 /**
  * @file
  * @brief Timeout management functions.
+ *
+ * Active timeouts of each CPU are kept in a hierarchical timing wheel,
+ * so that registering and unregistering a timeout takes constant time
+ * regardless of the number of pending timeouts.
  */
 
 #include <time/timeout.h>
@@ -45,6 +49,8 @@
 #include <cpu.h>
 #include <arch/asm.h>
 #include <arch.h>
+#include <macros.h>
+#include <align.h>
 
 /** Initialize timeouts
  *
@@ -53,8 +59,19 @@
  */
 void timeout_init(void)
 {
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+
 	irq_spinlock_initialize(&CPU->timeoutlock, "cpu.timeoutlock");
-	list_initialize(&CPU->timeout_active_list);
+
+	wheel->tick = CPU_LOCAL->current_clock_tick + 1;
+	wheel->count = 0;
+
+	for (unsigned int level = 0; level < TIMEOUT_WHEEL_LEVELS; level++) {
+		for (unsigned int i = 0; i < TIMEOUT_WHEEL_SLOTS; i++)
+			list_initialize(&wheel->slot[level][i]);
+	}
+
+	list_initialize(&wheel->overflow);
 }
 
 /** Initialize timeout
@@ -70,6 +87,133 @@ void timeout_initialize(timeout_t *timeout)
 	timeout->cpu = NULL;
 }
 
+/** Insert timeout into the timing wheel
+ *
+ * The timeout is put in the lowest level whose span covers the time
+ * remaining until its expiration. A timeout fires on the first clock tick
+ * past its deadline. Timeouts whose deadline has already passed fire on
+ * the next processed tick.
+ *
+ * @param wheel   Timing wheel.
+ * @param timeout Timeout to insert.
+ *
+ */
+static void timeout_wheel_insert(timeout_wheel_t *wheel, timeout_t *timeout)
+{
+	if (timeout->deadline == DEADLINE_NEVER) {
+		list_append(&timeout->link, &wheel->overflow);
+		return;
+	}
+
+	uint64_t expires = max(timeout->deadline + 1, wheel->tick);
+	uint64_t delta = expires - wheel->tick;
+
+	for (unsigned int level = 0; level < TIMEOUT_WHEEL_LEVELS; level++) {
+		unsigned int shift = level * TIMEOUT_WHEEL_BITS;
+
+		if ((delta >> shift) < TIMEOUT_WHEEL_SLOTS) {
+			size_t i = (expires >> shift) & (TIMEOUT_WHEEL_SLOTS - 1);
+			list_append(&timeout->link, &wheel->slot[level][i]);
+			return;
+		}
+	}
+
+	list_append(&timeout->link, &wheel->overflow);
+}
+
+/** Move timeouts from a higher level slot closer to expiration
+ *
+ * @param wheel Timing wheel.
+ * @param list  Slot or overflow list whose timeouts are to be reinserted.
+ *
+ */
+static void timeout_wheel_cascade(timeout_wheel_t *wheel, list_t *list)
+{
+	list_t pending;
+	link_t *cur;
+
+	list_initialize(&pending);
+	list_concat(&pending, list);
+
+	while ((cur = list_first(&pending)) != NULL) {
+		list_remove(cur);
+		timeout_wheel_insert(wheel,
+		    list_get_instance(cur, timeout_t, link));
+	}
+}
+
+/** Cascade the slots that the wheel reaches at its current tick
+ *
+ * @param wheel Timing wheel.
+ *
+ */
+static void timeout_wheel_advance(timeout_wheel_t *wheel)
+{
+	for (unsigned int level = 1; level <= TIMEOUT_WHEEL_LEVELS; level++) {
+		unsigned int shift = level * TIMEOUT_WHEEL_BITS;
+
+		/* Higher levels are only reached when the lower ones wrap. */
+		if ((wheel->tick & ((UINT64_C(1) << shift) - 1)) != 0)
+			break;
+
+		if (level == TIMEOUT_WHEEL_LEVELS) {
+			timeout_wheel_cascade(wheel, &wheel->overflow);
+		} else {
+			size_t i = (wheel->tick >> shift) & (TIMEOUT_WHEEL_SLOTS - 1);
+			timeout_wheel_cascade(wheel, &wheel->slot[level][i]);
+		}
+	}
+}
+
+/** Find the next tick at which the timing wheel has work to do
+ *
+ * This is either the expiration of a timeout or the cascade of a non-empty
+ * higher level slot, whichever comes first.
+ *
+ * @param wheel Timing wheel.
+ *
+ * @return The next tick to be processed or DEADLINE_NEVER if the wheel
+ *         is empty.
+ *
+ */
+static uint64_t timeout_wheel_next(timeout_wheel_t *wheel)
+{
+	if (wheel->count == 0)
+		return DEADLINE_NEVER;
+
+	uint64_t next = DEADLINE_NEVER;
+
+	for (unsigned int level = 0; level <= TIMEOUT_WHEEL_LEVELS; level++) {
+		unsigned int shift = level * TIMEOUT_WHEEL_BITS;
+		uint64_t span = UINT64_C(1) << shift;
+
+		/* The first tick at which this level is reached. */
+		uint64_t first = ALIGN_UP(wheel->tick, span);
+		if (first >= next)
+			break;
+
+		if (level == TIMEOUT_WHEEL_LEVELS) {
+			if (!list_empty(&wheel->overflow))
+				next = first;
+			break;
+		}
+
+		for (uint64_t i = 0; i < TIMEOUT_WHEEL_SLOTS; i++) {
+			uint64_t when = first + i * span;
+			if (when >= next)
+				break;
+
+			size_t slot = (when >> shift) & (TIMEOUT_WHEEL_SLOTS - 1);
+			if (!list_empty(&wheel->slot[level][slot])) {
+				next = when;
+				break;
+			}
+		}
+	}
+
+	return next;
+}
+
 /* Only call when interrupts are disabled. */
 deadline_t timeout_deadline_in_usec(uint32_t usec)
 {
@@ -92,21 +236,8 @@ static void timeout_register_deadline_locked(timeout_t *timeout, deadline_t dead
 		.finished = ATOMIC_VAR_INIT(false),
 	};
 
-	/* Insert timeout into the active timeouts list according to timeout->deadline. */
-
-	link_t *last = list_last(&CPU->timeout_active_list);
-	if (last == NULL || timeout->deadline >= list_get_instance(last, timeout_t, link)->deadline) {
-		list_append(&timeout->link, &CPU->timeout_active_list);
-	} else {
-		for (link_t *cur = list_first(&CPU->timeout_active_list); cur != NULL;
-		    cur = list_next(cur, &CPU->timeout_active_list)) {
-
-			if (timeout->deadline < list_get_instance(cur, timeout_t, link)->deadline) {
-				list_insert_before(&timeout->link, cur);
-				break;
-			}
-		}
-	}
+	timeout_wheel_insert(&CPU->timeout_wheel, timeout);
+	CPU->timeout_wheel.count++;
 }
 
 /** Register timeout
@@ -159,6 +290,7 @@ bool timeout_unregister(timeout_t *timeout)
 	bool success = link_in_use(&timeout->link);
 	if (success) {
 		list_remove(&timeout->link);
+		timeout->cpu->timeout_wheel.count--;
 	}
 
 	irq_spinlock_unlock(&timeout->cpu->timeoutlock, true);
@@ -172,5 +304,84 @@ bool timeout_unregister(timeout_t *timeout)
 	return success;
 }
 
+/** Run expired timeouts
+ *
+ * Called from the clock interrupt handler with interrupts disabled.
+ * To avoid lock ordering problems, expired timeouts are run as they
+ * are visited.
+ *
+ * @param current_clock_tick Current clock tick of this CPU.
+ *
+ */
+void timeout_process(uint64_t current_clock_tick)
+{
+	timeout_wheel_t *wheel = &CPU->timeout_wheel;
+
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	while (wheel->tick <= current_clock_tick) {
+		if (current_clock_tick - wheel->tick >= TIMEOUT_WHEEL_SLOTS ||
+		    wheel->count == 0) {
+			/*
+			 * Many ticks were missed, e.g. while the clock was
+			 * suspended. Skip the ticks with nothing to do.
+			 */
+			uint64_t next = timeout_wheel_next(wheel);
+			if (next > current_clock_tick) {
+				wheel->tick = current_clock_tick + 1;
+				break;
+			}
+
+			wheel->tick = next;
+		}
+
+		timeout_wheel_advance(wheel);
+
+		list_t *slot =
+		    &wheel->slot[0][wheel->tick & (TIMEOUT_WHEEL_SLOTS - 1)];
+
+		link_t *cur;
+		while ((cur = list_first(slot)) != NULL) {
+			timeout_t *timeout = list_get_instance(cur, timeout_t, link);
+
+			list_remove(cur);
+			wheel->count--;
+
+			timeout_handler_t handler = timeout->handler;
+			void *arg = timeout->arg;
+			atomic_bool *finished = &timeout->finished;
+
+			irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+			handler(arg);
+
+			/* Signal that the handler is finished. */
+			atomic_store_explicit(finished, true, memory_order_release);
+
+			irq_spinlock_lock(&CPU->timeoutlock, false);
+		}
+
+		wheel->tick++;
+	}
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+}
+
+/** Get the next clock tick at which timeouts of this CPU need processing
+ *
+ * Only call when interrupts are disabled.
+ *
+ * @return Clock tick or DEADLINE_NEVER if there are no timeouts.
+ *
+ */
+uint64_t timeout_next_tick(void)
+{
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+	uint64_t next = timeout_wheel_next(&CPU->timeout_wheel);
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+	return next;
+}
+
 /** @}
  */
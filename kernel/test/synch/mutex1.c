@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <config.h>
+#include <proc/thread.h>
+#include <synch/waitq.h>
+#include <synch/mutex.h>
+
+#define THREADS     8
+#define ITERATIONS  100000
+
+static mutex_t mtx;
+
+static waitq_t can_start;
+static atomic_size_t finished;
+static size_t counter;
+
+static void worker(void *arg)
+{
+	waitq_sleep(&can_start);
+
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		mutex_lock(&mtx);
+		counter++;
+		mutex_unlock(&mtx);
+	}
+
+	atomic_inc(&finished);
+}
+
+const char *test_mutex1(void)
+{
+	size_t threads = 0;
+
+	waitq_initialize(&can_start);
+	mutex_initialize(&mtx, MUTEX_PASSIVE);
+	atomic_store(&finished, 0);
+	counter = 0;
+
+	for (size_t i = 0; i < THREADS; i++) {
+		thread_t *thrd = thread_create(worker, NULL, TASK,
+		    THREAD_FLAG_NONE, "mutex1");
+		if (thrd) {
+			thread_wire(thrd, &cpus[i % config.cpu_active]);
+			thread_start(thrd);
+			thread_detach(thrd);
+			threads++;
+		} else {
+			TPRINTF("could not create thread %zu\n", i);
+		}
+	}
+
+	thread_sleep(1);
+	waitq_wake_all(&can_start);
+
+	while (atomic_load(&finished) != threads) {
+		TPRINTF("%zu threads remaining\n",
+		    threads - atomic_load(&finished));
+		thread_sleep(1);
+	}
+
+	TPRINTF("%zu acquisitions, %zu contended, %zu slept\n",
+	    threads * ITERATIONS, atomic_load(&mtx.contended),
+	    atomic_load(&mtx.slept));
+
+	if (counter != threads * ITERATIONS)
+		return "Mutex does not provide mutual exclusion";
+
+	return NULL;
+}
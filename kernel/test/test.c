@@ -47,6 +47,7 @@ test_t tests[] = {
 #include <mm/mapping1.def>
 #include <mm/slab1.def>
 #include <mm/slab2.def>
+#include <synch/mutex1.def>
 #include <synch/semaphore1.def>
 #include <synch/semaphore2.def>
 #include <print/print1.def>
@@ -55,6 +56,7 @@ test_t tests[] = {
 #include <print/print4.def>
 #include <print/print5.def>
 #include <thread/thread1.def>
+#include <time/timeout1.def>
 	{
 		.name = NULL,
 		.desc = NULL,
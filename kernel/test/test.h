@@ -65,6 +65,7 @@ extern const char *test_mapping1(void);
 extern const char *test_purge1(void);
 extern const char *test_slab1(void);
 extern const char *test_slab2(void);
+extern const char *test_mutex1(void);
 extern const char *test_semaphore1(void);
 extern const char *test_semaphore2(void);
 extern const char *test_print1(void);
@@ -73,6 +74,7 @@ extern const char *test_print3(void);
 extern const char *test_print4(void);
 extern const char *test_print5(void);
 extern const char *test_thread1(void);
+extern const char *test_timeout1(void);
 
 extern test_t tests[];
 
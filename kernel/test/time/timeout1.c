@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <atomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <proc/thread.h>
+#include <time/timeout.h>
+#include <arch/cycle.h>
+
+/** Number of pending timeouts. */
+#define TIMEOUTS  100000
+
+/** Number of register/unregister rounds measured with pending timeouts. */
+#define ROUNDS  10000
+
+/** Minimum delay of the pending timeouts in microseconds. */
+#define PENDING_MIN  1000000000
+
+/** Spread of the delays of the pending timeouts in microseconds. */
+#define PENDING_SPREAD  3000000000
+
+static void timeout_nop(void *arg)
+{
+}
+
+static void timeout_fired(void *arg)
+{
+	atomic_store((atomic_bool *) arg, true);
+}
+
+const char *test_timeout1(void)
+{
+	timeout_t *timeouts = malloc(TIMEOUTS * sizeof(timeout_t));
+	if (timeouts == NULL)
+		return "Unable to allocate timeouts";
+
+	/*
+	 * Register timeouts far enough in the future not to fire during
+	 * the test. Such delays only land on the upper levels of the timing
+	 * wheel, so it is the insertion and removal cost there that gets
+	 * measured. Only the short timeout below lands on the lowest level.
+	 */
+	TPRINTF("Registering %d timeouts...", TIMEOUTS);
+
+	uint64_t start = get_cycle();
+	for (int i = 0; i < TIMEOUTS; i++) {
+		timeout_initialize(&timeouts[i]);
+		timeout_register(&timeouts[i], PENDING_MIN +
+		    ((uint64_t) i * 7919) % PENDING_SPREAD, timeout_nop, NULL);
+	}
+	uint64_t cycles = get_cycle() - start;
+
+	TPRINTF(" %" PRIu64 " cycles per timeout\n", cycles / TIMEOUTS);
+
+	/* Measure registering and unregistering with the timeouts pending. */
+	TPRINTF("Registering and unregistering %d timeouts...", ROUNDS);
+
+	timeout_t probe;
+	start = get_cycle();
+	for (int i = 0; i < ROUNDS; i++) {
+		timeout_initialize(&probe);
+		timeout_register(&probe, PENDING_MIN + i, timeout_nop, NULL);
+		if (!timeout_unregister(&probe)) {
+			free(timeouts);
+			return "Probe timeout fired prematurely";
+		}
+	}
+	cycles = get_cycle() - start;
+
+	TPRINTF(" %" PRIu64 " cycles per round\n", cycles / ROUNDS);
+
+	/* A short timeout must still fire. */
+	atomic_bool fired = false;
+	timeout_t shortt;
+	timeout_initialize(&shortt);
+	timeout_register(&shortt, 10000, timeout_fired, &fired);
+	thread_usleep(200000);
+
+	if (!atomic_load(&fired)) {
+		timeout_unregister(&shortt);
+		free(timeouts);
+		return "Short timeout did not fire";
+	}
+
+	/* Unregister the pending timeouts. */
+	TPRINTF("Unregistering %d timeouts...", TIMEOUTS);
+
+	const char *ret = NULL;
+	start = get_cycle();
+	for (int i = 0; i < TIMEOUTS; i++) {
+		if (!timeout_unregister(&timeouts[i]))
+			ret = "Pending timeout fired prematurely";
+	}
+	cycles = get_cycle() - start;
+
+	TPRINTF(" %" PRIu64 " cycles per timeout\n", cycles / TIMEOUTS);
+
+	free(timeouts);
+	return ret;
+}
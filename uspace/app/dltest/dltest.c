@@ -37,6 +37,7 @@
 
 #include <dlfcn.h>
 #include <libdltest.h>
+#include <rtld/rtld.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,6 +49,9 @@ static void *handle;
 /** If true, do not run dlfcn tests */
 static bool no_dlfcn = false;
 
+/** If true, print dynamic linking statistics */
+static bool print_stats = false;
+
 /** Test dlsym() function */
 static bool test_dlsym(void)
 {
@@ -614,6 +618,27 @@ static bool test_lnk_dl_get_constant(void)
 	return true;
 }
 
+/** Test calling a linked function again once its PLT slot is bound */
+static bool test_lnk_dl_get_constant_bound(void)
+{
+	int val;
+
+	printf("Call linked dl_get_constant again...\n");
+
+	val = dl_get_constant();
+	if (val == dl_constant)
+		val = dl_get_constant();
+
+	printf("Got %d, expected %d... ", val, dl_constant);
+	if (val != dl_constant) {
+		printf("FAILED\n");
+		return false;
+	}
+
+	printf("Passed\n");
+	return true;
+}
+
 /** Test directly calling function that calls a function that returns a constant */
 static bool test_lnk_dl_get_constant_via_call(void)
 {
@@ -980,6 +1005,9 @@ static int test_lnk(void)
 	if (!test_lnk_dl_get_constant())
 		return 1;
 
+	if (!test_lnk_dl_get_constant_bound())
+		return 1;
+
 	if (!test_lnk_dl_get_constant_via_call())
 		return 1;
 
@@ -1029,22 +1057,22 @@ static int test_lnk(void)
 
 static void print_syntax(void)
 {
-	fprintf(stderr, "syntax: dltest [-n]\n");
+	fprintf(stderr, "syntax: dltest [-n] [-s]\n");
 	fprintf(stderr, "\t-n Do not run dlfcn tests\n");
+	fprintf(stderr, "\t-s Print dynamic linking statistics\n");
 }
 
 int main(int argc, char *argv[])
 {
-	printf("Dynamic linking test\n");
+	int i;
 
-	if (argc > 1) {
-		if (argc > 2) {
-			print_syntax();
-			return 1;
-		}
+	printf("Dynamic linking test\n");
 
-		if (str_cmp(argv[1], "-n") == 0) {
+	for (i = 1; i < argc; i++) {
+		if (str_cmp(argv[i], "-n") == 0) {
 			no_dlfcn = true;
+		} else if (str_cmp(argv[i], "-s") == 0) {
+			print_stats = true;
 		} else {
 			print_syntax();
 			return 1;
@@ -1061,6 +1089,9 @@ int main(int argc, char *argv[])
 		return 1;
 #endif
 
+	if (print_stats && runtime_env != NULL)
+		rtld_stats_print(runtime_env);
+
 	printf("All passed.\n");
 	return 0;
 }
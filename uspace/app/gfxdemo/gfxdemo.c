@@ -43,10 +43,13 @@
 #include <gfx/typeface.h>
 #include <io/console.h>
 #include <io/pixelmap.h>
+#include <memgfx/memgc.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <str.h>
+#include <str_error.h>
 #include <task.h>
+#include <time.h>
 #include <ui/ui.h>
 #include <ui/window.h>
 #include <ui/wdecor.h>
@@ -70,6 +73,33 @@ static ui_window_cb_t ui_window_cb = {
 
 static void demo_kbd_event(kbd_event_t *);
 
+static void bench_invalidate_rect(void *, gfx_rect_t *);
+static void bench_update(void *);
+
+static mem_gc_cb_t bench_mem_gc_cb = {
+	.invalidate = bench_invalidate_rect,
+	.update = bench_update
+};
+
+/** Benchmark operation */
+typedef enum {
+	/** Fill rectangle */
+	bench_fill,
+	/** Render bitmap */
+	bench_copy,
+	/** Render bitmap with color key */
+	bench_key,
+	/** Render bitmap with color key and colorization */
+	bench_colorize
+} bench_op_t;
+
+/** Duration of each benchmark in milliseconds */
+#define BENCH_MSEC 2000
+/** Width of benchmark surface */
+#define BENCH_WIDTH 1024
+/** Height of benchmark surface */
+#define BENCH_HEIGHT 768
+
 static bool quit = false;
 static FIBRIL_MUTEX_INITIALIZE(quit_lock);
 static FIBRIL_CONDVAR_INITIALIZE(quit_cv);
@@ -1324,9 +1354,181 @@ static void uiwnd_kbd_event(ui_window_t *window, void *arg, kbd_event_t *event)
 	demo_kbd_event(event);
 }
 
+/** Run one rendering benchmark on a graphic context.
+ *
+ * Repeatedly fill the whole GC or render a bitmap covering the whole GC
+ * and report throughput.
+ *
+ * @param gc Graphic context
+ * @param w Width
+ * @param h Height
+ * @param name Benchmark name
+ * @param op Operation to benchmark
+ * @return EOK on success or an error code
+ */
+static errno_t bench_run(gfx_context_t *gc, gfx_coord_t w, gfx_coord_t h,
+    const char *name, bench_op_t op)
+{
+	gfx_bitmap_t *bitmap = NULL;
+	gfx_bitmap_params_t params;
+	gfx_color_t *color;
+	gfx_rect_t rect;
+	struct timespec t0, t1;
+	uint64_t npixels;
+	uint64_t rate;
+	usec_t elapsed;
+	int i;
+	errno_t rc;
+
+	rect.p0.x = 0;
+	rect.p0.y = 0;
+	rect.p1.x = w;
+	rect.p1.y = h;
+
+	rc = gfx_color_new_rgb_i16(0xffff, 0x8000, 0, &color);
+	if (rc != EOK)
+		return rc;
+
+	rc = gfx_set_color(gc, color);
+	gfx_color_delete(color);
+	if (rc != EOK)
+		return rc;
+
+	if (op != bench_fill) {
+		gfx_bitmap_params_init(&params);
+		params.rect = rect;
+		if (op == bench_key || op == bench_colorize) {
+			params.flags = bmpf_color_key;
+			params.key_color = PIXEL(255, 255, 0, 255);
+		}
+		if (op == bench_colorize)
+			params.flags |= bmpf_colorize;
+
+		rc = gfx_bitmap_create(gc, &params, NULL, &bitmap);
+		if (rc != EOK)
+			return rc;
+
+		if (op == bench_copy)
+			rc = bitmap_moire(bitmap, w, h);
+		else
+			rc = bitmap_circle(bitmap, w, h);
+		if (rc != EOK)
+			goto error;
+	}
+
+	npixels = 0;
+	getuptime(&t0);
+
+	do {
+		for (i = 0; i < 10; i++) {
+			if (op == bench_fill)
+				rc = gfx_fill_rect(gc, &rect);
+			else
+				rc = gfx_bitmap_render(bitmap, NULL, NULL);
+			if (rc != EOK)
+				goto error;
+		}
+
+		npixels += 10 * (uint64_t) w * h;
+		getuptime(&t1);
+		elapsed = NSEC2USEC(ts_sub_diff(&t1, &t0));
+	} while (elapsed < MSEC2USEC(BENCH_MSEC));
+
+	/* Pixels per microsecond is Mpixel/s, keep two decimal places */
+	rate = npixels * 100 / elapsed;
+	printf("%-32s %6" PRIu64 ".%02u Mpixel/s\n", name, rate / 100,
+	    (unsigned) (rate % 100));
+
+	if (bitmap != NULL)
+		gfx_bitmap_destroy(bitmap);
+	return EOK;
+error:
+	if (bitmap != NULL)
+		gfx_bitmap_destroy(bitmap);
+	return rc;
+}
+
+/** Run rendering benchmarks on a memory GC.
+ *
+ * This measures the software renderer used by the display server
+ * without any IPC overhead.
+ */
+static errno_t demo_bench(void)
+{
+	mem_gc_t *mgc = NULL;
+	gfx_context_t *gc;
+	gfx_rect_t rect;
+	gfx_bitmap_alloc_t alloc;
+	errno_t rc;
+
+	rect.p0.x = 0;
+	rect.p0.y = 0;
+	rect.p1.x = BENCH_WIDTH;
+	rect.p1.y = BENCH_HEIGHT;
+
+	alloc.pitch = BENCH_WIDTH * sizeof(uint32_t);
+	alloc.off0 = 0;
+	alloc.pixels = calloc(1, alloc.pitch * BENCH_HEIGHT);
+	if (alloc.pixels == NULL) {
+		printf("Out of memory.\n");
+		return ENOMEM;
+	}
+
+	rc = mem_gc_create(&rect, &alloc, &bench_mem_gc_cb, NULL, &mgc);
+	if (rc != EOK) {
+		printf("Error creating memory GC.\n");
+		goto error;
+	}
+
+	gc = mem_gc_get_ctx(mgc);
+
+	printf("Memory GC %dx%d:\n", BENCH_WIDTH, BENCH_HEIGHT);
+
+	rc = bench_run(gc, BENCH_WIDTH, BENCH_HEIGHT, "Fill rectangle",
+	    bench_fill);
+	if (rc != EOK)
+		goto error;
+
+	rc = bench_run(gc, BENCH_WIDTH, BENCH_HEIGHT, "Bitmap", bench_copy);
+	if (rc != EOK)
+		goto error;
+
+	rc = bench_run(gc, BENCH_WIDTH, BENCH_HEIGHT, "Bitmap with color key",
+	    bench_key);
+	if (rc != EOK)
+		goto error;
+
+	rc = bench_run(gc, BENCH_WIDTH, BENCH_HEIGHT,
+	    "Bitmap with color key, colorized", bench_colorize);
+	if (rc != EOK)
+		goto error;
+
+	mem_gc_delete(mgc);
+	free(alloc.pixels);
+	return EOK;
+error:
+	if (rc != EOK)
+		printf("Benchmark failed: %s.\n", str_error(rc));
+	if (mgc != NULL)
+		mem_gc_delete(mgc);
+	free(alloc.pixels);
+	return rc;
+}
+
+static void bench_invalidate_rect(void *arg, gfx_rect_t *rect)
+{
+	(void) arg;
+	(void) rect;
+}
+
+static void bench_update(void *arg)
+{
+	(void) arg;
+}
+
 static void print_syntax(void)
 {
-	printf("Syntax: gfxdemo [-d <display>] {console|display|ui}\n");
+	printf("Syntax: gfxdemo [-d <display>] {console|display|ui|bench}\n");
 }
 
 int main(int argc, char *argv[])
@@ -1366,6 +1568,10 @@ int main(int argc, char *argv[])
 		rc = demo_display(display_svc);
 		if (rc != EOK)
 			return 1;
+	} else if (str_cmp(argv[i], "bench") == 0) {
+		rc = demo_bench();
+		if (rc != EOK)
+			return 1;
 	} else {
 		print_syntax();
 		return 1;
@@ -38,6 +38,7 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_amap_find,
 	&benchmark_dir_read,
 	&benchmark_fibril_mutex,
 	&benchmark_file_read,
@@ -45,11 +46,17 @@ benchmark_t *benchmarks[] = {
 	&benchmark_seq_read,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
+	&benchmark_malloc1_mt,
+	&benchmark_malloc2_mt,
+	&benchmark_nic_ring,
 	&benchmark_ns_ping,
 	&benchmark_ping_pong,
 	&benchmark_read1k,
+	&benchmark_read1m,
 	&benchmark_taskgetid,
+	&benchmark_tcp_xfer,
 	&benchmark_write1k,
+	&benchmark_write1m,
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -35,6 +35,7 @@
 #include <str_error.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <str.h>
 #include "../hbench.h"
 
 /** Execute disk sequential read benchmark. */
@@ -42,12 +43,15 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 {
 	const char *disk;
 	const char *nbstr;
+	const char *cachestr;
+	bool use_cache;
 	service_id_t svcid;
 	size_t block_size;
 	aoff64_t dev_nblocks;
 	aoff64_t baddr;
 	bool block_inited = false;
 	char *buf = NULL;
+	block_t *block;
 	uint64_t i;
 	errno_t rc;
 	int nitem;
@@ -66,6 +70,14 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 		goto error;
 	}
 
+	/*
+	 * With 'cache' set to 'yes' read one block at a time through
+	 * the block cache (exercising readahead), otherwise read 'nb'
+	 * blocks at a time directly from the device.
+	 */
+	cachestr = bench_env_param_get(env, "cache", "no");
+	use_cache = str_cmp(cachestr, "yes") == 0;
+
 	rc = loc_service_get_id(disk, &svcid, 0);
 	if (rc != EOK) {
 		bench_run_fail(run, "failed resolving device '%s'", disk);
@@ -92,29 +104,48 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 		goto error;
 	}
 
-	if (dev_nblocks < nb) {
+	if (use_cache)
+		nb = 1;
+
+	/* The block cache does not give out the last block. */
+	if (dev_nblocks < nb + 1) {
 		bench_run_fail(run, "device is smaller than %u blocks.\n",
-		    nb);
+		    nb + 1);
 		goto error;
 	}
 
-	buf = malloc(block_size);
+	if (use_cache) {
+		rc = block_cache_init(svcid, block_size, 0, CACHE_MODE_WT);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed to initialize block cache.");
+			goto error;
+		}
+	}
+
+	buf = malloc(block_size * nb);
 	if (buf == NULL) {
 		bench_run_fail(run, "failed to allocate buffer (%zu bytes)",
-		    block_size);
+		    block_size * nb);
 		goto error;
 	}
 
 	bench_run_start(run);
 	for (i = 0; i < size; i++) {
-		baddr = i % (dev_nblocks - nb + 1);
+		baddr = (i * nb) % (dev_nblocks - nb);
+
+		if (use_cache) {
+			rc = block_get(&block, svcid, baddr, BLOCK_FLAGS_NONE);
+			if (rc == EOK)
+				rc = block_put(block);
+		} else {
+			rc = block_read_direct(svcid, baddr, nb, buf);
+		}
 
-		rc = block_read_direct(svcid, baddr, 1, buf);
 		if (rc != EOK) {
 			bench_run_fail(run, "failed to read blocks %llu-%llu: "
 			    "%s", (unsigned long long)baddr,
 			    (unsigned long long)(baddr + nb - 1),
-			    str_error(errno));
+			    str_error(rc));
 			goto error;
 		}
 	}
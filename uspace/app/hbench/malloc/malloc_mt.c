@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * Multithreaded variants of malloc1 and malloc2. The iterations are split
+ * among several fibrils running on separate runner threads, so the results
+ * show how well the allocator scales compared to the single-threaded runs.
+ */
+
+/** Number of runner threads spawned so far. */
+static int runners = 0;
+
+typedef struct {
+	/** Number of iterations per worker */
+	uint64_t niter;
+	/** Number of workers which failed to allocate memory */
+	atomic_uint failed;
+	/** Signalled by each worker when it is done */
+	fibril_semaphore_t done;
+} shared_t;
+
+static errno_t worker1(void *arg)
+{
+	shared_t *shared = arg;
+
+	for (uint64_t i = 0; i < shared->niter; i++) {
+		void *p = malloc(1);
+		if (p == NULL) {
+			atomic_fetch_add(&shared->failed, 1);
+			break;
+		}
+		free(p);
+	}
+
+	fibril_semaphore_up(&shared->done);
+	return EOK;
+}
+
+static errno_t worker2(void *arg)
+{
+	shared_t *shared = arg;
+
+	void **p = malloc(shared->niter * sizeof(void *));
+	if (p == NULL) {
+		atomic_fetch_add(&shared->failed, 1);
+		fibril_semaphore_up(&shared->done);
+		return EOK;
+	}
+
+	uint64_t count;
+	for (count = 0; count < shared->niter; count++) {
+		p[count] = malloc(1);
+		if (p[count] == NULL) {
+			atomic_fetch_add(&shared->failed, 1);
+			break;
+		}
+	}
+
+	for (uint64_t j = 0; j < count; j++)
+		free(p[j]);
+
+	free(p);
+
+	fibril_semaphore_up(&shared->done);
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter,
+    errno_t (*worker)(void *))
+{
+	const char *tstr = bench_env_param_get(env, "threads", "4");
+	unsigned int nthreads;
+
+	if (sscanf(tstr, "%u", &nthreads) < 1 || nthreads == 0)
+		return bench_run_fail(run, "'threads' must be a positive integer.");
+
+	/* The main fibril waits, the workers need a runner each. */
+	if (runners < (int) nthreads)
+		runners += fibril_test_spawn_runners(nthreads - runners);
+
+	shared_t shared;
+	shared.niter = niter / nthreads;
+	atomic_store(&shared.failed, 0);
+	fibril_semaphore_initialize(&shared.done, 0);
+
+	bench_run_start(run);
+
+	unsigned int started;
+	for (started = 0; started < nthreads; started++) {
+		fid_t fid = fibril_create(worker, &shared);
+		if (fid == 0)
+			break;
+
+		fibril_add_ready(fid);
+	}
+
+	for (unsigned int i = 0; i < started; i++)
+		fibril_semaphore_down(&shared.done);
+
+	bench_run_stop(run);
+
+	if (started < nthreads)
+		return bench_run_fail(run, "failed to create worker fibril");
+
+	if (atomic_load(&shared.failed) > 0) {
+		return bench_run_fail(run, "%u worker(s) failed to allocate memory",
+		    atomic_load(&shared.failed));
+	}
+
+	return true;
+}
+
+static bool runner1(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	return runner(env, run, niter, worker1);
+}
+
+static bool runner2(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	return runner(env, run, niter, worker2);
+}
+
+benchmark_t benchmark_malloc1_mt = {
+	.name = "malloc1_mt",
+	.desc = "User-space memory allocator benchmark, repeatedly allocate one block in several threads",
+	.entry = &runner1,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_malloc2_mt = {
+	.name = "malloc2_mt",
+	.desc = "User-space memory allocator benchmark, allocate many small blocks in several threads",
+	.entry = &runner2,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <nettl/amap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+enum {
+	/** Local port used by all connections */
+	amap_local_port = 8080,
+	/** First remote port */
+	amap_remote_port = 1024
+};
+
+static amap_t *map = NULL;
+static unsigned nconn;
+static unsigned ninserted;
+
+/** Construct endpoint pair of @a idx-th connection.
+ *
+ * Remote addresses and ports are varied so that each connection
+ * ends up in a distinct repla entry.
+ */
+static void amap_bench_epp(unsigned idx, inet_ep2_t *epp)
+{
+	inet_ep2_init(epp);
+	inet_addr(&epp->local.addr, 10, 0, 0, 1);
+	epp->local.port = amap_local_port;
+	inet_addr(&epp->remote.addr, 10, 1 + (idx >> 16) % 254,
+	    (idx >> 8) & 0xff, idx & 0xff);
+	epp->remote.port = amap_remote_port + idx % 16;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	inet_ep2_t epp;
+
+	if (map == NULL)
+		return true;
+
+	for (unsigned i = 0; i < ninserted; i++) {
+		amap_bench_epp(i, &epp);
+		amap_remove(map, &epp);
+	}
+
+	amap_destroy(map);
+	map = NULL;
+	ninserted = 0;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	inet_ep2_t epp;
+	inet_ep2_t aepp;
+	const char *nstr;
+	errno_t rc;
+	int nitem;
+
+	nstr = bench_env_param_get(env, "connections", "10000");
+	nitem = sscanf(nstr, "%u", &nconn);
+	if (nitem < 1 || nconn == 0) {
+		return bench_run_fail(run,
+		    "'connections' must be a positive integer.");
+	}
+
+	rc = amap_create(&map);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed creating association map: %s",
+		    str_error(rc));
+	}
+
+	ninserted = 0;
+	for (unsigned i = 0; i < nconn; i++) {
+		amap_bench_epp(i, &epp);
+		rc = amap_insert(map, &epp, (void *)(uintptr_t)(i + 1), 0,
+		    &aepp);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed inserting connection %u: %s",
+			    i, str_error(rc));
+			teardown(env, run);
+			return false;
+		}
+
+		ninserted++;
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	inet_ep2_t epp;
+	void *arg;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		unsigned idx = count % nconn;
+
+		amap_bench_epp(idx, &epp);
+		rc = amap_find_match(map, &epp, &arg);
+		if (rc != EOK || arg != (void *)(uintptr_t)(idx + 1)) {
+			return bench_run_fail(run,
+			    "lookup of connection %u failed", idx);
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_amap_find = {
+	.name = "amap_find",
+	.desc = "Network transport layer association map lookup benchmark",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
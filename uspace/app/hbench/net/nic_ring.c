@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <as.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <mem.h>
+#include <nic/ring.h>
+#include <stdio.h>
+#include "../hbench.h"
+
+/*
+ * Loopback through the NIC frame rings. A sender fibril transmits frames
+ * through the TX ring, a driver fibril loops them back to the RX ring and
+ * a receiver fibril processes them in place, just like ethip and a NIC
+ * driver do. Doorbells are delivered by semaphores instead of IPC, so the
+ * result is the upper bound of packets per second the rings can pass.
+ */
+
+/** Number of runner threads spawned so far. */
+static int runners = 0;
+
+typedef struct {
+	/** Rings shared by the sender and receiver with the driver */
+	nic_rings_t *rings;
+	/** Number of frames to pass */
+	uint64_t niter;
+	/** Size of each frame */
+	size_t size;
+	/** Doorbell of the driver (TX ring kick) */
+	fibril_semaphore_t tx_kick;
+	/** Doorbell of the receiver (RX ring event) */
+	fibril_semaphore_t rx_event;
+	/** Signalled by each fibril when it is done */
+	fibril_semaphore_t done;
+	/** Sum of the first bytes of the received frames */
+	uint64_t checksum;
+} loop_t;
+
+static errno_t sender(void *arg)
+{
+	loop_t *loop = arg;
+	uint8_t frame[NIC_RING_SLOT_SIZE];
+
+	memset(frame, 0, loop->size);
+
+	for (uint64_t i = 0; i < loop->niter; i++) {
+		frame[0] = (uint8_t) i;
+
+		while (!nic_ring_put(&loop->rings->tx, frame, loop->size)) {
+			if (nic_ring_doorbell(&loop->rings->tx))
+				fibril_semaphore_up(&loop->tx_kick);
+			fibril_yield();
+		}
+
+		if (nic_ring_doorbell(&loop->rings->tx))
+			fibril_semaphore_up(&loop->tx_kick);
+	}
+
+	fibril_semaphore_up(&loop->done);
+	return EOK;
+}
+
+static errno_t driver(void *arg)
+{
+	loop_t *loop = arg;
+	nic_ring_t *tx = &loop->rings->tx;
+	nic_ring_t *rx = &loop->rings->rx;
+	uint64_t forwarded = 0;
+
+	while (forwarded < loop->niter) {
+		fibril_semaphore_down(&loop->tx_kick);
+
+		do {
+			void *data;
+			size_t size;
+
+			while (nic_ring_peek(tx, &data, &size)) {
+				while (!nic_ring_put(rx, data, size)) {
+					if (nic_ring_doorbell(rx))
+						fibril_semaphore_up(&loop->rx_event);
+					fibril_yield();
+				}
+
+				nic_ring_consume(tx);
+				forwarded++;
+			}
+
+			if (nic_ring_doorbell(rx))
+				fibril_semaphore_up(&loop->rx_event);
+		} while (!nic_ring_arm(tx));
+	}
+
+	fibril_semaphore_up(&loop->done);
+	return EOK;
+}
+
+static errno_t receiver(void *arg)
+{
+	loop_t *loop = arg;
+	nic_ring_t *rx = &loop->rings->rx;
+	uint64_t received = 0;
+
+	while (received < loop->niter) {
+		fibril_semaphore_down(&loop->rx_event);
+
+		do {
+			void *data;
+			size_t size;
+
+			while (nic_ring_peek(rx, &data, &size)) {
+				loop->checksum += *((uint8_t *) data);
+				nic_ring_consume(rx);
+				received++;
+			}
+		} while (!nic_ring_arm(rx));
+	}
+
+	fibril_semaphore_up(&loop->done);
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	const char *sstr = bench_env_param_get(env, "size", "1514");
+	size_t size;
+
+	if (sscanf(sstr, "%zu", &size) < 1 || size == 0 ||
+	    size > NIC_RING_SLOT_SIZE) {
+		return bench_run_fail(run, "'size' must be between 1 and %u.",
+		    NIC_RING_SLOT_SIZE);
+	}
+
+	/* The sender, driver and receiver need a runner each. */
+	if (runners < 3)
+		runners += fibril_test_spawn_runners(3 - runners);
+
+	loop_t loop;
+	loop.rings = as_area_create(AS_AREA_ANY, sizeof(nic_rings_t),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (loop.rings == AS_MAP_FAILED)
+		return bench_run_fail(run, "failed to allocate the rings");
+
+	nic_ring_init(&loop.rings->rx);
+	nic_ring_init(&loop.rings->tx);
+	loop.niter = niter;
+	loop.size = size;
+	loop.checksum = 0;
+	fibril_semaphore_initialize(&loop.tx_kick, 0);
+	fibril_semaphore_initialize(&loop.rx_event, 0);
+	fibril_semaphore_initialize(&loop.done, 0);
+
+	/* Either all three fibrils run or none, they depend on each other. */
+	fid_t fids[3];
+	fids[0] = fibril_create(receiver, &loop);
+	fids[1] = fibril_create(driver, &loop);
+	fids[2] = fibril_create(sender, &loop);
+
+	if (fids[0] == 0 || fids[1] == 0 || fids[2] == 0) {
+		for (size_t i = 0; i < 3; i++) {
+			if (fids[i] != 0)
+				fibril_destroy(fids[i]);
+		}
+
+		as_area_destroy(loop.rings);
+		return bench_run_fail(run, "failed to create fibril");
+	}
+
+	bench_run_start(run);
+
+	for (size_t i = 0; i < 3; i++)
+		fibril_add_ready(fids[i]);
+
+	for (size_t i = 0; i < 3; i++)
+		fibril_semaphore_down(&loop.done);
+
+	bench_run_stop(run);
+
+	uint64_t expected = 0;
+	for (uint64_t i = 0; i < niter; i++)
+		expected += (uint8_t) i;
+
+	as_area_destroy(loop.rings);
+
+	if (loop.checksum != expected)
+		return bench_run_fail(run, "frames were lost or reordered");
+
+	return true;
+}
+
+benchmark_t benchmark_nic_ring = {
+	.name = "nic_ring",
+	.desc = "Loop frames back through the NIC frame rings (packets per second)",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/endpoint.h>
+#include <inet/tcp.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Bulk transfer over a TCP connection to ourselves through the loopback
+ * address. Each iteration sends one chunk of data, the receiver verifies
+ * the data pattern. The result depends on the whole TCP/IP stack, including
+ * window scaling, which keeps the sender from stalling on a full window.
+ */
+
+/** Size of the receive buffer */
+#define RECV_BUF_SIZE 4096
+
+typedef struct {
+	/** Number of bytes to receive */
+	uint64_t total;
+	/** Number of bytes received correctly */
+	uint64_t received;
+	/** Data did not match the pattern */
+	bool corrupt;
+	/** Signalled when the receiver is done */
+	fibril_semaphore_t done;
+} xfer_t;
+
+static void xfer_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
+{
+	xfer_t *xfer = tcp_listener_userptr(lst);
+	uint8_t buf[RECV_BUF_SIZE];
+	size_t nrecv;
+
+	while (xfer->received < xfer->total) {
+		if (tcp_conn_recv_wait(conn, buf, sizeof(buf), &nrecv) != EOK)
+			break;
+		if (nrecv == 0)
+			break;
+
+		for (size_t i = 0; i < nrecv; i++) {
+			if (buf[i] != (uint8_t) (xfer->received + i))
+				xfer->corrupt = true;
+		}
+
+		xfer->received += nrecv;
+	}
+
+	fibril_semaphore_up(&xfer->done);
+}
+
+static tcp_listen_cb_t xfer_listen_cb = {
+	.new_conn = xfer_new_conn
+};
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	const char *sstr = bench_env_param_get(env, "size", "4096");
+	const char *pstr = bench_env_param_get(env, "port", "8091");
+	size_t size;
+	unsigned port;
+
+	if (sscanf(sstr, "%zu", &size) < 1 || size == 0 || size > 65536)
+		return bench_run_fail(run, "'size' must be between 1 and 65536.");
+
+	if (sscanf(pstr, "%u", &port) < 1 || port == 0 || port > UINT16_MAX)
+		return bench_run_fail(run, "'port' must be a valid port number.");
+
+	uint8_t *chunk = malloc(size);
+	if (chunk == NULL)
+		return bench_run_fail(run, "failed to allocate the chunk");
+
+	xfer_t xfer;
+	xfer.total = niter * size;
+	xfer.received = 0;
+	xfer.corrupt = false;
+	fibril_semaphore_initialize(&xfer.done, 0);
+
+	tcp_t *tcp = NULL;
+	tcp_listener_t *lst = NULL;
+	tcp_conn_t *conn = NULL;
+	bool receiving = false;
+	bool ok = false;
+
+	errno_t rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to connect to TCP: %s",
+		    str_error(rc));
+		goto out;
+	}
+
+	inet_ep_t ep;
+	inet_ep_init(&ep);
+	ep.port = port;
+
+	rc = tcp_listener_create(tcp, &ep, &xfer_listen_cb, &xfer, NULL, NULL,
+	    &lst);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to listen on port %u: %s", port,
+		    str_error(rc));
+		goto out;
+	}
+
+	inet_ep2_t epp;
+	inet_ep2_init(&epp);
+	inet_addr(&epp.remote.addr, 127, 0, 0, 1);
+	epp.remote.port = port;
+
+	bench_run_start(run);
+
+	rc = tcp_conn_create(tcp, &epp, NULL, NULL, &conn);
+	if (rc == EOK)
+		rc = tcp_conn_wait_connected(conn);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to connect: %s", str_error(rc));
+		goto out;
+	}
+
+	/* The receiver runs from now on and uses xfer until it is done. */
+	receiving = true;
+
+	uint64_t off = 0;
+	for (uint64_t i = 0; i < niter; i++) {
+		for (size_t j = 0; j < size; j++)
+			chunk[j] = (uint8_t) (off + j);
+
+		rc = tcp_conn_send(conn, chunk, size);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed to send: %s", str_error(rc));
+			goto out;
+		}
+
+		off += size;
+	}
+
+	rc = tcp_conn_send_fin(conn);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to close: %s", str_error(rc));
+		goto out;
+	}
+
+	fibril_semaphore_down(&xfer.done);
+	receiving = false;
+
+	bench_run_stop(run);
+
+	if (xfer.received != xfer.total) {
+		bench_run_fail(run, "received %" PRIu64 " of %" PRIu64 " bytes",
+		    xfer.received, xfer.total);
+		goto out;
+	}
+
+	if (xfer.corrupt) {
+		bench_run_fail(run, "received data were corrupted");
+		goto out;
+	}
+
+	ok = true;
+out:
+	tcp_conn_destroy(conn);
+	/* Destroying the connection makes the receiver give up. */
+	if (receiving)
+		fibril_semaphore_down(&xfer.done);
+	tcp_listener_destroy(lst);
+	tcp_destroy(tcp);
+	free(chunk);
+	return ok;
+}
+
+benchmark_t benchmark_tcp_xfer = {
+	.name = "tcp_xfer",
+	.desc = "Transfer data over TCP through the loopback (chunks per second)",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
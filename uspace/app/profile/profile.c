@@ -0,0 +1,657 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup profile
+ * @{
+ */
+/**
+ * @file
+ * @brief Sampling profiler front end.
+ *
+ * Collects the samples taken by the kernel on every clock tick and prints
+ * a flat profile and, optionally, a call graph. Kernel addresses are
+ * resolved by the kernel, user addresses are resolved using the symbol
+ * table of the executable the task was started from.
+ *
+ * There is no way to find out which shared libraries another task has
+ * loaded and where, so addresses in shared libraries are not resolved and
+ * are printed as raw addresses.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <arg_parse.h>
+#include <errno.h>
+#include <fibril.h>
+#include <gsort.h>
+#include <inttypes.h>
+#include <stats.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <symtab.h>
+
+#define NAME  "profile"
+
+/** Default length of the profiling run (seconds) */
+#define DEFAULT_DURATION  5
+
+/** Interval between reading the samples out of the kernel (microseconds) */
+#define POLL_INTERVAL  250000
+
+/** Symbols of a user task */
+typedef struct {
+	ht_link_t link;
+	task_id_t task_id;
+	/** Task name */
+	char *name;
+	/** Symbol table of the executable or NULL if it could not be loaded */
+	symtab_t *symtab;
+} task_syms_t;
+
+/** Profiled function */
+typedef struct {
+	ht_link_t link;
+	link_t funcs;
+	/** Function name qualified by the module it belongs to */
+	char *name;
+	/** Samples taken in the function itself */
+	size_t self;
+	/** Samples taken in the function or in anything it called */
+	size_t total;
+	/** Last sample counted in total */
+	size_t mark;
+} func_t;
+
+/** Address resolved to a function */
+typedef struct {
+	ht_link_t link;
+	bool kernel;
+	task_id_t task_id;
+	uint64_t pc;
+	func_t *func;
+} addr_t;
+
+/** Call graph edge */
+typedef struct {
+	ht_link_t link;
+	link_t edges;
+	func_t *caller;
+	func_t *callee;
+	size_t count;
+} edge_t;
+
+static hash_table_t task_syms_table;
+static hash_table_t func_table;
+static hash_table_t addr_table;
+static hash_table_t edge_table;
+
+static LIST_INITIALIZE(funcs);
+static LIST_INITIALIZE(edges);
+
+/** Number of samples accounted */
+static size_t samples;
+
+/** Number of samples overwritten in the kernel before they were read */
+static size_t missed;
+
+static size_t task_syms_key_hash(const void *key)
+{
+	const task_id_t *task_id = key;
+	return hash_mix(*task_id);
+}
+
+static size_t task_syms_hash(const ht_link_t *item)
+{
+	task_syms_t *ts = hash_table_get_inst(item, task_syms_t, link);
+	return hash_mix(ts->task_id);
+}
+
+static bool task_syms_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const task_id_t *task_id = key;
+	task_syms_t *ts = hash_table_get_inst(item, task_syms_t, link);
+	return ts->task_id == *task_id;
+}
+
+static const hash_table_ops_t task_syms_ops = {
+	.hash = task_syms_hash,
+	.key_hash = task_syms_key_hash,
+	.key_equal = task_syms_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static size_t func_key_hash(const void *key)
+{
+	return hash_string(key);
+}
+
+static size_t func_hash(const ht_link_t *item)
+{
+	func_t *func = hash_table_get_inst(item, func_t, link);
+	return hash_string(func->name);
+}
+
+static bool func_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	func_t *func = hash_table_get_inst(item, func_t, link);
+	return str_cmp(func->name, key) == 0;
+}
+
+static const hash_table_ops_t func_ops = {
+	.hash = func_hash,
+	.key_hash = func_key_hash,
+	.key_equal = func_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static size_t addr_key_hash(const void *key)
+{
+	const addr_t *addr = key;
+	return hash_combine(hash_mix(addr->task_id), hash_mix(addr->pc));
+}
+
+static size_t addr_hash(const ht_link_t *item)
+{
+	addr_t *addr = hash_table_get_inst(item, addr_t, link);
+	return addr_key_hash(addr);
+}
+
+static bool addr_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const addr_t *key_addr = key;
+	addr_t *addr = hash_table_get_inst(item, addr_t, link);
+	return (addr->kernel == key_addr->kernel) &&
+	    (addr->task_id == key_addr->task_id) &&
+	    (addr->pc == key_addr->pc);
+}
+
+static const hash_table_ops_t addr_ops = {
+	.hash = addr_hash,
+	.key_hash = addr_key_hash,
+	.key_equal = addr_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static size_t edge_key_hash(const void *key)
+{
+	const edge_t *edge = key;
+	return hash_combine(hash_mix((uintptr_t) edge->caller),
+	    hash_mix((uintptr_t) edge->callee));
+}
+
+static size_t edge_hash(const ht_link_t *item)
+{
+	edge_t *edge = hash_table_get_inst(item, edge_t, link);
+	return edge_key_hash(edge);
+}
+
+static bool edge_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const edge_t *key_edge = key;
+	edge_t *edge = hash_table_get_inst(item, edge_t, link);
+	return (edge->caller == key_edge->caller) &&
+	    (edge->callee == key_edge->callee);
+}
+
+static const hash_table_ops_t edge_ops = {
+	.hash = edge_hash,
+	.key_hash = edge_key_hash,
+	.key_equal = edge_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Get symbols of a user task, loading them on first use. */
+static task_syms_t *task_syms_get(task_id_t task_id)
+{
+	ht_link_t *link = hash_table_find(&task_syms_table, &task_id);
+	if (link != NULL)
+		return hash_table_get_inst(link, task_syms_t, link);
+
+	task_syms_t *ts = calloc(1, sizeof(task_syms_t));
+	if (ts == NULL)
+		return NULL;
+
+	ts->task_id = task_id;
+
+	/* The task may have exited in the meantime. */
+	stats_task_t *stats_task = stats_get_task(task_id);
+	if (stats_task != NULL) {
+		ts->name = str_dup(stats_task->name);
+		free(stats_task);
+	} else {
+		(void) asprintf(&ts->name, "%" PRIu64, task_id);
+	}
+
+	if (ts->name == NULL) {
+		free(ts);
+		return NULL;
+	}
+
+	/* Tasks started from a file are named after its path. */
+	if (ts->name[0] == '/')
+		(void) symtab_load(ts->name, &ts->symtab);
+
+	hash_table_insert(&task_syms_table, &ts->link);
+	return ts;
+}
+
+/** Find or create a function by name. Takes ownership of @a name. */
+static func_t *func_get(char *name)
+{
+	ht_link_t *link = hash_table_find(&func_table, name);
+	if (link != NULL) {
+		free(name);
+		return hash_table_get_inst(link, func_t, link);
+	}
+
+	func_t *func = calloc(1, sizeof(func_t));
+	if (func == NULL) {
+		free(name);
+		return NULL;
+	}
+
+	func->name = name;
+	func->mark = SIZE_MAX;
+
+	hash_table_insert(&func_table, &func->link);
+	list_append(&func->funcs, &funcs);
+	return func;
+}
+
+/** Resolve an address to the name of the function containing it. */
+static char *addr_resolve(bool kernel, task_id_t task_id, uint64_t pc)
+{
+	char *name = NULL;
+
+	if (kernel) {
+		char *symbol = stats_get_kernel_symbol(pc);
+		if (symbol != NULL) {
+			(void) asprintf(&name, "kernel`%s", symbol);
+			free(symbol);
+		} else {
+			(void) asprintf(&name, "kernel`0x%" PRIx64, pc);
+		}
+
+		return name;
+	}
+
+	task_syms_t *ts = task_syms_get(task_id);
+	if (ts == NULL)
+		return NULL;
+
+	char *symbol;
+	size_t offs;
+
+	if ((ts->symtab != NULL) && (symtab_addr_to_name(ts->symtab,
+	    (uintptr_t) pc, &symbol, &offs) == EOK))
+		(void) asprintf(&name, "%s`%s", ts->name, symbol);
+	else
+		(void) asprintf(&name, "%s`0x%" PRIx64, ts->name, pc);
+
+	return name;
+}
+
+/** Find the function containing an address. */
+static func_t *addr_func(bool kernel, task_id_t task_id, uint64_t pc)
+{
+	addr_t key = {
+		.kernel = kernel,
+		.task_id = kernel ? 0 : task_id,
+		.pc = pc
+	};
+
+	ht_link_t *link = hash_table_find(&addr_table, &key);
+	if (link != NULL)
+		return hash_table_get_inst(link, addr_t, link)->func;
+
+	char *name = addr_resolve(kernel, task_id, pc);
+	if (name == NULL)
+		return NULL;
+
+	func_t *func = func_get(name);
+	if (func == NULL)
+		return NULL;
+
+	addr_t *addr = malloc(sizeof(addr_t));
+	if (addr == NULL)
+		return func;
+
+	*addr = key;
+	addr->func = func;
+
+	hash_table_insert(&addr_table, &addr->link);
+	return func;
+}
+
+/** Count a call from @a caller to @a callee. */
+static void edge_count(func_t *caller, func_t *callee)
+{
+	edge_t key = {
+		.caller = caller,
+		.callee = callee
+	};
+
+	ht_link_t *link = hash_table_find(&edge_table, &key);
+	if (link != NULL) {
+		hash_table_get_inst(link, edge_t, link)->count++;
+		return;
+	}
+
+	edge_t *edge = malloc(sizeof(edge_t));
+	if (edge == NULL)
+		return;
+
+	*edge = key;
+	edge->count = 1;
+
+	hash_table_insert(&edge_table, &edge->link);
+	list_append(&edge->edges, &edges);
+}
+
+/** Account a single sample. */
+static void sample_account(stats_sample_t *sample)
+{
+	func_t *callee = NULL;
+
+	for (unsigned int i = 0; i < sample->depth; i++) {
+		/* Return addresses point past the call instruction. */
+		uint64_t pc = (i == 0) ? sample->pcs[i] : sample->pcs[i] - 1;
+
+		func_t *func = addr_func(!sample->uspace, sample->task_id, pc);
+		if (func == NULL)
+			break;
+
+		if (i == 0)
+			func->self++;
+
+		/* Do not count recursive functions more than once. */
+		if (func->mark != samples) {
+			func->mark = samples;
+			func->total++;
+		}
+
+		if (callee != NULL)
+			edge_count(func, callee);
+
+		callee = func;
+	}
+
+	samples++;
+}
+
+/** Read the new samples out of the kernel.
+ *
+ * @param next_seq  Next expected sequence number of each CPU.
+ * @param cpus      Number of CPUs.
+ * @param task_id   Only account samples of this task, unless zero.
+ * @param account   Account the new samples, or just skip them.
+ */
+static void samples_collect(uint64_t *next_seq, size_t cpus,
+    task_id_t task_id, bool account)
+{
+	size_t count;
+	stats_sample_t *stats_samples = stats_get_samples(&count);
+	if (stats_samples == NULL)
+		return;
+
+	for (size_t i = 0; i < count; i++) {
+		stats_sample_t *sample = &stats_samples[i];
+
+		if ((sample->cpu >= cpus) || (sample->seq < next_seq[sample->cpu]))
+			continue;
+
+		if (account)
+			missed += sample->seq - next_seq[sample->cpu];
+
+		next_seq[sample->cpu] = sample->seq + 1;
+
+		if ((account) && ((task_id == 0) || (sample->task_id == task_id)))
+			sample_account(sample);
+	}
+
+	free(stats_samples);
+}
+
+static int func_cmp_self(void *a, void *b, void *arg)
+{
+	func_t *fa = *(func_t **) a;
+	func_t *fb = *(func_t **) b;
+
+	if (fa->self != fb->self)
+		return (fa->self > fb->self) ? -1 : 1;
+
+	return (fa->total > fb->total) ? -1 : (fa->total < fb->total);
+}
+
+static int func_cmp_total(void *a, void *b, void *arg)
+{
+	func_t *fa = *(func_t **) a;
+	func_t *fb = *(func_t **) b;
+
+	if (fa->total != fb->total)
+		return (fa->total > fb->total) ? -1 : 1;
+
+	return (fa->self > fb->self) ? -1 : (fa->self < fb->self);
+}
+
+static unsigned int percent(size_t part)
+{
+	return (samples > 0) ? (part * 100) / samples : 0;
+}
+
+static void print_flat(func_t **sorted, size_t count)
+{
+	printf("%8s %5s %8s %5s  %s\n", "Self", "%", "Total", "%", "Function");
+
+	for (size_t i = 0; i < count; i++) {
+		func_t *func = sorted[i];
+
+		if (func->self == 0)
+			break;
+
+		printf("%8zu %4u%% %8zu %4u%%  %s\n", func->self,
+		    percent(func->self), func->total, percent(func->total),
+		    func->name);
+	}
+}
+
+static void print_call_graph(func_t **sorted, size_t count)
+{
+	printf("%8s %5s  %s\n", "Total", "%", "Function");
+
+	for (size_t i = 0; i < count; i++) {
+		func_t *func = sorted[i];
+
+		printf("\n%8zu %4u%%  %s\n", func->total, percent(func->total),
+		    func->name);
+
+		list_foreach(edges, edges, edge_t, edge) {
+			if (edge->callee == func)
+				printf("%8zu %5s    <- %s\n", edge->count, "",
+				    edge->caller->name);
+		}
+
+		list_foreach(edges, edges, edge_t, edge) {
+			if (edge->caller == func)
+				printf("%8zu %5s    -> %s\n", edge->count, "",
+				    edge->callee->name);
+		}
+	}
+}
+
+static void usage(const char *name)
+{
+	printf(
+	    "Usage: %s [-t task_id] [-d seconds] [-g]\n"
+	    "\n"
+	    "Options:\n"
+	    "\t-t task_id | --task=task_id\n"
+	    "\t\tOnly profile the given task\n"
+	    "\n"
+	    "\t-d seconds | --duration=seconds\n"
+	    "\t\tProfile for the given time (default %d seconds)\n"
+	    "\n"
+	    "\t-g | --call-graph\n"
+	    "\t\tAlso print the call graph\n"
+	    "\n"
+	    "\t-h | --help\n"
+	    "\t\tPrint this usage information\n",
+	    name, DEFAULT_DURATION);
+}
+
+int main(int argc, char *argv[])
+{
+	task_id_t task_id = 0;
+	int duration = DEFAULT_DURATION;
+	bool call_graph = false;
+
+	for (int i = 1; i < argc; i++) {
+		int off;
+
+		/* Usage */
+		if ((off = arg_parse_short_long(argv[i], "-h", "--help")) != -1) {
+			usage(argv[0]);
+			return 0;
+		}
+
+		/* Call graph */
+		if ((off = arg_parse_short_long(argv[i], "-g", "--call-graph")) != -1) {
+			call_graph = true;
+			continue;
+		}
+
+		/* Task */
+		if ((off = arg_parse_short_long(argv[i], "-t", "--task=")) != -1) {
+			char *arg;
+			errno_t ret = arg_parse_string(argc, argv, &i, &arg, off);
+			if (ret == EOK)
+				ret = str_uint64_t(arg, NULL, 10, true, &task_id);
+
+			if ((ret != EOK) || (task_id == 0)) {
+				printf("%s: Malformed task id '%s'\n", NAME, argv[i]);
+				return 1;
+			}
+
+			continue;
+		}
+
+		/* Duration */
+		if ((off = arg_parse_short_long(argv[i], "-d", "--duration=")) != -1) {
+			errno_t ret = arg_parse_int(argc, argv, &i, &duration, off);
+			if ((ret != EOK) || (duration <= 0)) {
+				printf("%s: Malformed duration '%s'\n", NAME, argv[i]);
+				return 1;
+			}
+
+			continue;
+		}
+
+		usage(argv[0]);
+		return 1;
+	}
+
+	size_t cpus;
+	stats_cpu_t *stats_cpus = stats_get_cpus(&cpus);
+	if (stats_cpus == NULL) {
+		printf("%s: Unable to get CPU statistics\n", NAME);
+		return 1;
+	}
+
+	free(stats_cpus);
+
+	uint64_t *next_seq = calloc(cpus, sizeof(uint64_t));
+	if (next_seq == NULL) {
+		printf("%s: Out of memory\n", NAME);
+		return 1;
+	}
+
+	if (!hash_table_create(&task_syms_table, 0, 0, &task_syms_ops) ||
+	    !hash_table_create(&func_table, 0, 0, &func_ops) ||
+	    !hash_table_create(&addr_table, 0, 0, &addr_ops) ||
+	    !hash_table_create(&edge_table, 0, 0, &edge_ops)) {
+		printf("%s: Out of memory\n", NAME);
+		return 1;
+	}
+
+	/* Skip the samples taken before we started. */
+	samples_collect(next_seq, cpus, task_id, false);
+
+	printf("Profiling for %d seconds...\n", duration);
+
+	usec_t polls = ((usec_t) duration * 1000000) / POLL_INTERVAL;
+	for (usec_t i = 0; i < polls; i++) {
+		fibril_usleep(POLL_INTERVAL);
+		samples_collect(next_seq, cpus, task_id, true);
+	}
+
+	free(next_seq);
+
+	if (samples == 0) {
+		printf("No samples taken. Is the sampling profiler enabled?\n");
+		return 0;
+	}
+
+	printf("%zu samples, %zu missed\n\n", samples, missed);
+
+	size_t count = list_count(&funcs);
+	func_t **sorted = malloc(sizeof(func_t *) * count);
+	if (sorted == NULL) {
+		printf("%s: Out of memory\n", NAME);
+		return 1;
+	}
+
+	size_t i = 0;
+	list_foreach(funcs, funcs, func_t, func)
+		sorted[i++] = func;
+
+	gsort(sorted, count, sizeof(func_t *), func_cmp_self, NULL);
+	print_flat(sorted, count);
+
+	if (call_graph) {
+		putchar('\n');
+		gsort(sorted, count, sizeof(func_t *), func_cmp_total, NULL);
+		print_call_graph(sorted, count);
+	}
+
+	free(sorted);
+	return 0;
+}
+
+/** @}
+ */
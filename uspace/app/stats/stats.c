@@ -172,7 +172,8 @@ static void list_cpus(void)
 		return;
 	}
 
-	printf("[id] [MHz     ] [busy cycles] [idle cycles]\n");
+	printf("[id] [MHz     ] [busy cycles] [idle cycles] [steals  ] [migrated]"
+	    " [faults  ] [large   ]\n");
 
 	for (size_t i = 0; i < count; i++) {
 		printf("%-4u ", cpus[i].id);
@@ -183,9 +184,11 @@ static void list_cpus(void)
 			order_suffix(cpus[i].busy_cycles, &bcycles, &bsuffix);
 			order_suffix(cpus[i].idle_cycles, &icycles, &isuffix);
 
-			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c\n",
+			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c"
+			    " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
 			    cpus[i].frequency_mhz, bcycles, bsuffix,
-			    icycles, isuffix);
+			    icycles, isuffix, cpus[i].steals, cpus[i].migrations,
+			    cpus[i].page_faults, cpus[i].large_pages);
 		} else
 			printf("inactive\n");
 	}
@@ -33,6 +33,7 @@
 #include <ns.h>
 #include <async.h>
 #include <errno.h>
+#include <str.h>
 #include "../tester.h"
 
 #define TEST_FILE	"/tmp/testfile"
@@ -40,6 +41,8 @@
 const char text[] = "Hello world!";
 
 int fd;
+static int pager_handle;
+static async_sess_t *vfs_pager_sess;
 
 static void *create_paged_area(size_t size)
 {
@@ -60,7 +63,11 @@ static void *create_paged_area(size_t size)
 		return NULL;
 	}
 
-	async_sess_t *vfs_pager_sess;
+	rc = vfs_pager_handle(fd, &pager_handle);
+	if (rc != EOK) {
+		vfs_put(fd);
+		return NULL;
+	}
 
 	TPRINTF("Connecting to VFS pager...\n");
 
@@ -75,7 +82,8 @@ static void *create_paged_area(size_t size)
 	TPRINTF("Creating AS area...\n");
 
 	void *result = async_as_area_create(AS_AREA_ANY, size,
-	    AS_AREA_READ | AS_AREA_CACHEABLE, vfs_pager_sess, fd, 0, 0);
+	    AS_AREA_READ | AS_AREA_CACHEABLE, vfs_pager_sess, pager_handle,
+	    0, 0);
 	if (result == AS_MAP_FAILED) {
 		vfs_put(fd);
 		return NULL;
@@ -104,8 +112,31 @@ const char *test_pager1(void)
 
 	touch_area(buffer, buffer_len);
 
+	TPRINTF("\nCreating writable AS area...\n");
+
+	char *private = async_as_area_create(AS_AREA_ANY, buffer_len,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, vfs_pager_sess,
+	    pager_handle, 0, 0);
+	if (private == AS_MAP_FAILED) {
+		as_area_destroy(buffer);
+		vfs_put(fd);
+		return "Cannot allocate writable memory";
+	}
+
+	TPRINTF("Writing to writable AS area...\n");
+
+	const char *rv = NULL;
+	if (str_cmp(private, text) != 0)
+		rv = "Writable area does not contain the file";
+
+	private[0] = '!';
+
+	if (rv == NULL && str_cmp(buffer, text) != 0)
+		rv = "Write to writable area is visible in read-only area";
+
+	as_area_destroy(private);
 	as_area_destroy(buffer);
 	vfs_put(fd);
 
-	return NULL;
+	return rv;
 }
@@ -44,6 +44,7 @@
 #include <as.h>
 #include <assert.h>
 #include <bd.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <adt/list.h>
 #include <adt/hash_table.h>
@@ -59,20 +60,61 @@
 
 #define MAX_WRITE_RETRIES 10
 
+/** Maximum number of logical blocks read by one readahead request. */
+#define READAHEAD_MAX_BLOCKS	64
+/** Maximum number of bytes read by one readahead request. */
+#define READAHEAD_MAX_BYTES	65536
+
 /** Lock protecting the device connection list */
 static FIBRIL_MUTEX_INITIALIZE(dcl_lock);
 /** Device connection list head. */
 static LIST_INITIALIZE(dcl);
 
+/** Number of cache shards. */
+#define CACHE_SHARDS	8
+
+/** Block cache shard.
+ *
+ * Blocks are distributed among shards by their logical address, so that
+ * lookups of different blocks do not contend on a single lock.
+ */
+typedef struct {
+	/** Lock protecting the hash table and the counters. */
+	fibril_mutex_t lock;
+	hash_table_t block_hash;
+	uint64_t hits;            /**< Number of cache hits. */
+	uint64_t misses;          /**< Number of cache misses. */
+} cache_shard_t;
+
+/** Block cache.
+ *
+ * Locks are taken in the order shard lock, block lock, cache lock.
+ */
 typedef struct {
+	/** Lock protecting the free list and the fields below. */
 	fibril_mutex_t lock;
 	size_t lblock_size;       /**< Logical block size. */
 	unsigned blocks_cluster;  /**< Physical blocks per block_t */
 	unsigned block_count;     /**< Total number of blocks. */
 	unsigned blocks_cached;   /**< Number of cached blocks. */
-	hash_table_t block_hash;
+	cache_shard_t shard[CACHE_SHARDS];
 	list_t free_list;
 	enum cache_mode mode;
+	/** Current readahead window in logical blocks (1 means none). */
+	unsigned ra_window;
+	/** Upper limit of the readahead window. */
+	unsigned ra_window_max;
+	/** Block following the last readahead. */
+	aoff64_t ra_next;
+	uint64_t readahead;       /**< Number of blocks read ahead. */
+	uint64_t writebacks;      /**< Number of blocks written back. */
+	uint64_t write_requests;  /**< Number of write requests. */
+	/** Flusher fibril (write-back mode only). */
+	fid_t flusher;
+	/** Wakes up the flusher and signals its termination. */
+	fibril_condvar_t flush_cv;
+	/** The flusher should terminate. */
+	bool flusher_quit;
 } cache_t;
 
 typedef struct {
@@ -268,16 +310,26 @@ static const hash_table_ops_t cache_ops = {
 	.remove_callback = NULL
 };
 
+/** Get the cache shard holding a logical block. */
+static cache_shard_t *cache_shard(cache_t *cache, aoff64_t lba)
+{
+	return &cache->shard[lba % CACHE_SHARDS];
+}
+
+static errno_t cache_flusher(void *);
+
 errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
     enum cache_mode mode)
 {
 	devcon_t *devcon = devcon_search(service_id);
 	cache_t *cache;
+	unsigned i;
+
 	if (!devcon)
 		return ENOENT;
 	if (devcon->cache)
 		return EEXIST;
-	cache = malloc(sizeof(cache_t));
+	cache = calloc(1, sizeof(cache_t));
 	if (!cache)
 		return ENOMEM;
 
@@ -287,6 +339,10 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 	cache->block_count = blocks;
 	cache->blocks_cached = 0;
 	cache->mode = mode;
+	cache->ra_window = 1;
+	cache->ra_window_max = max(1, min(READAHEAD_MAX_BLOCKS,
+	    READAHEAD_MAX_BYTES / size));
+	fibril_condvar_initialize(&cache->flush_cv);
 
 	/* Allow 1:1 or small-to-large block size translation */
 	if (cache->lblock_size % devcon->pblock_size != 0) {
@@ -296,19 +352,43 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 
 	cache->blocks_cluster = cache->lblock_size / devcon->pblock_size;
 
-	if (!hash_table_create(&cache->block_hash, 0, 0, &cache_ops)) {
-		free(cache);
-		return ENOMEM;
+	for (i = 0; i < CACHE_SHARDS; i++) {
+		fibril_mutex_initialize(&cache->shard[i].lock);
+		if (!hash_table_create(&cache->shard[i].block_hash, 0, 0,
+		    &cache_ops)) {
+			while (i > 0)
+				hash_table_destroy(&cache->shard[--i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
 	}
 
 	devcon->cache = cache;
+
+	/* Dirty blocks only linger in the cache in write-back mode. */
+	if (mode == CACHE_MODE_WB) {
+		cache->flusher = fibril_create(cache_flusher, devcon);
+		if (cache->flusher == 0) {
+			devcon->cache = NULL;
+			for (i = 0; i < CACHE_SHARDS; i++)
+				hash_table_destroy(&cache->shard[i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
+
+		fibril_add_ready(cache->flusher);
+	}
+
 	return EOK;
 }
 
+static errno_t cache_flush(devcon_t *);
+
 errno_t block_cache_fini(service_id_t service_id)
 {
 	devcon_t *devcon = devcon_search(service_id);
 	cache_t *cache;
+	unsigned i;
 	errno_t rc;
 
 	if (!devcon)
@@ -317,36 +397,109 @@ errno_t block_cache_fini(service_id_t service_id)
 		return EOK;
 	cache = devcon->cache;
 
+	/* Stop the flusher. */
+	if (cache->flusher != 0) {
+		fibril_mutex_lock(&cache->lock);
+		cache->flusher_quit = true;
+		fibril_condvar_broadcast(&cache->flush_cv);
+		while (cache->flusher != 0)
+			fibril_condvar_wait(&cache->flush_cv, &cache->lock);
+		fibril_mutex_unlock(&cache->lock);
+	}
+
 	/*
 	 * We are expecting to find all blocks for this device handle on the
-	 * free list, i.e. the block reference count should be zero. Do not
-	 * bother with the cache and block locks because we are single-threaded.
+	 * free list, i.e. the block reference count should be zero. Write
+	 * back the dirty ones first.
+	 */
+	rc = cache_flush(devcon);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * Do not bother with the cache and block locks because we are
+	 * single-threaded.
 	 */
 	while (!list_empty(&cache->free_list)) {
 		block_t *b = list_get_instance(list_first(&cache->free_list),
 		    block_t, free_link);
 
 		list_remove(&b->free_link);
-		if (b->dirty) {
-			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, b->size);
-			if (rc != EOK)
-				return rc;
-		}
-
-		hash_table_remove_item(&cache->block_hash, &b->hash_link);
+		hash_table_remove_item(&cache_shard(cache, b->lba)->block_hash,
+		    &b->hash_link);
 
 		free(b->data);
 		free(b);
 	}
 
-	hash_table_destroy(&cache->block_hash);
+	for (i = 0; i < CACHE_SHARDS; i++)
+		hash_table_destroy(&cache->shard[i].block_hash);
 	devcon->cache = NULL;
 	free(cache);
 
 	return EOK;
 }
 
+/** Get block cache statistics.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param stats		Place to store the statistics.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_cache_get_stats(service_id_t service_id,
+    block_cache_stats_t *stats)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+	unsigned i;
+
+	if (!devcon)
+		return ENOENT;
+	if (!devcon->cache)
+		return ENOENT;
+	cache = devcon->cache;
+
+	memset(stats, 0, sizeof(block_cache_stats_t));
+
+	for (i = 0; i < CACHE_SHARDS; i++) {
+		fibril_mutex_lock(&cache->shard[i].lock);
+		stats->hits += cache->shard[i].hits;
+		stats->misses += cache->shard[i].misses;
+		fibril_mutex_unlock(&cache->shard[i].lock);
+	}
+
+	fibril_mutex_lock(&cache->lock);
+	stats->readahead = cache->readahead;
+	stats->writebacks = cache->writebacks;
+	stats->write_requests = cache->write_requests;
+	stats->blocks_cached = cache->blocks_cached;
+	fibril_mutex_unlock(&cache->lock);
+
+	return EOK;
+}
+
+/** Write cached blocks back to the device and account for it.
+ *
+ * The cache lock must not be held.
+ */
+static errno_t cache_write_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt,
+    void *data, size_t size)
+{
+	cache_t *cache = devcon->cache;
+	errno_t rc;
+
+	rc = write_blocks(devcon, ba, cnt, data, size);
+
+	fibril_mutex_lock(&cache->lock);
+	cache->write_requests++;
+	if (rc == EOK)
+		cache->writebacks += cnt / cache->blocks_cluster;
+	fibril_mutex_unlock(&cache->lock);
+
+	return rc;
+}
+
 #define CACHE_LO_WATERMARK	10
 #define CACHE_HI_WATERMARK	20
 static bool cache_can_grow(cache_t *cache)
@@ -369,6 +522,542 @@ static void block_initialize(block_t *b)
 	link_initialize(&b->free_link);
 }
 
+/** Drop a reference to a block without syncing or freeing it.
+ *
+ * If the last reference is dropped, the block is put on the free list.
+ *
+ * @param cache		Cache.
+ * @param b		Block.
+ */
+static void cache_block_release(cache_t *cache, block_t *b)
+{
+	fibril_mutex_lock(&b->lock);
+	if (--b->refcnt == 0) {
+		fibril_mutex_lock(&cache->lock);
+		list_append(&b->free_link, &cache->free_list);
+		fibril_mutex_unlock(&cache->lock);
+	}
+	fibril_mutex_unlock(&b->lock);
+}
+
+/** Maximum number of dirty blocks written back in one flusher pass. */
+#define FLUSH_BATCH_BLOCKS	64
+/** Interval between flusher passes in microseconds. */
+#define FLUSH_INTERVAL		1000000
+
+static int cache_block_pba_cmp(const void *a, const void *b)
+{
+	const block_t *ba = *(const block_t **) a;
+	const block_t *bb = *(const block_t **) b;
+
+	if (ba->pba < bb->pba)
+		return -1;
+	if (ba->pba > bb->pba)
+		return 1;
+	return 0;
+}
+
+/** Write back one batch of dirty unused blocks.
+ *
+ * Runs of blocks which are adjacent on the device are written with a single
+ * request.
+ *
+ * @param devcon	Device connection.
+ * @param nflushed	Place to store the number of blocks written back.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_flush_batch(devcon_t *devcon, unsigned *nflushed)
+{
+	cache_t *cache = devcon->cache;
+	block_t *batch[FLUSH_BATCH_BLOCKS];
+	size_t bsize = cache->lblock_size;
+	unsigned n = 0;
+	unsigned i, j, k;
+	errno_t rc = EOK;
+
+	/*
+	 * Collect dirty blocks from the free list. Take a reference so that
+	 * the blocks are not recycled while being written. The block lock
+	 * ranks above the cache lock, hence the trylock.
+	 */
+	fibril_mutex_lock(&cache->lock);
+	list_foreach_safe(cache->free_list, cur, next) {
+		block_t *b = list_get_instance(cur, block_t, free_link);
+
+		if (n == FLUSH_BATCH_BLOCKS)
+			break;
+		if (!b->dirty || !fibril_mutex_trylock(&b->lock))
+			continue;
+
+		assert(b->refcnt == 0);
+		b->refcnt++;
+		list_remove(&b->free_link);
+		fibril_mutex_unlock(&b->lock);
+		batch[n++] = b;
+	}
+	fibril_mutex_unlock(&cache->lock);
+
+	qsort(batch, n, sizeof(block_t *), cache_block_pba_cmp);
+
+	for (i = 0; i < n; i = j) {
+		/* Find the run of adjacent blocks starting at i. */
+		for (j = i + 1; j < n; j++) {
+			if (batch[j]->pba != batch[j - 1]->pba +
+			    cache->blocks_cluster)
+				break;
+		}
+
+		uint8_t *buf = malloc((j - i) * bsize);
+		if (buf == NULL) {
+			/* Write the blocks one by one. */
+			j = i + 1;
+		}
+
+		for (k = i; k < j; k++) {
+			fibril_mutex_lock(&batch[k]->lock);
+			if (buf != NULL)
+				memcpy(buf + (k - i) * bsize, batch[k]->data, bsize);
+			batch[k]->dirty = false;
+			if (buf != NULL)
+				fibril_mutex_unlock(&batch[k]->lock);
+		}
+
+		errno_t wrc;
+		if (buf != NULL) {
+			wrc = cache_write_blocks(devcon, batch[i]->pba,
+			    (j - i) * cache->blocks_cluster, buf, (j - i) * bsize);
+			free(buf);
+		} else {
+			wrc = cache_write_blocks(devcon, batch[i]->pba,
+			    cache->blocks_cluster, batch[i]->data, bsize);
+			fibril_mutex_unlock(&batch[i]->lock);
+		}
+
+		for (k = i; k < j; k++) {
+			fibril_mutex_lock(&batch[k]->lock);
+			if (wrc == EOK) {
+				batch[k]->write_failures = 0;
+			} else if (batch[k]->write_failures < MAX_WRITE_RETRIES) {
+				/* Keep the block dirty for another try. */
+				batch[k]->dirty = true;
+				batch[k]->write_failures++;
+			} else {
+				printf("Too many errors writing block %"
+				    PRIuOFF64 " from device handle %" PRIun "\n"
+				    "SEVERE DATA LOSS POSSIBLE\n",
+				    batch[k]->lba, devcon->service_id);
+			}
+			fibril_mutex_unlock(&batch[k]->lock);
+		}
+
+		if (wrc != EOK)
+			rc = wrc;
+	}
+
+	for (i = 0; i < n; i++)
+		cache_block_release(cache, batch[i]);
+
+	*nflushed = n;
+	return rc;
+}
+
+/** Write back all dirty unused blocks.
+ *
+ * @param devcon	Device connection.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_flush(devcon_t *devcon)
+{
+	unsigned n;
+	errno_t rc;
+
+	do {
+		rc = cache_flush_batch(devcon, &n);
+		if (rc != EOK)
+			return rc;
+	} while (n == FLUSH_BATCH_BLOCKS);
+
+	return EOK;
+}
+
+/** Block cache flusher fibril.
+ *
+ * Periodically writes back dirty blocks in write-back mode, or sooner when
+ * woken up by a block_get() that could not find a clean block to recycle.
+ *
+ * @param arg		Device connection.
+ *
+ * @return		EOK.
+ */
+static errno_t cache_flusher(void *arg)
+{
+	devcon_t *devcon = (devcon_t *) arg;
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->lock);
+	while (!cache->flusher_quit) {
+		(void) fibril_condvar_wait_timeout(&cache->flush_cv,
+		    &cache->lock, FLUSH_INTERVAL);
+		if (cache->flusher_quit)
+			break;
+
+		fibril_mutex_unlock(&cache->lock);
+		(void) cache_flush(devcon);
+		fibril_mutex_lock(&cache->lock);
+	}
+
+	cache->flusher = 0;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	fibril_mutex_unlock(&cache->lock);
+	return EOK;
+}
+
+/** Get an unused block structure for a new cache entry.
+ *
+ * Either allocate a new block or recycle the least recently used clean block
+ * from the free list. If all unused blocks are dirty, write them back first.
+ *
+ * No shard lock may be held by the caller.
+ *
+ * @param devcon	Device connection.
+ * @param rb		Place to store the block, which is not in any shard.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_block_alloc(devcon_t *devcon, block_t **rb)
+{
+	cache_t *cache = devcon->cache;
+	block_t *b;
+	unsigned n;
+
+	fibril_mutex_lock(&cache->lock);
+	while (true) {
+		if (cache_can_grow(cache)) {
+			/*
+			 * We can grow the cache by allocating new blocks.
+			 * Should the allocation fail, we fail over and try to
+			 * recycle a block from the cache.
+			 */
+			cache->blocks_cached++;
+			fibril_mutex_unlock(&cache->lock);
+
+			b = malloc(sizeof(block_t));
+			if (b != NULL) {
+				b->data = malloc(cache->lblock_size);
+				if (b->data != NULL) {
+					*rb = b;
+					return EOK;
+				}
+				free(b);
+			}
+
+			fibril_mutex_lock(&cache->lock);
+			cache->blocks_cached--;
+		}
+
+		if (list_empty(&cache->free_list)) {
+			fibril_mutex_unlock(&cache->lock);
+			return ENOMEM;
+		}
+
+		/* Find the least recently used clean block. */
+		b = NULL;
+		list_foreach(cache->free_list, free_link, block_t, fb) {
+			if (!fb->dirty) {
+				b = fb;
+				break;
+			}
+		}
+
+		if (b == NULL) {
+			/*
+			 * All unused blocks are dirty. Write them back
+			 * while not holding the cache lock so that
+			 * concurrency is not impeded.
+			 */
+			fibril_mutex_unlock(&cache->lock);
+
+			/*
+			 * Blocks which failed to be written stay dirty for
+			 * another try, unless they have failed too many times.
+			 * Others may have been written, so keep looking for
+			 * a clean block.
+			 */
+			(void) cache_flush_batch(devcon, &n);
+
+			/* Let whoever holds the dirty blocks release them. */
+			if (n == 0)
+				fibril_yield();
+			fibril_mutex_lock(&cache->lock);
+			continue;
+		}
+
+		list_remove(&b->free_link);
+		fibril_mutex_unlock(&cache->lock);
+
+		/*
+		 * Take the block out of its shard. Somebody may have got
+		 * a reference to it in the meantime, in which case it is
+		 * not ours to recycle.
+		 */
+		cache_shard_t *shard = cache_shard(cache, b->lba);
+		fibril_mutex_lock(&shard->lock);
+		fibril_mutex_lock(&b->lock);
+		if (b->refcnt == 0 && !link_in_use(&b->free_link)) {
+			hash_table_remove_item(&shard->block_hash,
+			    &b->hash_link);
+			fibril_mutex_unlock(&b->lock);
+			fibril_mutex_unlock(&shard->lock);
+			*rb = b;
+			return EOK;
+		}
+		fibril_mutex_unlock(&b->lock);
+		fibril_mutex_unlock(&shard->lock);
+
+		fibril_mutex_lock(&cache->lock);
+	}
+}
+
+/** Return an unused block structure obtained by cache_block_alloc().
+ *
+ * @param cache		Cache.
+ * @param b		Block which is not in any shard.
+ */
+static void cache_block_free(cache_t *cache, block_t *b)
+{
+	free(b->data);
+	free(b);
+
+	fibril_mutex_lock(&cache->lock);
+	cache->blocks_cached--;
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Check whether a block is cached, without blocking.
+ *
+ * @param cache		Cache.
+ * @param lba		Logical block address.
+ * @param held		Shard whose lock is held by the caller.
+ *
+ * @return		True if the block is cached. False if it is not or
+ *			if its shard is busy.
+ */
+static bool cache_block_present(cache_t *cache, aoff64_t lba,
+    cache_shard_t *held)
+{
+	cache_shard_t *shard = cache_shard(cache, lba);
+	bool present;
+
+	if (shard != held && !fibril_mutex_trylock(&shard->lock))
+		return false;
+
+	present = hash_table_find(&shard->block_hash, &lba) != NULL;
+
+	if (shard != held)
+		fibril_mutex_unlock(&shard->lock);
+	return present;
+}
+
+/** Adjust the readahead window after a cache miss.
+ *
+ * A miss is considered sequential if it continues the previous readahead
+ * or if the preceding block is cached. The window doubles with each
+ * sequential miss and collapses on a random one.
+ *
+ * @param cache		Cache.
+ * @param ba		Logical address of the missed block.
+ * @param shard		Shard of @a ba, locked by the caller.
+ *
+ * @return		Number of blocks, including @a ba, to read.
+ */
+static unsigned cache_ra_window(cache_t *cache, aoff64_t ba,
+    cache_shard_t *shard)
+{
+	bool seq;
+	unsigned window;
+
+	seq = ba > 0 && cache_block_present(cache, ba - 1, shard);
+
+	fibril_mutex_lock(&cache->lock);
+	if (seq || ba == cache->ra_next) {
+		cache->ra_window = min(cache->ra_window * 2,
+		    cache->ra_window_max);
+	} else {
+		cache->ra_window = 1;
+	}
+	window = cache->ra_window;
+	fibril_mutex_unlock(&cache->lock);
+
+	return window;
+}
+
+/** Get a block structure for readahead.
+ *
+ * Readahead must not delay the request, so only a new block is allocated.
+ * The cache may grow past its high watermark by one readahead window;
+ * block_put() shrinks it back as the blocks are used.
+ *
+ * @param cache		Cache.
+ *
+ * @return		Block or NULL if none is readily available.
+ */
+static block_t *cache_ra_block_alloc(cache_t *cache)
+{
+	block_t *b;
+
+	fibril_mutex_lock(&cache->lock);
+	if (cache->blocks_cached >= CACHE_HI_WATERMARK + cache->ra_window_max) {
+		fibril_mutex_unlock(&cache->lock);
+		return NULL;
+	}
+	cache->blocks_cached++;
+	fibril_mutex_unlock(&cache->lock);
+
+	b = malloc(sizeof(block_t));
+	if (b != NULL) {
+		b->data = malloc(cache->lblock_size);
+		if (b->data != NULL)
+			return b;
+		free(b);
+	}
+
+	fibril_mutex_lock(&cache->lock);
+	cache->blocks_cached--;
+	fibril_mutex_unlock(&cache->lock);
+	return NULL;
+}
+
+/** Instantiate blocks following a missed block for readahead.
+ *
+ * The blocks are inserted into the cache and locked, so that concurrent
+ * block_get() calls wait for the data to be read.
+ *
+ * The caller holds the lock of the missed block but no shard lock. Shard
+ * locks rank above block locks, so readahead stops at a busy shard rather
+ * than wait for it.
+ *
+ * @param devcon	Device connection.
+ * @param ba		Logical address of the missed block.
+ * @param window	Readahead window including the missed block.
+ * @param ra		Array for storing the readahead blocks.
+ *
+ * @return		Number of readahead blocks.
+ */
+static unsigned cache_ra_blocks_get(devcon_t *devcon, aoff64_t ba,
+    unsigned window, block_t **ra)
+{
+	cache_t *cache = devcon->cache;
+	unsigned n;
+
+	for (n = 0; n + 1 < window; n++) {
+		aoff64_t lba = ba + n + 1;
+		cache_shard_t *shard = cache_shard(cache, lba);
+
+		/* Stop at the end of the device. */
+		if (ba_ltop(devcon, lba) + cache->blocks_cluster >=
+		    devcon->pblocks)
+			break;
+
+		block_t *b = cache_ra_block_alloc(cache);
+		if (b == NULL)
+			break;
+
+		if (!fibril_mutex_trylock(&shard->lock)) {
+			cache_block_free(cache, b);
+			break;
+		}
+
+		/* Stop at a cached block. */
+		if (hash_table_find(&shard->block_hash, &lba) != NULL) {
+			fibril_mutex_unlock(&shard->lock);
+			cache_block_free(cache, b);
+			break;
+		}
+
+		block_initialize(b);
+		b->service_id = devcon->service_id;
+		b->size = cache->lblock_size;
+		b->lba = lba;
+		b->pba = ba_ltop(devcon, lba);
+		hash_table_insert(&shard->block_hash, &b->hash_link);
+		fibril_mutex_lock(&b->lock);
+		fibril_mutex_unlock(&shard->lock);
+		ra[n] = b;
+	}
+
+	fibril_mutex_lock(&cache->lock);
+	cache->ra_next = ba + n + 1;
+	cache->readahead += n;
+	fibril_mutex_unlock(&cache->lock);
+
+	return n;
+}
+
+/** Read a missed block together with its readahead blocks.
+ *
+ * All blocks are read with a single request. Should that fail, the blocks
+ * are read one by one so that an error only affects the block that caused
+ * it.
+ *
+ * @param devcon	Device connection.
+ * @param b		Missed block.
+ * @param ra		Readahead blocks following @a b.
+ * @param nra		Number of readahead blocks.
+ *
+ * @return		EOK on success or an error code reading @a b.
+ */
+static errno_t cache_ra_read(devcon_t *devcon, block_t *b, block_t **ra,
+    unsigned nra)
+{
+	cache_t *cache = devcon->cache;
+	size_t bsize = cache->lblock_size;
+	uint8_t *buf;
+	unsigned i;
+	errno_t rc;
+
+	buf = malloc((nra + 1) * bsize);
+	if (buf != NULL) {
+		rc = read_blocks(devcon, b->pba,
+		    (nra + 1) * cache->blocks_cluster, buf, (nra + 1) * bsize);
+		if (rc == EOK) {
+			memcpy(b->data, buf, bsize);
+			for (i = 0; i < nra; i++)
+				memcpy(ra[i]->data, buf + (i + 1) * bsize, bsize);
+			free(buf);
+			return EOK;
+		}
+
+		free(buf);
+	}
+
+	for (i = 0; i < nra; i++) {
+		if (read_blocks(devcon, ra[i]->pba, cache->blocks_cluster,
+		    ra[i]->data, bsize) != EOK)
+			ra[i]->toxic = true;
+	}
+
+	return read_blocks(devcon, b->pba, cache->blocks_cluster, b->data,
+	    bsize);
+}
+
+/** Release readahead blocks after their data has been read.
+ *
+ * @param cache		Cache.
+ * @param ra		Readahead blocks.
+ * @param nra		Number of readahead blocks.
+ */
+static void cache_ra_blocks_put(cache_t *cache, block_t **ra, unsigned nra)
+{
+	unsigned i;
+
+	for (i = 0; i < nra; i++) {
+		fibril_mutex_unlock(&ra[i]->lock);
+		cache_block_release(cache, ra[i]);
+	}
+}
+
 /** Instantiate a block in memory and get a reference to it.
  *
  * @param block			Pointer to where the function will store the
@@ -385,8 +1074,11 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 {
 	devcon_t *devcon;
 	cache_t *cache;
+	cache_shard_t *shard;
 	block_t *b;
-	link_t *link;
+	block_t *ra[READAHEAD_MAX_BLOCKS];
+	unsigned window;
+	unsigned nra;
 	aoff64_t p_ba;
 	errno_t rc;
 
@@ -396,6 +1088,7 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 	assert(devcon->cache);
 
 	cache = devcon->cache;
+	shard = cache_shard(cache, ba);
 
 	/*
 	 * Check whether the logical block (or part of it) is beyond
@@ -408,12 +1101,11 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 		return EIO;
 	}
 
-retry:
 	rc = EOK;
 	b = NULL;
 
-	fibril_mutex_lock(&cache->lock);
-	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	fibril_mutex_lock(&shard->lock);
+	ht_link_t *hlink = hash_table_find(&shard->block_hash, &ba);
 	if (hlink) {
 	found:
 		/*
@@ -421,144 +1113,95 @@ retry:
 		 */
 		b = hash_table_get_inst(hlink, block_t, hash_link);
 		fibril_mutex_lock(&b->lock);
-		if (b->refcnt++ == 0)
-			list_remove(&b->free_link);
+		if (b->refcnt++ == 0) {
+			fibril_mutex_lock(&cache->lock);
+			if (link_in_use(&b->free_link))
+				list_remove(&b->free_link);
+			fibril_mutex_unlock(&cache->lock);
+		}
 		if (b->toxic)
 			rc = EIO;
 		fibril_mutex_unlock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		shard->hits++;
+		fibril_mutex_unlock(&shard->lock);
 	} else {
 		/*
-		 * The block was not found in the cache.
+		 * The block was not found in the cache. Get a block structure
+		 * while not holding the shard lock, as this may involve
+		 * writing back dirty blocks.
 		 */
-		if (cache_can_grow(cache)) {
-			/*
-			 * We can grow the cache by allocating new blocks.
-			 * Should the allocation fail, we fail over and try to
-			 * recycle a block from the cache.
-			 */
-			b = malloc(sizeof(block_t));
-			if (!b)
-				goto recycle;
-			b->data = malloc(cache->lblock_size);
-			if (!b->data) {
-				free(b);
-				b = NULL;
-				goto recycle;
-			}
-			cache->blocks_cached++;
-		} else {
-			/*
-			 * Try to recycle a block from the free list.
-			 */
-		recycle:
-			if (list_empty(&cache->free_list)) {
-				fibril_mutex_unlock(&cache->lock);
-				rc = ENOMEM;
-				goto out;
-			}
-			link = list_first(&cache->free_list);
-			b = list_get_instance(link, block_t, free_link);
+		fibril_mutex_unlock(&shard->lock);
 
-			fibril_mutex_lock(&b->lock);
-			if (b->dirty) {
-				/*
-				 * The block needs to be written back to the
-				 * device before it changes identity. Do this
-				 * while not holding the cache lock so that
-				 * concurrency is not impeded. Also move the
-				 * block to the end of the free list so that we
-				 * do not slow down other instances of
-				 * block_get() draining the free list.
-				 */
-				list_remove(&b->free_link);
-				list_append(&b->free_link, &cache->free_list);
-				fibril_mutex_unlock(&cache->lock);
-				rc = write_blocks(devcon, b->pba,
-				    cache->blocks_cluster, b->data, b->size);
-				if (rc != EOK) {
-					/*
-					 * We did not manage to write the block
-					 * to the device. Keep it around for
-					 * another try. Hopefully, we will grab
-					 * another block next time.
-					 */
-					if (b->write_failures < MAX_WRITE_RETRIES) {
-						b->write_failures++;
-						fibril_mutex_unlock(&b->lock);
-						goto retry;
-					} else {
-						printf("Too many errors writing block %"
-						    PRIuOFF64 "from device handle %" PRIun "\n"
-						    "SEVERE DATA LOSS POSSIBLE\n",
-						    b->lba, devcon->service_id);
-					}
-				} else
-					b->write_failures = 0;
-
-				b->dirty = false;
-				if (!fibril_mutex_trylock(&cache->lock)) {
-					/*
-					 * Somebody is probably racing with us.
-					 * Unlock the block and retry.
-					 */
-					fibril_mutex_unlock(&b->lock);
-					goto retry;
-				}
-				hlink = hash_table_find(&cache->block_hash, &ba);
-				if (hlink) {
-					/*
-					 * Someone else must have already
-					 * instantiated the block while we were
-					 * not holding the cache lock.
-					 * Leave the recycled block on the
-					 * freelist and continue as if we
-					 * found the block of interest during
-					 * the first try.
-					 */
-					fibril_mutex_unlock(&b->lock);
-					goto found;
-				}
-
-			}
-			fibril_mutex_unlock(&b->lock);
+		rc = cache_block_alloc(devcon, &b);
+		if (rc != EOK) {
+			b = NULL;
+			goto out;
+		}
 
+		fibril_mutex_lock(&shard->lock);
+		hlink = hash_table_find(&shard->block_hash, &ba);
+		if (hlink) {
 			/*
-			 * Unlink the block from the free list and the hash
-			 * table.
+			 * Someone else must have already instantiated the
+			 * block while we were not holding the shard lock.
+			 * Continue as if we found the block of interest
+			 * during the first try.
 			 */
-			list_remove(&b->free_link);
-			hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			cache_block_free(cache, b);
+			goto found;
 		}
 
+		shard->misses++;
+
 		block_initialize(b);
 		b->service_id = service_id;
 		b->size = cache->lblock_size;
 		b->lba = ba;
 		b->pba = ba_ltop(devcon, b->lba);
-		hash_table_insert(&cache->block_hash, &b->hash_link);
+		hash_table_insert(&shard->block_hash, &b->hash_link);
 
 		/*
-		 * Lock the block before releasing the cache lock. Thus we don't
+		 * Lock the block before releasing the shard lock. Thus we don't
 		 * kill concurrent operations on the cache while doing I/O on
 		 * the block.
 		 */
 		fibril_mutex_lock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+
+		window = 1;
+		if (!(flags & BLOCK_FLAGS_NOREAD))
+			window = cache_ra_window(cache, ba, shard);
+
+		fibril_mutex_unlock(&shard->lock);
+
+		/*
+		 * If the access looks sequential, read the following blocks
+		 * along with this one.
+		 */
+		nra = 0;
+		if (window > 1)
+			nra = cache_ra_blocks_get(devcon, ba, window, ra);
 
 		if (!(flags & BLOCK_FLAGS_NOREAD)) {
 			/*
 			 * The block contains old or no data. We need to read
 			 * the new contents from the device.
 			 */
-			rc = read_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, cache->lblock_size);
+			if (nra > 0) {
+				rc = cache_ra_read(devcon, b, ra, nra);
+			} else {
+				rc = read_blocks(devcon, b->pba,
+				    cache->blocks_cluster, b->data,
+				    cache->lblock_size);
+			}
 			if (rc != EOK)
 				b->toxic = true;
 		} else
 			rc = EOK;
 
 		fibril_mutex_unlock(&b->lock);
+
+		if (nra > 0)
+			cache_ra_blocks_put(cache, ra, nra);
 	}
 out:
 	if ((rc != EOK) && b) {
@@ -582,6 +1225,7 @@ errno_t block_put(block_t *block)
 {
 	devcon_t *devcon = devcon_search(block->service_id);
 	cache_t *cache;
+	cache_shard_t *shard;
 	unsigned blocks_cached;
 	enum cache_mode mode;
 	errno_t rc = EOK;
@@ -591,6 +1235,7 @@ errno_t block_put(block_t *block)
 	assert(block->refcnt >= 1);
 
 	cache = devcon->cache;
+	shard = cache_shard(cache, block->lba);
 
 retry:
 	fibril_mutex_lock(&cache->lock);
@@ -610,15 +1255,15 @@ retry:
 		block->dirty = false;	/* will not write back toxic block */
 	if (block->dirty && (block->refcnt == 1) &&
 	    (blocks_cached > CACHE_HI_WATERMARK || mode != CACHE_MODE_WB)) {
-		rc = write_blocks(devcon, block->pba, cache->blocks_cluster,
-		    block->data, block->size);
+		rc = cache_write_blocks(devcon, block->pba,
+		    cache->blocks_cluster, block->data, block->size);
 		if (rc == EOK)
 			block->write_failures = 0;
 		block->dirty = false;
 	}
 	fibril_mutex_unlock(&block->lock);
 
-	fibril_mutex_lock(&cache->lock);
+	fibril_mutex_lock(&shard->lock);
 	fibril_mutex_lock(&block->lock);
 	if (!--block->refcnt) {
 		/*
@@ -626,6 +1271,7 @@ retry:
 		 * block or put it on the free list. In case of an I/O error,
 		 * free the block.
 		 */
+		fibril_mutex_lock(&cache->lock);
 		if ((cache->blocks_cached > CACHE_HI_WATERMARK) ||
 		    (rc != EOK)) {
 			/*
@@ -642,8 +1288,9 @@ retry:
 
 				if (block->write_failures < MAX_WRITE_RETRIES) {
 					block->write_failures++;
-					fibril_mutex_unlock(&block->lock);
 					fibril_mutex_unlock(&cache->lock);
+					fibril_mutex_unlock(&block->lock);
+					fibril_mutex_unlock(&shard->lock);
 					goto retry;
 				} else {
 					printf("Too many errors writing block %"
@@ -655,12 +1302,14 @@ retry:
 			/*
 			 * Take the block out of the cache and free it.
 			 */
-			hash_table_remove_item(&cache->block_hash, &block->hash_link);
+			hash_table_remove_item(&shard->block_hash,
+			    &block->hash_link);
+			cache->blocks_cached--;
+			fibril_mutex_unlock(&cache->lock);
 			fibril_mutex_unlock(&block->lock);
+			fibril_mutex_unlock(&shard->lock);
 			free(block->data);
 			free(block);
-			cache->blocks_cached--;
-			fibril_mutex_unlock(&cache->lock);
 			return rc;
 		}
 		/*
@@ -672,14 +1321,16 @@ retry:
 			 * lock. Release everything and retry.
 			 */
 			block->refcnt++;
-			fibril_mutex_unlock(&block->lock);
 			fibril_mutex_unlock(&cache->lock);
+			fibril_mutex_unlock(&block->lock);
+			fibril_mutex_unlock(&shard->lock);
 			goto retry;
 		}
 		list_append(&block->free_link, &cache->free_list);
+		fibril_mutex_unlock(&cache->lock);
 	}
 	fibril_mutex_unlock(&block->lock);
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&shard->lock);
 
 	return rc;
 }
@@ -714,6 +1365,30 @@ errno_t block_seqread(service_id_t service_id, void *buf, size_t *bufpos,
 	while (left > 0) {
 		size_t rd;
 
+		if (*bufpos == *buflen && left >= block_size &&
+		    *pos % block_size == 0) {
+			/*
+			 * The communication buffer is empty and at least one
+			 * whole block is wanted. Read the whole blocks directly
+			 * into the destination buffer, at most
+			 * READAHEAD_MAX_BYTES per request to stay within the
+			 * IPC data transfer limit.
+			 */
+			size_t nblocks = min(left / block_size,
+			    max(1, READAHEAD_MAX_BYTES / block_size));
+			errno_t rc;
+
+			rc = read_blocks(devcon, *pos / block_size, nblocks,
+			    dst + offset, nblocks * block_size);
+			if (rc != EOK)
+				return rc;
+
+			offset += nblocks * block_size;
+			*pos += nblocks * block_size;
+			left -= nblocks * block_size;
+			continue;
+		}
+
 		if (*bufpos + left < *buflen)
 			rd = left;
 		else
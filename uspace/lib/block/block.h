@@ -99,6 +99,22 @@ enum cache_mode {
 	CACHE_MODE_WB
 };
 
+/** Block cache statistics */
+typedef struct {
+	/** Number of block_get() calls satisfied from the cache */
+	uint64_t hits;
+	/** Number of block_get() calls which had to instantiate the block */
+	uint64_t misses;
+	/** Number of blocks read ahead */
+	uint64_t readahead;
+	/** Number of blocks written back to the device */
+	uint64_t writebacks;
+	/** Number of write requests sent to the device */
+	uint64_t write_requests;
+	/** Number of blocks currently cached */
+	unsigned blocks_cached;
+} block_cache_stats_t;
+
 extern errno_t block_init(service_id_t);
 extern void block_fini(service_id_t);
 
@@ -107,6 +123,7 @@ extern void *block_bb_get(service_id_t);
 
 extern errno_t block_cache_init(service_id_t, size_t, unsigned, enum cache_mode);
 extern errno_t block_cache_fini(service_id_t);
+extern errno_t block_cache_get_stats(service_id_t, block_cache_stats_t *);
 
 extern errno_t block_get(block_t **, service_id_t, aoff64_t, int);
 extern errno_t block_put(block_t *);
@@ -36,10 +36,14 @@
 #define _LIBC_amd64_RTLD_MODULE_H_
 
 #include <elf/elf_mod.h>
+#include <stddef.h>
+#include <rtld/module.h>
 
 /** ELF module load flags */
 #define RTLD_MODULE_LDF 0
 
+extern void *rtld_lazy_bind(module_t *, size_t);
+
 #endif
 
 /** @}
@@ -35,10 +35,12 @@
  */
 
 #include <mem.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <libarch/rtld/elf_dyn.h>
+#include <libarch/rtld/module.h>
 #include <rtld/symbol.h>
 #include <rtld/rtld.h>
 #include <rtld/rtld_debug.h>
@@ -49,6 +51,80 @@ void module_process_pre_arch(module_t *m)
 	/* Unused */
 }
 
+/** Prepare the PLT of a module for lazy binding.
+ *
+ * Each GOT slot of the PLT initially points back to its PLT entry,
+ * which pushes the index of the relocation and jumps to PLT0. PLT0
+ * pushes GOT[1] and jumps to GOT[2], i.e. to the lazy binding
+ * trampoline, which resolves the slot on the first call.
+ *
+ * @param m Module
+ * @return @c true if the PLT is set up for lazy binding, @c false
+ *         if it needs to be bound eagerly
+ */
+bool plt_lazy_process(module_t *m)
+{
+	elf_rela_t *rt = m->dyn.jmp_rel;
+	uintptr_t *got = m->dyn.plt_got;
+	size_t rt_entries;
+	size_t i;
+
+	if (m->dyn.plt_rel != DT_RELA || got == NULL)
+		return false;
+
+	rt_entries = m->dyn.plt_rel_sz / sizeof(elf_rela_t);
+
+	/* Only plain jump slots can be bound lazily. */
+	for (i = 0; i < rt_entries; ++i) {
+		if (ELF64_R_TYPE(rt[i].r_info) != R_X86_64_JUMP_SLOT)
+			return false;
+	}
+
+	for (i = 0; i < rt_entries; ++i)
+		*(uintptr_t *) (rt[i].r_offset + m->bias) += m->bias;
+
+	got[1] = (uintptr_t) m;
+	got[2] = (uintptr_t) m->rtld->lazy_trampoline;
+
+	atomic_fetch_add_explicit(&m->rtld->stats.lazy_slots, rt_entries,
+	    memory_order_relaxed);
+	return true;
+}
+
+/** Resolve a PLT slot on its first call.
+ *
+ * Called by the lazy binding trampoline.
+ *
+ * @param m   Module containing the PLT
+ * @param idx Index of the relocation of the slot in the PLT relocation table
+ * @return Address of the function
+ */
+void *rtld_lazy_bind(module_t *m, size_t idx)
+{
+	elf_rela_t *rela = &((elf_rela_t *) m->dyn.jmp_rel)[idx];
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_symbol_t *sym = &sym_table[ELF64_R_SYM(rela->r_info)];
+	const char *name = m->dyn.str_tab + sym->st_name;
+	elf_symbol_t *sym_def;
+	module_t *dest;
+	uintptr_t sym_addr;
+
+	sym_def = symbol_def_find(name, m, ssf_none, &dest);
+	if (sym_def == NULL) {
+		printf("Definition of '%s' not found.\n", name);
+		abort();
+	}
+
+	sym_addr = (uintptr_t) symbol_get_addr(sym_def, dest, NULL);
+	DPRINTF("lazy bind '%s' = 0x%zx\n", name, sym_addr);
+
+	*(uintptr_t *) (rela->r_offset + m->bias) = sym_addr;
+
+	atomic_fetch_add_explicit(&m->rtld->stats.lazy_binds, 1,
+	    memory_order_relaxed);
+	return (void *) sym_addr;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table with implicit addends.
  */
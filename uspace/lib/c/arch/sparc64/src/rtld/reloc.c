@@ -53,6 +53,12 @@ void module_process_pre_arch(module_t *m)
 	/* Unused */
 }
 
+bool plt_lazy_process(module_t *m)
+{
+	/* Lazy binding is not supported, bind the PLT eagerly. */
+	return false;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table with implicit addends.
  */
@@ -37,13 +37,18 @@
  * @brief	Userspace ELF module loader.
  *
  * This module allows loading ELF binaries (both executables and
- * shared objects) from VFS. The current implementation allocates
- * anonymous memory, fills it with segment data and then adjusts
- * the memory areas' flags to the final value. In the future,
- * the segments will be mapped directly from the file.
+ * shared objects) from VFS. Whole pages of segments are mapped
+ * directly from the file by the VFS pager, so they are loaded on
+ * demand and pages of read-only segments are shared by all tasks
+ * running the same binary. The rest of each segment is loaded into
+ * anonymous memory and the memory area's flags are then adjusted
+ * to the final value.
  */
 
+#include <async.h>
 #include <errno.h>
+#include <ipc/services.h>
+#include <ns.h>
 #include <stdio.h>
 #include <vfs/vfs.h>
 #include <stddef.h>
@@ -67,6 +72,9 @@ static errno_t elf_load_module(elf_ld_t *elf);
 static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry);
 static errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
 
+/** Session to the VFS pager used for mapping segments from files */
+static async_sess_t *elf_pager_sess = NULL;
+
 /** Load ELF binary from a file.
  *
  * Load an ELF binary from the specified file. If the file is
@@ -98,10 +106,12 @@ errno_t elf_load_file(int file, eld_flags_t flags, elf_finfo_t *info)
 	elf.fd = ofile;
 	elf.info = info;
 	elf.flags = flags;
+	elf.pager_handle = -1;
 
 	rc = elf_load_module(&elf);
 
 	vfs_put(ofile);
+
 	return rc;
 }
 
@@ -371,6 +381,87 @@ static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry)
 	return EOK;
 }
 
+/** Get session to the VFS pager.
+ *
+ * @return Session or NULL if the pager is not available.
+ */
+static async_sess_t *elf_pager_get(void)
+{
+	errno_t rc;
+
+	if (elf_pager_sess == NULL) {
+		elf_pager_sess = service_connect(SERVICE_VFS, INTERFACE_PAGER,
+		    0, &rc);
+	}
+
+	return elf_pager_sess;
+}
+
+/** Map whole pages of a segment from the file.
+ *
+ * The pages are paged in by the VFS pager on first access. Pages of
+ * read-only segments are shared with the VFS page cache, writable
+ * segments get private copies of the pages. A page which is not
+ * completely backed by the file (e.g. it contains a part of .bss)
+ * is left to be loaded into anonymous memory.
+ *
+ * @param elf   Loader state.
+ * @param entry Program header entry describing the segment.
+ * @param flags Final flags of the memory area.
+ *
+ * @return Size of the mapped part of the segment in bytes, zero if the
+ *         segment cannot be mapped from the file.
+ */
+static size_t load_segment_paged(elf_ld_t *elf, elf_segment_header_t *entry,
+    int flags)
+{
+	/* The caller wants to modify the segments. */
+	if ((elf->flags & ELDF_RW) != 0)
+		return 0;
+
+	/* Pages of the segment must correspond to pages of the file. */
+	if ((entry->p_offset % PAGE_SIZE) != (entry->p_vaddr % PAGE_SIZE))
+		return 0;
+
+	uintptr_t base = ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE);
+	size_t file_sz = entry->p_filesz + (entry->p_vaddr - base);
+	size_t paged_sz;
+
+	if (entry->p_memsz > entry->p_filesz)
+		paged_sz = ALIGN_DOWN(file_sz, PAGE_SIZE);
+	else
+		paged_sz = ALIGN_UP(file_sz, PAGE_SIZE);
+
+	if (paged_sz == 0)
+		return 0;
+
+	async_sess_t *pager = elf_pager_get();
+	if (pager == NULL)
+		return 0;
+
+	/*
+	 * The pager handle keeps the file open in VFS for the lifetime of
+	 * the task, so that our file handle can be put after loading.
+	 */
+	if (elf->pager_handle < 0) {
+		if (vfs_pager_handle(elf->fd, &elf->pager_handle) != EOK) {
+			elf->pager_handle = -1;
+			return 0;
+		}
+	}
+
+	void *a = async_as_area_create((uint8_t *) base + elf->bias, paged_sz,
+	    flags, pager, elf->pager_handle, ALIGN_DOWN(entry->p_offset,
+	    PAGE_SIZE), 0);
+	if (a == AS_MAP_FAILED) {
+		DPRINTF("paged memory mapping failed (%p, %zu)\n",
+		    (void *) (base + elf->bias), paged_sz);
+		return 0;
+	}
+
+	return paged_sz;
+}
+
 /** Load segment described by program header entry.
  *
  * @param elf	Loader state.
@@ -387,6 +478,8 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	void *seg_ptr;
 	uintptr_t seg_addr;
 	size_t mem_sz;
+	size_t file_sz;
+	size_t paged_sz;
 	aoff64_t pos;
 	errno_t rc;
 	size_t nr;
@@ -432,30 +525,51 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	    (void *) (entry->p_vaddr + bias +
 	    ALIGN_UP(entry->p_memsz, PAGE_SIZE)));
 
+	/*
+	 * Whole pages of the segment are mapped directly from the file,
+	 * if possible. The rest is loaded into anonymous memory.
+	 */
+	paged_sz = load_segment_paged(elf, entry, flags);
+	if (paged_sz >= mem_sz)
+		return EOK;
+
 	/*
 	 * For the course of loading, the area needs to be readable
 	 * and writeable.
 	 */
-	a = as_area_create((uint8_t *) base + bias, mem_sz,
-	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+	a = as_area_create((uint8_t *) base + bias + paged_sz,
+	    mem_sz - paged_sz, AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
 	    AS_AREA_UNPAGED);
 	if (a == AS_MAP_FAILED) {
 		DPRINTF("memory mapping failed (%p, %zu)\n",
-		    (void *) (base + bias), mem_sz);
+		    (void *) (base + bias + paged_sz), mem_sz - paged_sz);
 		return ENOMEM;
 	}
 
 	DPRINTF("as_area_create(%p, %#zx, %d) -> %p\n",
-	    (void *) (base + bias), mem_sz, flags, (void *) a);
+	    (void *) (base + bias + paged_sz), mem_sz - paged_sz, flags,
+	    (void *) a);
 
 	/*
 	 * Load segment data
 	 */
-	pos = entry->p_offset;
-	rc = vfs_read(elf->fd, &pos, seg_ptr, entry->p_filesz, &nr);
-	if (rc != EOK || nr != entry->p_filesz) {
-		DPRINTF("read error\n");
-		return EIO;
+	file_sz = entry->p_filesz + (entry->p_vaddr - base);
+	if (file_sz > paged_sz) {
+		uint8_t *load_ptr = (uint8_t *) base + bias + paged_sz;
+		size_t load_sz = file_sz - paged_sz;
+
+		if (paged_sz == 0) {
+			/* Not rounded down to the page boundary */
+			load_ptr = seg_ptr;
+			load_sz = entry->p_filesz;
+		}
+
+		pos = entry->p_offset + ((uintptr_t) load_ptr - seg_addr);
+		rc = vfs_read(elf->fd, &pos, load_ptr, load_sz, &nr);
+		if (rc != EOK || nr != load_sz) {
+			DPRINTF("read error\n");
+			return EIO;
+		}
 	}
 
 	/*
@@ -466,16 +580,17 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 		return EOK;
 
 	DPRINTF("as_area_change_flags(%p, %x)\n",
-	    (uint8_t *) base + bias, flags);
-	rc = as_area_change_flags((uint8_t *) base + bias, flags);
+	    (uint8_t *) base + bias + paged_sz, flags);
+	rc = as_area_change_flags((uint8_t *) base + bias + paged_sz, flags);
 	if (rc != EOK) {
 		DPRINTF("Failed to set memory area flags.\n");
 		return ENOMEM;
 	}
 
-	if (flags & AS_AREA_EXEC) {
-		/* Enforce SMC coherence for the segment */
-		if (smc_coherence(seg_ptr, entry->p_filesz))
+	if ((flags & AS_AREA_EXEC) && (file_sz > paged_sz)) {
+		/* Enforce SMC coherence for the loaded part of the segment */
+		if (smc_coherence((uint8_t *) base + bias + paged_sz,
+		    file_sz - paged_sz))
 			return ENOMEM;
 	}
 
@@ -31,6 +31,8 @@
  * @{
  */
 
+#include <align.h>
+#include <as.h>
 #include <assert.h>
 #include <errno.h>
 #include <fibril_synch.h>
@@ -43,8 +45,8 @@
 #include <str.h>
 #include <ns.h>
 
-/** Id of the first log we create at logger. */
-static sysarg_t default_log_id;
+/** The first log we create at logger. */
+static log_t default_log;
 
 /** Log messages are printed under this name. */
 static const char *log_prog_name;
@@ -63,9 +65,69 @@ static const char *log_level_names[] = {
 /** IPC session with the logger service. */
 static async_sess_t *logger_session;
 
+/** Logger ids of our logs, indexed by slot. */
+static sysarg_t log_ids[LOGGER_CLIENT_LOGS_MAX];
+
+/** Effective levels of our logs published by the logger (read-only). */
+static const logger_levels_t *log_levels;
+
 /** Maximum length of a single log message (in bytes). */
 #define MESSAGE_BUFFER_SIZE 4096
 
+/** Size of the buffer collecting messages for the logger (in bytes). */
+#define BATCH_BUFFER_SIZE LOGGER_BATCH_SIZE_MAX
+
+/** Delay before a partially filled batch is sent (in microseconds). */
+#define BATCH_FLUSH_DELAY 50000
+
+static_assert(BATCH_BUFFER_SIZE >=
+    sizeof(logger_batch_msg_t) + MESSAGE_BUFFER_SIZE, "");
+
+/** Guards the batch of messages. */
+static FIBRIL_MUTEX_INITIALIZE(batch_lock);
+
+/** Messages not yet sent to the logger. */
+static uint8_t *batch_buffer;
+
+/** Number of bytes used in batch_buffer. */
+static size_t batch_used;
+
+/** Timer sending a partially filled batch. */
+static fibril_timer_t *batch_timer;
+
+/** Whether batch_timer is set. */
+static bool batch_timer_set;
+
+/** Get slot of a log.
+ *
+ * Logs are identified by their slot plus one so that
+ * LOG_NO_PARENT never denotes a valid log.
+ *
+ * @param log Log.
+ * @return Slot (LOGGER_CLIENT_LOGS_MAX or more if invalid).
+ */
+static inline size_t log_slot(log_t log)
+{
+	if (log == LOG_DEFAULT)
+		log = default_log;
+
+	return log - 1;
+}
+
+/** Get logger id of a log.
+ *
+ * @param log Log.
+ * @return Logger id or 0 if the log is not valid.
+ */
+static sysarg_t log_id(log_t log)
+{
+	size_t slot = log_slot(log);
+	if (slot >= LOGGER_CLIENT_LOGS_MAX)
+		return 0;
+
+	return log_ids[slot];
+}
+
 /** Send formatted message to the logger service.
  *
  * @param session Initialized IPC session with the logger.
@@ -80,14 +142,12 @@ static errno_t logger_message(async_sess_t *session, log_t log, log_level_t leve
 	if (exchange == NULL) {
 		return ENOMEM;
 	}
-	if (log == LOG_DEFAULT)
-		log = default_log_id;
 
 	// FIXME: remove when all USB drivers use libc logging explicitly
 	str_rtrim(message, '\n');
 
 	aid_t reg_msg = async_send_2(exchange, LOGGER_WRITER_MESSAGE,
-	    log, level, NULL);
+	    log_id(log), level, NULL);
 	errno_t rc = async_data_write_start(exchange, message, str_size(message));
 	errno_t reg_msg_rc;
 	async_wait_for(reg_msg, &reg_msg_rc);
@@ -108,6 +168,112 @@ static errno_t logger_message(async_sess_t *session, log_t log, log_level_t leve
 	return reg_msg_rc;
 }
 
+/** Send the collected batch of messages to the logger service.
+ *
+ * Must be called with batch_lock held.
+ *
+ * @return Error code of the transfer or EOK on success.
+ */
+static errno_t batch_flush_locked(void)
+{
+	assert(fibril_mutex_is_locked(&batch_lock));
+
+	if (batch_used == 0)
+		return EOK;
+
+	async_exch_t *exchange = async_exchange_begin(logger_session);
+	if (exchange == NULL)
+		return ENOMEM;
+
+	aid_t reg_msg = async_send_0(exchange, LOGGER_WRITER_MESSAGES, NULL);
+	errno_t rc = async_data_write_start(exchange, batch_buffer,
+	    batch_used);
+	errno_t reg_msg_rc;
+	async_wait_for(reg_msg, &reg_msg_rc);
+
+	async_exchange_end(exchange);
+
+	/* The messages are dropped even if the transfer failed. */
+	batch_used = 0;
+
+	if (rc == ENAK)
+		rc = EOK;
+
+	if (rc != EOK)
+		return rc;
+
+	return reg_msg_rc;
+}
+
+/** Send a partially filled batch after BATCH_FLUSH_DELAY.
+ *
+ * @param arg Not used.
+ */
+static void batch_timer_fun(void *arg)
+{
+	fibril_mutex_lock(&batch_lock);
+	batch_timer_set = false;
+	(void) batch_flush_locked();
+	fibril_mutex_unlock(&batch_lock);
+}
+
+/** Map the table of effective levels published by the logger.
+ *
+ * Without the table, all messages are sent to the logger
+ * which filters them itself.
+ */
+static void log_levels_share(void)
+{
+	async_exch_t *exchange = async_exchange_begin(logger_session);
+	if (exchange == NULL)
+		return;
+
+	void *levels;
+	aid_t reg_msg = async_send_0(exchange, LOGGER_WRITER_SHARE_LEVELS,
+	    NULL);
+	errno_t rc = async_share_in_start_0_0(exchange, LOGGER_LEVELS_SIZE,
+	    &levels);
+	async_exchange_end(exchange);
+
+	if (rc != EOK) {
+		async_forget(reg_msg);
+		return;
+	}
+
+	errno_t reg_msg_rc;
+	async_wait_for(reg_msg, &reg_msg_rc);
+	if (reg_msg_rc != EOK) {
+		as_area_destroy(levels);
+		return;
+	}
+
+	log_levels = levels;
+}
+
+/** Prepare batching of messages.
+ *
+ * Without batching, each message is sent to the logger separately.
+ */
+static void batch_init(void)
+{
+	uint8_t *buffer = malloc(BATCH_BUFFER_SIZE);
+	if (buffer == NULL)
+		return;
+
+	fibril_timer_t *timer = fibril_timer_create(&batch_lock);
+	if (timer == NULL) {
+		free(buffer);
+		return;
+	}
+
+	fibril_mutex_lock(&batch_lock);
+	batch_timer = timer;
+	batch_buffer = buffer;
+	fibril_mutex_unlock(&batch_lock);
+
+	(void) atexit(log_flush);
+}
+
 /** Get name of the log level.
  *
  * @param level The log level.
@@ -172,7 +338,10 @@ errno_t log_init(const char *prog_name)
 	if (logger_session == NULL)
 		return rc;
 
-	default_log_id = log_create(prog_name, LOG_NO_PARENT);
+	default_log = log_create(prog_name, LOG_NO_PARENT);
+
+	log_levels_share();
+	batch_init();
 
 	return EOK;
 }
@@ -193,11 +362,11 @@ log_t log_create(const char *name, log_t parent)
 		return parent;
 
 	if (parent == LOG_DEFAULT)
-		parent = default_log_id;
+		parent = default_log;
 
 	ipc_call_t answer;
 	aid_t reg_msg = async_send_1(exchange, LOGGER_WRITER_CREATE_LOG,
-	    parent, &answer);
+	    log_id(parent), &answer);
 	errno_t rc = async_data_write_start(exchange, name, str_size(name));
 	errno_t reg_msg_rc;
 	async_wait_for(reg_msg, &reg_msg_rc);
@@ -207,7 +376,45 @@ log_t log_create(const char *name, log_t parent)
 	if ((rc != EOK) || (reg_msg_rc != EOK))
 		return parent;
 
-	return ipc_get_arg1(&answer);
+	size_t slot = ipc_get_arg2(&answer);
+	if (slot >= LOGGER_CLIENT_LOGS_MAX)
+		return parent;
+
+	log_ids[slot] = ipc_get_arg1(&answer);
+	return slot + 1;
+}
+
+/** Check whether a message would be logged.
+ *
+ * Messages above the effective level of the log are dropped by
+ * log_msg() without contacting the logger. Callers can use this
+ * to skip preparing arguments of such messages.
+ *
+ * @param ctx Log to use (use LOG_DEFAULT if you have no idea what it means).
+ * @param level Severity level of the message.
+ * @return @c true if the message would be passed to the logger.
+ */
+bool log_enabled(log_t ctx, log_level_t level)
+{
+	size_t slot = log_slot(ctx);
+
+	/* Leave the decision to the logger if it did not publish the level. */
+	if ((log_levels == NULL) || (slot >= LOGGER_CLIENT_LOGS_MAX))
+		return true;
+
+	return level <= log_levels->level[slot];
+}
+
+/** Send all pending messages to the logger.
+ *
+ * Messages are normally sent in batches after a short delay.
+ * Messages of level LVL_WARN and more severe are sent immediately.
+ */
+void log_flush(void)
+{
+	fibril_mutex_lock(&batch_lock);
+	(void) batch_flush_locked();
+	fibril_mutex_unlock(&batch_lock);
 }
 
 /** Write an entry to the log.
@@ -239,13 +446,52 @@ void log_msgv(log_t ctx, log_level_t level, const char *fmt, va_list args)
 {
 	assert(level < LVL_LIMIT);
 
-	char *message_buffer = malloc(MESSAGE_BUFFER_SIZE);
-	if (message_buffer == NULL)
+	if (!log_enabled(ctx, level))
 		return;
 
-	vsnprintf(message_buffer, MESSAGE_BUFFER_SIZE, fmt, args);
-	logger_message(logger_session, ctx, level, message_buffer);
-	free(message_buffer);
+	fibril_mutex_lock(&batch_lock);
+
+	if (batch_buffer == NULL) {
+		fibril_mutex_unlock(&batch_lock);
+
+		char *message_buffer = malloc(MESSAGE_BUFFER_SIZE);
+		if (message_buffer == NULL)
+			return;
+
+		vsnprintf(message_buffer, MESSAGE_BUFFER_SIZE, fmt, args);
+		logger_message(logger_session, ctx, level, message_buffer);
+		free(message_buffer);
+		return;
+	}
+
+	if (BATCH_BUFFER_SIZE - batch_used <
+	    sizeof(logger_batch_msg_t) + MESSAGE_BUFFER_SIZE)
+		(void) batch_flush_locked();
+
+	logger_batch_msg_t *msg =
+	    (logger_batch_msg_t *) (batch_buffer + batch_used);
+	char *message = (char *) (msg + 1);
+
+	vsnprintf(message, MESSAGE_BUFFER_SIZE, fmt, args);
+
+	// FIXME: remove when all USB drivers use libc logging explicitly
+	str_rtrim(message, '\n');
+
+	msg->log = log_id(ctx);
+	msg->level = level;
+	msg->size = str_size(message) + 1;
+	batch_used += ALIGN_UP(sizeof(logger_batch_msg_t) + msg->size,
+	    sizeof(sysarg_t));
+
+	if (level <= LVL_WARN) {
+		(void) batch_flush_locked();
+	} else if (!batch_timer_set) {
+		fibril_timer_set_locked(batch_timer, BATCH_FLUSH_DELAY,
+		    batch_timer_fun, NULL);
+		batch_timer_set = true;
+	}
+
+	fibril_mutex_unlock(&batch_lock);
 }
 
 /** @}
@@ -47,7 +47,10 @@
 #include <mem.h>
 #include <stdlib.h>
 #include <adt/gcdlcm.h>
+#include <adt/hash.h>
+#include <adt/list.h>
 #include <malloc.h>
+#include <tls.h>
 
 #include "private/malloc.h"
 #include "private/fibril.h"
@@ -61,6 +64,15 @@
 /** Magic used in heap descriptor. */
 #define HEAP_AREA_MAGIC  UINT32_C(0xBEEFCAFE)
 
+/** Magic used in headers of allocated small objects. */
+#define HEAP_SMALL_MAGIC  UINT32_C(0xBEEF0303)
+
+/** Magic used in headers of free small objects. */
+#define HEAP_SMALL_FREE_MAGIC  UINT32_C(0xBEEF0404)
+
+/** Magic used in run descriptors. */
+#define HEAP_RUN_MAGIC  UINT32_C(0xBEEFF00D)
+
 /** Allocation alignment.
  *
  * This also covers the alignment of fields
@@ -79,6 +91,25 @@
  */
 #define SHRINK_GRANULARITY  (64 * PAGE_SIZE)
 
+/** Number of heap caches
+ *
+ * Small objects are served from several independently
+ * locked caches. Each fibril always uses the same cache,
+ * so runner threads executing different fibrils rarely
+ * contend for the same lock.
+ *
+ */
+#define HEAP_CACHES  4
+
+/** Gross size of the heap block holding a run of small objects */
+#define HEAP_RUN_SIZE  (4 * PAGE_SIZE)
+
+/** Number of small object size classes */
+#define SMALL_CLASSES  20
+
+/** Largest request served from a run of small objects */
+#define SMALL_MAX  1024
+
 /** Overhead of each heap block. */
 #define STRUCT_OVERHEAD \
 	(sizeof(heap_block_head_t) + sizeof(heap_block_foot_t))
@@ -116,6 +147,32 @@
 #define AREA_LAST_BLOCK_HEAD(area) \
 	((uintptr_t) BLOCK_HEAD(((heap_block_foot_t *) AREA_LAST_BLOCK_FOOT(area))))
 
+/** Net size of the heap block holding a run of small objects. */
+#define RUN_NET_SIZE  NET_SIZE(HEAP_RUN_SIZE)
+
+/** Get the first slot of a run of small objects.
+ *
+ */
+#define RUN_FIRST_SLOT(run) \
+	(ALIGN_UP(((uintptr_t) (run)) + sizeof(heap_run_t), BASE_ALIGN))
+
+/** Overhead of each small object. */
+#define SMALL_OVERHEAD \
+	(ALIGN_UP(sizeof(heap_small_head_t), BASE_ALIGN))
+
+/** Get header of a small object.
+ *
+ */
+#define SMALL_HEAD(obj) \
+	((heap_small_head_t *) \
+	    (((uintptr_t) (obj)) - sizeof(heap_small_head_t)))
+
+/** Get index into small_class for a request size.
+ *
+ */
+#define SMALL_INDEX(size) \
+	(ALIGN_UP((size), BASE_ALIGN) / BASE_ALIGN)
+
 /** Get header in heap block.
  *
  */
@@ -187,6 +244,93 @@ typedef struct {
 	uint32_t magic;
 } heap_block_foot_t;
 
+struct heap_cache;
+
+/** Run of small objects
+ *
+ * A run occupies a single heap block and holds objects
+ * of one size class. The run descriptor is followed
+ * by equally sized slots, each consisting of a small
+ * object header and the object itself.
+ *
+ */
+typedef struct {
+	/** Link to heap_cache_t.partial while the run has free slots */
+	link_t partial_link;
+
+	/** Link to heap_cache_t.runs */
+	link_t runs_link;
+
+	/** Heap cache owning the run */
+	struct heap_cache *cache;
+
+	/** Size class of the objects */
+	unsigned int cls;
+
+	/** Size of each slot (including the object header) */
+	size_t slot_size;
+
+	/** Number of slots */
+	size_t slots;
+
+	/** Number of allocated objects */
+	size_t used;
+
+	/** Singly linked list of freed objects */
+	void *free;
+
+	/** First slot which has never been allocated */
+	uintptr_t fresh;
+
+	/** A magic value */
+	uint32_t magic;
+} heap_run_t;
+
+/** Header of a small object
+ *
+ * The magic has the same position relative to the object
+ * as the magic of heap_block_head_t relative to the data
+ * of a heap block. This way small objects and heap blocks
+ * can be told apart by their headers.
+ *
+ */
+typedef struct {
+	/** Run this object belongs to */
+	heap_run_t *run;
+
+	/* A magic value to detect overwrite of the header */
+	uint32_t magic;
+} heap_small_head_t;
+
+/** Heap cache
+ *
+ * Set of runs of small objects protected by a single lock.
+ *
+ */
+typedef struct heap_cache {
+	/** Serializes access to the cache and its runs */
+	fibril_rmutex_t lock;
+
+	/** Runs with at least one free slot, per size class */
+	list_t partial[SMALL_CLASSES];
+
+	/** All runs owned by the cache */
+	list_t runs;
+} heap_cache_t;
+
+/** Net sizes of small objects in each size class */
+static const size_t small_class_size[SMALL_CLASSES] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256, 320, 384, 448, 512,
+	640, 768, 896, 1024
+};
+
+/** Size class of each request size rounded up to BASE_ALIGN */
+static uint8_t small_class[SMALL_MAX / BASE_ALIGN + 1];
+
+/** Heap caches */
+static heap_cache_t heap_caches[HEAP_CACHES];
+
 /** First heap area */
 static heap_area_t *first_heap_area = NULL;
 
@@ -208,6 +352,16 @@ static_assert(BASE_ALIGN >= alignof(heap_area_t), "");
 static_assert(BASE_ALIGN >= alignof(heap_block_head_t), "");
 static_assert(BASE_ALIGN >= alignof(heap_block_foot_t), "");
 static_assert(BASE_ALIGN >= alignof(max_align_t), "");
+static_assert(BASE_ALIGN >= alignof(heap_run_t), "");
+
+/*
+ * Make sure free() can tell small objects and heap blocks apart.
+ */
+static_assert(sizeof(heap_small_head_t) -
+    offsetof(heap_small_head_t, magic) ==
+    sizeof(heap_block_head_t) - offsetof(heap_block_head_t, magic), "");
+static_assert(sizeof(heap_small_head_t) <= SMALL_OVERHEAD, "");
+static_assert(SMALL_MAX % BASE_ALIGN == 0, "");
 
 /** Serializes access to the heap from multiple threads. */
 static inline void heap_lock(void)
@@ -497,12 +651,35 @@ void __malloc_init(void)
 	if (fibril_rmutex_initialize(&malloc_mutex) != EOK)
 		abort();
 
+	for (size_t i = 0; i < HEAP_CACHES; i++) {
+		heap_cache_t *cache = &heap_caches[i];
+
+		if (fibril_rmutex_initialize(&cache->lock) != EOK)
+			abort();
+
+		for (unsigned int cls = 0; cls < SMALL_CLASSES; cls++)
+			list_initialize(&cache->partial[cls]);
+
+		list_initialize(&cache->runs);
+	}
+
+	unsigned int cls = 0;
+	for (size_t i = 0; i <= SMALL_MAX / BASE_ALIGN; i++) {
+		while (small_class_size[cls] < i * BASE_ALIGN)
+			cls++;
+
+		small_class[i] = cls;
+	}
+
 	if (!area_create(PAGE_SIZE))
 		abort();
 }
 
 void __malloc_fini(void)
 {
+	for (size_t i = 0; i < HEAP_CACHES; i++)
+		fibril_rmutex_destroy(&heap_caches[i].lock);
+
 	fibril_rmutex_destroy(&malloc_mutex);
 }
 
@@ -777,6 +954,241 @@ static void *malloc_internal(size_t size, size_t align)
 	return heap_grow_and_alloc(gross_size, falign);
 }
 
+/** Free a heap block
+ *
+ * Should be called only inside the critical section.
+ *
+ * @param head Header of the block to free.
+ *
+ */
+static void block_free(heap_block_head_t *head)
+{
+	block_check(head);
+	malloc_assert(!head->free);
+
+	heap_area_t *area = head->area;
+
+	area_check(area);
+	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
+	malloc_assert((void *) head < area->end);
+
+	/* Mark the block itself as free. */
+	head->free = true;
+
+	/* Look at the next block. If it is free, merge the two. */
+	heap_block_head_t *next_head =
+	    (heap_block_head_t *) (((void *) head) + head->size);
+
+	if ((void *) next_head < area->end) {
+		block_check(next_head);
+		if (next_head->free)
+			block_init(head, head->size + next_head->size, true, area);
+	}
+
+	/* Look at the previous block. If it is free, merge the two. */
+	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
+		heap_block_foot_t *prev_foot =
+		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
+
+		heap_block_head_t *prev_head =
+		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
+
+		block_check(prev_head);
+
+		if (prev_head->free)
+			block_init(prev_head, prev_head->size + head->size, true,
+			    area);
+	}
+
+	heap_shrink(area);
+}
+
+/** Get the heap cache of the current fibril
+ *
+ * The cache is selected by the thread control block, which
+ * is unique to each fibril and does not require the fibril
+ * local storage to be usable.
+ *
+ */
+static inline heap_cache_t *heap_cache_get(void)
+{
+	size_t hash = hash_mix((size_t) __tcb_get());
+	return &heap_caches[hash % HEAP_CACHES];
+}
+
+/** Check a run of small objects
+ *
+ * Should be called only with the lock of the owning cache held.
+ *
+ * @param run Run to check.
+ *
+ */
+static void run_check(heap_run_t *run)
+{
+	malloc_assert(run->magic == HEAP_RUN_MAGIC);
+	malloc_assert(run->cls < SMALL_CLASSES);
+	malloc_assert(run->used <= run->slots);
+}
+
+/** Create a new run of small objects
+ *
+ * The run is carved from the heap and becomes the first run
+ * with free slots of its size class.
+ * Should be called only with the lock of the cache held.
+ *
+ * @param cache Cache to own the run.
+ * @param cls   Size class of the objects.
+ *
+ * @return New run or NULL on not enough memory.
+ *
+ */
+static heap_run_t *run_create(heap_cache_t *cache, unsigned int cls)
+{
+	heap_lock();
+	heap_run_t *run = malloc_internal(RUN_NET_SIZE, BASE_ALIGN);
+	heap_unlock();
+
+	if (run == NULL)
+		return NULL;
+
+	uintptr_t first = RUN_FIRST_SLOT(run);
+
+	run->cache = cache;
+	run->cls = cls;
+	run->slot_size = SMALL_OVERHEAD + small_class_size[cls];
+	run->slots = ((uintptr_t) run + RUN_NET_SIZE - first) / run->slot_size;
+	run->used = 0;
+	run->free = NULL;
+	run->fresh = first;
+	run->magic = HEAP_RUN_MAGIC;
+
+	list_prepend(&run->partial_link, &cache->partial[cls]);
+	list_append(&run->runs_link, &cache->runs);
+
+	return run;
+}
+
+/** Return an empty run of small objects to the heap
+ *
+ * Should be called only with the lock of the owning cache held.
+ *
+ * @param run Run to destroy.
+ *
+ */
+static void run_destroy(heap_run_t *run)
+{
+	malloc_assert(run->used == 0);
+
+	list_remove(&run->partial_link);
+	list_remove(&run->runs_link);
+	run->magic = 0;
+
+	heap_lock();
+	block_free((heap_block_head_t *)
+	    (((void *) run) - sizeof(heap_block_head_t)));
+	heap_unlock();
+}
+
+/** Allocate a small object
+ *
+ * Takes the first free slot of the first run with free slots
+ * in the size class, thus the allocation runs in constant
+ * time unless a new run needs to be created.
+ *
+ * @param size Number of bytes to allocate (at most SMALL_MAX).
+ *
+ * @return Allocated object or NULL on not enough memory.
+ *
+ */
+static void *small_alloc(size_t size)
+{
+	malloc_assert(size <= SMALL_MAX);
+
+	unsigned int cls = small_class[SMALL_INDEX(size)];
+	heap_cache_t *cache = heap_cache_get();
+
+	fibril_rmutex_lock(&cache->lock);
+
+	heap_run_t *run;
+	link_t *link = list_first(&cache->partial[cls]);
+	if (link != NULL) {
+		run = list_get_instance(link, heap_run_t, partial_link);
+		run_check(run);
+	} else {
+		run = run_create(cache, cls);
+		if (run == NULL) {
+			fibril_rmutex_unlock(&cache->lock);
+			return NULL;
+		}
+	}
+
+	void *obj;
+	heap_small_head_t *head;
+
+	if (run->free != NULL) {
+		obj = run->free;
+		head = SMALL_HEAD(obj);
+		malloc_assert(head->magic == HEAP_SMALL_FREE_MAGIC);
+		run->free = *((void **) obj);
+	} else {
+		obj = (void *) (run->fresh + SMALL_OVERHEAD);
+		head = SMALL_HEAD(obj);
+		run->fresh += run->slot_size;
+	}
+
+	head->run = run;
+	head->magic = HEAP_SMALL_MAGIC;
+
+	run->used++;
+	if (run->used == run->slots)
+		list_remove(&run->partial_link);
+
+	fibril_rmutex_unlock(&cache->lock);
+
+	return obj;
+}
+
+/** Free a small object
+ *
+ * The object is returned to its run, regardless of the cache
+ * used by the current fibril. A run which becomes empty is
+ * returned to the heap unless it is the only run with free
+ * slots in its size class.
+ *
+ * @param obj Object to free.
+ *
+ */
+static void small_free(void *obj)
+{
+	heap_small_head_t *head = SMALL_HEAD(obj);
+	heap_run_t *run = head->run;
+
+	/* The run cannot go away while it holds this object. */
+	heap_cache_t *cache = run->cache;
+
+	fibril_rmutex_lock(&cache->lock);
+
+	run_check(run);
+	malloc_assert(run->cache == cache);
+	malloc_assert(run->used > 0);
+
+	head->magic = HEAP_SMALL_FREE_MAGIC;
+	*((void **) obj) = run->free;
+	run->free = obj;
+
+	list_t *partial = &cache->partial[run->cls];
+
+	if (run->used == run->slots)
+		list_prepend(&run->partial_link, partial);
+
+	run->used--;
+	if ((run->used == 0) && ((list_first(partial) != &run->partial_link) ||
+	    (list_last(partial) != &run->partial_link)))
+		run_destroy(run);
+
+	fibril_rmutex_unlock(&cache->lock);
+}
+
 /** Allocate memory
  *
  * @param size Number of bytes to allocate.
@@ -786,6 +1198,9 @@ static void *malloc_internal(size_t size, size_t align)
  */
 void *malloc(const size_t size)
 {
+	if (size <= SMALL_MAX)
+		return small_alloc(size);
+
 	heap_lock();
 	void *block = malloc_internal(size, BASE_ALIGN);
 	heap_unlock();
@@ -809,6 +1224,10 @@ void *memalign(const size_t align, const size_t size)
 	size_t palign =
 	    1 << (fnzb(max(sizeof(void *), align) - 1) + 1);
 
+	/* Small objects are always aligned on BASE_ALIGN. */
+	if ((palign <= BASE_ALIGN) && (size <= SMALL_MAX))
+		return small_alloc(size);
+
 	heap_lock();
 	void *block = malloc_internal(size, palign);
 	heap_unlock();
@@ -816,6 +1235,31 @@ void *memalign(const size_t align, const size_t size)
 	return block;
 }
 
+/** Reallocate a small object
+ *
+ * @param addr Small object.
+ * @param size New size of the object.
+ *
+ * @return Reallocated memory or NULL.
+ *
+ */
+static void *small_realloc(void *const addr, size_t size)
+{
+	heap_run_t *run = SMALL_HEAD(addr)->run;
+
+	/* The object stays in place if the size class does not change. */
+	if ((size <= SMALL_MAX) && (small_class[SMALL_INDEX(size)] == run->cls))
+		return addr;
+
+	void *ptr = malloc(size);
+	if (ptr != NULL) {
+		memcpy(ptr, addr, min(size, small_class_size[run->cls]));
+		small_free(addr);
+	}
+
+	return ptr;
+}
+
 /** Reallocate memory block
  *
  * @param addr Already allocated memory or NULL.
@@ -834,6 +1278,9 @@ void *realloc(void *const addr, size_t size)
 	if (addr == NULL)
 		return malloc(size);
 
+	if (SMALL_HEAD(addr)->magic == HEAP_SMALL_MAGIC)
+		return small_realloc(addr, size);
+
 	heap_lock();
 
 	/* Calculate the position of the header. */
@@ -962,56 +1409,93 @@ void free(void *const addr)
 	if (addr == NULL)
 		return;
 
+	if (SMALL_HEAD(addr)->magic == HEAP_SMALL_MAGIC) {
+		small_free(addr);
+		return;
+	}
+
 	heap_lock();
 
 	/* Calculate the position of the header. */
-	heap_block_head_t *head =
-	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
-
-	block_check(head);
-	malloc_assert(!head->free);
+	block_free((heap_block_head_t *) (addr - sizeof(heap_block_head_t)));
 
-	heap_area_t *area = head->area;
-
-	area_check(area);
-	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
-	malloc_assert((void *) head < area->end);
+	heap_unlock();
+}
 
-	/* Mark the block itself as free. */
-	head->free = true;
+/** Check runs of small objects owned by a heap cache
+ *
+ * Should be called only with the lock of the cache held.
+ *
+ * @param cache Cache to check.
+ * @param stats Statistics to update or NULL.
+ *
+ * @return NULL if the runs are consistent, otherwise the first
+ *         inconsistent structure found.
+ *
+ */
+static void *cache_check(heap_cache_t *cache, heap_stats_t *stats)
+{
+	list_foreach(cache->runs, runs_link, heap_run_t, run) {
+		/* Check run consistency */
+		if ((run->magic != HEAP_RUN_MAGIC) || (run->cache != cache) ||
+		    (run->cls >= SMALL_CLASSES) || (run->used > run->slots))
+			return (void *) run;
+
+		/* Walk all slots which have ever been allocated */
+		size_t used = 0;
+		for (uintptr_t slot = RUN_FIRST_SLOT(run); slot < run->fresh;
+		    slot += run->slot_size) {
+			heap_small_head_t *head = SMALL_HEAD(slot + SMALL_OVERHEAD);
+
+			if (head->magic == HEAP_SMALL_MAGIC) {
+				if (head->run != run)
+					return (void *) head;
+
+				used++;
+			} else if (head->magic != HEAP_SMALL_FREE_MAGIC) {
+				return (void *) head;
+			}
+		}
 
-	/* Look at the next block. If it is free, merge the two. */
-	heap_block_head_t *next_head =
-	    (heap_block_head_t *) (((void *) head) + head->size);
+		if (used != run->used)
+			return (void *) run;
 
-	if ((void *) next_head < area->end) {
-		block_check(next_head);
-		if (next_head->free)
-			block_init(head, head->size + next_head->size, true, area);
+		if (stats != NULL) {
+			stats->runs++;
+			stats->small_used += used;
+			stats->small_bytes += used * small_class_size[run->cls];
+			stats->small_free += run->slots - used;
+		}
 	}
 
-	/* Look at the previous block. If it is free, merge the two. */
-	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
-		heap_block_foot_t *prev_foot =
-		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
-
-		heap_block_head_t *prev_head =
-		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
+	return NULL;
+}
 
-		block_check(prev_head);
+/** Check heap consistency and gather heap statistics
+ *
+ * @param stats Statistics to fill in or NULL.
+ *
+ * @return NULL if the heap is consistent, otherwise the first
+ *         inconsistent structure found or (void *) -1 if there
+ *         is no heap.
+ *
+ */
+void *heap_check_stats(heap_stats_t *stats)
+{
+	if (stats != NULL)
+		memset(stats, 0, sizeof(heap_stats_t));
 
-		if (prev_head->free)
-			block_init(prev_head, prev_head->size + head->size, true,
-			    area);
-	}
+	for (size_t i = 0; i < HEAP_CACHES; i++) {
+		heap_cache_t *cache = &heap_caches[i];
 
-	heap_shrink(area);
+		fibril_rmutex_lock(&cache->lock);
+		void *prob = cache_check(cache, stats);
+		fibril_rmutex_unlock(&cache->lock);
 
-	heap_unlock();
-}
+		if (prob != NULL)
+			return prob;
+	}
 
-void *heap_check(void)
-{
 	heap_lock();
 
 	if (first_heap_area == NULL) {
@@ -1033,6 +1517,11 @@ void *heap_check(void)
 			return (void *) area;
 		}
 
+		if (stats != NULL) {
+			stats->areas++;
+			stats->area_bytes += area->end - area->start;
+		}
+
 		/* Walk all heap blocks */
 		for (heap_block_head_t *head = (heap_block_head_t *)
 		    AREA_FIRST_BLOCK_HEAD(area); (void *) head < area->end;
@@ -1051,6 +1540,17 @@ void *heap_check(void)
 				heap_unlock();
 				return (void *) foot;
 			}
+
+			if (stats == NULL)
+				continue;
+
+			if (head->free) {
+				stats->blocks_free++;
+				stats->bytes_free += head->size;
+			} else {
+				stats->blocks_used++;
+				stats->bytes_used += head->size;
+			}
 		}
 	}
 
@@ -1059,5 +1559,17 @@ void *heap_check(void)
 	return NULL;
 }
 
+/** Check heap consistency
+ *
+ * @return NULL if the heap is consistent, otherwise the first
+ *         inconsistent structure found or (void *) -1 if there
+ *         is no heap.
+ *
+ */
+void *heap_check(void)
+{
+	return heap_check_stats(NULL);
+}
+
 /** @}
  */
@@ -107,9 +107,24 @@ errno_t module_create_entrypoint(elf_finfo_t *p_info, rtld_t *rtld, module_t **r
 	return EOK;
 }
 
-/** (Eagerly) process all relocation tables in a module.
+/** Determine whether the PLT of a module may be bound lazily.
  *
- * Currently works as if LD_BIND_NOW was specified.
+ * The PLT is bound eagerly if the module asks for it (DT_BIND_NOW),
+ * if there is no lazy binding trampoline or if the module defines
+ * the trampoline itself.
+ */
+static bool module_plt_lazy(module_t *m)
+{
+	rtld_t *rtld = m->rtld;
+
+	return !m->dyn.bind_now && rtld->lazy_trampoline != NULL &&
+	    m != rtld->lazy_module;
+}
+
+/** Process all relocation tables in a module.
+ *
+ * Relocations in the PLT are left for lazy binding where supported,
+ * all other relocations are processed eagerly.
  */
 void module_process_relocs(module_t *m)
 {
@@ -124,7 +139,9 @@ void module_process_relocs(module_t *m)
 	/* jmp_rel table */
 	if (m->dyn.jmp_rel != NULL) {
 		DPRINTF("jmp_rel table\n");
-		if (m->dyn.plt_rel == DT_REL) {
+		if (module_plt_lazy(m) && plt_lazy_process(m)) {
+			DPRINTF("jmp_rel table bound lazily\n");
+		} else if (m->dyn.plt_rel == DT_REL) {
 			DPRINTF("jmp_rel table type DT_REL\n");
 			rel_table_process(m, m->dyn.jmp_rel, m->dyn.plt_rel_sz);
 		} else {
@@ -35,14 +35,45 @@
  */
 
 #include <errno.h>
+#include <perf.h>
 #include <rtld/module.h>
 #include <rtld/rtld.h>
 #include <rtld/rtld_debug.h>
+#include <rtld/symbol.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 
 rtld_t *runtime_env;
 
+/** Set up lazy binding of PLT slots.
+ *
+ * The PLT slots are resolved by the trampoline of the C library
+ * loaded with the program rather than by the one linked into the
+ * loader, so that the program does not depend on the loader image
+ * once it runs. The C library itself is bound eagerly so that
+ * resolving a slot never recurses.
+ *
+ * If no trampoline is found, all PLT slots are bound eagerly.
+ *
+ * @param rtld Runtime environment
+ */
+static void rtld_lazy_init(rtld_t *rtld)
+{
+	elf_symbol_t *sym;
+	module_t *m;
+
+	sym = symbol_def_find("__rtld_lazy_trampoline", rtld->program,
+	    ssf_noexec, &m);
+	if (sym == NULL) {
+		DPRINTF("lazy binding not available\n");
+		return;
+	}
+
+	rtld->lazy_trampoline = symbol_get_addr(sym, m, NULL);
+	rtld->lazy_module = m;
+}
+
 /** Initialize and process an executable.
  *
  * @param p_info Program info
@@ -52,8 +83,12 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 {
 	rtld_t *env;
 	bool is_dynamic = p_info->dynamic != NULL;
+	stopwatch_t sw;
 	DPRINTF("rtld_prog_process\n");
 
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+
 	/* Allocate new RTLD environment to pass to the loaded program */
 	env = calloc(1, sizeof(rtld_t));
 	if (env == NULL)
@@ -63,9 +98,13 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 	list_initialize(&env->imodules);
 	env->next_id = 1;
 
+	/* Lookups work without the cache, only slower. */
+	(void) symbol_cache_create(env);
+
 	module_t *module;
 	errno_t rc = module_create_entrypoint(p_info, env, &module);
 	if (rc != EOK) {
+		free(env->lookup_cache);
 		free(env);
 		return rc;
 	}
@@ -82,6 +121,7 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 		rc = module_load_deps(module, 0);
 		if (rc != EOK) {
 			free(module);
+			free(env->lookup_cache);
 			free(env);
 			return rc;
 		}
@@ -90,14 +130,25 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 	/* Compute static TLS size */
 	modules_process_tls(env);
 
+	stopwatch_stop(&sw);
+	env->stats.load_time = stopwatch_get_nanos(&sw);
+	env->stats.modules = list_count(&env->modules);
+
 	/*
 	 * Now relocate/link all modules together.
 	 */
 
 	if (is_dynamic) {
+		stopwatch_start(&sw);
+
+		rtld_lazy_init(env);
+
 		/* Process relocations in all modules */
 		DPRINTF("Relocate all modules\n");
 		modules_process_relocs(env, module);
+
+		stopwatch_stop(&sw);
+		env->stats.reloc_time = stopwatch_get_nanos(&sw);
 	}
 
 	if (rre != NULL)
@@ -213,5 +264,22 @@ void *rtld_tls_get_addr(rtld_t *rtld, tcb_t *tcb, unsigned long mod_id,
 	return (uint8_t *)(tcb->dtv[mod_id]) + offset;
 }
 
+/** Print dynamic linking statistics.
+ *
+ * @param rtld RTLD instance
+ */
+void rtld_stats_print(rtld_t *rtld)
+{
+	rtld_stats_t *stats = &rtld->stats;
+
+	printf("Initial modules: %zu\n", stats->modules);
+	printf("Load time: %lld us, relocation time: %lld us\n",
+	    NSEC2USEC(stats->load_time), NSEC2USEC(stats->reloc_time));
+	printf("Symbol lookups: %zu, cache hits: %zu\n",
+	    atomic_load(&stats->lookups), atomic_load(&stats->cache_hits));
+	printf("Lazy PLT slots: %zu, bound: %zu\n",
+	    atomic_load(&stats->lazy_slots), atomic_load(&stats->lazy_binds));
+}
+
 /** @}
  */
@@ -34,6 +34,9 @@
  * @file
  */
 
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -44,6 +47,47 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/symbol.h>
 
+/** Number of entries in the symbol lookup cache (power of two) */
+#define LOOKUP_CACHE_SIZE  1024
+
+/** Symbol lookup cache entry */
+typedef struct {
+	/** Symbol name or @c NULL if the entry is empty */
+	const char *name;
+	/** GNU hash of the name */
+	uint32_t hash;
+	/** Search flags used for the lookup */
+	symbol_search_flags_t flags;
+	/** Definition of the symbol */
+	elf_symbol_t *sym;
+	/** Module containing the definition */
+	module_t *mod;
+} lookup_entry_t;
+
+/** Symbol lookup cache
+ *
+ * Direct-mapped cache of symbols found in the global scope. Modules are
+ * only ever appended to the global scope, thus a symbol once found there
+ * keeps resolving to the same definition and entries never go stale.
+ *
+ * Lazy binding can happen before the fibril runtime of the program is
+ * initialized, hence the entries are protected by a plain spinlock.
+ */
+typedef struct rtld_lookup_cache {
+	atomic_flag lock;
+	lookup_entry_t entries[LOOKUP_CACHE_SIZE];
+} rtld_lookup_cache_t;
+
+/** Name of a symbol being looked up along with its hashes */
+typedef struct {
+	const char *name;
+	/** GNU hash of the name */
+	uint32_t gnu_hash;
+	/** System V hash of the name, valid if @c hash_valid is @c true */
+	elf_word hash;
+	bool hash_valid;
+} symbol_key_t;
+
 /*
  * Hash tables are 32-bit (elf_word) even for 64-bit ELF files.
  */
@@ -62,43 +106,132 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/** Compute the GNU hash of a symbol name. */
+static uint32_t gnu_hash(const unsigned char *name)
 {
-	if (m->dyn.hash == NULL) {
-		/* No hash table */
-		return NULL;
-	}
+	uint32_t h = 5381;
+
+	while (*name)
+		h = (h << 5) + h + *name++;
 
+	return h;
+}
+
+static void symbol_key_init(symbol_key_t *key, const char *name)
+{
+	key->name = name;
+	key->gnu_hash = gnu_hash((const unsigned char *) name);
+	key->hash_valid = false;
+}
+
+/** Look up a symbol in the System V hash table of a module. */
+static elf_symbol_t *sysv_find_in_module(symbol_key_t *key, module_t *m)
+{
 	elf_symbol_t *sym_table;
-	elf_symbol_t *s, *sym;
+	elf_symbol_t *s;
 	elf_word nbucket;
 	/* elf_word nchain; */
 	elf_word i;
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
+	if (!key->hash_valid) {
+		key->hash = elf_hash((const unsigned char *) key->name);
+		key->hash_valid = true;
+	}
 
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/* nchain = m->dyn.hash[1]; XXX Use to check HT range */
 
-	bucket = elf_hash((unsigned char *)name) % nbucket;
+	bucket = key->hash % nbucket;
 	i = m->dyn.hash[2 + bucket];
 
-	sym = NULL;
 	while (i != STN_UNDEF) {
 		s = &sym_table[i];
 		s_name = m->dyn.str_tab + s->st_name;
 
-		if (str_cmp(name, s_name) == 0) {
-			sym = s;
-			break;
-		}
+		if (str_cmp(key->name, s_name) == 0)
+			return s;
 
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return NULL;
+}
+
+/** Look up a symbol in the GNU hash table of a module.
+ *
+ * The table consists of a header (number of buckets, index of the first
+ * hashed symbol, number of bloom filter words and the bloom filter shift)
+ * followed by the bloom filter, the buckets and the hash chain. The bloom
+ * filter rejects most of the symbols not defined in the module without
+ * touching the buckets and the symbol table at all.
+ */
+static elf_symbol_t *gnu_find_in_module(symbol_key_t *key, module_t *m)
+{
+	const elf_word *ht = m->dyn.gnu_hash;
+	elf_word nbucket = ht[0];
+	elf_word symoffset = ht[1];
+	elf_word bloom_size = ht[2];
+	elf_word bloom_shift = ht[3];
+	const uintptr_t *bloom = (const uintptr_t *) &ht[4];
+	const elf_word *buckets = (const elf_word *) &bloom[bloom_size];
+	const elf_word *chain = &buckets[nbucket];
+	const unsigned bits = sizeof(uintptr_t) * 8;
+
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	uint32_t h = key->gnu_hash;
+	uintptr_t word;
+	uintptr_t mask;
+	elf_word i;
+	elf_word h2;
+
+	if (nbucket == 0 || bloom_size == 0)
+		return NULL;
+
+	word = bloom[(h / bits) % bloom_size];
+	mask = ((uintptr_t) 1 << (h % bits)) |
+	    ((uintptr_t) 1 << ((h >> bloom_shift) % bits));
+	if ((word & mask) != mask)
+		return NULL;
+
+	i = buckets[h % nbucket];
+	if (i < symoffset)
+		return NULL;
+
+	while (true) {
+		h2 = chain[i - symoffset];
+
+		if ((h | 1) == (h2 | 1) && str_cmp(key->name,
+		    m->dyn.str_tab + sym_table[i].st_name) == 0)
+			return &sym_table[i];
+
+		/* The lowest bit marks the end of the chain */
+		if ((h2 & 1) != 0)
+			break;
+
+		++i;
+	}
+
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(symbol_key_t *key, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", key->name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL) {
+		sym = gnu_find_in_module(key, m);
+	} else if (m->dyn.hash != NULL) {
+		sym = sysv_find_in_module(key, m);
+	} else {
+		/* No hash table */
+		return NULL;
+	}
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -110,25 +243,125 @@ static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
 	return sym; /* Found */
 }
 
-/** Find the definition of a symbol in a module and its deps.
+/** Create the symbol lookup cache of a runtime environment.
  *
- * Search the module dependency graph is breadth-first, beginning
- * from the module @a start. Thus, @start and all its dependencies
- * get searched.
+ * The cache is never destroyed as it lives as long as the program.
  *
- * @param name		Name of the symbol to search for.
- * @param start		Module in which to start the search..
- * @param mod		(output) Will be filled with a pointer to the module
- *			that contains the symbol.
+ * @param rtld Runtime environment
+ * @return EOK on success, ENOMEM if out of memory
  */
-elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
-    module_t **mod)
+errno_t symbol_cache_create(rtld_t *rtld)
+{
+	rtld_lookup_cache_t *cache;
+
+	cache = calloc(1, sizeof(rtld_lookup_cache_t));
+	if (cache == NULL)
+		return ENOMEM;
+
+	atomic_flag_clear(&cache->lock);
+	rtld->lookup_cache = cache;
+	return EOK;
+}
+
+static void lookup_cache_lock(rtld_lookup_cache_t *cache)
+{
+	while (atomic_flag_test_and_set_explicit(&cache->lock,
+	    memory_order_acquire)) {
+	}
+}
+
+static void lookup_cache_unlock(rtld_lookup_cache_t *cache)
+{
+	atomic_flag_clear_explicit(&cache->lock, memory_order_release);
+}
+
+/** Find the definition of a symbol in the global scope.
+ *
+ * @param key		Symbol to search for.
+ * @param rtld		Runtime environment.
+ * @param flags		@c ssf_none or @c ssf_noexec.
+ * @param mod		(output) Module that contains the symbol.
+ */
+static elf_symbol_t *global_find(symbol_key_t *key, rtld_t *rtld,
+    symbol_search_flags_t flags, module_t **mod)
+{
+	rtld_lookup_cache_t *cache = rtld->lookup_cache;
+	lookup_entry_t *entry = NULL;
+	elf_symbol_t *s;
+
+	atomic_fetch_add_explicit(&rtld->stats.lookups, 1,
+	    memory_order_relaxed);
+
+	if (cache != NULL) {
+		entry = &cache->entries[(key->gnu_hash + flags) &
+		    (LOOKUP_CACHE_SIZE - 1)];
+
+		lookup_cache_lock(cache);
+		if (entry->name != NULL && entry->hash == key->gnu_hash &&
+		    entry->flags == flags &&
+		    str_cmp(entry->name, key->name) == 0) {
+			s = entry->sym;
+			*mod = entry->mod;
+			lookup_cache_unlock(cache);
+
+			atomic_fetch_add_explicit(&rtld->stats.cache_hits, 1,
+			    memory_order_relaxed);
+			return s;
+		}
+		lookup_cache_unlock(cache);
+	}
+
+	list_foreach(rtld->modules, modules_link, module_t, m) {
+		DPRINTF("module '%s' local?\n", m->dyn.soname);
+		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
+			DPRINTF("!local->find '%s' in module '%s'\n",
+			    key->name, m->dyn.soname);
+			s = def_find_in_module(key, m);
+			if (s != NULL) {
+				/* Found */
+				if (entry != NULL) {
+					lookup_cache_lock(cache);
+					entry->name = m->dyn.str_tab + s->st_name;
+					entry->hash = key->gnu_hash;
+					entry->flags = flags;
+					entry->sym = s;
+					entry->mod = m;
+					lookup_cache_unlock(cache);
+				}
+
+				*mod = m;
+				return s;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/** Get the breadth-first search order of the module dependency graph.
+ *
+ * The order is computed on first use and kept in the module, since
+ * the dependencies of a module never change once it is loaded.
+ *
+ * @param start Module in which the search starts
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t module_scope_get(module_t *start)
 {
 	module_t *m, *dm;
-	elf_symbol_t *sym, *s;
+	module_t **scope;
 	list_t queue;
+	size_t n;
 	size_t i;
 
+	if (start->scope != NULL)
+		return EOK;
+
+	/* The scope cannot contain more modules than there are loaded. */
+	scope = malloc(list_count(&start->rtld->modules) * sizeof(module_t *));
+	if (scope == NULL)
+		return ENOMEM;
+
 	/*
 	 * Do a BFS using the queue_link and bfs_tag fields.
 	 * Vertices (modules) are tagged the moment they are inserted
@@ -157,8 +390,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 	list_append(&start->queue_link, &queue);
 #pragma GCC diagnostic pop
 
-	/* If the symbol is found, it will be stored in 'sym' */
-	sym = NULL;
+	n = 0;
 
 	/* While queue is not empty */
 	while (!list_empty(&queue)) {
@@ -166,14 +398,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		m = list_get_instance(list_first(&queue), module_t, queue_link);
 		list_remove(&m->queue_link);
 
-		/* If ssf_noroot is specified, do not look in start module */
-		s = def_find_in_module(name, m);
-		if (s != NULL) {
-			/* Symbol found */
-			sym = s;
-			*mod = m;
-			break;
-		}
+		scope[n++] = m;
 
 		/*
 		 * Insert m's untagged dependencies into the queue
@@ -189,15 +414,46 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		}
 	}
 
-	/* Empty the queue so that we leave it in a clean state */
-	while (!list_empty(&queue))
-		list_remove(list_first(&queue));
+	start->scope_len = n;
+	start->scope = scope;
+	return EOK;
+}
 
-	if (!sym) {
-		return NULL; /* Not found */
+/** Find the definition of a symbol in a module and its deps.
+ *
+ * Search the module dependency graph is breadth-first, beginning
+ * from the module @a start. Thus, @start and all its dependencies
+ * get searched.
+ *
+ * @param name		Name of the symbol to search for.
+ * @param start		Module in which to start the search..
+ * @param mod		(output) Will be filled with a pointer to the module
+ *			that contains the symbol.
+ */
+elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
+    module_t **mod)
+{
+	symbol_key_t key;
+	elf_symbol_t *s;
+	size_t i;
+
+	if (module_scope_get(start) != EOK) {
+		DPRINTF("malloc failed\n");
+		return NULL;
 	}
 
-	return sym; /* Symbol found */
+	symbol_key_init(&key, name);
+
+	for (i = 0; i < start->scope_len; ++i) {
+		s = def_find_in_module(&key, start->scope[i]);
+		if (s != NULL) {
+			/* Symbol found */
+			*mod = start->scope[i];
+			return s;
+		}
+	}
+
+	return NULL; /* Not found */
 }
 
 /** Find the definition of a symbol.
@@ -216,17 +472,21 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
     symbol_search_flags_t flags, module_t **mod)
 {
+	symbol_key_t key;
 	elf_symbol_t *s;
 
 	DPRINTF("symbol_def_find('%s', origin='%s'\n",
 	    name, origin->dyn.soname);
+
+	symbol_key_init(&key, name);
+
 	if (origin->dyn.symbolic && (!origin->exec || (flags & ssf_noexec) == 0)) {
 		DPRINTF("symbolic->find '%s' in module '%s'\n", name, origin->dyn.soname);
 		/*
 		 * Origin module has a DT_SYMBOLIC flag.
 		 * Try this module first
 		 */
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -236,18 +496,9 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 
 	/* Not DT_SYMBOLIC or no match. Now try other locations. */
 
-	list_foreach(origin->rtld->modules, modules_link, module_t, m) {
-		DPRINTF("module '%s' local?\n", m->dyn.soname);
-		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
-			DPRINTF("!local->find '%s' in module '%s'\n", name, m->dyn.soname);
-			s = def_find_in_module(name, m);
-			if (s != NULL) {
-				/* Found */
-				*mod = m;
-				return s;
-			}
-		}
-	}
+	s = global_find(&key, origin->rtld, flags, mod);
+	if (s != NULL)
+		return s;
 
 	/* Finally, try origin. */
 
@@ -255,7 +506,7 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 	    origin->dyn.soname);
 
 	if (!origin->exec || (flags & ssf_noexec) == 0) {
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
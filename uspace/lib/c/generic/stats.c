@@ -262,6 +262,62 @@ stats_exc_t *stats_get_exception(unsigned int excn)
 	return stats_exception;
 }
 
+/** Get profiler samples.
+ *
+ * The samples currently held by the kernel are returned, including
+ * the ones returned by previous calls. Use the sequence numbers to
+ * tell the new ones.
+ *
+ * @param count Number of records returned.
+ *
+ * @return Array of stats_sample_t structures.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+stats_sample_t *stats_get_samples(size_t *count)
+{
+	size_t size = 0;
+	stats_sample_t *stats_samples =
+	    (stats_sample_t *) sysinfo_get_data("system.samples", &size);
+
+	if ((size % sizeof(stats_sample_t)) != 0) {
+		if (stats_samples != NULL)
+			free(stats_samples);
+		*count = 0;
+		return NULL;
+	}
+
+	*count = size / sizeof(stats_sample_t);
+	return stats_samples;
+}
+
+/** Get name of the kernel symbol containing an address.
+ *
+ * @param addr Kernel address.
+ *
+ * @return Symbol name or NULL if the address cannot be resolved.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+char *stats_get_kernel_symbol(uint64_t addr)
+{
+	char name[SYSINFO_STATS_MAX_PATH];
+	snprintf(name, SYSINFO_STATS_MAX_PATH, "system.symbols.%" PRIu64, addr);
+
+	size_t size = 0;
+	char *symbol = (char *) sysinfo_get_data(name, &size);
+
+	if ((size == 0) || (symbol[size - 1] != 0)) {
+		if (symbol != NULL)
+			free(symbol);
+		return NULL;
+	}
+
+	return symbol;
+}
+
 /** Get system load
  *
  * @param count Number of load records returned.
@@ -760,6 +760,31 @@ errno_t vfs_open(int file, int mode)
 	return rc;
 }
 
+/** Get a pager handle for a file
+ *
+ * The pager handle identifies the file in the pager info of address space
+ * areas backed by the VFS pager. Unlike a file handle, it remains valid after
+ * the file handle is put, so the file can be closed once it is mapped.
+ *
+ * @param file          File handle open for reading
+ * @param[out] handle   Pager handle
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_pager_handle(int file, int *handle)
+{
+	assert(handle != NULL);
+
+	async_exch_t *exch = vfs_exchange_begin();
+	sysarg_t ret;
+	errno_t rc = async_req_1_1(exch, VFS_IN_PAGER_HANDLE, file, &ret);
+	vfs_exchange_end(exch);
+
+	if (rc == EOK)
+		*handle = ret;
+	return rc;
+}
+
 /** Pass a file handle to another VFS client
  *
  * @param vfs_exch      Donor's VFS exchange
@@ -883,8 +908,8 @@ errno_t vfs_read_short(int file, aoff64_t pos, void *buf, size_t nbyte,
 	ipc_call_t answer;
 	aid_t req;
 
-	if (nbyte > DATA_XFER_LIMIT)
-		nbyte = DATA_XFER_LIMIT;
+	if (nbyte > DATA_XFER_LARGE_LIMIT)
+		nbyte = DATA_XFER_LARGE_LIMIT;
 
 	async_exch_t *exch = vfs_exchange_begin();
 
@@ -1347,8 +1372,8 @@ errno_t vfs_write_short(int file, aoff64_t pos, const void *buf, size_t nbyte,
 	ipc_call_t answer;
 	aid_t req;
 
-	if (nbyte > DATA_XFER_LIMIT)
-		nbyte = DATA_XFER_LIMIT;
+	if (nbyte > DATA_XFER_LARGE_LIMIT)
+		nbyte = DATA_XFER_LARGE_LIMIT;
 
 	async_exch_t *exch = vfs_exchange_begin();
 
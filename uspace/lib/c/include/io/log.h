@@ -35,6 +35,7 @@
 #define _LIBC_IO_LOG_H_
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <inttypes.h>
 #include <io/verify.h>
 #include <types/common.h>
@@ -58,6 +59,9 @@ extern errno_t log_level_from_str(const char *, log_level_t *);
 extern errno_t log_init(const char *);
 extern log_t log_create(const char *, log_t);
 
+extern bool log_enabled(log_t, log_level_t);
+extern void log_flush(void);
+
 extern void log_msg(log_t, log_level_t, const char *, ...)
     _HELENOS_PRINTF_ATTRIBUTE(3, 4);
 extern void log_msgv(log_t, log_level_t, const char *, va_list);
@@ -34,6 +34,8 @@
 #define _LIBC_IPC_LOGGER_H_
 
 #include <ipc/common.h>
+#include <as.h>
+#include <stdint.h>
 
 typedef enum {
 	/** Set (global) default displayed logging level.
@@ -61,7 +63,7 @@ typedef enum {
 	/** Create new log.
 	 *
 	 * Arguments: parent log id (0 for top-level log).
-	 * Returns: error code, log id
+	 * Returns: error code, log id, slot in logger_levels_t
 	 * Followed by: string with log name.
 	 */
 	LOGGER_WRITER_CREATE_LOG = IPC_FIRST_USER_METHOD,
@@ -71,9 +73,54 @@ typedef enum {
 	 * Returns: error code
 	 * Followed by: string with the message.
 	 */
-	LOGGER_WRITER_MESSAGE
+	LOGGER_WRITER_MESSAGE,
+	/** Share effective levels of the logs created by the client.
+	 *
+	 * Returns: error code
+	 * Followed by: read-only share-in of LOGGER_LEVELS_SIZE bytes
+	 * holding logger_levels_t.
+	 */
+	LOGGER_WRITER_SHARE_LEVELS,
+	/** Write a batch of messages.
+	 *
+	 * Returns: error code
+	 * Followed by: data write with a sequence of logger_batch_msg_t,
+	 * each followed by the zero-terminated message and padded
+	 * to a multiple of sizeof(sysarg_t).
+	 */
+	LOGGER_WRITER_MESSAGES
 } logger_writer_request_t;
 
+/** Maximum number of logs created by a single writer client. */
+#define LOGGER_CLIENT_LOGS_MAX  100
+
+/** Effective levels of the logs created by a writer client.
+ *
+ * The logger keeps the table up to date whenever a level changes,
+ * so that the client can drop filtered messages without any IPC.
+ * The table is indexed by the slot returned by
+ * LOGGER_WRITER_CREATE_LOG.
+ */
+typedef struct {
+	uint8_t level[LOGGER_CLIENT_LOGS_MAX];
+} logger_levels_t;
+
+/** Size of the memory area shared by LOGGER_WRITER_SHARE_LEVELS. */
+#define LOGGER_LEVELS_SIZE  PAGE_SIZE
+
+/** Maximum size of a LOGGER_WRITER_MESSAGES batch (in bytes). */
+#define LOGGER_BATCH_SIZE_MAX  16384
+
+/** Header of a message in a LOGGER_WRITER_MESSAGES batch. */
+typedef struct {
+	/** Log id */
+	sysarg_t log;
+	/** Message severity level (log_level_t) */
+	sysarg_t level;
+	/** Size of the message including the terminating zero */
+	sysarg_t size;
+} logger_batch_msg_t;
+
 #endif
 
 /** @}
@@ -61,6 +61,10 @@ typedef struct {
 	unsigned int instance;
 	bool concurrent_read_write;
 	bool write_retains_size;
+	/** File contents may be cached by VFS. */
+	bool cacheable;
+	/** Directory entries may be cached by VFS. */
+	bool names_cacheable;
 } vfs_info_t;
 
 /** Data returned by filesystem probe regarding a specific volume. */
@@ -75,6 +79,7 @@ typedef enum {
 	VFS_IN_FSTYPES,
 	VFS_IN_MOUNT,
 	VFS_IN_OPEN,
+	VFS_IN_PAGER_HANDLE,
 	VFS_IN_PUT,
 	VFS_IN_READ,
 	VFS_IN_REGISTER,
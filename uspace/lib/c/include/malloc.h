@@ -41,7 +41,32 @@
 #ifdef _HELENOS_SOURCE
 __HELENOS_DECLS_BEGIN;
 
+/** Heap statistics */
+typedef struct {
+	/** Number of heap areas */
+	size_t areas;
+	/** Bytes of address space occupied by heap areas */
+	size_t area_bytes;
+	/** Number of used heap blocks (including runs of small objects) */
+	size_t blocks_used;
+	/** Bytes in used heap blocks (including headers and footers) */
+	size_t bytes_used;
+	/** Number of free heap blocks */
+	size_t blocks_free;
+	/** Bytes in free heap blocks (including headers and footers) */
+	size_t bytes_free;
+	/** Number of runs of small objects */
+	size_t runs;
+	/** Number of allocated small objects */
+	size_t small_used;
+	/** Bytes usable in allocated small objects */
+	size_t small_bytes;
+	/** Number of free small object slots */
+	size_t small_free;
+} heap_stats_t;
+
 extern void *heap_check(void);
+extern void *heap_check_stats(heap_stats_t *);
 
 __HELENOS_DECLS_END;
 #endif
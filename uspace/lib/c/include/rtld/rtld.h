@@ -48,6 +48,7 @@ extern errno_t rtld_prog_process(elf_finfo_t *, rtld_t **);
 extern tcb_t *rtld_tls_make(rtld_t *);
 extern unsigned long rtld_get_next_id(rtld_t *);
 extern void *rtld_tls_get_addr(rtld_t *, tcb_t *, unsigned long, unsigned long);
+extern void rtld_stats_print(rtld_t *);
 
 #endif
 
@@ -36,6 +36,7 @@
 #define _LIBC_RTLD_SYMBOL_H_
 
 #include <elf/elf.h>
+#include <errno.h>
 #include <rtld/rtld.h>
 #include <tls.h>
 
@@ -47,6 +48,7 @@ typedef enum {
 	ssf_noexec = 0x1
 } symbol_search_flags_t;
 
+extern errno_t symbol_cache_create(rtld_t *);
 extern elf_symbol_t *symbol_bfs_find(const char *, module_t *, module_t **);
 extern elf_symbol_t *symbol_def_find(const char *, module_t *,
     symbol_search_flags_t, module_t **);
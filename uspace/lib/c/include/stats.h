@@ -56,6 +56,9 @@ extern stats_ipcc_t *stats_get_ipccs(size_t *);
 extern stats_exc_t *stats_get_exceptions(size_t *);
 extern stats_exc_t *stats_get_exception(unsigned int);
 
+extern stats_sample_t *stats_get_samples(size_t *);
+extern char *stats_get_kernel_symbol(uint64_t);
+
 extern void stats_print_load_fragment(load_t, unsigned int);
 extern const char *thread_get_state(state_t);
 
@@ -79,6 +79,11 @@ typedef struct module {
 	/** Link to list of initial modules */
 	link_t imodules_link;
 
+	/** Modules in breadth-first order of the dependency graph from here */
+	struct module **scope;
+	/** Number of fields in scope */
+	size_t scope_len;
+
 	/** Link to BFS queue. Only used when doing a BFS of the module graph */
 	link_t queue_link;
 	/** Tag for modules already processed during a BFS */
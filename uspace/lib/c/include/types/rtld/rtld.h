@@ -37,11 +37,32 @@
 
 #include <adt/list.h>
 #include <elf/elf_mod.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 #include <types/rtld/module.h>
 
+/** Run-time dynamic linker statistics */
+typedef struct {
+	/** Time spent loading the initial modules */
+	nsec_t load_time;
+	/** Time spent processing relocations of the initial modules */
+	nsec_t reloc_time;
+	/** Number of initial modules */
+	size_t modules;
+
+	/** Symbol lookups in the global scope */
+	atomic_size_t lookups;
+	/** Lookups satisfied from the lookup cache */
+	atomic_size_t cache_hits;
+	/** PLT slots left for lazy binding */
+	atomic_size_t lazy_slots;
+	/** PLT slots bound lazily */
+	atomic_size_t lazy_binds;
+} rtld_stats_t;
+
 typedef struct rtld {
 	elf_dyn_t *rtld_dynamic;
 	module_t rtld;
@@ -60,6 +81,17 @@ typedef struct rtld {
 
 	/** List of initial modules */
 	list_t imodules;
+
+	/** Symbol lookup cache */
+	struct rtld_lookup_cache *lookup_cache;
+
+	/** Lazy binding trampoline or @c NULL to bind PLT slots eagerly */
+	void *lazy_trampoline;
+	/** Module defining the lazy binding trampoline */
+	module_t *lazy_module;
+
+	/** Statistics */
+	rtld_stats_t stats;
 } rtld_t;
 
 #endif
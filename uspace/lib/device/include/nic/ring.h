@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libdevice
+ * @{
+ */
+/** @file Shared-memory frame rings between a NIC driver and its client
+ */
+
+#ifndef LIBDEVICE_NIC_RING_H
+#define LIBDEVICE_NIC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Number of slots in a frame ring (must be a power of two) */
+#define NIC_RING_SLOTS  64
+
+/** Size of a frame ring slot, i.e. maximum size of a frame in the ring */
+#define NIC_RING_SLOT_SIZE  2048
+
+/** Single-producer single-consumer ring of frames.
+ *
+ * The ring lives in memory shared by the NIC driver and its client.
+ * The producer copies frames into free slots and publishes them by
+ * advancing @c head. The consumer processes frames in place and
+ * releases the slots by advancing @c tail.
+ *
+ * A consumer that runs out of frames arms @c doorbell before going
+ * to sleep. A producer that finds the doorbell armed after publishing
+ * frames disarms it and notifies the consumer by IPC. Thus frames
+ * produced while the consumer is busy cost no IPC at all and the
+ * consumer processes all of them after a single notification.
+ */
+typedef struct {
+	/** Number of frames ever produced (written by the producer) */
+	_Atomic uint32_t head;
+	uint32_t pad1[15];
+	/** Number of frames ever consumed (written by the consumer) */
+	_Atomic uint32_t tail;
+	/** Consumer waits for a notification */
+	_Atomic uint32_t doorbell;
+	uint32_t pad2[14];
+	/** Sizes of frames in slots */
+	uint32_t size[NIC_RING_SLOTS];
+	/** Frame data */
+	uint8_t data[NIC_RING_SLOTS][NIC_RING_SLOT_SIZE];
+} nic_ring_t;
+
+/** Frame rings of a NIC, shared by the client with the driver */
+typedef struct {
+	/** Received frames (produced by the driver) */
+	nic_ring_t rx;
+	/** Frames to transmit (produced by the client) */
+	nic_ring_t tx;
+} nic_rings_t;
+
+extern void nic_ring_init(nic_ring_t *);
+extern bool nic_ring_put(nic_ring_t *, const void *, size_t);
+extern bool nic_ring_empty(nic_ring_t *);
+extern bool nic_ring_doorbell(nic_ring_t *);
+extern bool nic_ring_peek(nic_ring_t *, void **, size_t *);
+extern void nic_ring_consume(nic_ring_t *);
+extern bool nic_ring_arm(nic_ring_t *);
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libdevice
+ * @{
+ */
+/** @file Shared-memory frame rings between a NIC driver and its client
+ *
+ * The peer sharing the ring is not trusted, so everything read from
+ * the ring is validated before use.
+ */
+
+#include <assert.h>
+#include <mem.h>
+#include <nic/ring.h>
+
+static_assert((NIC_RING_SLOTS & (NIC_RING_SLOTS - 1)) == 0, "");
+
+/** Initialize an empty ring.
+ *
+ * The consumer starts armed, so the first frame produced
+ * results in a notification.
+ *
+ * @param ring Ring
+ */
+void nic_ring_init(nic_ring_t *ring)
+{
+	atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->doorbell, 1, memory_order_relaxed);
+}
+
+/** Copy a frame to the ring (producer).
+ *
+ * @param ring Ring
+ * @param data Frame data
+ * @param size Frame size in bytes
+ *
+ * @return @c true on success, @c false if the ring is full or the
+ *         frame does not fit in a slot.
+ */
+bool nic_ring_put(nic_ring_t *ring, const void *data, size_t size)
+{
+	if (size > NIC_RING_SLOT_SIZE)
+		return false;
+
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+	if (head - tail >= NIC_RING_SLOTS)
+		return false;
+
+	size_t slot = head % NIC_RING_SLOTS;
+	memcpy(ring->data[slot], data, size);
+	ring->size[slot] = size;
+
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+	return true;
+}
+
+/** Check whether the consumer has released all frames (producer).
+ *
+ * @param ring Ring
+ *
+ * @return @c true if the ring is empty.
+ */
+bool nic_ring_empty(nic_ring_t *ring)
+{
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+	return head == tail;
+}
+
+/** Check whether the consumer needs to be notified (producer).
+ *
+ * Call after producing one or more frames. The doorbell is disarmed,
+ * so the consumer is notified only once per batch.
+ *
+ * @param ring Ring
+ *
+ * @return @c true if the caller must notify the consumer.
+ */
+bool nic_ring_doorbell(nic_ring_t *ring)
+{
+	/* Order publishing of the frames before reading the doorbell. */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (atomic_load_explicit(&ring->doorbell, memory_order_relaxed) == 0)
+		return false;
+
+	return atomic_exchange_explicit(&ring->doorbell, 0,
+	    memory_order_relaxed) != 0;
+}
+
+/** Get the oldest frame in the ring (consumer).
+ *
+ * The frame stays in the ring until nic_ring_consume() is called.
+ *
+ * @param ring Ring
+ * @param data Place to store pointer to the frame data
+ * @param size Place to store frame size in bytes
+ *
+ * @return @c true on success, @c false if the ring is empty.
+ */
+bool nic_ring_peek(nic_ring_t *ring, void **data, size_t *size)
+{
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	if ((head == tail) || (head - tail > NIC_RING_SLOTS))
+		return false;
+
+	size_t slot = tail % NIC_RING_SLOTS;
+	uint32_t fsize = ring->size[slot];
+
+	*data = ring->data[slot];
+	*size = (fsize <= NIC_RING_SLOT_SIZE) ? fsize : NIC_RING_SLOT_SIZE;
+	return true;
+}
+
+/** Release the oldest frame in the ring (consumer).
+ *
+ * @param ring Ring
+ */
+void nic_ring_consume(nic_ring_t *ring)
+{
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+/** Ask for a notification before going to sleep (consumer).
+ *
+ * @param ring Ring
+ *
+ * @return @c true if the ring is empty and the consumer may sleep
+ *         until notified, @c false if frames arrived meanwhile and
+ *         need to be processed first.
+ */
+bool nic_ring_arm(nic_ring_t *ring)
+{
+	atomic_store_explicit(&ring->doorbell, 1, memory_order_seq_cst);
+
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_seq_cst);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	return head == tail;
+}
+
+/** @}
+ */
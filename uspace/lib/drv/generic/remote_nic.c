@@ -34,6 +34,7 @@
  * @brief Driver-side RPC skeletons for DDF NIC interface
  */
 
+#include <as.h>
 #include <assert.h>
 #include <async.h>
 #include <errno.h>
@@ -85,7 +86,9 @@ typedef enum {
 	NIC_OFFLOAD_SET,
 	NIC_POLL_GET_MODE,
 	NIC_POLL_SET_MODE,
-	NIC_POLL_NOW
+	NIC_POLL_NOW,
+	NIC_RING_SETUP,
+	NIC_RING_KICK
 } nic_funcs_t;
 
 /** Send frame from NIC
@@ -1335,6 +1338,55 @@ errno_t nic_poll_now(async_sess_t *dev_sess)
 	return rc;
 }
 
+/** Share frame rings with the NIC
+ *
+ * After a successful setup, received frames are passed through the
+ * RX ring (see NIC_EV_RX_RING) and frames can be transmitted through
+ * the TX ring (see nic_ring_kick()). Frames which do not fit into
+ * a ring are still passed by the individual IPC requests.
+ *
+ * @param[in] dev_sess
+ * @param[in] rings    Initialized nic_rings_t at the start of an
+ *                     address space area
+ *
+ * @return EOK If the operation was successfully completed
+ *
+ */
+errno_t nic_ring_setup(async_sess_t *dev_sess, void *rings)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_RING_SETUP, &answer);
+	errno_t retval = async_share_out_start(exch, rings,
+	    AS_AREA_READ | AS_AREA_WRITE);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Notify the NIC about frames in the TX ring
+ *
+ * The notification is asynchronous, no answer is awaited.
+ *
+ * @param[in] dev_sess
+ *
+ */
+void nic_ring_kick(async_sess_t *dev_sess)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+	async_msg_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE), NIC_RING_KICK);
+	async_exchange_end(exch);
+}
+
 static void remote_nic_send_frame(ddf_fun_t *dev, void *iface,
     ipc_call_t *call)
 {
@@ -2485,6 +2537,54 @@ static void remote_nic_poll_now(ddf_fun_t *dev, void *iface,
 	async_answer_0(call, rc);
 }
 
+static void remote_nic_ring_setup(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+
+	ipc_call_t data;
+	size_t size;
+	unsigned int flags;
+	void *rings;
+
+	if (!async_share_out_receive(&data, &size, &flags)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (nic_iface->ring_setup == NULL) {
+		async_answer_0(&data, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	errno_t rc = async_share_out_finalize(&data, &rings);
+	if (rc != EOK) {
+		async_answer_0(call, rc);
+		return;
+	}
+
+	rc = nic_iface->ring_setup(dev, rings, size);
+	if (rc != EOK)
+		as_area_destroy(rings);
+
+	async_answer_0(call, rc);
+}
+
+static void remote_nic_ring_kick(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	if (nic_iface->ring_kick == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	/* The client does not wait for the answer. */
+	async_answer_0(call, EOK);
+	(void) nic_iface->ring_kick(dev);
+}
+
 /** Remote NIC interface operations.
  *
  */
@@ -2529,7 +2629,9 @@ static const remote_iface_func_ptr_t remote_nic_iface_ops[] = {
 	[NIC_OFFLOAD_SET] = remote_nic_offload_set,
 	[NIC_POLL_GET_MODE] = remote_nic_poll_get_mode,
 	[NIC_POLL_SET_MODE] = remote_nic_poll_set_mode,
-	[NIC_POLL_NOW] = remote_nic_poll_now
+	[NIC_POLL_NOW] = remote_nic_poll_now,
+	[NIC_RING_SETUP] = remote_nic_ring_setup,
+	[NIC_RING_KICK] = remote_nic_ring_kick
 };
 
 /** Remote NIC interface structure.
@@ -42,7 +42,8 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	NIC_EV_RX_RING
 } nic_event_t;
 
 extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
@@ -109,6 +110,9 @@ extern errno_t nic_poll_set_mode(async_sess_t *, nic_poll_mode_t,
     const struct timespec *);
 extern errno_t nic_poll_now(async_sess_t *);
 
+extern errno_t nic_ring_setup(async_sess_t *, void *);
+extern void nic_ring_kick(async_sess_t *);
+
 #endif
 
 /** @}
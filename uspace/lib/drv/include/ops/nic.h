@@ -107,6 +107,9 @@ typedef struct nic_iface {
 	errno_t (*poll_set_mode)(ddf_fun_t *, nic_poll_mode_t,
 	    const struct timespec *);
 	errno_t (*poll_now)(ddf_fun_t *);
+
+	errno_t (*ring_setup)(ddf_fun_t *, void *, size_t);
+	errno_t (*ring_kick)(ddf_fun_t *);
 } nic_iface_t;
 
 #endif
@@ -42,10 +42,11 @@
 #include <gfx/context.h>
 #include <gfx/render.h>
 #include <io/pixel.h>
-#include <io/pixelmap.h>
 #include <memgfx/memgc.h>
+#include <mem.h>
 #include <stdlib.h>
 #include "../private/memgc.h"
+#include "../private/pixops.h"
 
 static errno_t mem_gc_set_clip_rect(void *, gfx_rect_t *);
 static errno_t mem_gc_set_color(void *, gfx_color_t *);
@@ -126,8 +127,11 @@ static errno_t mem_gc_fill_rect(void *arg, gfx_rect_t *rect)
 {
 	mem_gc_t *mgc = (mem_gc_t *) arg;
 	gfx_rect_t crect;
-	gfx_coord_t x, y;
-	pixelmap_t pixelmap;
+	gfx_coord_t y;
+	gfx_coord_t width;
+	pixel_t *row0;
+	pixel_t *row;
+	size_t dpitch;
 
 	/* Make sure we have a sorted, clipped rectangle */
 	gfx_rect_clip(rect, &mgc->clip_rect, &crect);
@@ -135,13 +139,20 @@ static errno_t mem_gc_fill_rect(void *arg, gfx_rect_t *rect)
 	assert(mgc->rect.p0.x == 0);
 	assert(mgc->rect.p0.y == 0);
 	assert(mgc->alloc.pitch == mgc->rect.p1.x * (int)sizeof(uint32_t));
-	pixelmap.width = mgc->rect.p1.x;
-	pixelmap.height = mgc->rect.p1.y;
-	pixelmap.data = mgc->alloc.pixels;
 
-	for (y = crect.p0.y; y < crect.p1.y; y++) {
-		for (x = crect.p0.x; x < crect.p1.x; x++) {
-			pixelmap_put_pixel(&pixelmap, x, y, mgc->color);
+	width = crect.p1.x - crect.p0.x;
+	if (width > 0 && crect.p1.y > crect.p0.y) {
+		dpitch = mgc->rect.p1.x;
+		row0 = (pixel_t *)mgc->alloc.pixels + crect.p0.y * dpitch +
+		    crect.p0.x;
+
+		/* Fill the first row, then replicate it */
+		mem_pix_fill(row0, mgc->color, width);
+
+		row = row0 + dpitch;
+		for (y = crect.p0.y + 1; y < crect.p1.y; y++) {
+			memcpy(row, row0, width * sizeof(pixel_t));
+			row += dpitch;
 		}
 	}
 
@@ -379,10 +390,12 @@ static errno_t mem_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 	gfx_rect_t drect;
 	gfx_rect_t crect;
 	gfx_coord2_t offs;
-	gfx_coord_t x, y;
-	pixelmap_t smap;
-	pixelmap_t dmap;
-	pixel_t pixel;
+	gfx_coord_t y;
+	gfx_coord_t width;
+	size_t spitch;
+	size_t dpitch;
+	pixel_t *srow;
+	pixel_t *drow;
 
 	if (srect0 != NULL)
 		gfx_rect_clip(srect0, &mbm->rect, &srect);
@@ -404,51 +417,53 @@ static errno_t mem_gc_bitmap_render(void *bm, gfx_rect_t *srect0,
 
 	assert(mbm->alloc.pitch == (mbm->rect.p1.x - mbm->rect.p0.x) *
 	    (int)sizeof(uint32_t));
-	smap.width = mbm->rect.p1.x - mbm->rect.p0.x;
-	smap.height = mbm->rect.p1.y - mbm->rect.p0.y;
-	smap.data = mbm->alloc.pixels;
+	spitch = mbm->rect.p1.x - mbm->rect.p0.x;
 
 	assert(mbm->mgc->rect.p0.x == 0);
 	assert(mbm->mgc->rect.p0.y == 0);
 	assert(mbm->mgc->alloc.pitch == mbm->mgc->rect.p1.x * (int)sizeof(uint32_t));
-	dmap.width = mbm->mgc->rect.p1.x;
-	dmap.height = mbm->mgc->rect.p1.y;
-	dmap.data = mbm->mgc->alloc.pixels;
+	dpitch = mbm->mgc->rect.p1.x;
 
-	if ((mbm->flags & bmpf_direct_output) != 0) {
+	width = crect.p1.x - crect.p0.x;
+	if ((mbm->flags & bmpf_direct_output) != 0 || width <= 0 ||
+	    crect.p1.y <= crect.p0.y) {
 		/* Nothing to do */
-	} else if ((mbm->flags & bmpf_color_key) == 0) {
+		mem_gc_invalidate_rect(mbm->mgc, &crect);
+		return EOK;
+	}
+
+	/*
+	 * The clipped destination rectangle lies within the translated
+	 * source rectangle, so whole rows can be processed without
+	 * checking bounds of individual pixels.
+	 */
+	srow = (pixel_t *)mbm->alloc.pixels +
+	    (crect.p0.y - mbm->rect.p0.y - offs.y) * spitch +
+	    (crect.p0.x - mbm->rect.p0.x - offs.x);
+	drow = (pixel_t *)mbm->mgc->alloc.pixels + crect.p0.y * dpitch +
+	    crect.p0.x;
+
+	if ((mbm->flags & bmpf_color_key) == 0) {
 		/* Simple copy */
 		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				pixelmap_put_pixel(&dmap, x, y, pixel);
-			}
+			memcpy(drow, srow, width * sizeof(pixel_t));
+			srow += spitch;
+			drow += dpitch;
 		}
 	} else if ((mbm->flags & bmpf_colorize) == 0) {
 		/* Color key */
 		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				if (pixel != mbm->key_color)
-					pixelmap_put_pixel(&dmap, x, y, pixel);
-			}
+			mem_pix_copy_key(drow, srow, mbm->key_color, width);
+			srow += spitch;
+			drow += dpitch;
 		}
 	} else {
 		/* Color key & colorization */
 		for (y = crect.p0.y; y < crect.p1.y; y++) {
-			for (x = crect.p0.x; x < crect.p1.x; x++) {
-				pixel = pixelmap_get_pixel(&smap,
-				    x - mbm->rect.p0.x - offs.x,
-				    y - mbm->rect.p0.y - offs.y);
-				if (pixel != mbm->key_color)
-					pixelmap_put_pixel(&dmap, x, y,
-					    mbm->mgc->color);
-			}
+			mem_pix_colorize_key(drow, srow, mbm->key_color,
+			    mbm->mgc->color, width);
+			srow += spitch;
+			drow += dpitch;
 		}
 	}
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libmemgfx
+ * @{
+ */
+/**
+ * @file Pixel row operations
+ *
+ * Inner loops of the memory GC renderer. These operate on one row of
+ * pixels at a time. Where the target supports it (SSE2 on x86, NEON on
+ * ARM) four pixels are processed at once, with a scalar loop handling
+ * the remainder.
+ */
+
+#include <io/pixel.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "../private/pixops.h"
+
+/** Fill row of pixels with a color.
+ *
+ * @param dst Destination pixels
+ * @param color Color
+ * @param n Number of pixels
+ */
+void mem_pix_fill(pixel_t *dst, pixel_t color, size_t n)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	__m128i vcolor = _mm_set1_epi32((int) color);
+
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_si128((__m128i *) &dst[i], vcolor);
+#elif defined(__ARM_NEON)
+	uint32x4_t vcolor = vdupq_n_u32(color);
+
+	for (; i + 4 <= n; i += 4)
+		vst1q_u32(&dst[i], vcolor);
+#endif
+
+	for (; i < n; i++)
+		dst[i] = color;
+}
+
+/** Copy row of pixels except pixels equal to key color.
+ *
+ * @param dst Destination pixels
+ * @param src Source pixels
+ * @param key Key color (pixels with this value are transparent)
+ * @param n Number of pixels
+ */
+void mem_pix_copy_key(pixel_t *dst, const pixel_t *src, pixel_t key,
+    size_t n)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	__m128i vkey = _mm_set1_epi32((int) key);
+	__m128i s, d, mask;
+
+	for (; i + 4 <= n; i += 4) {
+		s = _mm_loadu_si128((const __m128i *) &src[i]);
+		d = _mm_loadu_si128((const __m128i *) &dst[i]);
+		mask = _mm_cmpeq_epi32(s, vkey);
+		d = _mm_or_si128(_mm_and_si128(mask, d),
+		    _mm_andnot_si128(mask, s));
+		_mm_storeu_si128((__m128i *) &dst[i], d);
+	}
+#elif defined(__ARM_NEON)
+	uint32x4_t vkey = vdupq_n_u32(key);
+	uint32x4_t s, d, mask;
+
+	for (; i + 4 <= n; i += 4) {
+		s = vld1q_u32(&src[i]);
+		d = vld1q_u32(&dst[i]);
+		mask = vceqq_u32(s, vkey);
+		vst1q_u32(&dst[i], vbslq_u32(mask, d, s));
+	}
+#endif
+
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = src[i];
+	}
+}
+
+/** Paint color where row of source pixels is not equal to key color.
+ *
+ * @param dst Destination pixels
+ * @param src Source pixels
+ * @param key Key color (pixels with this value are transparent)
+ * @param color Color to paint with
+ * @param n Number of pixels
+ */
+void mem_pix_colorize_key(pixel_t *dst, const pixel_t *src, pixel_t key,
+    pixel_t color, size_t n)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	__m128i vkey = _mm_set1_epi32((int) key);
+	__m128i vcolor = _mm_set1_epi32((int) color);
+	__m128i s, d, mask;
+
+	for (; i + 4 <= n; i += 4) {
+		s = _mm_loadu_si128((const __m128i *) &src[i]);
+		d = _mm_loadu_si128((const __m128i *) &dst[i]);
+		mask = _mm_cmpeq_epi32(s, vkey);
+		d = _mm_or_si128(_mm_and_si128(mask, d),
+		    _mm_andnot_si128(mask, vcolor));
+		_mm_storeu_si128((__m128i *) &dst[i], d);
+	}
+#elif defined(__ARM_NEON)
+	uint32x4_t vkey = vdupq_n_u32(key);
+	uint32x4_t vcolor = vdupq_n_u32(color);
+	uint32x4_t s, d, mask;
+
+	for (; i + 4 <= n; i += 4) {
+		s = vld1q_u32(&src[i]);
+		d = vld1q_u32(&dst[i]);
+		mask = vceqq_u32(s, vkey);
+		vst1q_u32(&dst[i], vbslq_u32(mask, d, vcolor));
+	}
+#endif
+
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = color;
+	}
+}
+
+/** @}
+ */
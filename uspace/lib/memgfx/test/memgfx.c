@@ -279,6 +279,124 @@ PCUT_TEST(bitmap_render)
 	free(alloc.pixels);
 }
 
+/** Test rendering a bitmap with color key, offset and clipping */
+PCUT_TEST(bitmap_render_key_offs)
+{
+	mem_gc_t *mgc;
+	gfx_rect_t rect;
+	gfx_rect_t clip;
+	gfx_bitmap_alloc_t alloc;
+	gfx_context_t *gc;
+	gfx_coord2_t pos;
+	gfx_coord2_t offs;
+	gfx_coord2_t bpos;
+	gfx_bitmap_params_t params;
+	gfx_bitmap_alloc_t balloc;
+	gfx_bitmap_t *bitmap;
+	pixelmap_t bpmap;
+	pixelmap_t dpmap;
+	pixel_t pixel;
+	pixel_t expected;
+	test_resp_t resp;
+	errno_t rc;
+
+	/* Bounding rectangle for memory GC */
+	rect.p0.x = 0;
+	rect.p0.y = 0;
+	rect.p1.x = 10;
+	rect.p1.y = 10;
+
+	alloc.pitch = (rect.p1.x - rect.p0.x) * sizeof(uint32_t);
+	alloc.off0 = 0;
+	alloc.pixels = calloc(1, alloc.pitch * (rect.p1.y - rect.p0.y));
+	PCUT_ASSERT_NOT_NULL(alloc.pixels);
+
+	rc = mem_gc_create(&rect, &alloc, &test_mem_gc_cb, &resp, &mgc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	gc = mem_gc_get_ctx(mgc);
+	PCUT_ASSERT_NOT_NULL(gc);
+
+	/* Create bitmap with color key */
+
+	gfx_bitmap_params_init(&params);
+	params.rect.p0.x = 1;
+	params.rect.p0.y = 1;
+	params.rect.p1.x = 6;
+	params.rect.p1.y = 6;
+	params.flags = bmpf_color_key;
+	params.key_color = PIXEL(0, 255, 0, 255);
+
+	rc = gfx_bitmap_create(gc, &params, NULL, &bitmap);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gfx_bitmap_get_alloc(bitmap, &balloc);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	bpmap.width = params.rect.p1.x - params.rect.p0.x;
+	bpmap.height = params.rect.p1.y - params.rect.p0.y;
+	bpmap.data = balloc.pixels;
+
+	/* Every other pixel is transparent, others encode their position */
+	for (pos.y = 0; pos.y < (gfx_coord_t) bpmap.height; pos.y++) {
+		for (pos.x = 0; pos.x < (gfx_coord_t) bpmap.width; pos.x++) {
+			pixelmap_put_pixel(&bpmap, pos.x, pos.y,
+			    (pos.x + pos.y) % 2 == 0 ? params.key_color :
+			    PIXEL(0, pos.x, pos.y, 1));
+		}
+	}
+
+	dpmap.width = rect.p1.x - rect.p0.x;
+	dpmap.height = rect.p1.y - rect.p0.y;
+	dpmap.data = alloc.pixels;
+
+	/* Clip away the right part of the destination */
+	clip.p0.x = 0;
+	clip.p0.y = 0;
+	clip.p1.x = 7;
+	clip.p1.y = 10;
+	rc = gfx_set_clip_rect(gc, &clip);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	memset(&resp, 0, sizeof(resp));
+
+	offs.x = 3;
+	offs.y = 2;
+	rc = gfx_bitmap_render(bitmap, NULL, &offs);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	for (pos.y = rect.p0.y; pos.y < rect.p1.y; pos.y++) {
+		for (pos.x = rect.p0.x; pos.x < rect.p1.x; pos.x++) {
+			/* Position within the bitmap pixel map */
+			bpos.x = pos.x - offs.x - params.rect.p0.x;
+			bpos.y = pos.y - offs.y - params.rect.p0.y;
+
+			expected = PIXEL(0, 0, 0, 0);
+			if (pos.x < clip.p1.x && bpos.x >= 0 && bpos.y >= 0 &&
+			    bpos.x < (gfx_coord_t) bpmap.width &&
+			    bpos.y < (gfx_coord_t) bpmap.height &&
+			    (bpos.x + bpos.y) % 2 != 0)
+				expected = PIXEL(0, bpos.x, bpos.y, 1);
+
+			pixel = pixelmap_get_pixel(&dpmap, pos.x, pos.y);
+			PCUT_ASSERT_INT_EQUALS(expected, pixel);
+		}
+	}
+
+	/* Invalidate rect is the clipped destination rectangle */
+	PCUT_ASSERT_TRUE(resp.invalidate_called);
+	PCUT_ASSERT_INT_EQUALS(4, resp.inv_rect.p0.x);
+	PCUT_ASSERT_INT_EQUALS(3, resp.inv_rect.p0.y);
+	PCUT_ASSERT_INT_EQUALS(7, resp.inv_rect.p1.x);
+	PCUT_ASSERT_INT_EQUALS(8, resp.inv_rect.p1.y);
+
+	rc = gfx_bitmap_destroy(bitmap);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	mem_gc_delete(mgc);
+	free(alloc.pixels);
+}
+
 /** Test gfx_update() on a memory GC */
 PCUT_TEST(gfx_update)
 {
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <io/pixel.h>
+#include <pcut/pcut.h>
+#include <stddef.h>
+#include "../private/pixops.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(pixops);
+
+enum {
+	/** Test buffer size (pixels) */
+	test_buf_size = 32,
+	/** Key color used by the tests */
+	test_key = 7,
+	/** Color used by the tests */
+	test_color = 0x55,
+	/** Pixel value outside of the processed range */
+	test_guard = 0xdead
+};
+
+/** Set up source and destination buffers.
+ *
+ * Every third source pixel is equal to the key color.
+ */
+static void test_bufs_init(pixel_t *src, pixel_t *dst)
+{
+	size_t i;
+
+	for (i = 0; i < test_buf_size; i++) {
+		src[i] = (i % 3) != 0 ? 0x100 + i : test_key;
+		dst[i] = test_guard + i;
+	}
+}
+
+/** Fill rows of various lengths and alignments. */
+PCUT_TEST(fill)
+{
+	pixel_t src[test_buf_size];
+	pixel_t dst[test_buf_size];
+	size_t n, off, i;
+
+	for (n = 0; n < 20; n++) {
+		for (off = 0; off < 4; off++) {
+			test_bufs_init(src, dst);
+			mem_pix_fill(dst + off, test_color, n);
+
+			for (i = 0; i < test_buf_size; i++) {
+				if (i >= off && i < off + n)
+					PCUT_ASSERT_INT_EQUALS(test_color, dst[i]);
+				else
+					PCUT_ASSERT_INT_EQUALS(test_guard + i, dst[i]);
+			}
+		}
+	}
+}
+
+/** Copy rows of various lengths and alignments with color key. */
+PCUT_TEST(copy_key)
+{
+	pixel_t src[test_buf_size];
+	pixel_t dst[test_buf_size];
+	size_t n, off, i;
+
+	for (n = 0; n < 20; n++) {
+		for (off = 0; off < 4; off++) {
+			test_bufs_init(src, dst);
+			mem_pix_copy_key(dst + off, src + off, test_key, n);
+
+			for (i = 0; i < test_buf_size; i++) {
+				if (i >= off && i < off + n && src[i] != test_key)
+					PCUT_ASSERT_INT_EQUALS(src[i], dst[i]);
+				else
+					PCUT_ASSERT_INT_EQUALS(test_guard + i, dst[i]);
+			}
+		}
+	}
+}
+
+/** Colorize rows of various lengths and alignments with color key. */
+PCUT_TEST(colorize_key)
+{
+	pixel_t src[test_buf_size];
+	pixel_t dst[test_buf_size];
+	size_t n, off, i;
+
+	for (n = 0; n < 20; n++) {
+		for (off = 0; off < 4; off++) {
+			test_bufs_init(src, dst);
+			mem_pix_colorize_key(dst + off, src + off, test_key,
+			    test_color, n);
+
+			for (i = 0; i < test_buf_size; i++) {
+				if (i >= off && i < off + n && src[i] != test_key)
+					PCUT_ASSERT_INT_EQUALS(test_color, dst[i]);
+				else
+					PCUT_ASSERT_INT_EQUALS(test_guard + i, dst[i]);
+			}
+		}
+	}
+}
+
+PCUT_EXPORT(pixops);
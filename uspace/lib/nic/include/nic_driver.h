@@ -44,6 +44,7 @@
 
 #include <fibril_synch.h>
 #include <nic/nic.h>
+#include <nic/ring.h>
 #include <async.h>
 #include <pcapdump_srv.h>
 
@@ -80,6 +81,18 @@ struct nic {
 	nic_address_t default_mac;
 	/** Client callback session */
 	async_sess_t *client_session;
+	/** Frame rings shared by the client (NULL if frames are passed by IPC) */
+	nic_rings_t *rings;
+	/**
+	 * Lock for producing frames to the RX ring. Can be locked while holding
+	 * main_lock and tx_ring_lock.
+	 */
+	fibril_mutex_t rx_ring_lock;
+	/**
+	 * Lock for consuming frames from the TX ring. Can be locked while
+	 * holding main_lock, the rx_ring_lock must be locked as the second.
+	 */
+	fibril_mutex_t tx_ring_lock;
 	/** Current polling mode of the NIC */
 	nic_poll_mode_t poll_mode;
 	/** Polling period (applicable when poll_mode == NIC_POLL_PERIODIC) */
@@ -144,6 +144,10 @@ void nic_driver_implement(driver_ops_t *driver_ops, ddf_dev_ops_t *dev_ops,
 			iface->poll_set_mode = nic_poll_set_mode_impl;
 		if (!iface->poll_now)
 			iface->poll_now = nic_poll_now_impl;
+		if (!iface->ring_setup)
+			iface->ring_setup = nic_ring_setup_impl;
+		if (!iface->ring_kick)
+			iface->ring_kick = nic_ring_kick_impl;
 	}
 }
 
@@ -508,6 +512,46 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 	nic_data->tx_busy = busy;
 }
 
+/**
+ * Pass a received frame to the client. The frame is copied to the RX ring
+ * if the client shares one, otherwise it is sent by IPC. Like a hardware
+ * ring, a full RX ring drops the frame, so frames are never reordered.
+ * A frame too big for a ring slot is sent by IPC if the ring is empty
+ * and dropped otherwise.
+ *
+ * @param nic_data
+ * @param data		Frame data
+ * @param size		Frame size
+ */
+static void nic_deliver_frame(nic_t *nic_data, void *data, size_t size)
+{
+	fibril_mutex_lock(&nic_data->rx_ring_lock);
+	if (nic_data->rings != NULL) {
+		nic_ring_t *ring = &nic_data->rings->rx;
+		bool queued = false;
+		bool sent = false;
+
+		if (size <= NIC_RING_SLOT_SIZE) {
+			queued = nic_ring_put(ring, data, size);
+		} else if (nic_ring_empty(ring)) {
+			nic_ev_received(nic_data->client_session, data, size);
+			sent = true;
+		}
+
+		if (queued && nic_ring_doorbell(ring))
+			nic_ev_rx_ring(nic_data->client_session);
+
+		fibril_mutex_unlock(&nic_data->rx_ring_lock);
+
+		if (!queued && !sent)
+			nic_report_receive_error(nic_data, NIC_REC_BUFFER_FULL, 1);
+		return;
+	}
+	fibril_mutex_unlock(&nic_data->rx_ring_lock);
+
+	nic_ev_received(nic_data->client_session, data, size);
+}
+
 /**
  * This is the function that the driver should call when it receives a frame.
  * The frame is checked by filters and then sent up to the NIL layer or
@@ -545,8 +589,7 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			break;
 		}
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
-		nic_ev_received(nic_data->client_session, frame->data,
-		    frame->size);
+		nic_deliver_frame(nic_data, frame->data, frame->size);
 	} else {
 		switch (frame_type) {
 		case NIC_FRAME_UNICAST:
@@ -612,6 +655,7 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->fun = NULL;
 	nic_data->state = NIC_STATE_STOPPED;
 	nic_data->client_session = NULL;
+	nic_data->rings = NULL;
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
@@ -624,6 +668,8 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	fibril_rwlock_initialize(&nic_data->stats_lock);
 	fibril_rwlock_initialize(&nic_data->rxc_lock);
 	fibril_rwlock_initialize(&nic_data->wv_lock);
+	fibril_mutex_initialize(&nic_data->rx_ring_lock);
+	fibril_mutex_initialize(&nic_data->tx_ring_lock);
 
 	memset(&nic_data->mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->default_mac, 0, sizeof(nic_address_t));
@@ -666,6 +712,8 @@ nic_t *nic_create_and_bind(ddf_dev_t *device)
  */
 static void nic_destroy(nic_t *nic_data)
 {
+	if (nic_data->rings != NULL)
+		as_area_destroy(nic_data->rings);
 	free(nic_data->specific);
 }
 
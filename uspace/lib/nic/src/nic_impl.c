@@ -35,6 +35,7 @@
  * @brief Default DDF NIC interface methods implementations
  */
 
+#include <as.h>
 #include <errno.h>
 #include <str_error.h>
 #include <ipc/services.h>
@@ -809,6 +810,93 @@ errno_t nic_poll_now_impl(ddf_fun_t *fun)
 	}
 }
 
+/**
+ * Replace the frame rings shared by the client. The memory of the previous
+ * rings is unmapped. Must be called with the main_lock locked for writing.
+ *
+ * @param nic_data
+ * @param rings		New rings or NULL to pass frames by IPC
+ */
+static void nic_ring_replace(nic_t *nic_data, nic_rings_t *rings)
+{
+	fibril_mutex_lock(&nic_data->tx_ring_lock);
+	fibril_mutex_lock(&nic_data->rx_ring_lock);
+	nic_rings_t *old = nic_data->rings;
+	nic_data->rings = rings;
+	fibril_mutex_unlock(&nic_data->rx_ring_lock);
+	fibril_mutex_unlock(&nic_data->tx_ring_lock);
+
+	if (old != NULL)
+		as_area_destroy(old);
+}
+
+/**
+ * Default implementation of the ring_setup method.
+ * Starts passing frames through the rings shared by the client.
+ *
+ * @param	fun
+ * @param	rings	Address space area with the rings shared by the client
+ * @param	size	Size of the address space area
+ *
+ * @return EOK		If the rings are used from now on
+ * @return EINVAL	If the area is too small to hold the rings
+ */
+errno_t nic_ring_setup_impl(ddf_fun_t *fun, void *rings, size_t size)
+{
+	if (size < sizeof(nic_rings_t))
+		return EINVAL;
+
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	fibril_rwlock_write_lock(&nic_data->main_lock);
+	nic_ring_replace(nic_data, rings);
+	fibril_rwlock_write_unlock(&nic_data->main_lock);
+	return EOK;
+}
+
+/**
+ * Default implementation of the ring_kick method.
+ * Sends all frames in the TX ring. Frames are dropped if the NIC is not
+ * active or the transmitter is busy, as in nic_send_frame_impl.
+ *
+ * @param	fun
+ *
+ * @return EOK		If the TX ring was drained
+ * @return ENOENT	If no rings are shared by the client
+ */
+errno_t nic_ring_kick_impl(ddf_fun_t *fun)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	fibril_rwlock_read_lock(&nic_data->main_lock);
+	fibril_mutex_lock(&nic_data->tx_ring_lock);
+
+	nic_ring_t *ring = (nic_data->rings != NULL) ?
+	    &nic_data->rings->tx : NULL;
+	if (ring == NULL) {
+		fibril_mutex_unlock(&nic_data->tx_ring_lock);
+		fibril_rwlock_read_unlock(&nic_data->main_lock);
+		return ENOENT;
+	}
+
+	do {
+		void *data;
+		size_t size;
+
+		while (nic_ring_peek(ring, &data, &size)) {
+			if (nic_data->state == NIC_STATE_ACTIVE &&
+			    !nic_data->tx_busy) {
+				pcapdump_packet(nic_get_pcap_dumper(nic_data),
+				    data, size);
+				nic_data->send_frame(nic_data, data, size);
+			}
+			nic_ring_consume(ring);
+		}
+	} while (!nic_ring_arm(ring));
+
+	fibril_mutex_unlock(&nic_data->tx_ring_lock);
+	fibril_rwlock_read_unlock(&nic_data->main_lock);
+	return EOK;
+}
+
 /**
  * Default handler for unknown methods (outside of the NIC interface).
  * Logs a warning message and returns ENOTSUP to the caller.
@@ -835,12 +923,17 @@ errno_t nic_open_impl(ddf_fun_t *fun)
 }
 
 /**
- * Default (empty) OPEN function implementation.
+ * Default CLOSE function implementation. Stops using the frame rings
+ * shared by the client.
  *
  * @param fun	The DDF function
  */
 void nic_close_impl(ddf_fun_t *fun)
 {
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+	fibril_rwlock_write_lock(&nic_data->main_lock);
+	nic_ring_replace(nic_data, NULL);
+	fibril_rwlock_write_unlock(&nic_data->main_lock);
 }
 
 errno_t nic_fun_add_to_cats(ddf_fun_t *fun)
@@ -53,6 +53,8 @@ static vfs_info_t cdfs_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.cacheable = true,
+	.names_cacheable = true,
 	.instance = 0,
 };
 
@@ -50,6 +50,8 @@
 
 vfs_info_t ext4fs_vfs_info = {
 	.name = NAME,
+	.cacheable = true,
+	.names_cacheable = true,
 	.instance = 0
 };
 
@@ -55,6 +55,8 @@ vfs_info_t fat_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.cacheable = true,
+	.names_cacheable = true,
 	.instance = 0,
 };
 
@@ -56,6 +56,8 @@ static vfs_info_t locfs_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.cacheable = false,
+	.names_cacheable = false,
 	.instance = 0,
 };
 
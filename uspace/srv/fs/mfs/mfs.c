@@ -53,6 +53,8 @@ vfs_info_t mfs_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.cacheable = true,
+	.names_cacheable = true,
 	.instance = 0,
 };
 
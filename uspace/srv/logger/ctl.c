@@ -82,10 +82,14 @@ void logger_connection_handler_control(ipc_call_t *icall)
 		switch (ipc_get_imethod(&call)) {
 		case LOGGER_CONTROL_SET_DEFAULT_LEVEL:
 			rc = set_default_logging_level(ipc_get_arg1(&call));
+			if (rc == EOK)
+				publish_all_levels();
 			async_answer_0(&call, rc);
 			break;
 		case LOGGER_CONTROL_SET_LOG_LEVEL:
 			rc = handle_log_level_change(ipc_get_arg1(&call));
+			if (rc == EOK)
+				publish_all_levels();
 			async_answer_0(&call, rc);
 			break;
 		case LOGGER_CONTROL_SET_ROOT:
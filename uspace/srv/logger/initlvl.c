@@ -79,6 +79,8 @@ void parse_level_settings(char *settings)
 		parse_single_level_setting(single_setting);
 		single_setting = str_tok(tmp, " ", &tmp);
 	}
+
+	publish_all_levels();
 }
 
 void parse_initial_settings(void)
@@ -42,6 +42,7 @@
 #include <stdbool.h>
 #include <fibril_synch.h>
 #include <stdio.h>
+#include <ipc/logger.h>
 
 #define NAME "logger"
 #define LOG_LEVEL_USE_DEFAULT (LVL_LIMIT + 1)
@@ -58,6 +59,8 @@ typedef struct {
 	fibril_mutex_t guard;
 	char *filename;
 	FILE *logfile;
+	/** Messages were written to logfile since it was last flushed. */
+	bool dirty;
 } logger_dest_t;
 
 struct logger_log {
@@ -74,11 +77,15 @@ struct logger_log {
 	logger_dest_t *dest;
 };
 
-#define MAX_REFERENCED_LOGS_PER_CLIENT 100
+#define MAX_REFERENCED_LOGS_PER_CLIENT LOGGER_CLIENT_LOGS_MAX
 
 typedef struct {
+	/** Link to the list of writer clients. */
+	link_t link;
 	size_t logs_count;
 	logger_log_t *logs[MAX_REFERENCED_LOGS_PER_CLIENT];
+	/** Effective levels of the logs shared with the client (or NULL). */
+	logger_levels_t *levels;
 } logger_registered_logs_t;
 
 logger_log_t *find_log_by_name_and_lock(const char *name);
@@ -87,11 +94,14 @@ logger_log_t *find_log_by_id_and_lock(sysarg_t);
 bool shall_log_message(logger_log_t *, log_level_t);
 void log_unlock(logger_log_t *);
 void write_to_log(logger_log_t *, log_level_t, const char *);
+void flush_logs(logger_registered_logs_t *);
 void log_release(logger_log_t *);
 
 void registered_logs_init(logger_registered_logs_t *);
 bool register_log(logger_registered_logs_t *, logger_log_t *);
 void unregister_logs(logger_registered_logs_t *);
+void publish_levels(logger_registered_logs_t *);
+void publish_all_levels(void);
 
 log_level_t get_default_logging_level(void);
 errno_t set_default_logging_level(log_level_t);
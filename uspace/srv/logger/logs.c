@@ -30,6 +30,7 @@
 /** @addtogroup logger
  * @{
  */
+#include <as.h>
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
@@ -40,6 +41,10 @@
 static FIBRIL_MUTEX_INITIALIZE(log_list_guard);
 static LIST_INITIALIZE(log_list);
 
+/** Guards the list of writer clients. */
+static FIBRIL_MUTEX_INITIALIZE(client_list_guard);
+static LIST_INITIALIZE(client_list);
+
 static logger_log_t *find_log_by_name_and_parent_no_list_lock(const char *name, logger_log_t *parent)
 {
 	list_foreach(log_list, link, logger_log_t, log) {
@@ -60,6 +65,7 @@ static errno_t create_dest(const char *name, logger_dest_t **dest)
 		return ENOMEM;
 	}
 	result->logfile = NULL;
+	result->dirty = false;
 	fibril_mutex_initialize(&result->guard);
 	*dest = result;
 	return EOK;
@@ -295,15 +301,42 @@ void write_to_log(logger_log_t *log, log_level_t level, const char *message)
 		fprintf(log->dest->logfile, "[%s] %s: %s\n",
 		    log->full_name, log_level_str(level),
 		    (const char *) message);
-		fflush(log->dest->logfile);
+		log->dest->dirty = true;
 	}
 
 	fibril_mutex_unlock(&log->dest->guard);
 }
 
+/** Flush log files written through logs of a client.
+ *
+ * Log files are flushed once per request rather than after
+ * each message written by write_to_log().
+ *
+ * @param logs Logs registered by the client.
+ */
+void flush_logs(logger_registered_logs_t *logs)
+{
+	for (size_t i = 0; i < logs->logs_count; i++) {
+		logger_dest_t *dest = logs->logs[i]->dest;
+
+		fibril_mutex_lock(&dest->guard);
+		if (dest->dirty) {
+			fflush(dest->logfile);
+			dest->dirty = false;
+		}
+		fibril_mutex_unlock(&dest->guard);
+	}
+}
+
 void registered_logs_init(logger_registered_logs_t *logs)
 {
+	link_initialize(&logs->link);
 	logs->logs_count = 0;
+	logs->levels = NULL;
+
+	fibril_mutex_lock(&client_list_guard);
+	list_append(&logs->link, &client_list);
+	fibril_mutex_unlock(&client_list_guard);
 }
 
 bool register_log(logger_registered_logs_t *logs, logger_log_t *new_log)
@@ -323,11 +356,60 @@ bool register_log(logger_registered_logs_t *logs, logger_log_t *new_log)
 
 void unregister_logs(logger_registered_logs_t *logs)
 {
+	fibril_mutex_lock(&client_list_guard);
+	list_remove(&logs->link);
+	fibril_mutex_unlock(&client_list_guard);
+
 	for (size_t i = 0; i < logs->logs_count; i++) {
 		logger_log_t *log = logs->logs[i];
 		fibril_mutex_lock(&log->guard);
 		log_release(log);
 	}
+
+	if (logs->levels != NULL) {
+		as_area_destroy(logs->levels);
+		logs->levels = NULL;
+	}
+}
+
+/** Publish effective levels of logs registered by a client.
+ *
+ * Precondition: client list is locked.
+ *
+ * @param logs Logs registered by the client.
+ */
+static void publish_levels_no_client_list_lock(logger_registered_logs_t *logs)
+{
+	if (logs->levels == NULL)
+		return;
+
+	fibril_mutex_lock(&log_list_guard);
+	for (size_t i = 0; i < logs->logs_count; i++)
+		logs->levels->level[i] = get_actual_log_level(logs->logs[i]);
+	fibril_mutex_unlock(&log_list_guard);
+}
+
+/** Publish effective levels of logs registered by a client.
+ *
+ * @param logs Logs registered by the client.
+ */
+void publish_levels(logger_registered_logs_t *logs)
+{
+	fibril_mutex_lock(&client_list_guard);
+	publish_levels_no_client_list_lock(logs);
+	fibril_mutex_unlock(&client_list_guard);
+}
+
+/** Publish effective levels of logs registered by all clients.
+ *
+ * Must be called whenever a logging level changes.
+ */
+void publish_all_levels(void)
+{
+	fibril_mutex_lock(&client_list_guard);
+	list_foreach(client_list, link, logger_registered_logs_t, logs)
+		publish_levels_no_client_list_lock(logs);
+	fibril_mutex_unlock(&client_list_guard);
 }
 
 /**
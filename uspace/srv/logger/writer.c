@@ -34,6 +34,8 @@
 /** @file
  */
 
+#include <align.h>
+#include <as.h>
 #include <ipc/services.h>
 #include <ipc/logger.h>
 #include <io/log.h>
@@ -61,36 +63,108 @@ static logger_log_t *handle_create_log(sysarg_t parent)
 	return log;
 }
 
-static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level)
+static errno_t write_message(sysarg_t log_id, sysarg_t level,
+    const char *message)
 {
+	if (level >= LVL_LIMIT)
+		return EINVAL;
+
 	logger_log_t *log = find_log_by_id_and_lock(log_id);
 	if (log == NULL)
 		return ENOENT;
 
+	if (shall_log_message(log, level)) {
+		KLOG_PRINTF(level, "[%s] %s: %s",
+		    log->full_name, log_level_str(level), message);
+		write_to_log(log, level, message);
+	}
+
+	log_unlock(log);
+
+	return EOK;
+}
+
+static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level)
+{
 	void *message = NULL;
 	errno_t rc = async_data_write_accept(&message, true, 1, 0, 0, NULL);
 	if (rc != EOK)
-		goto leave;
+		return rc;
 
-	if (!shall_log_message(log, level)) {
-		rc = EOK;
-		goto leave;
-	}
+	rc = write_message(log_id, level, message);
+	free(message);
 
-	KLOG_PRINTF(level, "[%s] %s: %s",
-	    log->full_name, log_level_str(level),
-	    (const char *) message);
-	write_to_log(log, level, message);
+	return rc;
+}
 
-	rc = EOK;
+static errno_t handle_receive_messages(void)
+{
+	void *batch = NULL;
+	size_t size;
+	errno_t rc = async_data_write_accept(&batch, false,
+	    sizeof(logger_batch_msg_t), LOGGER_BATCH_SIZE_MAX, 0, &size);
+	if (rc != EOK)
+		return rc;
+
+	size_t offset = 0;
+	while (size - offset >= sizeof(logger_batch_msg_t)) {
+		logger_batch_msg_t *msg =
+		    (logger_batch_msg_t *) ((uint8_t *) batch + offset);
+		const char *message = (const char *) (msg + 1);
+		size_t avail = size - offset - sizeof(logger_batch_msg_t);
+
+		if ((msg->size == 0) || (msg->size > avail) ||
+		    (message[msg->size - 1] != '\0')) {
+			rc = EINVAL;
+			break;
+		}
 
-leave:
-	log_unlock(log);
-	free(message);
+		/* A message for an unknown log does not spoil the batch. */
+		errno_t msg_rc = write_message(msg->log, msg->level, message);
+		if (rc == EOK)
+			rc = msg_rc;
+
+		offset += ALIGN_UP(sizeof(logger_batch_msg_t) + msg->size,
+		    sizeof(sysarg_t));
+	}
+
+	free(batch);
 
 	return rc;
 }
 
+static errno_t handle_share_levels(logger_registered_logs_t *logs)
+{
+	ipc_call_t call;
+	size_t size;
+
+	if (!async_share_in_receive(&call, &size))
+		return EINVAL;
+
+	if ((logs->levels != NULL) || (size != LOGGER_LEVELS_SIZE)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	void *levels = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (levels == AS_MAP_FAILED) {
+		async_answer_0(&call, ENOMEM);
+		return ENOMEM;
+	}
+
+	errno_t rc = async_share_in_finalize(&call, levels, AS_AREA_READ);
+	if (rc != EOK) {
+		as_area_destroy(levels);
+		return rc;
+	}
+
+	logs->levels = levels;
+	publish_levels(logs);
+
+	return EOK;
+}
+
 void logger_connection_handler_writer(ipc_call_t *icall)
 {
 	logger_log_t *log;
@@ -126,11 +200,23 @@ void logger_connection_handler_writer(ipc_call_t *icall)
 				break;
 			}
 			log_unlock(log);
-			async_answer_1(&call, EOK, (sysarg_t) log);
+			publish_levels(&registered_logs);
+			async_answer_2(&call, EOK, (sysarg_t) log,
+			    registered_logs.logs_count - 1);
 			break;
 		case LOGGER_WRITER_MESSAGE:
 			rc = handle_receive_message(ipc_get_arg1(&call),
 			    ipc_get_arg2(&call));
+			flush_logs(&registered_logs);
+			async_answer_0(&call, rc);
+			break;
+		case LOGGER_WRITER_MESSAGES:
+			rc = handle_receive_messages();
+			flush_logs(&registered_logs);
+			async_answer_0(&call, rc);
+			break;
+		case LOGGER_WRITER_SHARE_LEVELS:
+			rc = handle_share_levels(&registered_logs);
 			async_answer_0(&call, rc);
 			break;
 		default:
@@ -39,10 +39,12 @@
 
 #include <adt/list.h>
 #include <async.h>
+#include <fibril_synch.h>
 #include <inet/addr.h>
 #include <inet/eth_addr.h>
 #include <inet/iplink_srv.h>
 #include <loc.h>
+#include <nic/ring.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -57,6 +59,11 @@ typedef struct ethip_nic {
 	char *svc_name;
 	async_sess_t *sess;
 
+	/** Frame rings shared with the NIC (NULL if not supported) */
+	nic_rings_t *rings;
+	/** Protects setup of the rings and production to the TX ring */
+	fibril_mutex_t tx_lock;
+
 	iplink_srv_t iplink;
 	service_id_t iplink_sid;
 
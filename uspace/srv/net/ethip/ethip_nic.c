@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <as.h>
 #include <async.h>
 #include <errno.h>
 #include <fibril_synch.h>
@@ -51,6 +52,9 @@
 #include "ethip_nic.h"
 #include "pdu.h"
 
+/** Time to wait for the NIC to make room in the TX ring */
+#define ETHIP_TX_WAIT_USEC 100
+
 static errno_t ethip_nic_open(service_id_t sid);
 static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg);
 
@@ -115,6 +119,7 @@ static ethip_nic_t *ethip_nic_new(void)
 
 	link_initialize(&nic->link);
 	list_initialize(&nic->addr_list);
+	fibril_mutex_initialize(&nic->tx_lock);
 
 	return nic;
 }
@@ -139,6 +144,9 @@ static void ethip_nic_delete(ethip_nic_t *nic)
 	if (nic->svc_name != NULL)
 		free(nic->svc_name);
 
+	if (nic->rings != NULL)
+		as_area_destroy(nic->rings);
+
 	free(nic);
 }
 
@@ -147,6 +155,47 @@ static void ethip_link_addr_delete(ethip_link_addr_t *laddr)
 	free(laddr);
 }
 
+/** Share frame rings with the NIC
+ *
+ * Failure is not fatal, the frames are then passed by IPC.
+ *
+ * @param nic NIC
+ */
+static void ethip_nic_rings_setup(ethip_nic_t *nic)
+{
+	nic_rings_t *rings = as_area_create(AS_AREA_ANY, sizeof(nic_rings_t),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (rings == AS_MAP_FAILED) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed allocating frame rings "
+		    "for '%s'.", nic->svc_name);
+		return;
+	}
+
+	nic_ring_init(&rings->rx);
+	nic_ring_init(&rings->tx);
+
+	/*
+	 * The NIC can notify us of received frames before nic_ring_setup()
+	 * returns, so the rings must be published first. Frames to transmit
+	 * wait on tx_lock until the NIC has accepted the rings.
+	 */
+	fibril_mutex_lock(&nic->tx_lock);
+	nic->rings = rings;
+
+	errno_t rc = nic_ring_setup(nic->sess, rings);
+	if (rc != EOK) {
+		nic->rings = NULL;
+		fibril_mutex_unlock(&nic->tx_lock);
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "NIC '%s' does not support "
+		    "frame rings: %s.", nic->svc_name, str_error_name(rc));
+		as_area_destroy(rings);
+		return;
+	}
+
+	fibril_mutex_unlock(&nic->tx_lock);
+}
+
 static errno_t ethip_nic_open(service_id_t sid)
 {
 	bool in_list = false;
@@ -209,6 +258,8 @@ static errno_t ethip_nic_open(service_id_t sid)
 		goto error;
 	}
 
+	ethip_nic_rings_setup(nic);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Initialized IP link service,");
 
 	return EOK;
@@ -284,6 +335,31 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void ethip_nic_rx_ring(ethip_nic_t *nic, ipc_call_t *call)
+{
+	async_answer_0(call, EOK);
+
+	if (nic->rings == NULL)
+		return;
+
+	nic_ring_t *ring = &nic->rings->rx;
+	void *data;
+	size_t size;
+
+	/* Process the frames in place until the ring stays empty */
+	do {
+		while (nic_ring_peek(ring, &data, &size)) {
+			errno_t rc = ethip_received(&nic->iplink, data, size);
+			if (rc != EOK) {
+				log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_received() "
+				    "failed, rc=%s", str_error_name(rc));
+			}
+
+			nic_ring_consume(ring);
+		}
+	} while (!nic_ring_arm(ring));
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -315,6 +391,9 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
+		case NIC_EV_RX_RING:
+			ethip_nic_rx_ring(nic, &call);
+			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, ipc_get_imethod(&call));
 			async_answer_0(&call, ENOTSUP);
@@ -355,8 +434,49 @@ errno_t ethip_nic_send(ethip_nic_t *nic, void *data, size_t size)
 {
 	errno_t rc;
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_send(size=%zu)", size);
-	rc = nic_send_frame(nic->sess, data, size);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame -> %s", str_error_name(rc));
+
+	fibril_mutex_lock(&nic->tx_lock);
+	if (nic->rings == NULL) {
+		fibril_mutex_unlock(&nic->tx_lock);
+		rc = nic_send_frame(nic->sess, data, size);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame -> %s",
+		    str_error_name(rc));
+		return rc;
+	}
+
+	nic_ring_t *ring = &nic->rings->tx;
+
+	/*
+	 * Wait for the NIC to make room in the ring. A frame which does not
+	 * fit in a slot is sent by IPC, but only after the NIC has drained
+	 * the ring, so that it cannot overtake the frames queued before it.
+	 * Holding tx_lock keeps frames of other fibrils from overtaking it.
+	 */
+	while (true) {
+		if (size <= NIC_RING_SLOT_SIZE) {
+			if (nic_ring_put(ring, data, size))
+				break;
+		} else if (nic_ring_empty(ring)) {
+			break;
+		}
+
+		if (nic_ring_doorbell(ring))
+			nic_ring_kick(nic->sess);
+
+		fibril_usleep(ETHIP_TX_WAIT_USEC);
+	}
+
+	if (size <= NIC_RING_SLOT_SIZE) {
+		if (nic_ring_doorbell(ring))
+			nic_ring_kick(nic->sess);
+		rc = EOK;
+	} else {
+		rc = nic_send_frame(nic->sess, data, size);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame -> %s",
+		    str_error_name(rc));
+	}
+
+	fibril_mutex_unlock(&nic->tx_lock);
 	return rc;
 }
 
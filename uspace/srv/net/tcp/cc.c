@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file TCP congestion control
+ *
+ * Implements slow start and congestion avoidance (RFC 5681) with fast
+ * retransmit and NewReno fast recovery (RFC 6582). The way the congestion
+ * window grows in congestion avoidance and how much it is reduced when
+ * loss is detected is left to a pluggable algorithm (tcp_cc_ops_t).
+ * NewReno (RFC 5681) and CUBIC (RFC 8312) are provided.
+ */
+
+#include <macros.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "cc.h"
+#include "rtt.h"
+#include "tcp_type.h"
+
+/** Number of duplicate ACKs that trigger fast retransmit */
+#define CC_DUPACK_THRESH	3
+/** Upper bound of initial window (RFC 3390) */
+#define CC_IW_MAX		4380
+/** Upper bound of congestion window */
+#define CC_CWND_MAX		(1 << 30)
+
+/** CUBIC multiplicative decrease factor (0.7, scaled by 1024) */
+#define CUBIC_BETA		717
+/** CUBIC Reno-friendly additive increase 3(1-beta)/(1+beta) (scaled by 1024) */
+#define CUBIC_AI		542
+/** CUBIC constant C (0.4) in milli-segments per 10^7 ms^3 */
+#define CUBIC_C			4
+/** 1 / C in ms^3 per segment, used to compute K */
+#define CUBIC_K_SCALE		2500000000ULL
+/** Bound on distance from K that is evaluated [ms] */
+#define CUBIC_T_MAX		100000
+
+static void tcp_cc_newreno_cong_avoid(tcp_conn_t *, uint32_t);
+static uint32_t tcp_cc_newreno_ssthresh(tcp_conn_t *);
+static void tcp_cc_cubic_init(tcp_conn_t *);
+static void tcp_cc_cubic_cong_avoid(tcp_conn_t *, uint32_t);
+static uint32_t tcp_cc_cubic_ssthresh(tcp_conn_t *);
+
+/** NewReno congestion control */
+tcp_cc_ops_t tcp_cc_newreno = {
+	.name = "newreno",
+	.init = NULL,
+	.cong_avoid = tcp_cc_newreno_cong_avoid,
+	.ssthresh = tcp_cc_newreno_ssthresh
+};
+
+/** CUBIC congestion control */
+tcp_cc_ops_t tcp_cc_cubic = {
+	.name = "cubic",
+	.init = tcp_cc_cubic_init,
+	.cong_avoid = tcp_cc_cubic_cong_avoid,
+	.ssthresh = tcp_cc_cubic_ssthresh
+};
+
+/** Congestion control algorithm used for new connections */
+tcp_cc_ops_t *tcp_cc_default = &tcp_cc_cubic;
+
+/** Amount of data sent, but not yet acknowledged.
+ *
+ * @param conn Connection
+ * @return Flight size
+ */
+static uint32_t tcp_cc_flight_size(tcp_conn_t *conn)
+{
+	return conn->snd_nxt - conn->snd_una;
+}
+
+/** Increase congestion window, respecting its upper bound.
+ *
+ * @param cc Congestion control
+ * @param incr Increment
+ */
+static void tcp_cc_cwnd_add(tcp_cc_t *cc, uint32_t incr)
+{
+	cc->cwnd = min(cc->cwnd + incr, CC_CWND_MAX);
+}
+
+/** Initialize congestion control of a connection.
+ *
+ * @a conn->smss must be set before calling this function.
+ *
+ * @param conn Connection
+ * @param ops Congestion control algorithm
+ */
+void tcp_cc_init(tcp_conn_t *conn, tcp_cc_ops_t *ops)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	cc->ops = ops;
+	cc->state = ccs_open;
+	cc->cwnd = min(4 * conn->smss, max(2 * conn->smss, CC_IW_MAX));
+	cc->ssthresh = UINT32_MAX;
+	cc->bytes_acked = 0;
+	cc->dupacks = 0;
+	cc->recover = 0;
+
+	if (ops->init != NULL)
+		ops->init(conn);
+}
+
+/** Get effective send window.
+ *
+ * @param conn Connection
+ * @return Number of bytes past SND.UNA we are allowed to send
+ */
+uint32_t tcp_cc_snd_wnd(tcp_conn_t *conn)
+{
+	return min(conn->snd_wnd, conn->cc.cwnd);
+}
+
+/** Grow congestion window after new data was acknowledged.
+ *
+ * @param conn Connection
+ * @param acked Number of newly acknowledged bytes
+ */
+static void tcp_cc_grow(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	if (cc->cwnd < cc->ssthresh) {
+		/* Slow start */
+		tcp_cc_cwnd_add(cc, min(acked, conn->smss));
+	} else {
+		/* Congestion avoidance */
+		cc->ops->cong_avoid(conn, acked);
+	}
+}
+
+/** Process acknowledgement of new data.
+ *
+ * Call after SND.UNA has been updated.
+ *
+ * @param conn Connection
+ * @param acked Number of newly acknowledged bytes
+ * @return @c true if the first unacknowledged segment should be
+ *         retransmitted
+ */
+bool tcp_cc_ack(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cc_t *cc = &conn->cc;
+	bool recovered;
+
+	cc->dupacks = 0;
+	if (acked == 0)
+		return false;
+
+	/* SND.UNA >= recover modulo sequence space */
+	recovered = ((conn->snd_una - cc->recover) & (0x1u << 31)) == 0;
+
+	switch (cc->state) {
+	case ccs_open:
+		tcp_cc_grow(conn, acked);
+		break;
+	case ccs_recovery:
+		if (!recovered) {
+			/*
+			 * Partial ACK. Deflate window by the amount of data
+			 * acknowledged and retransmit the next segment.
+			 */
+			cc->cwnd -= min(acked, cc->cwnd);
+			if (acked >= conn->smss)
+				cc->cwnd += conn->smss;
+			cc->cwnd = max(cc->cwnd, conn->smss);
+			return true;
+		}
+
+		/* Full ACK. Exit fast recovery */
+		cc->cwnd = min(cc->ssthresh,
+		    max(tcp_cc_flight_size(conn), conn->smss) + conn->smss);
+		cc->bytes_acked = 0;
+		cc->state = ccs_open;
+		break;
+	case ccs_loss:
+		tcp_cc_grow(conn, acked);
+		if (!recovered) {
+			/* Next segment was most likely lost as well */
+			return true;
+		}
+
+		cc->state = ccs_open;
+		break;
+	}
+
+	return false;
+}
+
+/** Process duplicate acknowledgement.
+ *
+ * @param conn Connection
+ * @return @c true if the first unacknowledged segment should be
+ *         retransmitted (fast retransmit)
+ */
+bool tcp_cc_dup_ack(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	switch (cc->state) {
+	case ccs_open:
+		if (++cc->dupacks < CC_DUPACK_THRESH)
+			return false;
+
+		/* Fast retransmit, enter fast recovery */
+		cc->ssthresh = cc->ops->ssthresh(conn);
+		cc->cwnd = cc->ssthresh + CC_DUPACK_THRESH * conn->smss;
+		cc->recover = conn->snd_nxt;
+		cc->bytes_acked = 0;
+		cc->state = ccs_recovery;
+		return true;
+	case ccs_recovery:
+		/* Another segment has left the network, inflate window */
+		tcp_cc_cwnd_add(cc, conn->smss);
+		return false;
+	case ccs_loss:
+		break;
+	}
+
+	return false;
+}
+
+/** Process expiration of the retransmission timer.
+ *
+ * @param conn Connection
+ */
+void tcp_cc_timeout(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	/* Keep ssthresh if the segment has already been retransmitted */
+	if (cc->state != ccs_loss)
+		cc->ssthresh = cc->ops->ssthresh(conn);
+
+	cc->cwnd = conn->smss;
+	cc->recover = conn->snd_nxt;
+	cc->bytes_acked = 0;
+	cc->dupacks = 0;
+	cc->state = ccs_loss;
+}
+
+/** NewReno congestion avoidance.
+ *
+ * Increase the window by one SMSS for each window worth of data
+ * acknowledged.
+ *
+ * @param conn Connection
+ * @param acked Number of newly acknowledged bytes
+ */
+static void tcp_cc_newreno_cong_avoid(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	cc->bytes_acked += acked;
+	if (cc->bytes_acked >= cc->cwnd) {
+		cc->bytes_acked -= cc->cwnd;
+		tcp_cc_cwnd_add(cc, conn->smss);
+	}
+}
+
+/** NewReno slow start threshold after loss.
+ *
+ * @param conn Connection
+ * @return Half of the flight size, at least two segments
+ */
+static uint32_t tcp_cc_newreno_ssthresh(tcp_conn_t *conn)
+{
+	return max(tcp_cc_flight_size(conn) / 2, 2 * conn->smss);
+}
+
+/** Integer cube root.
+ *
+ * @param a Argument
+ * @return Largest integer r such that r^3 <= a
+ */
+static uint32_t tcp_cc_cbrt(uint64_t a)
+{
+	uint32_t lo, hi, mid;
+
+	lo = 0;
+	hi = 2642245;	/* floor(cbrt(2^64 - 1)) */
+
+	while (lo < hi) {
+		mid = lo + (hi - lo + 1) / 2;
+		if ((uint64_t)mid * mid * mid <= a)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return lo;
+}
+
+/** Initialize CUBIC state.
+ *
+ * @param conn Connection
+ */
+static void tcp_cc_cubic_init(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	cc->w_max = 0;
+	cc->epoch_start = 0;
+	cc->k = 0;
+	cc->origin = 0;
+	cc->w_est = 0;
+}
+
+/** CUBIC congestion avoidance.
+ *
+ * The window follows W(t) = C (t - K)^3 + W_max, where t is the time
+ * since the start of the congestion avoidance epoch, but never grows
+ * slower than Reno would.
+ *
+ * @param conn Connection
+ * @param acked Number of newly acknowledged bytes
+ */
+static void tcp_cc_cubic_cong_avoid(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cc_t *cc = &conn->cc;
+	usec_t now;
+	int64_t t;
+	int64_t target;
+	uint64_t cnt;
+
+	now = tcp_rtt_now();
+
+	if (cc->epoch_start == 0) {
+		/* Start new epoch */
+		cc->epoch_start = now;
+		cc->bytes_acked = 0;
+		if (cc->cwnd < cc->w_max) {
+			cc->k = tcp_cc_cbrt((uint64_t)(cc->w_max - cc->cwnd) *
+			    CUBIC_K_SCALE / conn->smss);
+			cc->origin = cc->w_max;
+		} else {
+			cc->k = 0;
+			cc->origin = cc->cwnd;
+		}
+		cc->w_est = cc->cwnd;
+	}
+
+	/* Target window one RTT from now */
+	t = USEC2MSEC(now - cc->epoch_start + conn->rtt.srtt) - cc->k;
+	t = min(max(t, -CUBIC_T_MAX), CUBIC_T_MAX);
+	target = (int64_t)cc->origin +
+	    t * t * t * CUBIC_C / 10000000 * conn->smss / 1000;
+
+	/* Reno-friendly region */
+	cc->w_est += (uint64_t)acked * conn->smss * CUBIC_AI / 1024 / cc->cwnd;
+	if (target < cc->w_est)
+		target = cc->w_est;
+
+	/* Number of bytes to acknowledge before increasing window by SMSS */
+	if (target > cc->cwnd) {
+		cnt = (uint64_t)cc->cwnd * conn->smss / (target - cc->cwnd);
+		cnt = max(cnt, conn->smss);
+	} else {
+		cnt = 100 * (uint64_t)cc->cwnd;
+	}
+
+	cc->bytes_acked += acked;
+	while (cc->bytes_acked >= cnt) {
+		cc->bytes_acked -= cnt;
+		tcp_cc_cwnd_add(cc, conn->smss);
+	}
+}
+
+/** CUBIC slow start threshold after loss.
+ *
+ * @param conn Connection
+ * @return Reduced window
+ */
+static uint32_t tcp_cc_cubic_ssthresh(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	cc->epoch_start = 0;
+
+	/* Fast convergence */
+	if (cc->cwnd < cc->w_max)
+		cc->w_max = (uint64_t)cc->cwnd * (1024 + CUBIC_BETA) / 2048;
+	else
+		cc->w_max = cc->cwnd;
+
+	return max((uint64_t)cc->cwnd * CUBIC_BETA / 1024, 2 * conn->smss);
+}
+
+/**
+ * @}
+ */
@@ -42,19 +42,32 @@
 #include <nettl/amap.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "iqueue.h"
+#include "ncsim.h"
 #include "pdu.h"
 #include "rqueue.h"
+#include "rtt.h"
 #include "segment.h"
 #include "seq_no.h"
+#include "std.h"
 #include "tcp_type.h"
 #include "tqueue.h"
 #include "ucall.h"
 
-#define RCV_BUF_SIZE 4096/*2*/
-#define SND_BUF_SIZE 4096
+/*
+ * Buffers larger than 64 KiB allow windows beyond what fits in the TCP
+ * header, these are advertised using window scaling (RFC 7323).
+ */
+#define RCV_BUF_SIZE (128 * 1024)
+#define SND_BUF_SIZE (128 * 1024)
+
+/** Sender maximum segment size (Ethernet MTU less IPv4 and TCP headers) */
+#define SND_MSS 1460
+/** Smallest maximum segment size we accept from the peer */
+#define SND_MSS_MIN 88
 
 #define MAX_SEGMENT_LIFETIME	(15*1000*1000) //(2*60*1000*1000)
 #define TIME_WAIT_TIMEOUT	(2*MAX_SEGMENT_LIFETIME)
@@ -72,6 +85,7 @@ static FIBRIL_MUTEX_INITIALIZE(amap_lock);
 tcp_lb_t tcp_conn_lb = tcp_lb_none;
 
 static void tcp_conn_seg_process(tcp_conn_t *, tcp_segment_t *);
+static void tcp_conn_opts_offer(tcp_conn_t *);
 static void tcp_conn_tw_timer_set(tcp_conn_t *);
 static void tcp_conn_tw_timer_clear(tcp_conn_t *);
 static void tcp_transmit_segment(inet_ep2_t *, tcp_segment_t *);
@@ -152,6 +166,13 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	/* Set up receive window. */
 	conn->rcv_wnd = conn->rcv_buf_size;
 
+	/* Set up congestion control and RTT estimation */
+	conn->smss = SND_MSS;
+	conn->rmss = SND_MSS;
+	tcp_conn_opts_offer(conn);
+	tcp_cc_init(conn, tcp_cc_default);
+	tcp_rtt_init(&conn->rtt);
+
 	/* Initialize incoming segment queue */
 	tcp_iqueue_init(&conn->incoming, conn);
 
@@ -511,6 +532,82 @@ bool tcp_conn_got_syn(tcp_conn_t *conn)
 	assert(false);
 }
 
+/** Offer all supported TCP extensions.
+ *
+ * Before SYN segments are exchanged the extension flags in the connection
+ * determine what we offer to the peer.
+ *
+ * @param conn		Connection
+ */
+static void tcp_conn_opts_offer(tcp_conn_t *conn)
+{
+	conn->ws_ok = true;
+	conn->sack_ok = true;
+	conn->ts_ok = true;
+	conn->snd_wscale = 0;
+	conn->ts_recent = 0;
+
+	/* Smallest shift count that allows advertising the whole buffer */
+	conn->rcv_wscale = 0;
+	while (conn->rcv_wscale < TCP_WSCALE_MAX &&
+	    (conn->rcv_buf_size >> conn->rcv_wscale) > UINT16_MAX)
+		++conn->rcv_wscale;
+}
+
+/** Negotiate TCP extensions using SYN segment received from the peer.
+ *
+ * An extension we offered is only used if the peer offered it as well.
+ *
+ * @param conn		Connection
+ * @param seg		SYN segment
+ */
+static void tcp_conn_opts_negotiate(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	tcp_seg_opts_t *opts = &seg->opts;
+
+	if ((opts->flags & TOPT_MSS) != 0)
+		conn->smss = min(SND_MSS, max(opts->mss, SND_MSS_MIN));
+	else
+		conn->smss = TCP_MSS_DEFAULT;
+
+	if (conn->ws_ok && (opts->flags & TOPT_WSCALE) != 0) {
+		conn->snd_wscale = min(opts->wscale, TCP_WSCALE_MAX);
+	} else {
+		conn->ws_ok = false;
+		conn->snd_wscale = 0;
+		conn->rcv_wscale = 0;
+	}
+
+	if ((opts->flags & TOPT_SACK_PERM) == 0)
+		conn->sack_ok = false;
+
+	if (conn->ts_ok && (opts->flags & TOPT_TS) != 0)
+		conn->ts_recent = opts->ts_val;
+	else
+		conn->ts_ok = false;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: SMSS=%" PRIu32 ", WS=%d(%u/%u), "
+	    "SACK=%d, TS=%d", conn->name, conn->smss, conn->ws_ok,
+	    conn->snd_wscale, conn->rcv_wscale, conn->sack_ok, conn->ts_ok);
+
+	/* Initial congestion window depends on SMSS */
+	tcp_cc_init(conn, conn->cc.ops);
+}
+
+/** Take RTT measurement from timestamp echoed in an acknowledgement.
+ *
+ * @param conn		Connection
+ * @param seg		Segment acknowledging new data
+ */
+static void tcp_conn_ts_ack(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	if (!conn->ts_ok || (seg->opts.flags & TOPT_TS) == 0 ||
+	    seg->opts.ts_ecr == 0)
+		return;
+
+	tcp_rtt_ts_ack(&conn->rtt, seg->opts.ts_ecr, tcp_rtt_now());
+}
+
 /** Segment arrived in Listen state.
  *
  * @param conn		Connection
@@ -551,6 +648,9 @@ static void tcp_conn_sa_listen(tcp_conn_t *conn, tcp_segment_t *seg)
 	conn->snd_nxt = conn->iss;
 	conn->snd_una = conn->iss;
 
+	tcp_conn_opts_offer(conn);
+	tcp_conn_opts_negotiate(conn, seg);
+
 	/*
 	 * Surprisingly the spec does not deal with initial window setting.
 	 * Set SND.WND = SEG.WND and set SND.WL1 so that next segment
@@ -615,8 +715,11 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
 
+	tcp_conn_opts_negotiate(conn, seg);
+
 	if ((seg->ctrl & CTL_ACK) != 0) {
 		conn->snd_una = seg->ack;
+		tcp_conn_ts_ack(conn, seg);
 
 		/*
 		 * Prune acked segments from retransmission queue and
@@ -662,6 +765,7 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	tcp_segment_t *pseg;
+	bool ooo;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_sa_seq(%p, %p)", conn, seg);
 
@@ -673,9 +777,37 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 		return;
 	}
 
+	if (conn->ts_ok && (seg->opts.flags & TOPT_TS) != 0) {
+		/* Protection against wrapped sequence numbers (PAWS) */
+		if ((seg->ctrl & CTL_RST) == 0 &&
+		    (int32_t)(seg->opts.ts_val - conn->ts_recent) < 0) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "PAWS: Replying ACK to "
+			    "segment with old timestamp.");
+			tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+			tcp_segment_delete(seg);
+			return;
+		}
+
+		/* Remember timestamp to echo (RFC 7323, section 4.3) */
+		if (seq_no_segment_ready(conn, seg))
+			conn->ts_recent = seg->opts.ts_val;
+	}
+
+	ooo = seg->len > 0 && !seq_no_segment_ready(conn, seg);
+
 	/* Queue for processing */
 	tcp_iqueue_insert_seg(&conn->incoming, seg);
 
+	/*
+	 * A segment arriving out of order means an earlier one was probably
+	 * lost. Send duplicate ACK immediately to allow fast retransmit.
+	 * The ACK reports the queued segment using SACK, if enabled.
+	 */
+	if (ooo) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Out-of-order segment, sending ACK.");
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+	}
+
 	/*
 	 * Process all segments from incoming queue that are ready.
 	 * Unacceptable segments are discarded by tcp_iqueue_get_ready_seg().
@@ -811,12 +943,16 @@ static cproc_t tcp_conn_seg_proc_ack_sr(tcp_conn_t *conn, tcp_segment_t *seg)
  */
 static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 {
+	bool dup_ack;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_seg_proc_ack_est(%p, %p)", conn, seg);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "SEG.ACK=%u, SND.UNA=%u, SND.NXT=%u",
 	    (unsigned)seg->ack, (unsigned)conn->snd_una,
 	    (unsigned)conn->snd_nxt);
 
+	dup_ack = false;
+
 	if (!seq_no_ack_acceptable(conn, seg->ack)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "ACK not acceptable.");
 		if (!seq_no_ack_duplicate(conn, seg->ack)) {
@@ -827,11 +963,21 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 			tcp_segment_delete(seg);
 			return cp_done;
 		} else {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "Ignoring duplicate ACK.");
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Duplicate ACK.");
+
+			/*
+			 * Only an ACK that carries no data and no window
+			 * update while we have data outstanding signals
+			 * that the peer received a segment out of order.
+			 */
+			dup_ack = seg->ack == conn->snd_una && seg->len == 0 &&
+			    seg->wnd == conn->snd_wnd &&
+			    conn->snd_una != conn->snd_nxt;
 		}
 	} else {
 		/* Update SND.UNA */
 		conn->snd_una = seg->ack;
+		tcp_conn_ts_ack(conn, seg);
 	}
 
 	if (seq_no_new_wnd_update(conn, seg)) {
@@ -844,11 +990,16 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 		    conn->snd_wnd, conn->snd_wl1, conn->snd_wl2);
 	}
 
+	tcp_tqueue_sack_received(conn, &seg->opts);
+
 	/*
 	 * Prune acked segments from retransmission queue and
 	 * possibly transmit more data.
 	 */
-	tcp_tqueue_ack_received(conn);
+	if (dup_ack)
+		tcp_tqueue_dup_ack_received(conn);
+	else
+		tcp_tqueue_ack_received(conn);
 
 	return cp_continue;
 }
@@ -1281,6 +1432,10 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 		conn->name = (char *) "a";
 	}
 
+	/* Window in SYN segments is never scaled (RFC 7323) */
+	if ((seg->ctrl & CTL_SYN) == 0)
+		seg->wnd <<= conn->snd_wscale;
+
 	switch (conn->cstate) {
 	case st_listen:
 		tcp_conn_sa_listen(conn, seg);
@@ -1410,17 +1565,18 @@ static void tcp_transmit_segment(inet_ep2_t *epp, tcp_segment_t *seg)
 	tcp_segment_dump(seg);
 
 	if (tcp_conn_lb == tcp_lb_segment) {
-		/* Loop back segment */
-#if 0
-		tcp_ncsim_bounce_seg(sp, seg);
-#endif
-
-		/* Reverse the identification */
-		tcp_ep2_flipped(epp, &rident);
-
-		/* Insert segment back into rqueue */
+		/*
+		 * Loop back segment via network condition simulator (which
+		 * inserts it straight back into rqueue unless configured
+		 * otherwise).
+		 */
 		dseg = tcp_segment_dup(seg);
-		tcp_rqueue_insert_seg(&rident, dseg);
+		if (dseg == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
+			return;
+		}
+
+		tcp_ncsim_bounce_seg(epp, dseg);
 		return;
 	}
 
@@ -75,6 +75,7 @@ void tcp_iqueue_insert_seg(tcp_iqueue_t *iqueue, tcp_segment_t *seg)
 	}
 
 	iqe->seg = seg;
+	iqueue->last_seq = seg->seq;
 
 	/* Sort by sequence number */
 
@@ -186,6 +187,98 @@ errno_t tcp_iqueue_get_ready_seg(tcp_iqueue_t *iqueue, tcp_segment_t **seg)
 	return EOK;
 }
 
+/** Get next range of contiguous out-of-order data.
+ *
+ * Segments that start at or before RCV.NXT are not out of order and
+ * are skipped.
+ *
+ * @param iqueue	Incoming queue
+ * @param link		Link to start at, updated to the link following the range
+ * @param blk		Place to store the range
+ * @return		@c true if a range was found, @c false otherwise
+ */
+static bool tcp_iqueue_next_range(tcp_iqueue_t *iqueue, link_t **link,
+    tcp_sack_block_t *blk)
+{
+	tcp_iqueue_entry_t *qe;
+	uint32_t rcv_nxt = iqueue->conn->rcv_nxt;
+	uint32_t soff, eoff;
+	uint32_t start_off = 0;
+	uint32_t end_off = 0;
+	bool found = false;
+
+	while (*link != NULL) {
+		qe = list_get_instance(*link, tcp_iqueue_entry_t, link);
+
+		/* Offsets relative to RCV.NXT */
+		soff = qe->seg->seq - rcv_nxt;
+		eoff = soff + qe->seg->len;
+
+		if ((int32_t)soff <= 0 || qe->seg->len == 0) {
+			*link = list_next(*link, &iqueue->list);
+			continue;
+		}
+
+		if (found && soff > end_off)
+			break;
+
+		if (!found) {
+			start_off = soff;
+			end_off = eoff;
+			found = true;
+		} else if (eoff > end_off) {
+			end_off = eoff;
+		}
+
+		*link = list_next(*link, &iqueue->list);
+	}
+
+	if (found) {
+		blk->left = rcv_nxt + start_off;
+		blk->right = rcv_nxt + end_off;
+	}
+
+	return found;
+}
+
+/** Describe out-of-order data in the queue using SACK blocks.
+ *
+ * As required by RFC 2018 the first block contains the most recently
+ * received segment, the remaining blocks follow in order of sequence
+ * number.
+ *
+ * @param iqueue	Incoming queue
+ * @param blocks	Array of at least @a max_blocks SACK blocks
+ * @param max_blocks	Maximum number of blocks to fill in
+ * @return		Number of blocks filled in
+ */
+unsigned tcp_iqueue_sack_blocks(tcp_iqueue_t *iqueue, tcp_sack_block_t *blocks,
+    unsigned max_blocks)
+{
+	tcp_sack_block_t blk;
+	link_t *link;
+	uint32_t rcv_nxt = iqueue->conn->rcv_nxt;
+	uint32_t loff = iqueue->last_seq - rcv_nxt;
+	unsigned n = 0;
+
+	link = list_first(&iqueue->list);
+	while (n < max_blocks && tcp_iqueue_next_range(iqueue, &link, &blk)) {
+		if (loff >= blk.left - rcv_nxt && loff < blk.right - rcv_nxt) {
+			blocks[n++] = blk;
+			break;
+		}
+	}
+
+	link = list_first(&iqueue->list);
+	while (n < max_blocks && tcp_iqueue_next_range(iqueue, &link, &blk)) {
+		if (n > 0 && blk.left == blocks[0].left)
+			continue;
+		blocks[n++] = blk;
+	}
+
+	return n;
+}
+
 /**
  * @}
  */
@@ -33,9 +33,14 @@
 /**
  * @file Network condition simulator
  *
- * Simulate network conditions for testing the reliability implementation:
+ * Simulate network conditions for testing the reliability implementation
+ * as well as congestion control and RTT estimation:
  *    - variable latency
  *    - frame drop
+ *
+ * The simulator is only used with segment loopback and is disabled by
+ * default (segments are bounced straight into the receive queue). Tests
+ * configure it to measure throughput over links with higher latency.
  */
 
 #include <adt/list.h>
@@ -43,8 +48,10 @@
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <io/log.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <fibril.h>
+#include <time.h>
 #include "conn.h"
 #include "ncsim.h"
 #include "rqueue.h"
@@ -55,12 +62,78 @@ static list_t sim_queue;
 static fibril_mutex_t sim_queue_lock;
 static fibril_condvar_t sim_queue_cv;
 
+/** Percentage of segments to drop */
+static unsigned sim_drop_pct;
+/** Latency added to every segment */
+static usec_t sim_latency;
+/** Maximum random latency added on top of @c sim_latency */
+static usec_t sim_jitter;
+
+/** Simulator fibril should terminate */
+static bool sim_quit;
+/** Simulator fibril is running */
+static bool sim_fibril_active;
+
+/** Get current time.
+ *
+ * @return Current time
+ */
+static usec_t tcp_ncsim_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
 /** Initialize segment receive queue. */
 void tcp_ncsim_init(void)
 {
 	list_initialize(&sim_queue);
 	fibril_mutex_initialize(&sim_queue_lock);
 	fibril_condvar_initialize(&sim_queue_cv);
+	sim_quit = false;
+}
+
+/** Stop simulator fibril and discard segments in flight. */
+void tcp_ncsim_fini(void)
+{
+	tcp_squeue_entry_t *sqe;
+	link_t *link;
+
+	fibril_mutex_lock(&sim_queue_lock);
+	sim_quit = true;
+	fibril_condvar_broadcast(&sim_queue_cv);
+
+	while (sim_fibril_active)
+		fibril_condvar_wait(&sim_queue_cv, &sim_queue_lock);
+
+	while ((link = list_first(&sim_queue)) != NULL) {
+		sqe = list_get_instance(link, tcp_squeue_entry_t, link);
+		list_remove(link);
+		tcp_segment_delete(sqe->seg);
+		free(sqe);
+	}
+
+	fibril_mutex_unlock(&sim_queue_lock);
+}
+
+/** Configure simulated network conditions.
+ *
+ * Segments are only reordered if @a jitter is non-zero.
+ *
+ * @param drop_pct	Percentage of segments to drop
+ * @param latency	Latency added to every segment
+ * @param jitter	Maximum random latency added on top of @a latency
+ *			(actual value is random in [0, jitter))
+ */
+void tcp_ncsim_configure(unsigned drop_pct, usec_t latency, usec_t jitter)
+{
+	fibril_mutex_lock(&sim_queue_lock);
+	sim_drop_pct = drop_pct;
+	sim_latency = latency;
+	sim_jitter = jitter;
+	fibril_mutex_unlock(&sim_queue_lock);
 }
 
 /** Bounce segment through simulator into receive queue.
@@ -76,13 +149,17 @@ void tcp_ncsim_bounce_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 	link_t *link;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_ncsim_bounce_seg()");
-	tcp_ep2_flipped(epp, &rident);
-	tcp_rqueue_insert_seg(&rident, seg);
-	return;
 
-	if (0 /* rand() % 4 == 3 */) {
+	if (sim_drop_pct == 0 && sim_latency == 0 && sim_jitter == 0) {
+		/* Simulation disabled */
+		tcp_ep2_flipped(epp, &rident);
+		tcp_rqueue_insert_seg(&rident, seg);
+		return;
+	}
+
+	if (sim_drop_pct != 0 && (unsigned) rand() % 100 < sim_drop_pct) {
 		/* Drop segment */
-		log_msg(LOG_DEFAULT, LVL_ERROR, "NCSim dropping segment");
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim dropping segment");
 		tcp_segment_delete(seg);
 		return;
 	}
@@ -93,27 +170,26 @@ void tcp_ncsim_bounce_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 		return;
 	}
 
-	sqe->delay = rand() % (1000 * 1000);
+	sqe->due = tcp_ncsim_now() + sim_latency;
+	if (sim_jitter != 0)
+		sqe->due += rand() % sim_jitter;
 	sqe->epp = *epp;
 	sqe->seg = seg;
 
 	fibril_mutex_lock(&sim_queue_lock);
 
+	/* Keep queue sorted by delivery time */
 	link = list_first(&sim_queue);
-	while (link != NULL && sqe->delay > 0) {
+	while (link != NULL) {
 		old_qe = list_get_instance(link, tcp_squeue_entry_t, link);
-		if (sqe->delay < old_qe->delay)
+		if (sqe->due < old_qe->due)
 			break;
 
-		sqe->delay -= old_qe->delay;
-
-		link = link->next;
-		if (link == &sim_queue.head)
-			link = NULL;
+		link = list_next(link, &sim_queue);
 	}
 
 	if (link != NULL)
-		list_insert_after(&sqe->link, link);
+		list_insert_before(&sqe->link, link);
 	else
 		list_append(&sqe->link, &sim_queue);
 
@@ -127,24 +203,37 @@ static errno_t tcp_ncsim_fibril(void *arg)
 	link_t *link;
 	tcp_squeue_entry_t *sqe;
 	inet_ep2_t rident;
-	errno_t rc;
+	usec_t now;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_ncsim_fibril()");
 
 	while (true) {
 		fibril_mutex_lock(&sim_queue_lock);
 
-		while (list_empty(&sim_queue))
-			fibril_condvar_wait(&sim_queue_cv, &sim_queue_lock);
+		while (true) {
+			while (list_empty(&sim_queue) && !sim_quit)
+				fibril_condvar_wait(&sim_queue_cv, &sim_queue_lock);
+
+			if (sim_quit)
+				break;
 
-		do {
 			link = list_first(&sim_queue);
 			sqe = list_get_instance(link, tcp_squeue_entry_t, link);
 
+			now = tcp_ncsim_now();
+			if (sqe->due <= now)
+				break;
+
+			/* Sleep until due or until an earlier segment arrives */
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim - Sleep");
-			rc = fibril_condvar_wait_timeout(&sim_queue_cv,
-			    &sim_queue_lock, sqe->delay);
-		} while (rc != ETIMEOUT);
+			(void) fibril_condvar_wait_timeout(&sim_queue_cv,
+			    &sim_queue_lock, sqe->due - now);
+		}
+
+		if (sim_quit) {
+			fibril_mutex_unlock(&sim_queue_lock);
+			break;
+		}
 
 		list_remove(link);
 		fibril_mutex_unlock(&sim_queue_lock);
@@ -155,7 +244,14 @@ static errno_t tcp_ncsim_fibril(void *arg)
 		free(sqe);
 	}
 
-	/* Not reached */
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_ncsim_fibril() exiting");
+
+	/* Finished */
+	fibril_mutex_lock(&sim_queue_lock);
+	sim_fibril_active = false;
+	fibril_mutex_unlock(&sim_queue_lock);
+	fibril_condvar_broadcast(&sim_queue_cv);
+
 	return 0;
 }
 
@@ -172,6 +268,7 @@ void tcp_ncsim_fibril_start(void)
 		return;
 	}
 
+	sim_fibril_active = true;
 	fibril_add_ready(fid);
 }
 
@@ -34,10 +34,12 @@
  * @file TCP header encoding and decoding
  */
 
+#include <assert.h>
 #include <bitops.h>
 #include <byteorder.h>
 #include <errno.h>
 #include <inet/endpoint.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "pdu.h"
@@ -125,7 +127,8 @@ static void tcp_header_encode_flags(tcp_control_t ctl, uint16_t doff_flags0,
 	*rdoff_flags = doff_flags;
 }
 
-static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *hdr)
+static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg,
+    tcp_header_t *hdr, size_t hdr_size)
 {
 	uint16_t doff_flags;
 	uint16_t doff;
@@ -135,7 +138,7 @@ static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *
 	hdr->seq = host2uint32_t_be(seg->seq);
 	hdr->ack = host2uint32_t_be(seg->ack);
 
-	doff = (sizeof(tcp_header_t) / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
+	doff = (hdr_size / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
 	tcp_header_encode_flags(seg->ctrl, doff, &doff_flags);
 
 	hdr->doff_flags = host2uint16_t_be(doff_flags);
@@ -181,6 +184,219 @@ static ip_ver_t tcp_phdr_setup(tcp_pdu_t *pdu, tcp_phdr_t *phdr,
 	return src_ver;
 }
 
+/** Store 16-bit value in network byte order at unaligned address. */
+static void tcp_opt_put16(uint8_t *bp, uint16_t val)
+{
+	bp[0] = val >> 8;
+	bp[1] = val & 0xff;
+}
+
+/** Store 32-bit value in network byte order at unaligned address. */
+static void tcp_opt_put32(uint8_t *bp, uint32_t val)
+{
+	tcp_opt_put16(bp, val >> 16);
+	tcp_opt_put16(bp + 2, val & 0xffff);
+}
+
+/** Load 16-bit value in network byte order from unaligned address. */
+static uint16_t tcp_opt_get16(const uint8_t *bp)
+{
+	return ((uint16_t)bp[0] << 8) | bp[1];
+}
+
+/** Load 32-bit value in network byte order from unaligned address. */
+static uint32_t tcp_opt_get32(const uint8_t *bp)
+{
+	return ((uint32_t)tcp_opt_get16(bp) << 16) | tcp_opt_get16(bp + 2);
+}
+
+/** Determine number of SACK blocks that fit in the options.
+ *
+ * @param opts Segment options
+ * @return Number of SACK blocks that will be encoded
+ */
+static unsigned tcp_opts_sack_blocks(tcp_seg_opts_t *opts)
+{
+	unsigned max_blocks;
+
+	if ((opts->flags & TOPT_SACK) == 0)
+		return 0;
+
+	/* Timestamps take 12 bytes, leaving room for three blocks */
+	max_blocks = (opts->flags & TOPT_TS) != 0 ? 3 : TCP_SACK_BLOCKS_MAX;
+	return min(opts->sack_blocks, max_blocks);
+}
+
+/** Compute size of encoded options.
+ *
+ * Every option is padded with leading NOPs to a multiple of four bytes
+ * so that the result is always properly aligned.
+ *
+ * @param opts Segment options
+ * @return Size of encoded options in bytes
+ */
+static size_t tcp_opts_size(tcp_seg_opts_t *opts)
+{
+	size_t size = 0;
+	unsigned blocks;
+
+	if ((opts->flags & TOPT_MSS) != 0)
+		size += 4;
+	if ((opts->flags & TOPT_WSCALE) != 0)
+		size += 4;
+	if ((opts->flags & TOPT_SACK_PERM) != 0)
+		size += 4;
+	if ((opts->flags & TOPT_TS) != 0)
+		size += 12;
+
+	blocks = tcp_opts_sack_blocks(opts);
+	if (blocks > 0)
+		size += 4 + blocks * OPT_SACK_BLOCK_LEN;
+
+	assert(size <= TCP_OPTS_MAX_LEN);
+	return size;
+}
+
+/** Encode options.
+ *
+ * @param opts Segment options
+ * @param bp Buffer of size tcp_opts_size(@a opts)
+ */
+static void tcp_opts_encode(tcp_seg_opts_t *opts, uint8_t *bp)
+{
+	unsigned blocks;
+	unsigned i;
+
+	if ((opts->flags & TOPT_MSS) != 0) {
+		bp[0] = OPT_MAX_SEG_SIZE;
+		bp[1] = OPT_MAX_SEG_SIZE_LEN;
+		tcp_opt_put16(bp + 2, opts->mss);
+		bp += 4;
+	}
+
+	if ((opts->flags & TOPT_WSCALE) != 0) {
+		bp[0] = OPT_NOP;
+		bp[1] = OPT_WINDOW_SCALE;
+		bp[2] = OPT_WINDOW_SCALE_LEN;
+		bp[3] = opts->wscale;
+		bp += 4;
+	}
+
+	if ((opts->flags & TOPT_SACK_PERM) != 0) {
+		bp[0] = OPT_NOP;
+		bp[1] = OPT_NOP;
+		bp[2] = OPT_SACK_PERMITTED;
+		bp[3] = OPT_SACK_PERMITTED_LEN;
+		bp += 4;
+	}
+
+	if ((opts->flags & TOPT_TS) != 0) {
+		bp[0] = OPT_NOP;
+		bp[1] = OPT_NOP;
+		bp[2] = OPT_TIMESTAMP;
+		bp[3] = OPT_TIMESTAMP_LEN;
+		tcp_opt_put32(bp + 4, opts->ts_val);
+		tcp_opt_put32(bp + 8, opts->ts_ecr);
+		bp += 12;
+	}
+
+	blocks = tcp_opts_sack_blocks(opts);
+	if (blocks > 0) {
+		bp[0] = OPT_NOP;
+		bp[1] = OPT_NOP;
+		bp[2] = OPT_SACK;
+		bp[3] = OPT_SACK_BASE_LEN + blocks * OPT_SACK_BLOCK_LEN;
+		bp += 4;
+
+		for (i = 0; i < blocks; i++) {
+			tcp_opt_put32(bp, opts->sack[i].left);
+			tcp_opt_put32(bp + 4, opts->sack[i].right);
+			bp += OPT_SACK_BLOCK_LEN;
+		}
+	}
+}
+
+/** Decode options.
+ *
+ * Unknown options are skipped. Parsing stops at the first malformed
+ * option, keeping whatever has been decoded up to that point.
+ *
+ * @param bp Options
+ * @param size Size of options in bytes
+ * @param opts Place to store decoded options
+ */
+static void tcp_opts_decode(const uint8_t *bp, size_t size,
+    tcp_seg_opts_t *opts)
+{
+	const uint8_t *end = bp + size;
+	uint8_t kind;
+	uint8_t len;
+	unsigned i;
+
+	memset(opts, 0, sizeof(tcp_seg_opts_t));
+
+	while (bp < end) {
+		kind = bp[0];
+		if (kind == OPT_END_LIST)
+			break;
+		if (kind == OPT_NOP) {
+			++bp;
+			continue;
+		}
+
+		if (end - bp < 2)
+			break;
+		len = bp[1];
+		if (len < 2 || len > end - bp)
+			break;
+
+		switch (kind) {
+		case OPT_MAX_SEG_SIZE:
+			if (len != OPT_MAX_SEG_SIZE_LEN)
+				break;
+			opts->flags |= TOPT_MSS;
+			opts->mss = tcp_opt_get16(bp + 2);
+			break;
+		case OPT_WINDOW_SCALE:
+			if (len != OPT_WINDOW_SCALE_LEN)
+				break;
+			opts->flags |= TOPT_WSCALE;
+			opts->wscale = bp[2];
+			break;
+		case OPT_SACK_PERMITTED:
+			if (len != OPT_SACK_PERMITTED_LEN)
+				break;
+			opts->flags |= TOPT_SACK_PERM;
+			break;
+		case OPT_TIMESTAMP:
+			if (len != OPT_TIMESTAMP_LEN)
+				break;
+			opts->flags |= TOPT_TS;
+			opts->ts_val = tcp_opt_get32(bp + 2);
+			opts->ts_ecr = tcp_opt_get32(bp + 6);
+			break;
+		case OPT_SACK:
+			if ((len - OPT_SACK_BASE_LEN) % OPT_SACK_BLOCK_LEN != 0)
+				break;
+			opts->sack_blocks = min((len - OPT_SACK_BASE_LEN) /
+			    OPT_SACK_BLOCK_LEN, TCP_SACK_BLOCKS_MAX);
+			for (i = 0; i < opts->sack_blocks; i++) {
+				opts->sack[i].left = tcp_opt_get32(bp + 2 +
+				    i * OPT_SACK_BLOCK_LEN);
+				opts->sack[i].right = tcp_opt_get32(bp + 6 +
+				    i * OPT_SACK_BLOCK_LEN);
+			}
+			if (opts->sack_blocks > 0)
+				opts->flags |= TOPT_SACK;
+			break;
+		default:
+			break;
+		}
+
+		bp += len;
+	}
+}
+
 static void tcp_header_decode(tcp_header_t *hdr, tcp_segment_t *seg)
 {
 	tcp_header_decode_flags(uint16_t_be2host(hdr->doff_flags), &seg->ctrl);
@@ -194,14 +410,17 @@ static errno_t tcp_header_encode(inet_ep2_t *epp, tcp_segment_t *seg,
     void **header, size_t *size)
 {
 	tcp_header_t *hdr;
+	size_t hdr_size;
 
-	hdr = calloc(1, sizeof(tcp_header_t));
+	hdr_size = sizeof(tcp_header_t) + tcp_opts_size(&seg->opts);
+	hdr = calloc(1, hdr_size);
 	if (hdr == NULL)
 		return ENOMEM;
 
-	tcp_header_setup(epp, seg, hdr);
+	tcp_header_setup(epp, seg, hdr, hdr_size);
+	tcp_opts_encode(&seg->opts, (uint8_t *)(hdr + 1));
 	*header = hdr;
-	*size = sizeof(tcp_header_t);
+	*size = hdr_size;
 
 	return EOK;
 }
@@ -305,6 +524,8 @@ errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 
 	tcp_header_decode(pdu->header, nseg);
 	nseg->len += seq_no_control_len(nseg->ctrl);
+	tcp_opts_decode((uint8_t *)pdu->header + sizeof(tcp_header_t),
+	    pdu->header_size - sizeof(tcp_header_t), &nseg->opts);
 
 	hdr = (tcp_header_t *)pdu->header;
 
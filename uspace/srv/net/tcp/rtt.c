@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file TCP round-trip time estimator
+ *
+ * Computes the retransmission timeout from round-trip time measurements
+ * as specified by RFC 6298. At most one segment is timed at a time and
+ * measurements are discarded if the timed segment is retransmitted
+ * (Karn's algorithm). When the RFC 7323 timestamp option is in use,
+ * every acknowledgement carrying an echoed timestamp yields a sample
+ * instead.
+ */
+
+#include <macros.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "rtt.h"
+#include "tcp_type.h"
+
+/** Initial retransmission timeout */
+#define RTT_RTO_INIT	(1000 * 1000)
+/** Lower bound on retransmission timeout */
+#define RTT_RTO_MIN	(200 * 1000)
+/** Upper bound on retransmission timeout */
+#define RTT_RTO_MAX	(60 * 1000 * 1000)
+/** Clock granularity */
+#define RTT_CLOCK_G	(1000)
+
+/** Initialize RTT estimator.
+ *
+ * @param rtt RTT estimator
+ */
+void tcp_rtt_init(tcp_rtt_t *rtt)
+{
+	rtt->valid = false;
+	rtt->srtt = 0;
+	rtt->rttvar = 0;
+	rtt->rto = RTT_RTO_INIT;
+	rtt->timing = false;
+}
+
+/** Get current time for the purpose of RTT measurement.
+ *
+ * @return Current time
+ */
+usec_t tcp_rtt_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Start timing a segment, unless another segment is being timed.
+ *
+ * @param rtt RTT estimator
+ * @param seq Sequence number following the timed segment
+ * @param now Current time
+ */
+void tcp_rtt_start(tcp_rtt_t *rtt, uint32_t seq, usec_t now)
+{
+	if (rtt->timing)
+		return;
+
+	rtt->timing = true;
+	rtt->seq = seq;
+	rtt->start = now;
+}
+
+/** Cancel measurement in progress.
+ *
+ * This must be called when any segment is retransmitted as we would not
+ * be able to tell which copy of the segment is being acknowledged.
+ *
+ * @param rtt RTT estimator
+ */
+void tcp_rtt_cancel(tcp_rtt_t *rtt)
+{
+	rtt->timing = false;
+}
+
+/** Complete measurement if the timed segment has been acknowledged.
+ *
+ * @param rtt RTT estimator
+ * @param snd_una SND.UNA
+ * @param now Current time
+ */
+void tcp_rtt_ack(tcp_rtt_t *rtt, uint32_t snd_una, usec_t now)
+{
+	if (!rtt->timing)
+		return;
+
+	/* SND.UNA >= seq modulo sequence space (see seq_no_ack_duplicate) */
+	if (((snd_una - rtt->seq) & (0x1u << 31)) != 0)
+		return;
+
+	rtt->timing = false;
+	tcp_rtt_sample(rtt, now - rtt->start);
+}
+
+/** Update estimate with a new RTT measurement.
+ *
+ * @param rtt RTT estimator
+ * @param r Measured round-trip time
+ */
+void tcp_rtt_sample(tcp_rtt_t *rtt, usec_t r)
+{
+	usec_t delta;
+	usec_t rto;
+
+	if (!rtt->valid) {
+		rtt->srtt = r;
+		rtt->rttvar = r / 2;
+		rtt->valid = true;
+	} else {
+		delta = rtt->srtt > r ? rtt->srtt - r : r - rtt->srtt;
+		rtt->rttvar = (3 * rtt->rttvar + delta) / 4;
+		rtt->srtt = (7 * rtt->srtt + r) / 8;
+	}
+
+	rto = rtt->srtt + max(RTT_CLOCK_G, 4 * rtt->rttvar);
+	rtt->rto = min(max(rto, RTT_RTO_MIN), RTT_RTO_MAX);
+}
+
+/** Get timestamp clock value to send in the timestamp option.
+ *
+ * The timestamp clock ticks once per millisecond.
+ *
+ * @param now Current time
+ * @return Timestamp value
+ */
+uint32_t tcp_rtt_ts_clock(usec_t now)
+{
+	return (uint32_t) USEC2MSEC(now);
+}
+
+/** Take RTT measurement from an echoed timestamp.
+ *
+ * @param rtt RTT estimator
+ * @param ts_ecr Timestamp echo reply received from the peer
+ * @param now Current time
+ */
+void tcp_rtt_ts_ack(tcp_rtt_t *rtt, uint32_t ts_ecr, usec_t now)
+{
+	uint32_t r;
+
+	r = tcp_rtt_ts_clock(now) - ts_ecr;
+
+	/* Ignore echoes that cannot be valid (from the future or too old) */
+	if (r > USEC2MSEC(RTT_RTO_MAX))
+		return;
+
+	tcp_rtt_sample(rtt, MSEC2USEC(r));
+}
+
+/** Back off retransmission timer after it expired.
+ *
+ * @param rtt RTT estimator
+ */
+void tcp_rtt_backoff(tcp_rtt_t *rtt)
+{
+	rtt->rto = min(2 * rtt->rto, RTT_RTO_MAX);
+	rtt->timing = false;
+}
+
+/**
+ * @}
+ */
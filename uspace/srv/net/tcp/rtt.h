@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+/** @file TCP round-trip time estimator
+ */
+
+#ifndef RTT_H
+#define RTT_H
+
+#include <stdint.h>
+#include <time.h>
+#include "tcp_type.h"
+
+extern void tcp_rtt_init(tcp_rtt_t *);
+extern usec_t tcp_rtt_now(void);
+extern void tcp_rtt_start(tcp_rtt_t *, uint32_t, usec_t);
+extern void tcp_rtt_cancel(tcp_rtt_t *);
+extern void tcp_rtt_ack(tcp_rtt_t *, uint32_t, usec_t);
+extern void tcp_rtt_sample(tcp_rtt_t *, usec_t);
+extern uint32_t tcp_rtt_ts_clock(usec_t);
+extern void tcp_rtt_ts_ack(tcp_rtt_t *, uint32_t, usec_t);
+extern void tcp_rtt_backoff(tcp_rtt_t *);
+
+#endif
+
+/** @}
+ */
@@ -31,7 +31,8 @@
  */
 /** @file TCP header definitions
  *
- * Based on IETF RFC 793
+ * Based on IETF RFC 793, RFC 2018 (SACK) and RFC 7323 (window scaling,
+ * timestamps)
  */
 
 #ifndef STD_H
@@ -109,9 +110,36 @@ enum opt_kind {
 	/** No-operation */
 	OPT_NOP			= 1,
 	/** Maximum segment size */
-	OPT_MAX_SEG_SIZE	= 2
+	OPT_MAX_SEG_SIZE	= 2,
+	/** Window scale */
+	OPT_WINDOW_SCALE	= 3,
+	/** SACK permitted */
+	OPT_SACK_PERMITTED	= 4,
+	/** SACK */
+	OPT_SACK		= 5,
+	/** Timestamps */
+	OPT_TIMESTAMP		= 8
 };
 
+/** Option length (including kind and length octets) */
+enum opt_len {
+	OPT_MAX_SEG_SIZE_LEN	= 4,
+	OPT_WINDOW_SCALE_LEN	= 3,
+	OPT_SACK_PERMITTED_LEN	= 2,
+	OPT_TIMESTAMP_LEN	= 10,
+	/** SACK option length without blocks */
+	OPT_SACK_BASE_LEN	= 2,
+	/** Length of one SACK block */
+	OPT_SACK_BLOCK_LEN	= 8
+};
+
+/** Maximum length of TCP options */
+#define TCP_OPTS_MAX_LEN 40
+/** Maximum window scale shift count */
+#define TCP_WSCALE_MAX 14
+/** Default maximum segment size when the peer does not send MSS option */
+#define TCP_MSS_DEFAULT 536
+
 #endif
 
 /** @}
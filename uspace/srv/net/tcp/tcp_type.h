@@ -124,6 +124,8 @@ typedef enum {
 typedef struct {
 	struct tcp_conn *conn;
 	list_t list;
+	/** Sequence number of the most recently inserted segment */
+	uint32_t last_seq;
 } tcp_iqueue_t;
 
 /** Active or passive connection */
@@ -154,6 +156,44 @@ typedef struct {
 	tcp_cstate_t cstate;
 } tcp_conn_status_t;
 
+/** Maximum number of SACK blocks carried by a segment */
+#define TCP_SACK_BLOCKS_MAX 4
+
+/** TCP options present in a segment */
+typedef enum {
+	TOPT_MSS	= 0x1,
+	TOPT_WSCALE	= 0x2,
+	TOPT_SACK_PERM	= 0x4,
+	TOPT_SACK	= 0x8,
+	TOPT_TS		= 0x10
+} tcp_opt_flags_t;
+
+/** SACK block */
+typedef struct {
+	/** First sequence number of the block */
+	uint32_t left;
+	/** Sequence number immediately following the block */
+	uint32_t right;
+} tcp_sack_block_t;
+
+/** Segment options */
+typedef struct {
+	/** Options present in the segment */
+	tcp_opt_flags_t flags;
+	/** Maximum segment size */
+	uint16_t mss;
+	/** Window scale shift count */
+	uint8_t wscale;
+	/** Timestamp value */
+	uint32_t ts_val;
+	/** Timestamp echo reply */
+	uint32_t ts_ecr;
+	/** Number of valid entries in @c sack */
+	unsigned sack_blocks;
+	/** SACK blocks */
+	tcp_sack_block_t sack[TCP_SACK_BLOCKS_MAX];
+} tcp_seg_opts_t;
+
 typedef struct {
 	/** SYN, FIN */
 	tcp_control_t ctrl;
@@ -168,6 +208,8 @@ typedef struct {
 	uint32_t wnd;
 	/** Segment urgent pointer */
 	uint32_t up;
+	/** Segment options */
+	tcp_seg_opts_t opts;
 
 	/** Segment data, may be moved when trimming segment */
 	void *data;
@@ -191,7 +233,8 @@ typedef struct {
 /** NCSim queue entry */
 typedef struct {
 	link_t link;
-	usec_t delay;
+	/** Time when segment should be delivered */
+	usec_t due;
 	inet_ep2_t epp;
 	tcp_segment_t *seg;
 } tcp_squeue_entry_t;
@@ -207,6 +250,8 @@ typedef struct {
 	link_t link;
 	tcp_conn_t *conn;
 	tcp_segment_t *seg;
+	/** Segment has been selectively acknowledged by the peer */
+	bool sacked;
 } tcp_tqueue_entry_t;
 
 /** Retransmission queue callbacks */
@@ -227,6 +272,75 @@ typedef struct {
 	tcp_tqueue_cb_t *cb;
 } tcp_tqueue_t;
 
+/** Congestion control state */
+typedef enum {
+	/** No loss detected */
+	ccs_open,
+	/** Fast recovery after fast retransmit */
+	ccs_recovery,
+	/** Recovery after retransmission timeout */
+	ccs_loss
+} tcp_cc_state_t;
+
+/** Congestion control algorithm */
+typedef struct tcp_cc_ops {
+	/** Algorithm name */
+	const char *name;
+	/** Initialize algorithm-specific state */
+	void (*init)(tcp_conn_t *);
+	/** Grow congestion window in congestion avoidance */
+	void (*cong_avoid)(tcp_conn_t *, uint32_t);
+	/** Compute new slow start threshold when loss is detected */
+	uint32_t (*ssthresh)(tcp_conn_t *);
+} tcp_cc_ops_t;
+
+/** Congestion control */
+typedef struct {
+	/** Congestion control algorithm */
+	tcp_cc_ops_t *ops;
+	/** State */
+	tcp_cc_state_t state;
+	/** Congestion window */
+	uint32_t cwnd;
+	/** Slow start threshold */
+	uint32_t ssthresh;
+	/** Bytes acknowledged since last congestion window increase */
+	uint32_t bytes_acked;
+	/** Number of duplicate ACKs received in a row */
+	unsigned dupacks;
+	/** SND.NXT when loss was detected */
+	uint32_t recover;
+
+	/** CUBIC: Window size just before the last reduction */
+	uint32_t w_max;
+	/** CUBIC: Start of current congestion avoidance epoch (0 = none) */
+	usec_t epoch_start;
+	/** CUBIC: Time to reach @c origin from epoch start [ms] */
+	uint32_t k;
+	/** CUBIC: Window size at the plateau of the cubic function */
+	uint32_t origin;
+	/** CUBIC: Estimate of window size Reno would have */
+	uint32_t w_est;
+} tcp_cc_t;
+
+/** Round-trip time estimator */
+typedef struct {
+	/** At least one RTT measurement has been taken */
+	bool valid;
+	/** Smoothed round-trip time */
+	usec_t srtt;
+	/** Round-trip time variation */
+	usec_t rttvar;
+	/** Retransmission timeout */
+	usec_t rto;
+	/** A segment is being timed */
+	bool timing;
+	/** Acknowledging this sequence number completes the measurement */
+	uint32_t seq;
+	/** Time when the timed segment was sent */
+	usec_t start;
+} tcp_rtt_t;
+
 /** Connection */
 struct tcp_conn {
 	char *name;
@@ -307,6 +421,28 @@ struct tcp_conn {
 	uint32_t snd_wl2;
 	/** Initial send sequence number */
 	uint32_t iss;
+	/** Sender maximum segment size */
+	uint32_t smss;
+	/** Receiver maximum segment size (advertised to the peer) */
+	uint32_t rmss;
+
+	/** Window scaling offered (before SYN exchange) or in use (after) */
+	bool ws_ok;
+	/** SACK offered (before SYN exchange) or in use (after) */
+	bool sack_ok;
+	/** Timestamps offered (before SYN exchange) or in use (after) */
+	bool ts_ok;
+	/** Shift count applied to windows received from the peer */
+	uint8_t snd_wscale;
+	/** Shift count applied to windows sent to the peer */
+	uint8_t rcv_wscale;
+	/** Most recent timestamp value to echo to the peer (TS.Recent) */
+	uint32_t ts_recent;
+
+	/** Congestion control */
+	tcp_cc_t cc;
+	/** Round-trip time estimator */
+	tcp_rtt_t rtt;
 
 	/** Receive next */
 	uint32_t rcv_nxt;
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <inet/endpoint.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+
+#include "../cc.h"
+#include "../conn.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cc);
+
+/** Create connection with @a ops congestion control and 10 segments
+ * in flight.
+ */
+static tcp_conn_t *test_cc_conn_new(tcp_cc_ops_t *ops)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->smss = 1460;
+	conn->snd_wnd = 65535;
+	conn->snd_una = 1000;
+	conn->snd_nxt = 1000 + 10 * 1460;
+	tcp_cc_init(conn, ops);
+
+	return conn;
+}
+
+/** Test initial window and slow start */
+PCUT_TEST(slow_start)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn_new(&tcp_cc_newreno);
+
+	PCUT_ASSERT_INT_EQUALS(4380, conn->cc.cwnd);
+	PCUT_ASSERT_EQUALS(UINT32_MAX, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(4380, tcp_cc_snd_wnd(conn));
+
+	/* Window grows by at most SMSS per ACK */
+	conn->snd_una += 1460;
+	PCUT_ASSERT_FALSE(tcp_cc_ack(conn, 1460));
+	PCUT_ASSERT_INT_EQUALS(5840, conn->cc.cwnd);
+
+	conn->snd_una += 2920;
+	PCUT_ASSERT_FALSE(tcp_cc_ack(conn, 2920));
+	PCUT_ASSERT_INT_EQUALS(7300, conn->cc.cwnd);
+
+	/* Send window limits effective window */
+	conn->snd_wnd = 4096;
+	PCUT_ASSERT_INT_EQUALS(4096, tcp_cc_snd_wnd(conn));
+
+	tcp_conn_delete(conn);
+}
+
+/** Test NewReno congestion avoidance */
+PCUT_TEST(newreno_cong_avoid)
+{
+	tcp_conn_t *conn;
+	int i;
+
+	conn = test_cc_conn_new(&tcp_cc_newreno);
+
+	conn->cc.cwnd = 14600;
+	conn->cc.ssthresh = 14600;
+
+	/* Window grows by SMSS per window worth of data acknowledged */
+	for (i = 0; i < 9; i++)
+		PCUT_ASSERT_FALSE(tcp_cc_ack(conn, 1460));
+	PCUT_ASSERT_INT_EQUALS(14600, conn->cc.cwnd);
+
+	PCUT_ASSERT_FALSE(tcp_cc_ack(conn, 1460));
+	PCUT_ASSERT_INT_EQUALS(16060, conn->cc.cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test fast retransmit and fast recovery */
+PCUT_TEST(fast_recovery)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn_new(&tcp_cc_newreno);
+
+	/* Third duplicate ACK triggers fast retransmit */
+	PCUT_ASSERT_FALSE(tcp_cc_dup_ack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dup_ack(conn));
+	PCUT_ASSERT_TRUE(tcp_cc_dup_ack(conn));
+
+	PCUT_ASSERT_INT_EQUALS(ccs_recovery, conn->cc.state);
+	PCUT_ASSERT_INT_EQUALS(7300, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(7300 + 3 * 1460, conn->cc.cwnd);
+	PCUT_ASSERT_INT_EQUALS(conn->snd_nxt, conn->cc.recover);
+
+	/* Further duplicate ACKs inflate the window */
+	PCUT_ASSERT_FALSE(tcp_cc_dup_ack(conn));
+	PCUT_ASSERT_INT_EQUALS(7300 + 4 * 1460, conn->cc.cwnd);
+
+	/* Partial ACK causes retransmission of next segment */
+	conn->snd_una += 1460;
+	PCUT_ASSERT_TRUE(tcp_cc_ack(conn, 1460));
+	PCUT_ASSERT_INT_EQUALS(ccs_recovery, conn->cc.state);
+	PCUT_ASSERT_INT_EQUALS(7300 + 4 * 1460, conn->cc.cwnd);
+
+	/* Full ACK terminates recovery and deflates the window */
+	conn->snd_una = conn->snd_nxt;
+	PCUT_ASSERT_FALSE(tcp_cc_ack(conn, 9 * 1460));
+	PCUT_ASSERT_INT_EQUALS(ccs_open, conn->cc.state);
+	PCUT_ASSERT_INT_EQUALS(2 * 1460, conn->cc.cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test retransmission timeout */
+PCUT_TEST(timeout)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn_new(&tcp_cc_newreno);
+
+	tcp_cc_timeout(conn);
+	PCUT_ASSERT_INT_EQUALS(ccs_loss, conn->cc.state);
+	PCUT_ASSERT_INT_EQUALS(7300, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(1460, conn->cc.cwnd);
+
+	/* Repeated timeout does not reduce ssthresh further */
+	conn->snd_nxt -= 1460;
+	tcp_cc_timeout(conn);
+	PCUT_ASSERT_INT_EQUALS(7300, conn->cc.ssthresh);
+
+	/* Duplicate ACKs do not trigger fast retransmit now */
+	PCUT_ASSERT_FALSE(tcp_cc_dup_ack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dup_ack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dup_ack(conn));
+
+	/* Retransmit next segment until all data sent before timeout is acked */
+	conn->snd_una += 1460;
+	PCUT_ASSERT_TRUE(tcp_cc_ack(conn, 1460));
+	PCUT_ASSERT_INT_EQUALS(2920, conn->cc.cwnd);
+
+	conn->snd_una = conn->snd_nxt;
+	PCUT_ASSERT_FALSE(tcp_cc_ack(conn, 8 * 1460));
+	PCUT_ASSERT_INT_EQUALS(ccs_open, conn->cc.state);
+	PCUT_ASSERT_INT_EQUALS(4380, conn->cc.cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test CUBIC window reduction */
+PCUT_TEST(cubic_ssthresh)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn_new(&tcp_cc_cubic);
+
+	conn->cc.cwnd = 14600;
+	conn->cc.ssthresh = 14600;
+
+	/* Window is reduced by factor of 0.7 */
+	tcp_cc_timeout(conn);
+	PCUT_ASSERT_INT_EQUALS(10222, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(14600, conn->cc.w_max);
+
+	/* Fast convergence: release bandwidth if window did not recover */
+	conn->cc.state = ccs_open;
+	conn->cc.cwnd = 10222;
+	tcp_cc_timeout(conn);
+	PCUT_ASSERT_INT_EQUALS(8689, conn->cc.w_max);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test CUBIC congestion avoidance */
+PCUT_TEST(cubic_cong_avoid)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn_new(&tcp_cc_cubic);
+
+	conn->cc.cwnd = 10222;
+	conn->cc.ssthresh = 10222;
+	conn->cc.w_max = 14600;
+
+	/* Starting epoch computes time to reach W_max */
+	PCUT_ASSERT_FALSE(tcp_cc_ack(conn, 1460));
+	PCUT_ASSERT_INT_EQUALS(1957, conn->cc.k);
+	PCUT_ASSERT_INT_EQUALS(14600, conn->cc.origin);
+	PCUT_ASSERT_TRUE(conn->cc.cwnd >= 10222);
+	PCUT_ASSERT_TRUE(conn->cc.cwnd < 14600);
+
+	tcp_conn_delete(conn);
+}
+
+PCUT_EXPORT(cc);
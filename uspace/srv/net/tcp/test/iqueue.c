@@ -175,4 +175,66 @@ PCUT_TEST(two_segments)
 	tcp_conn_delete(conn);
 }
 
+/** Test describing out-of-order segments with SACK blocks */
+PCUT_TEST(sack_blocks)
+{
+	tcp_conn_t *conn;
+	tcp_iqueue_t iqueue;
+	inet_ep2_t epp;
+	tcp_segment_t *seg[3];
+	tcp_sack_block_t blocks[TCP_SACK_BLOCKS_MAX];
+	void *data;
+	size_t dsize;
+	unsigned nblocks;
+	unsigned i;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->rcv_nxt = 10;
+	conn->rcv_wnd = 100;
+
+	dsize = 10;
+	data = calloc(dsize, 1);
+	PCUT_ASSERT_NOT_NULL(data);
+
+	for (i = 0; i < 3; i++) {
+		seg[i] = tcp_segment_make_data(0, data, dsize);
+		PCUT_ASSERT_NOT_NULL(seg[i]);
+	}
+
+	tcp_iqueue_init(&iqueue, conn);
+	nblocks = tcp_iqueue_sack_blocks(&iqueue, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(0, nblocks);
+
+	/* Two adjacent segments form one block, the third one another */
+	seg[0]->seq = 30;
+	tcp_iqueue_insert_seg(&iqueue, seg[0]);
+	seg[1]->seq = 40;
+	tcp_iqueue_insert_seg(&iqueue, seg[1]);
+	seg[2]->seq = 60;
+	tcp_iqueue_insert_seg(&iqueue, seg[2]);
+
+	/* Block with the most recently received segment comes first */
+	nblocks = tcp_iqueue_sack_blocks(&iqueue, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(2, nblocks);
+	PCUT_ASSERT_INT_EQUALS(60, blocks[0].left);
+	PCUT_ASSERT_INT_EQUALS(70, blocks[0].right);
+	PCUT_ASSERT_INT_EQUALS(30, blocks[1].left);
+	PCUT_ASSERT_INT_EQUALS(50, blocks[1].right);
+
+	nblocks = tcp_iqueue_sack_blocks(&iqueue, blocks, 1);
+	PCUT_ASSERT_INT_EQUALS(1, nblocks);
+	PCUT_ASSERT_INT_EQUALS(60, blocks[0].left);
+
+	for (i = 0; i < 3; i++) {
+		tcp_iqueue_remove_seg(&iqueue, seg[i]);
+		tcp_segment_delete(seg[i]);
+	}
+
+	free(data);
+	tcp_conn_delete(conn);
+}
+
 PCUT_EXPORT(iqueue);
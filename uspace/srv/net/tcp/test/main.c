@@ -42,6 +42,7 @@ void test_seg_same(tcp_segment_t *a, tcp_segment_t *b)
 	PCUT_ASSERT_INT_EQUALS(a->len, b->len);
 	PCUT_ASSERT_INT_EQUALS(a->wnd, b->wnd);
 	PCUT_ASSERT_INT_EQUALS(a->up, b->up);
+	PCUT_ASSERT_INT_EQUALS(a->opts.flags, b->opts.flags);
 	PCUT_ASSERT_INT_EQUALS(tcp_segment_text_size(a),
 	    tcp_segment_text_size(b));
 	if (tcp_segment_text_size(a) != 0)
@@ -56,10 +57,13 @@ void test_seg_same(tcp_segment_t *a, tcp_segment_t *b)
 
 PCUT_INIT;
 
+PCUT_IMPORT(cc);
 PCUT_IMPORT(conn);
 PCUT_IMPORT(iqueue);
+PCUT_IMPORT(ncsim);
 PCUT_IMPORT(pdu);
 PCUT_IMPORT(rqueue);
+PCUT_IMPORT(rtt);
 PCUT_IMPORT(segment);
 PCUT_IMPORT(seq_no);
 PCUT_IMPORT(tqueue);
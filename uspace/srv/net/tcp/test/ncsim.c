@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inet/endpoint.h>
+#include <io/log.h>
+#include <macros.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "../conn.h"
+#include "../ncsim.h"
+#include "../rqueue.h"
+#include "../ucall.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(ncsim);
+
+/** Size of receive and send chunks */
+#define CHUNK_SIZE 4096
+
+/** Seed of the generator of dropped segments */
+#define TEST_SEED 42
+
+/** Sender fibril state */
+typedef struct {
+	/** Sending connection */
+	tcp_conn_t *conn;
+	/** Number of bytes to send */
+	size_t size;
+	/** Result of sending */
+	tcp_error_t trc;
+	/** Sender has finished */
+	bool done;
+} test_sender_t;
+
+static void test_cstate_change(tcp_conn_t *, void *, tcp_cstate_t);
+static void test_recv_data(tcp_conn_t *, void *);
+static void test_conns_establish(tcp_conn_t **, tcp_conn_t **);
+static void test_conns_tear_down(tcp_conn_t *, tcp_conn_t *);
+static void test_xfer(unsigned, size_t);
+
+static tcp_rqueue_cb_t test_rqueue_cb = {
+	.seg_received = tcp_as_segment_arrived
+};
+
+static tcp_cb_t test_conn_cb = {
+	.cstate_change = test_cstate_change,
+	.recv_data = test_recv_data
+};
+
+static tcp_conn_status_t cconn_status;
+static tcp_conn_status_t sconn_status;
+
+static FIBRIL_MUTEX_INITIALIZE(cst_lock);
+static FIBRIL_CONDVAR_INITIALIZE(cst_cv);
+
+/** Set when data is received, protected by @c cst_lock */
+static bool recv_ready;
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-tcp");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tcp_conns_init();
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	tcp_rqueue_init(&test_rqueue_cb);
+	tcp_rqueue_fibril_start();
+
+	tcp_ncsim_init();
+	tcp_ncsim_fibril_start();
+
+	/* Enable internal loopback */
+	tcp_conn_lb = tcp_lb_segment;
+}
+
+PCUT_TEST_AFTER
+{
+	tcp_ncsim_configure(0, 0, 0);
+	tcp_ncsim_fini();
+	tcp_rqueue_fini();
+	tcp_conns_fini();
+}
+
+/** Test transfer over lossy link.
+ *
+ * The simulator draws the segments to drop from a seeded generator and
+ * adds no latency, so the test is quick and always drops the same segments.
+ * Throughput is measured by the tcp_xfer benchmark in hbench.
+ */
+PCUT_TEST(xfer_loss)
+{
+	srand(TEST_SEED);
+	test_xfer(1, 64 * 1024);
+}
+
+/** Sender fibril.
+ *
+ * Send data with a known pattern, then close the connection.
+ *
+ * @param arg Sender state (test_sender_t *)
+ * @return EOK
+ */
+static errno_t test_sender_fibril(void *arg)
+{
+	test_sender_t *sender = (test_sender_t *)arg;
+	uint8_t buf[CHUNK_SIZE];
+	size_t off = 0;
+	size_t chunk;
+	size_t i;
+	tcp_error_t trc = TCP_EOK;
+
+	while (off < sender->size) {
+		chunk = min(sizeof(buf), sender->size - off);
+		for (i = 0; i < chunk; i++)
+			buf[i] = (uint8_t)(off + i);
+
+		trc = tcp_uc_send(sender->conn, buf, chunk, 0);
+		if (trc != TCP_EOK)
+			break;
+
+		off += chunk;
+	}
+
+	if (trc == TCP_EOK)
+		trc = tcp_uc_close(sender->conn);
+
+	fibril_mutex_lock(&cst_lock);
+	sender->trc = trc;
+	sender->done = true;
+	fibril_mutex_unlock(&cst_lock);
+	fibril_condvar_broadcast(&cst_cv);
+
+	return EOK;
+}
+
+/** Transfer data over simulated network and verify it.
+ *
+ * @param drop_pct Percentage of segments to drop
+ * @param size Number of bytes to transfer
+ */
+static void test_xfer(unsigned drop_pct, size_t size)
+{
+	tcp_conn_t *cconn, *sconn;
+	test_sender_t sender;
+	uint8_t buf[CHUNK_SIZE];
+	size_t total;
+	size_t rcvd;
+	size_t i;
+	xflags_t xflags;
+	tcp_error_t trc;
+	fid_t fid;
+
+	tcp_ncsim_configure(drop_pct, 0, 0);
+
+	test_conns_establish(&cconn, &sconn);
+
+	sender.conn = cconn;
+	sender.size = size;
+	sender.trc = TCP_EOK;
+	sender.done = false;
+
+	fid = fibril_create(test_sender_fibril, &sender);
+	PCUT_ASSERT_TRUE(fid != 0);
+	fibril_add_ready(fid);
+
+	total = 0;
+	while (true) {
+		trc = tcp_uc_receive(sconn, buf, sizeof(buf), &rcvd, &xflags);
+		if (trc == TCP_EAGAIN) {
+			fibril_mutex_lock(&cst_lock);
+			while (!recv_ready)
+				fibril_condvar_wait(&cst_cv, &cst_lock);
+			recv_ready = false;
+			fibril_mutex_unlock(&cst_lock);
+			continue;
+		}
+
+		if (trc == TCP_ECLOSING)
+			break;
+
+		PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+
+		for (i = 0; i < rcvd; i++)
+			PCUT_ASSERT_INT_EQUALS((uint8_t)(total + i), buf[i]);
+
+		total += rcvd;
+	}
+
+	PCUT_ASSERT_INT_EQUALS(size, total);
+
+	fibril_mutex_lock(&cst_lock);
+	while (!sender.done)
+		fibril_condvar_wait(&cst_cv, &cst_lock);
+	fibril_mutex_unlock(&cst_lock);
+
+	PCUT_ASSERT_INT_EQUALS(TCP_EOK, sender.trc);
+
+	test_conns_tear_down(cconn, sconn);
+}
+
+static void test_cstate_change(tcp_conn_t *conn, void *arg,
+    tcp_cstate_t old_state)
+{
+	tcp_conn_status_t *status = (tcp_conn_status_t *)arg;
+
+	fibril_mutex_lock(&cst_lock);
+	tcp_uc_status(conn, status);
+	fibril_mutex_unlock(&cst_lock);
+	fibril_condvar_broadcast(&cst_cv);
+}
+
+static void test_recv_data(tcp_conn_t *conn, void *arg)
+{
+	fibril_mutex_lock(&cst_lock);
+	recv_ready = true;
+	fibril_mutex_unlock(&cst_lock);
+	fibril_condvar_broadcast(&cst_cv);
+}
+
+/** Establish client-server connection */
+static void test_conns_establish(tcp_conn_t **rcconn, tcp_conn_t **rsconn)
+{
+	tcp_conn_t *cconn, *sconn;
+	inet_ep2_t cepp, sepp;
+	tcp_error_t trc;
+
+	/* Client EPP */
+	inet_ep2_init(&cepp);
+	inet_addr(&cepp.local.addr, 127, 0, 0, 1);
+	inet_addr(&cepp.remote.addr, 127, 0, 0, 1);
+	cepp.remote.port = inet_port_user_lo;
+
+	/* Server EPP */
+	inet_ep2_init(&sepp);
+	inet_addr(&sepp.local.addr, 127, 0, 0, 1);
+	sepp.local.port = inet_port_user_lo;
+
+	/* Server side of the connection */
+	sconn = NULL;
+	trc = tcp_uc_open(&sepp, ap_passive, tcp_open_nonblock, &sconn);
+	PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+	PCUT_ASSERT_NOT_NULL(sconn);
+
+	tcp_uc_set_cb(sconn, &test_conn_cb, &sconn_status);
+
+	/* Client side of the connection */
+	cconn = NULL;
+	trc = tcp_uc_open(&cepp, ap_active, 0, &cconn);
+	PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+	PCUT_ASSERT_NOT_NULL(cconn);
+
+	tcp_uc_set_cb(cconn, &test_conn_cb, &cconn_status);
+
+	/* Need to wait for server side */
+	fibril_mutex_lock(&cst_lock);
+	tcp_uc_status(sconn, &sconn_status);
+	while (sconn_status.cstate != st_established)
+		fibril_condvar_wait(&cst_cv, &cst_lock);
+	fibril_mutex_unlock(&cst_lock);
+
+	/* Both sides negotiated window scaling, SACK and timestamps */
+	PCUT_ASSERT_TRUE(cconn->ws_ok);
+	PCUT_ASSERT_TRUE(sconn->ws_ok);
+	PCUT_ASSERT_TRUE(cconn->sack_ok);
+	PCUT_ASSERT_TRUE(sconn->sack_ok);
+	PCUT_ASSERT_TRUE(cconn->ts_ok);
+	PCUT_ASSERT_TRUE(sconn->ts_ok);
+
+	*rcconn = cconn;
+	*rsconn = sconn;
+}
+
+/* Tear down client-server connection. */
+static void test_conns_tear_down(tcp_conn_t *cconn, tcp_conn_t *sconn)
+{
+	tcp_uc_abort(cconn);
+	tcp_uc_delete(cconn);
+
+	tcp_uc_abort(sconn);
+	tcp_uc_delete(sconn);
+}
+
+PCUT_EXPORT(ncsim);
@@ -108,4 +108,97 @@ PCUT_TEST(encdec_data)
 	free(data);
 }
 
+/** Test encode/decode round trip for SYN PDU with options */
+PCUT_TEST(encdec_syn_opts)
+{
+	tcp_segment_t *seg, *dseg;
+	tcp_pdu_t *pdu;
+	inet_ep2_t epp, depp;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	seg = tcp_segment_make_ctrl(CTL_SYN);
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->wnd = 18;
+	seg->opts.flags = TOPT_MSS | TOPT_WSCALE | TOPT_SACK_PERM | TOPT_TS;
+	seg->opts.mss = 1460;
+	seg->opts.wscale = 7;
+	seg->opts.ts_val = 0x12345678;
+	seg->opts.ts_ecr = 0x9abcdef0;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Options must be padded to a multiple of four bytes */
+	PCUT_ASSERT_INT_EQUALS(0, pdu->header_size % 4);
+
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_seg_same(seg, dseg);
+	PCUT_ASSERT_INT_EQUALS(1460, dseg->opts.mss);
+	PCUT_ASSERT_INT_EQUALS(7, dseg->opts.wscale);
+	PCUT_ASSERT_INT_EQUALS(0x12345678, dseg->opts.ts_val);
+	PCUT_ASSERT_INT_EQUALS(0x9abcdef0, dseg->opts.ts_ecr);
+
+	tcp_segment_delete(seg);
+	tcp_segment_delete(dseg);
+	tcp_pdu_delete(pdu);
+}
+
+/** Test encode/decode round trip for ACK PDU with SACK blocks */
+PCUT_TEST(encdec_sack)
+{
+	tcp_segment_t *seg, *dseg;
+	tcp_pdu_t *pdu;
+	inet_ep2_t epp, depp;
+	unsigned i;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	seg = tcp_segment_make_ctrl(CTL_ACK);
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->ack = 1000;
+	seg->wnd = 18;
+	seg->opts.flags = TOPT_TS | TOPT_SACK;
+	seg->opts.ts_val = 1;
+	seg->opts.ts_ecr = 2;
+	seg->opts.sack_blocks = 3;
+	for (i = 0; i < 3; i++) {
+		seg->opts.sack[i].left = 2000 + 1000 * i;
+		seg->opts.sack[i].right = 2500 + 1000 * i;
+	}
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, pdu->header_size % 4);
+
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_seg_same(seg, dseg);
+	PCUT_ASSERT_INT_EQUALS(1, dseg->opts.ts_val);
+	PCUT_ASSERT_INT_EQUALS(2, dseg->opts.ts_ecr);
+	PCUT_ASSERT_INT_EQUALS(3, dseg->opts.sack_blocks);
+	for (i = 0; i < 3; i++) {
+		PCUT_ASSERT_INT_EQUALS(2000 + 1000 * i, dseg->opts.sack[i].left);
+		PCUT_ASSERT_INT_EQUALS(2500 + 1000 * i,
+		    dseg->opts.sack[i].right);
+	}
+
+	tcp_segment_delete(seg);
+	tcp_segment_delete(dseg);
+	tcp_pdu_delete(pdu);
+}
+
 PCUT_EXPORT(pdu);
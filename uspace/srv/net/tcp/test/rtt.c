@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcut/pcut.h>
+
+#include "../rtt.h"
+#include "../tcp_type.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(rtt);
+
+/** Test computing RTO from RTT samples */
+PCUT_TEST(sample)
+{
+	tcp_rtt_t rtt;
+
+	tcp_rtt_init(&rtt);
+	PCUT_ASSERT_FALSE(rtt.valid);
+	PCUT_ASSERT_INT_EQUALS(1000 * 1000, rtt.rto);
+
+	/* First sample: SRTT = R, RTTVAR = R / 2 */
+	tcp_rtt_sample(&rtt, 100 * 1000);
+	PCUT_ASSERT_TRUE(rtt.valid);
+	PCUT_ASSERT_INT_EQUALS(100 * 1000, rtt.srtt);
+	PCUT_ASSERT_INT_EQUALS(50 * 1000, rtt.rttvar);
+	PCUT_ASSERT_INT_EQUALS(300 * 1000, rtt.rto);
+
+	/* Subsequent samples are smoothed */
+	tcp_rtt_sample(&rtt, 100 * 1000);
+	PCUT_ASSERT_INT_EQUALS(100 * 1000, rtt.srtt);
+	PCUT_ASSERT_INT_EQUALS(37500, rtt.rttvar);
+	PCUT_ASSERT_INT_EQUALS(250 * 1000, rtt.rto);
+
+	tcp_rtt_sample(&rtt, 180 * 1000);
+	PCUT_ASSERT_INT_EQUALS(110 * 1000, rtt.srtt);
+	PCUT_ASSERT_INT_EQUALS(48125, rtt.rttvar);
+	PCUT_ASSERT_INT_EQUALS(302500, rtt.rto);
+}
+
+/** Test RTO bounds and backoff */
+PCUT_TEST(bounds_backoff)
+{
+	tcp_rtt_t rtt;
+	int i;
+
+	tcp_rtt_init(&rtt);
+
+	/* RTO has a lower bound */
+	tcp_rtt_sample(&rtt, 1000);
+	PCUT_ASSERT_INT_EQUALS(200 * 1000, rtt.rto);
+
+	/* Backoff doubles RTO */
+	tcp_rtt_backoff(&rtt);
+	PCUT_ASSERT_INT_EQUALS(400 * 1000, rtt.rto);
+
+	/* RTO has an upper bound */
+	for (i = 0; i < 20; i++)
+		tcp_rtt_backoff(&rtt);
+	PCUT_ASSERT_INT_EQUALS(60 * 1000 * 1000, rtt.rto);
+
+	/* New sample resets backoff */
+	tcp_rtt_sample(&rtt, 1000);
+	PCUT_ASSERT_INT_EQUALS(200 * 1000, rtt.rto);
+}
+
+/** Test timing a segment */
+PCUT_TEST(timing)
+{
+	tcp_rtt_t rtt;
+
+	tcp_rtt_init(&rtt);
+
+	tcp_rtt_start(&rtt, 100, 1000);
+	PCUT_ASSERT_TRUE(rtt.timing);
+
+	/* Starting again does not restart measurement */
+	tcp_rtt_start(&rtt, 200, 2000);
+	PCUT_ASSERT_INT_EQUALS(100, rtt.seq);
+
+	/* Timed segment not acknowledged yet */
+	tcp_rtt_ack(&rtt, 50, 3000);
+	PCUT_ASSERT_TRUE(rtt.timing);
+	PCUT_ASSERT_FALSE(rtt.valid);
+
+	tcp_rtt_ack(&rtt, 150, 51000);
+	PCUT_ASSERT_FALSE(rtt.timing);
+	PCUT_ASSERT_TRUE(rtt.valid);
+	PCUT_ASSERT_INT_EQUALS(50000, rtt.srtt);
+}
+
+/** Test that measurement of retransmitted segment is discarded */
+PCUT_TEST(karn)
+{
+	tcp_rtt_t rtt;
+
+	tcp_rtt_init(&rtt);
+
+	tcp_rtt_start(&rtt, 100, 1000);
+	tcp_rtt_cancel(&rtt);
+	tcp_rtt_ack(&rtt, 100, 51000);
+	PCUT_ASSERT_FALSE(rtt.valid);
+	PCUT_ASSERT_INT_EQUALS(1000 * 1000, rtt.rto);
+
+	/* Sequence number wrap-around */
+	tcp_rtt_start(&rtt, 0x10, 1000);
+	tcp_rtt_ack(&rtt, 0xfffffff0, 2000);
+	PCUT_ASSERT_TRUE(rtt.timing);
+	tcp_rtt_ack(&rtt, 0x10, 3000);
+	PCUT_ASSERT_FALSE(rtt.timing);
+	PCUT_ASSERT_INT_EQUALS(2000, rtt.srtt);
+}
+
+PCUT_EXPORT(rtt);
@@ -28,7 +28,9 @@
 
 //#include <inet/endpoint.h>
 #include <io/log.h>
+#include <mem.h>
 #include <pcut/pcut.h>
+#include <stdbool.h>
 
 #include "../conn.h"
 #include "../segment.h"
@@ -257,6 +259,70 @@ PCUT_TEST(ack_received)
 	tcp_conn_delete(conn);
 }
 
+/** Test marking segments selectively acknowledged by the peer */
+PCUT_TEST(sack_received)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	tcp_seg_opts_t opts;
+	bool sacked[3];
+	int i;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 1024;
+	conn->sack_ok = true;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+
+	/* Queue three data segments of 10 bytes each */
+	for (i = 0; i < 3; i++) {
+		conn->snd_buf_used = 10;
+		conn->snd_buf_fin = false;
+		tcp_tqueue_new_data(conn);
+	}
+
+	PCUT_ASSERT_EQUALS(40, conn->snd_nxt);
+	PCUT_ASSERT_INT_EQUALS(3, list_count(&conn->retransmit.list));
+
+	/* Invalid blocks are ignored, valid block covers last two segments */
+	memset(&opts, 0, sizeof(opts));
+	opts.flags = TOPT_SACK;
+	opts.sack_blocks = 3;
+	opts.sack[0].left = 10;
+	opts.sack[0].right = 20;
+	opts.sack[1].left = 30;
+	opts.sack[1].right = 50;
+	opts.sack[2].left = 20;
+	opts.sack[2].right = 40;
+	tcp_tqueue_sack_received(conn, &opts);
+
+	i = 0;
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe)
+		sacked[i++] = tqe->sacked;
+
+	PCUT_ASSERT_FALSE(sacked[0]);
+	PCUT_ASSERT_TRUE(sacked[1]);
+	PCUT_ASSERT_TRUE(sacked[2]);
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+
+	for (i = 0; i < seg_cnt; i++)
+		tcp_segment_delete(trans_seg[i]);
+}
+
 static void tqueue_test_transmit_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
 	trans_seg[seg_cnt++] = tcp_segment_dup(seg);
@@ -43,17 +43,19 @@
 #include <mem.h>
 #include <stdlib.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
+#include "iqueue.h"
 #include "ncsim.h"
 #include "rqueue.h"
+#include "rtt.h"
 #include "segment.h"
 #include "seq_no.h"
+#include "std.h"
 #include "tqueue.h"
 #include "tcp_type.h"
 
-#define RETRANSMIT_TIMEOUT	(2*1000*1000)
-
 static void retransmit_timeout_func(void *);
 static void tcp_tqueue_timer_set(tcp_conn_t *);
 static void tcp_tqueue_timer_clear(tcp_conn_t *);
@@ -61,6 +63,8 @@ static void tcp_tqueue_seg(tcp_conn_t *, tcp_segment_t *);
 static void tcp_conn_transmit_segment(tcp_conn_t *, tcp_segment_t *);
 static void tcp_prepare_transmit_segment(tcp_conn_t *, tcp_segment_t *);
 static void tcp_tqueue_send_immed(tcp_conn_t *, tcp_segment_t *);
+static void tcp_tqueue_retransmit(tcp_conn_t *);
+static void tcp_tqueue_seg_opts(tcp_conn_t *, tcp_segment_t *);
 
 errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
     tcp_tqueue_cb_t *cb)
@@ -149,6 +153,15 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 
 		list_append(&tqe->link, &conn->retransmit.list);
 
+		/*
+		 * Measure RTT unless we are already timing another segment.
+		 * With timestamps every ACK provides a measurement instead.
+		 */
+		if (!conn->ts_ok) {
+			tcp_rtt_start(&conn->rtt, conn->snd_nxt + seg->len,
+			    tcp_rtt_now());
+		}
+
 		/* Set retransmission timer */
 		tcp_tqueue_timer_set(conn);
 	}
@@ -172,40 +185,54 @@ static void tcp_prepare_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 	tcp_conn_transmit_segment(conn, seg);
 }
 
-/** Transmit data from the send buffer.
+/** Transmit one segment of data from the send buffer.
  *
  * @param conn	Connection
+ * @return	@c true if a segment was sent
  */
-void tcp_tqueue_new_data(tcp_conn_t *conn)
+static bool tcp_tqueue_new_seg(tcp_conn_t *conn)
 {
+	uint32_t snd_wnd;
+	uint32_t flight;
 	size_t avail_wnd;
 	size_t xfer_seqlen;
 	size_t snd_buf_seqlen;
 	size_t data_size;
+	size_t mss;
 	tcp_control_t ctrl;
 	bool send_fin;
 
 	tcp_segment_t *seg;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_new_data()", conn->name);
-
-	/* Number of free sequence numbers in send window */
-	avail_wnd = (conn->snd_una + conn->snd_wnd) - conn->snd_nxt;
+	/* Number of free sequence numbers in send and congestion window */
+	snd_wnd = tcp_cc_snd_wnd(conn);
+	flight = conn->snd_nxt - conn->snd_una;
+	avail_wnd = flight < snd_wnd ? snd_wnd - flight : 0;
 	snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
 
 	xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, SND.WND = %" PRIu32 ", "
-	    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen, conn->snd_wnd,
-	    xfer_seqlen);
+	    "CWND = %" PRIu32 ", xfer_seqlen = %zu", conn->name, snd_buf_seqlen,
+	    conn->snd_wnd, conn->cc.cwnd, xfer_seqlen);
 
 	if (xfer_seqlen == 0)
-		return;
+		return false;
 
 	/* XXX Do not always send immediately */
 
 	send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
 	data_size = xfer_seqlen - (send_fin ? 1 : 0);
 
+	/*
+	 * Do not send more than SMSS bytes of data in one segment, less
+	 * the space taken by the timestamp option (with its padding).
+	 */
+	mss = conn->smss - (conn->ts_ok ? OPT_TIMESTAMP_LEN + 2 : 0);
+	if (data_size > mss) {
+		data_size = mss;
+		send_fin = false;
+	}
+
 	if (send_fin) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
 		/* We are sending out FIN */
@@ -217,7 +244,7 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 	seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
 	if (seg == NULL) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
-		return;
+		return false;
 	}
 
 	/* Remove data from send buffer */
@@ -235,6 +262,21 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 
 	tcp_tqueue_seg(conn, seg);
 	tcp_segment_delete(seg);
+	return true;
+}
+
+/** Transmit data from the send buffer.
+ *
+ * Send as many segments as the send and congestion windows allow.
+ *
+ * @param conn	Connection
+ */
+void tcp_tqueue_new_data(tcp_conn_t *conn)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_new_data()", conn->name);
+
+	while (tcp_tqueue_new_seg(conn))
+		;
 }
 
 /** Remove ACKed segments from retransmission queue and possibly transmit
@@ -245,6 +287,7 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 void tcp_tqueue_ack_received(tcp_conn_t *conn)
 {
 	link_t *cur, *next;
+	uint32_t acked = 0;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_ack_received(%p)", conn->name,
 	    conn);
@@ -270,6 +313,7 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 				conn->fin_is_acked = true;
 			}
 
+			acked += tcp_segment_text_size(tqe->seg);
 			tcp_segment_delete(tqe->seg);
 			free(tqe);
 
@@ -284,22 +328,180 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 	if (list_empty(&conn->retransmit.list))
 		tcp_tqueue_timer_clear(conn);
 
+	tcp_rtt_ack(&conn->rtt, conn->snd_una, tcp_rtt_now());
+
+	/* Partial acknowledgement during recovery */
+	if (tcp_cc_ack(conn, acked))
+		tcp_tqueue_retransmit(conn);
+
 	/* Possibly transmit more data */
 	tcp_tqueue_new_data(conn);
 }
 
+/** Process duplicate ACK.
+ *
+ * Retransmit the first unacknowledged segment once enough duplicate
+ * ACKs indicate it has been lost, then possibly transmit more data.
+ *
+ * @param conn	Connection
+ */
+void tcp_tqueue_dup_ack_received(tcp_conn_t *conn)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_dup_ack_received(%p)",
+	    conn->name, conn);
+
+	if (tcp_cc_dup_ack(conn)) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: fast retransmit", conn->name);
+		tcp_tqueue_retransmit(conn);
+	}
+
+	/* Possibly transmit more data */
+	tcp_tqueue_new_data(conn);
+}
+
+/** Process SACK blocks received from the peer.
+ *
+ * Mark segments in the retransmission queue which the peer reports
+ * as received so that they are skipped by fast retransmission.
+ *
+ * @param conn	Connection
+ * @param opts	Options of the received segment
+ */
+void tcp_tqueue_sack_received(tcp_conn_t *conn, tcp_seg_opts_t *opts)
+{
+	uint32_t flight;
+	uint32_t loff, roff;
+	uint32_t soff;
+	unsigned i;
+
+	if (!conn->sack_ok || (opts->flags & TOPT_SACK) == 0)
+		return;
+
+	flight = conn->snd_nxt - conn->snd_una;
+
+	for (i = 0; i < opts->sack_blocks; i++) {
+		/* Offsets relative to SND.UNA */
+		loff = opts->sack[i].left - conn->snd_una;
+		roff = opts->sack[i].right - conn->snd_una;
+
+		/* Ignore blocks which are not within SND.UNA..SND.NXT */
+		if (loff == 0 || loff >= roff || roff > flight)
+			continue;
+
+		list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t,
+		    tqe) {
+			soff = tqe->seg->seq - conn->snd_una;
+			if (soff >= loff && soff + tqe->seg->len <= roff)
+				tqe->sacked = true;
+		}
+	}
+}
+
+/** Retransmit first segment in retransmission queue that has not been
+ * selectively acknowledged.
+ *
+ * @param conn	Connection
+ */
+static void tcp_tqueue_retransmit(tcp_conn_t *conn)
+{
+	tcp_tqueue_entry_t *tqe;
+	tcp_segment_t *rt_seg;
+	link_t *link;
+
+	link = list_first(&conn->retransmit.list);
+	if (link == NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Nothing to retransmit");
+		return;
+	}
+
+	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+
+	/* Skip segments the peer already has */
+	while (tqe->sacked) {
+		link = list_next(link, &conn->retransmit.list);
+		if (link == NULL) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "All segments SACKed");
+			return;
+		}
+
+		tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+	}
+
+	rt_seg = tcp_segment_dup(tqe->seg);
+	if (rt_seg == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
+		/* XXX Handle properly */
+		return;
+	}
+
+	/* Karn's algorithm: the measurement would be ambiguous */
+	tcp_rtt_cancel(&conn->rtt);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
+	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+}
+
+/** Fill in options of outgoing segment.
+ *
+ * SYN segments carry MSS and offer the extensions that are enabled.
+ * Once the extensions have been negotiated, segments carry timestamps
+ * and pure ACKs report out-of-order data using SACK blocks.
+ *
+ * @param conn	Connection
+ * @param seg	Segment
+ */
+static void tcp_tqueue_seg_opts(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	tcp_seg_opts_t *opts = &seg->opts;
+
+	memset(opts, 0, sizeof(tcp_seg_opts_t));
+
+	if ((seg->ctrl & CTL_SYN) != 0) {
+		opts->flags |= TOPT_MSS;
+		opts->mss = conn->rmss;
+
+		if (conn->ws_ok) {
+			opts->flags |= TOPT_WSCALE;
+			opts->wscale = conn->rcv_wscale;
+		}
+
+		if (conn->sack_ok)
+			opts->flags |= TOPT_SACK_PERM;
+	}
+
+	if (conn->ts_ok) {
+		opts->flags |= TOPT_TS;
+		opts->ts_val = tcp_rtt_ts_clock(tcp_rtt_now());
+		opts->ts_ecr = conn->ts_recent;
+	}
+
+	if (conn->sack_ok && (seg->ctrl & (CTL_SYN | CTL_RST)) == 0 &&
+	    tcp_segment_text_size(seg) == 0) {
+		opts->sack_blocks = tcp_iqueue_sack_blocks(&conn->incoming,
+		    opts->sack, conn->ts_ok ? 3 : TCP_SACK_BLOCKS_MAX);
+		if (opts->sack_blocks > 0)
+			opts->flags |= TOPT_SACK;
+	}
+}
+
 static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_transmit_segment(%p, %p)",
 	    conn->name, conn, seg);
 
-	seg->wnd = conn->rcv_wnd;
+	/* Window in SYN segments is never scaled */
+	if ((seg->ctrl & CTL_SYN) != 0)
+		seg->wnd = min(conn->rcv_wnd, UINT16_MAX);
+	else
+		seg->wnd = min(conn->rcv_wnd >> conn->rcv_wscale, UINT16_MAX);
 
 	if ((seg->ctrl & CTL_ACK) != 0)
 		seg->ack = conn->rcv_nxt;
 	else
 		seg->ack = 0;
 
+	tcp_tqueue_seg_opts(conn, seg);
+
 	tcp_tqueue_send_immed(conn, seg);
 }
 
@@ -320,9 +522,6 @@ void tcp_tqueue_send_immed(tcp_conn_t *conn, tcp_segment_t *seg)
 static void retransmit_timeout_func(void *arg)
 {
 	tcp_conn_t *conn = (tcp_conn_t *) arg;
-	tcp_tqueue_entry_t *tqe;
-	tcp_segment_t *rt_seg;
-	link_t *link;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p)", conn->name, conn);
 
@@ -335,30 +534,25 @@ static void retransmit_timeout_func(void *arg)
 		return;
 	}
 
-	link = list_first(&conn->retransmit.list);
-	if (link == NULL) {
+	if (list_empty(&conn->retransmit.list)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Nothing to retransmit");
 		tcp_conn_unlock(conn);
 		tcp_conn_delref(conn);
 		return;
 	}
 
-	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+	/* Collapse congestion window and back off the timer */
+	tcp_cc_timeout(conn);
+	tcp_rtt_backoff(&conn->rtt);
 
-	rt_seg = tcp_segment_dup(tqe->seg);
-	if (rt_seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
-		tcp_conn_unlock(conn);
-		tcp_conn_delref(conn);
-		/* XXX Handle properly */
-		return;
-	}
+	/* The peer may have discarded data it reported with SACK (RFC 2018) */
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe)
+		tqe->sacked = false;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
-	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	tcp_tqueue_retransmit(conn);
 
 	/* Reset retransmission timer */
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rtt.rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	tcp_conn_unlock(conn);
@@ -377,7 +571,7 @@ static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 	tcp_tqueue_timer_clear(conn);
 
 	tcp_conn_addref(conn);
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rtt.rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_set() end", conn->name);
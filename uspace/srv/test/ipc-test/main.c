@@ -55,7 +55,7 @@
 static service_id_t svc_id;
 
 enum {
-	max_rw_buf_size = 16384,
+	max_rw_buf_size = 1024 * 1024,
 };
 
 /** Object in read-only memory area that will be shared.
@@ -98,6 +98,23 @@ int main(int argc, char **argv)
 		return ENOMEM;
 	}
 
+	/*
+	 * Initialize VFS directory entry cache.
+	 */
+	if (!vfs_dcache_init()) {
+		printf("%s: Failed to initialize VFS directory entry cache\n",
+		    NAME);
+		return ENOMEM;
+	}
+
+	/*
+	 * Initialize VFS page cache.
+	 */
+	if (!vfs_pcache_init()) {
+		printf("%s: Failed to initialize VFS page cache\n", NAME);
+		return ENOMEM;
+	}
+
 	/*
 	 * Allocate and initialize the Path Lookup Buffer.
 	 */
@@ -124,8 +124,41 @@ typedef struct _vfs_node {
 	fibril_rwlock_t contents_rwlock;
 
 	struct _vfs_node *mount;
+
+	/** The node has been unlinked while in use. */
+	bool unlinked;
 } vfs_node_t;
 
+/**
+ * Instances of this type represent a page of file contents cached by VFS.
+ */
+typedef struct {
+	ht_link_t link;		/**< Page cache hash table link. */
+	link_t lru_link;	/**< Link in the list of unused pages. */
+	link_t refresh_link;	/**< Link in the list of pages to refresh. */
+
+	/** Node the page belongs to. */
+	vfs_triplet_t triplet;
+	/** Page-aligned offset of the page in the node. */
+	aoff64_t offset;
+
+	/** Page contents, in an address space area of its own. */
+	void *data;
+	/** Number of valid bytes in the page. */
+	size_t size;
+
+	/** Number of users of the page. */
+	unsigned refcnt;
+	/** The page contents are being read from the file system. */
+	bool reading;
+	/** Result of the last read. */
+	errno_t rc;
+	/** The page has been removed from the cache. */
+	bool stale;
+	/** The page is mapped by some client. */
+	bool mapped;
+} vfs_page_t;
+
 /**
  * Instances of this type represent an open file. If the file is opened by more
  * than one task, there will be a separate structure allocated for each task.
@@ -200,6 +233,7 @@ extern void vfs_op_pass_handle(task_id_t, task_id_t, int);
 extern errno_t vfs_wait_handle_internal(vfs_client_data_t *, bool, int *);
 
 extern vfs_file_t *vfs_file_get(vfs_client_data_t *, int);
+extern vfs_file_t *vfs_pager_file_get(vfs_client_data_t *, int);
 extern void vfs_file_put(vfs_client_data_t *, vfs_file_t *);
 extern errno_t vfs_fd_assign(vfs_client_data_t *vfs_data, vfs_file_t *, int);
 extern errno_t vfs_fd_alloc(vfs_client_data_t *vfs_data, vfs_file_t **file, bool desc, int *);
@@ -214,6 +248,7 @@ extern errno_t vfs_op_fsprobe(const char *, service_id_t, vfs_fs_probe_info_t *)
 extern errno_t vfs_op_mount(vfs_client_data_t *vfs_data, int mpfd, unsigned servid, unsigned flags, unsigned instance, const char *opts, const char *fsname, int *outfd);
 extern errno_t vfs_op_mtab_get(void);
 extern errno_t vfs_op_open(vfs_client_data_t *vfs_data, int fd, int flags);
+extern errno_t vfs_op_pager_handle(vfs_client_data_t *vfs_data, int fd, int *out_handle);
 extern errno_t vfs_op_put(vfs_client_data_t *vfs_data, int fd);
 extern errno_t vfs_op_read(vfs_client_data_t *vfs_data, int fd, aoff64_t, size_t *out_bytes);
 extern errno_t vfs_op_rename(vfs_client_data_t *vfs_data, int basefd, char *old, char *new);
@@ -231,12 +266,34 @@ extern void vfs_register(ipc_call_t *);
 
 extern void vfs_page_in(ipc_call_t *);
 
+extern bool vfs_dcache_init(void);
+extern bool vfs_dcache_enabled(fs_handle_t);
+extern unsigned vfs_dcache_generation(void);
+extern errno_t vfs_dcache_lookup(vfs_triplet_t *, const char *,
+    vfs_lookup_res_t *);
+extern void vfs_dcache_insert(unsigned, vfs_triplet_t *, const char *,
+    vfs_lookup_res_t *);
+extern void vfs_dcache_remove(vfs_triplet_t *, const char *);
+extern void vfs_dcache_forget(vfs_triplet_t *);
+extern void vfs_dcache_forget_fs(fs_handle_t, service_id_t);
+extern void vfs_dcache_set_size(vfs_triplet_t *, aoff64_t);
+
+extern bool vfs_pcache_init(void);
+extern bool vfs_pcache_enabled(vfs_node_t *);
+extern errno_t vfs_pcache_get(async_exch_t *, vfs_node_t *, aoff64_t,
+    vfs_page_t **);
+extern void vfs_pcache_put(vfs_page_t *);
+extern void vfs_pcache_mapped(vfs_page_t *);
+extern void vfs_pcache_invalidate(vfs_node_t *, aoff64_t, aoff64_t);
+extern void vfs_pcache_forget(vfs_triplet_t *);
+extern void vfs_pcache_forget_fs(fs_handle_t, service_id_t);
+
 typedef struct {
 	void *buffer;
 	size_t size;
 } rdwr_io_chunk_t;
 
-extern errno_t vfs_rdwr_internal(vfs_client_data_t *, int, aoff64_t, bool, rdwr_io_chunk_t *);
+extern errno_t vfs_rdwr_internal(vfs_file_t *, aoff64_t, bool, rdwr_io_chunk_t *);
 
 extern void vfs_connection(ipc_call_t *, void *);
 
@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file vfs_dcache.c
+ * @brief VFS directory entry cache.
+ *
+ * The cache maps a directory node triplet and a path component to the lookup
+ * result of the component, or records that the component does not exist.
+ * Path lookups consult it one component at a time and only ask the file
+ * system server about components which are not cached.
+ *
+ * Every entry is in two hash tables: one keyed by the parent and the name for
+ * lookups, the other keyed by the child node so that the entries of a node
+ * can be found when the node changes.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <str.h>
+
+/** Maximum number of entries kept in the cache. */
+#define DCACHE_ENTRIES_MAX	1024
+
+/** Directory entry. */
+typedef struct {
+	ht_link_t link;		/**< Link in the parent-name hash table. */
+	ht_link_t child_link;	/**< Link in the child hash table. */
+	link_t lru_link;	/**< Link in the LRU list. */
+
+	/** Directory containing the entry. */
+	vfs_triplet_t parent;
+	/** Name of the entry. */
+	char *name;
+	/** The entry does not exist. */
+	bool negative;
+	/** Lookup result of the entry, unless negative. */
+	vfs_lookup_res_t child;
+} dentry_t;
+
+/** Lookup key of the parent-name hash table. */
+typedef struct {
+	vfs_triplet_t *parent;
+	const char *name;
+} dentry_key_t;
+
+/** Mutex protecting the directory entry cache. */
+static FIBRIL_MUTEX_INITIALIZE(dcache_mutex);
+
+/** Directory entries keyed by parent and name. */
+static hash_table_t dcache;
+
+/** Positive directory entries keyed by child. */
+static hash_table_t dcache_child;
+
+/** Directory entries, least recently used first. */
+static LIST_INITIALIZE(dcache_lru);
+
+/** Incremented whenever entries are removed. */
+static unsigned dcache_gen;
+
+static size_t triplet_hash(const vfs_triplet_t *);
+static size_t dentry_key_hash(const void *);
+static size_t dentry_hash(const ht_link_t *);
+static bool dentry_key_equal(const void *, size_t, const ht_link_t *);
+static size_t dentry_child_key_hash(const void *);
+static size_t dentry_child_hash(const ht_link_t *);
+static bool dentry_child_key_equal(const void *, size_t, const ht_link_t *);
+
+/** Directory entry hash table operations. */
+static const hash_table_ops_t dcache_ops = {
+	.hash = dentry_hash,
+	.key_hash = dentry_key_hash,
+	.key_equal = dentry_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL,
+};
+
+/** Directory entry child hash table operations. */
+static const hash_table_ops_t dcache_child_ops = {
+	.hash = dentry_child_hash,
+	.key_hash = dentry_child_key_hash,
+	.key_equal = dentry_child_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL,
+};
+
+/** Initialize the directory entry cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_dcache_init(void)
+{
+	if (!hash_table_create(&dcache, 0, 0, &dcache_ops))
+		return false;
+
+	if (!hash_table_create(&dcache_child, 0, 0, &dcache_child_ops)) {
+		hash_table_destroy(&dcache);
+		return false;
+	}
+
+	return true;
+}
+
+/** Determine whether directory entries of a file system may be cached.
+ *
+ * File systems whose namespace changes outside VFS, such as locfs, do not
+ * allow caching.
+ *
+ * @param fs_handle	File system handle.
+ *
+ * @return		True if the entries may be cached.
+ */
+bool vfs_dcache_enabled(fs_handle_t fs_handle)
+{
+	vfs_info_t *info = fs_handle_to_info(fs_handle);
+	return info != NULL && info->names_cacheable;
+}
+
+static inline bool triplet_equal(const vfs_triplet_t *a,
+    const vfs_triplet_t *b)
+{
+	return a->fs_handle == b->fs_handle &&
+	    a->service_id == b->service_id && a->index == b->index;
+}
+
+/** Remove directory entry from the cache and free it.
+ *
+ * @param dentry	Directory entry. The cache mutex must be held.
+ */
+static void dentry_remove(dentry_t *dentry)
+{
+	assert(fibril_mutex_is_locked(&dcache_mutex));
+
+	hash_table_remove_item(&dcache, &dentry->link);
+	if (!dentry->negative)
+		hash_table_remove_item(&dcache_child, &dentry->child_link);
+	list_remove(&dentry->lru_link);
+	free(dentry->name);
+	free(dentry);
+}
+
+/** Get the current cache generation.
+ *
+ * The generation must be read before a lookup whose result is going to be
+ * inserted into the cache with vfs_dcache_insert().
+ *
+ * @return		Cache generation.
+ */
+unsigned vfs_dcache_generation(void)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	unsigned gen = dcache_gen;
+	fibril_mutex_unlock(&dcache_mutex);
+
+	return gen;
+}
+
+/** Look up directory entry.
+ *
+ * @param parent	Directory node.
+ * @param name		Name of the entry.
+ * @param result	Place to store the lookup result of the entry.
+ *
+ * @return		EOK if the entry is cached, ENOENT if the entry is
+ *			cached as non-existent, EAGAIN if the entry is not
+ *			cached.
+ */
+errno_t vfs_dcache_lookup(vfs_triplet_t *parent, const char *name,
+    vfs_lookup_res_t *result)
+{
+	dentry_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+	errno_t rc;
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	ht_link_t *link = hash_table_find(&dcache, &key);
+	if (link == NULL) {
+		fibril_mutex_unlock(&dcache_mutex);
+		return EAGAIN;
+	}
+
+	dentry_t *dentry = hash_table_get_inst(link, dentry_t, link);
+	list_remove(&dentry->lru_link);
+	list_append(&dentry->lru_link, &dcache_lru);
+
+	if (dentry->negative) {
+		rc = ENOENT;
+	} else {
+		*result = dentry->child;
+		rc = EOK;
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+	return rc;
+}
+
+/** Insert directory entry.
+ *
+ * The entry is not inserted if any entries have been removed since @a gen
+ * was obtained, as the lookup result could be already stale.
+ *
+ * @param gen		Cache generation obtained before the lookup.
+ * @param parent	Directory node.
+ * @param name		Name of the entry.
+ * @param child		Lookup result of the entry or NULL if the entry does
+ *			not exist.
+ */
+void vfs_dcache_insert(unsigned gen, vfs_triplet_t *parent, const char *name,
+    vfs_lookup_res_t *child)
+{
+	dentry_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	dentry_t *dentry = calloc(1, sizeof(dentry_t));
+	if (dentry == NULL)
+		return;
+
+	dentry->name = str_dup(name);
+	if (dentry->name == NULL) {
+		free(dentry);
+		return;
+	}
+
+	dentry->parent = *parent;
+	if (child != NULL)
+		dentry->child = *child;
+	else
+		dentry->negative = true;
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	if (gen != dcache_gen || hash_table_find(&dcache, &key) != NULL) {
+		fibril_mutex_unlock(&dcache_mutex);
+		free(dentry->name);
+		free(dentry);
+		return;
+	}
+
+	if (hash_table_size(&dcache) >= DCACHE_ENTRIES_MAX) {
+		dentry_remove(list_get_instance(list_first(&dcache_lru),
+		    dentry_t, lru_link));
+	}
+
+	hash_table_insert(&dcache, &dentry->link);
+	if (!dentry->negative)
+		hash_table_insert(&dcache_child, &dentry->child_link);
+	list_append(&dentry->lru_link, &dcache_lru);
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/** Remove directory entry.
+ *
+ * This must be called whenever a name is linked or unlinked.
+ *
+ * @param parent	Directory node.
+ * @param name		Name of the entry.
+ */
+void vfs_dcache_remove(vfs_triplet_t *parent, const char *name)
+{
+	dentry_key_t key = {
+		.parent = parent,
+		.name = name
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	dcache_gen++;
+	ht_link_t *link = hash_table_find(&dcache, &key);
+	if (link != NULL)
+		dentry_remove(hash_table_get_inst(link, dentry_t, link));
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+static bool dcache_forget_dir_visitor(ht_link_t *item, void *arg)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, link);
+	vfs_triplet_t *dir = (vfs_triplet_t *) arg;
+
+	if (triplet_equal(&dentry->parent, dir))
+		dentry_remove(dentry);
+
+	return true;
+}
+
+/** Remove all directory entries referring to a node.
+ *
+ * This removes the entries of all names of the node and, if the node is
+ * a directory, all entries in the directory. It must be called when the node
+ * is unlinked, as its index may be reused once the node is destroyed.
+ *
+ * @param node		Node triplet.
+ */
+void vfs_dcache_forget(vfs_triplet_t *node)
+{
+	fibril_mutex_lock(&dcache_mutex);
+
+	dcache_gen++;
+
+	ht_link_t *link;
+	while ((link = hash_table_find(&dcache_child, node)) != NULL) {
+		dentry_remove(hash_table_get_inst(link, dentry_t,
+		    child_link));
+	}
+
+	hash_table_apply(&dcache, dcache_forget_dir_visitor, node);
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+static bool dcache_forget_fs_visitor(ht_link_t *item, void *arg)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, link);
+	vfs_pair_t *pair = (vfs_pair_t *) arg;
+
+	if (dentry->parent.fs_handle == pair->fs_handle &&
+	    dentry->parent.service_id == pair->service_id)
+		dentry_remove(dentry);
+
+	return true;
+}
+
+/** Remove all directory entries of a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_dcache_forget_fs(fs_handle_t fs_handle, service_id_t service_id)
+{
+	vfs_pair_t pair = {
+		.fs_handle = fs_handle,
+		.service_id = service_id
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+	dcache_gen++;
+	hash_table_apply(&dcache, dcache_forget_fs_visitor, &pair);
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/** Update the cached size of a node.
+ *
+ * The size in the lookup result is used to initialize a VFS node which is
+ * not active, so it must be kept up to date when an active node is dropped.
+ *
+ * @param node		Node triplet.
+ * @param size		Current size of the node.
+ */
+void vfs_dcache_set_size(vfs_triplet_t *node, aoff64_t size)
+{
+	fibril_mutex_lock(&dcache_mutex);
+
+	hash_table_foreach(&dcache_child, node, child_link, dentry_t, dentry) {
+		dentry->child.size = size;
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+static size_t triplet_hash(const vfs_triplet_t *tri)
+{
+	size_t hash = hash_combine(tri->fs_handle, tri->index);
+	return hash_combine(hash, tri->service_id);
+}
+
+static size_t dentry_key_hash(const void *key)
+{
+	const dentry_key_t *dkey = key;
+	return hash_combine(triplet_hash(dkey->parent),
+	    hash_string(dkey->name));
+}
+
+static size_t dentry_hash(const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, link);
+	dentry_key_t key = {
+		.parent = &dentry->parent,
+		.name = dentry->name
+	};
+	return dentry_key_hash(&key);
+}
+
+static bool dentry_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const dentry_key_t *dkey = key;
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, link);
+	return triplet_equal(&dentry->parent, dkey->parent) &&
+	    str_cmp(dentry->name, dkey->name) == 0;
+}
+
+static size_t dentry_child_key_hash(const void *key)
+{
+	return triplet_hash(key);
+}
+
+static size_t dentry_child_hash(const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, child_link);
+	return triplet_hash(&dentry->child.triplet);
+}
+
+static bool dentry_child_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	dentry_t *dentry = hash_table_get_inst(item, dentry_t, child_link);
+	return triplet_equal(&dentry->child.triplet, key);
+}
+
+/**
+ * @}
+ */
@@ -52,6 +52,10 @@ struct vfs_client_data {
 	fibril_condvar_t cv;
 	list_t passed_handles;
 	vfs_file_t **files;
+	/** Files referenced by pager handles, see vfs_op_pager_handle(). */
+	list_t pager_files;
+	/** Next pager handle to allocate. */
+	int pager_next;
 };
 
 typedef struct {
@@ -60,6 +64,14 @@ typedef struct {
 	int permissions;
 } vfs_boxed_handle_t;
 
+typedef struct {
+	link_t link;
+	vfs_file_t *file;
+	int handle;
+} vfs_pager_file_t;
+
+static errno_t vfs_file_delref(vfs_client_data_t *, vfs_file_t *);
+
 /** Initialize the table of open files. */
 static bool vfs_files_init(vfs_client_data_t *vfs_data)
 {
@@ -81,6 +93,19 @@ static void vfs_files_done(vfs_client_data_t *vfs_data)
 {
 	int i;
 
+	fibril_mutex_lock(&vfs_data->lock);
+	while (!list_empty(&vfs_data->pager_files)) {
+		vfs_pager_file_t *pf;
+
+		pf = list_get_instance(list_first(&vfs_data->pager_files),
+		    vfs_pager_file_t, link);
+		list_remove(&pf->link);
+
+		(void) vfs_file_delref(vfs_data, pf->file);
+		free(pf);
+	}
+	fibril_mutex_unlock(&vfs_data->lock);
+
 	if (!vfs_data->files)
 		return;
 
@@ -113,6 +138,8 @@ void *vfs_client_data_create(void)
 		fibril_condvar_initialize(&vfs_data->cv);
 		list_initialize(&vfs_data->passed_handles);
 		vfs_data->files = NULL;
+		list_initialize(&vfs_data->pager_files);
+		vfs_data->pager_next = 0;
 	}
 
 	return vfs_data;
@@ -356,6 +383,88 @@ vfs_file_t *vfs_file_get(vfs_client_data_t *vfs_data, int fd)
 	return NULL;
 }
 
+/** Get a pager handle for an open file.
+ *
+ * The pager handle keeps a reference to the file structure, and thus to the
+ * underlying VFS node, which is independent of the client's file descriptor
+ * table. A client can therefore close the file descriptor once it has mapped
+ * the file. All open files of the same node share one pager handle. Pager
+ * handles are released when the client disconnects.
+ *
+ * @param fd		File descriptor of a file open for reading.
+ * @param[out] out_handle Pager handle.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t vfs_op_pager_handle(vfs_client_data_t *vfs_data, int fd,
+    int *out_handle)
+{
+	vfs_file_t *file = vfs_file_get(vfs_data, fd);
+	if (file == NULL)
+		return EBADF;
+
+	if (!file->open_read) {
+		vfs_file_put(vfs_data, file);
+		return EINVAL;
+	}
+
+	fibril_mutex_lock(&vfs_data->lock);
+
+	list_foreach(vfs_data->pager_files, link, vfs_pager_file_t, pf) {
+		if (pf->file->node == file->node) {
+			*out_handle = pf->handle;
+			fibril_mutex_unlock(&vfs_data->lock);
+			vfs_file_put(vfs_data, file);
+			return EOK;
+		}
+	}
+
+	vfs_pager_file_t *pf = malloc(sizeof(vfs_pager_file_t));
+	if (pf == NULL) {
+		fibril_mutex_unlock(&vfs_data->lock);
+		vfs_file_put(vfs_data, file);
+		return ENOMEM;
+	}
+
+	link_initialize(&pf->link);
+	pf->file = file;
+	pf->handle = vfs_data->pager_next++;
+	vfs_file_addref(vfs_data, file);
+	list_append(&pf->link, &vfs_data->pager_files);
+
+	*out_handle = pf->handle;
+	fibril_mutex_unlock(&vfs_data->lock);
+
+	vfs_file_put(vfs_data, file);
+	return EOK;
+}
+
+/** Find VFS file structure for a given pager handle.
+ *
+ * @param handle	Pager handle obtained by vfs_op_pager_handle().
+ *
+ * @return		VFS file structure corresponding to handle. Must be put
+ *			afterwards.
+ */
+vfs_file_t *vfs_pager_file_get(vfs_client_data_t *vfs_data, int handle)
+{
+	fibril_mutex_lock(&vfs_data->lock);
+	list_foreach(vfs_data->pager_files, link, vfs_pager_file_t, pf) {
+		if (pf->handle == handle) {
+			vfs_file_t *file = pf->file;
+
+			vfs_file_addref(vfs_data, file);
+			fibril_mutex_unlock(&vfs_data->lock);
+
+			fibril_mutex_lock(&file->_lock);
+			return file;
+		}
+	}
+	fibril_mutex_unlock(&vfs_data->lock);
+
+	return NULL;
+}
+
 void vfs_op_pass_handle(task_id_t donor_id, task_id_t acceptor_id, int donor_fd)
 {
 	vfs_client_data_t *donor_data = NULL;
@@ -167,6 +167,15 @@ static void vfs_in_open(ipc_call_t *req)
 	async_answer_0(req, rc);
 }
 
+static void vfs_in_pager_handle(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	int handle = -1;
+
+	errno_t rc = vfs_op_pager_handle(VFS_DATA, fd, &handle);
+	async_answer_1(req, rc, handle);
+}
+
 static void vfs_in_put(ipc_call_t *req)
 {
 	int fd = ipc_get_arg1(req);
@@ -352,6 +361,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_OPEN:
 			vfs_in_open(&call);
 			break;
+		case VFS_IN_PAGER_HANDLE:
+			vfs_in_pager_handle(&call);
+			break;
 		case VFS_IN_PUT:
 			vfs_in_put(&call);
 			break;
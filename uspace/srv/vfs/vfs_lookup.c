@@ -202,6 +202,9 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 	if (orig_rc != EOK)
 		rc = orig_rc;
 
+	/* The name may have been cached as non-existent. */
+	vfs_dcache_remove(triplet, component);
+
 out:
 	return rc;
 }
@@ -321,6 +324,201 @@ out:
 	return rc;
 }
 
+/** Look up one path component.
+ *
+ * The component is looked up in the directory entry cache first. If it is
+ * not cached, the file system server is asked and the result is cached.
+ * File systems which do not allow caching of names are always asked.
+ *
+ * @param dir      Directory in which to look up the component.
+ * @param path     Canonical path being resolved.
+ * @param len      Length of the path.
+ * @param pos      Position of the slash preceding the component in @a path.
+ * @param clen     Length of the component.
+ * @param entry    PLB entry of the path.
+ * @param pfirst   Pointer to @a first once the path has been inserted into
+ *                 PLB, NULL before. The path is inserted on the first cache
+ *                 miss.
+ * @param first    Place to store the start of the path in PLB.
+ * @param result   Place to store the lookup result.
+ *
+ * @return EOK on success, ENOENT if the component does not exist or another
+ *         error code.
+ */
+static errno_t lookup_component(vfs_triplet_t *dir, char *path, size_t len,
+    size_t pos, size_t clen, plb_entry_t *entry, size_t **pfirst,
+    size_t *first, vfs_lookup_res_t *result)
+{
+	char component[NAME_MAX + 1];
+	errno_t rc;
+
+	if (clen > NAME_MAX)
+		return ENAMETOOLONG;
+
+	memcpy(component, path + pos + 1, clen);
+	component[clen] = 0;
+
+	bool cached = vfs_dcache_enabled(dir->fs_handle);
+	if (cached) {
+		rc = vfs_dcache_lookup(dir, component, result);
+		if (rc != EAGAIN)
+			return rc;
+	}
+
+	unsigned gen = vfs_dcache_generation();
+
+	if (*pfirst == NULL) {
+		rc = plb_insert_entry(entry, path, first, len);
+		if (rc != EOK)
+			return rc;
+		*pfirst = first;
+	}
+
+	/* Ask for this component only, so that the result can be cached. */
+	size_t next = *first + pos;
+	size_t nlen = clen + 1;
+	rc = out_lookup(dir, &next, &nlen, L_NONE, result);
+	if (rc != EOK)
+		return rc;
+
+	if (nlen > 0) {
+		if (cached)
+			vfs_dcache_insert(gen, dir, component, NULL);
+		return ENOENT;
+	}
+
+	if (cached)
+		vfs_dcache_insert(gen, dir, component, result);
+	return EOK;
+}
+
+/** Perform a path lookup using the directory entry cache.
+ *
+ * The path is resolved one component at a time, crossing mount points
+ * in VFS. Components which are not cached are looked up at the file system
+ * server. This cannot be used for creating or unlinking names.
+ *
+ * @param base    The file from which to perform the lookup.
+ * @param path    Canonical path to be resolved.
+ * @param lflag   Flags to be used during lookup.
+ * @param result  Empty structure where the lookup result will be stored.
+ *                Can be NULL.
+ * @param len     Length of the path.
+ *
+ * @return EOK on success or an error code from errno.h.
+ */
+static errno_t _vfs_lookup_cached(vfs_node_t *base, char *path, int lflag,
+    vfs_lookup_res_t *result, size_t len)
+{
+	plb_entry_t entry;
+	size_t first;
+	size_t *pfirst = NULL;
+	vfs_lookup_res_t res;
+	size_t pos = 0;
+	errno_t rc = EOK;
+
+	assert(!(lflag & (L_CREATE | L_UNLINK)));
+	assert(path[0] == '/');
+
+	while (base->mount) {
+		if (lflag & L_DISABLE_MOUNTS)
+			return EXDEV;
+
+		base = base->mount;
+	}
+
+	res.triplet = *((vfs_triplet_t *) base);
+	res.type = base->type;
+	res.size = base->size;
+
+	while (pos < len) {
+		size_t clen = 0;
+		while (pos + 1 + clen < len && path[pos + 1 + clen] != '/')
+			clen++;
+
+		if (clen == 0) {
+			/* The path is just "/". */
+			break;
+		}
+
+		if (res.type != VFS_NODE_DIRECTORY) {
+			rc = ENOTDIR;
+			goto out;
+		}
+
+		vfs_triplet_t dir = res.triplet;
+		rc = lookup_component(&dir, path, len, pos, clen, &entry,
+		    &pfirst, &first, &res);
+		if (rc != EOK)
+			goto out;
+
+		pos += clen + 1;
+		if (pos == len)
+			break;
+
+		/* Cross a mount point in the middle of the path. */
+		vfs_node_t *node = vfs_node_peek(&res);
+		if (node != NULL) {
+			if (node->mount != NULL) {
+				if (lflag & L_DISABLE_MOUNTS) {
+					vfs_node_put(node);
+					rc = EXDEV;
+					goto out;
+				}
+
+				vfs_node_t *mnt = node->mount;
+				while (mnt->mount)
+					mnt = mnt->mount;
+
+				res.triplet = *((vfs_triplet_t *) mnt);
+				res.type = mnt->type;
+				res.size = mnt->size;
+			}
+			vfs_node_put(node);
+		}
+	}
+
+	if ((lflag & L_FILE) && res.type == VFS_NODE_DIRECTORY) {
+		rc = EISDIR;
+		goto out;
+	}
+
+	if ((lflag & L_DIRECTORY) && res.type == VFS_NODE_FILE) {
+		rc = ENOTDIR;
+		goto out;
+	}
+
+	if (result != NULL) {
+		/* The found file may be a mount point. Try to cross it. */
+		if (!(lflag & (L_MP | L_DISABLE_MOUNTS))) {
+			base = vfs_node_peek(&res);
+			if (base && base->mount) {
+				while (base->mount) {
+					vfs_node_addref(base->mount);
+					vfs_node_t *nbase = base->mount;
+					vfs_node_put(base);
+					base = nbase;
+				}
+
+				result->triplet = *((vfs_triplet_t *) base);
+				result->type = base->type;
+				result->size = base->size;
+				vfs_node_put(base);
+				goto out;
+			}
+			if (base)
+				vfs_node_put(base);
+		}
+
+		*result = res;
+	}
+
+out:
+	if (pfirst != NULL)
+		plb_clear_entry(&entry, first, len);
+	return rc;
+}
+
 /** Perform a path lookup.
  *
  * @param base    The file from which to perform the lookup.
@@ -372,7 +570,7 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 
 			tflag &= ~(L_CREATE | L_EXCLUSIVE | L_UNLINK | L_FILE);
 			tflag |= L_DIRECTORY;
-			rc = _vfs_lookup_internal(base, path, tflag, &tres,
+			rc = _vfs_lookup_cached(base, path, tflag, &tres,
 			    slash - path);
 			if (rc != EOK)
 				return rc;
@@ -385,10 +583,22 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 		rc = _vfs_lookup_internal(parent, slash, lflag, result,
 		    len - (slash - path));
 
+		/*
+		 * The name has been created or unlinked, update the directory
+		 * entry cache.
+		 */
+		vfs_node_t *dir = parent;
+		while (dir->mount)
+			dir = dir->mount;
+
+		vfs_dcache_remove((vfs_triplet_t *) dir, slash + 1);
+		if (rc == EOK && (lflag & L_UNLINK) && result != NULL)
+			vfs_dcache_forget(&result->triplet);
+
 		vfs_node_put(parent);
 
 	} else {
-		rc = _vfs_lookup_internal(base, path, lflag, result, len);
+		rc = _vfs_lookup_cached(base, path, lflag, result, len);
 	}
 
 	return rc;
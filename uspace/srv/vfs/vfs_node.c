@@ -124,6 +124,16 @@ void vfs_node_delref(vfs_node_t *node)
 	fibril_mutex_unlock(&nodes_mutex);
 
 	if (free_node) {
+		/*
+		 * The index of an unlinked node may be reused once the node is
+		 * destroyed, so its cached pages must go.
+		 */
+		vfs_triplet_t tri = node_triplet(node);
+		if (node->unlinked)
+			vfs_pcache_forget(&tri);
+		else if (node->type == VFS_NODE_FILE)
+			vfs_dcache_set_size(&tri, node->size);
+
 		/*
 		 * VFS_OUT_DESTROY will free up the file's resources if there
 		 * are no more hard links.
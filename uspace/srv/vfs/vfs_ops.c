@@ -48,6 +48,10 @@
 #include <adt/list.h>
 #include <assert.h>
 #include <vfs/canonify.h>
+#include <libarch/config.h>
+
+/** Maximum number of bytes served from the page cache in one read. */
+#define PCACHE_READ_MAX  (16 * PAGE_SIZE)
 
 /* Forward declarations of static functions. */
 static errno_t vfs_truncate_internal(fs_handle_t, service_id_t, fs_index_t,
@@ -266,6 +270,10 @@ errno_t vfs_op_mount(vfs_client_data_t *vfs_data, int mpfd, unsigned service_id,
 
 	rc = vfs_connect_internal(service_id, flags, instance, opts, fs_name,
 	    &root);
+	if (rc == EOK) {
+		/* Do not trust entries cached by a previous mount. */
+		vfs_dcache_forget_fs(root->fs_handle, root->service_id);
+	}
 	if (rc == EOK && !(flags & VFS_MOUNT_CONNECT_ONLY)) {
 		vfs_node_addref(mp->node);
 		vfs_node_addref(root);
@@ -406,29 +414,95 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 	return (errno_t) rc;
 }
 
-static errno_t vfs_rdwr(vfs_client_data_t *vfs_data, int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
-    void *ipc_cb_data)
+static errno_t rdwr_pcache_client(async_exch_t *exch, vfs_file_t *file,
+    aoff64_t pos, ipc_call_t *answer, bool read, void *data)
 {
+	vfs_node_t *node = file->node;
+	size_t *bytes = (size_t *) data;
+	vfs_page_t *page;
+	ipc_call_t call;
+	size_t size;
+	errno_t rc;
+
+	assert(read);
+
+	if (!vfs_pcache_enabled(node))
+		return rdwr_ipc_client(exch, file, pos, answer, read, data);
+
 	/*
-	 * The following code strongly depends on the fact that the files data
-	 * structure can be only accessed by a single fibril and all file
-	 * operations are serialized (i.e. the reads and writes cannot
-	 * interleave and a file cannot be closed while it is being read).
-	 *
-	 * Additional synchronization needs to be added once the table of
-	 * open files supports parallel access!
+	 * Serve the client's IPC_M_DATA_READ request from the page cache
+	 * instead of forwarding it to the FS server.
 	 */
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
 
-	/* Lookup the file structure corresponding to the file descriptor. */
-	vfs_file_t *file = vfs_file_get(vfs_data, fd);
-	if (!file)
-		return EBADF;
+	if (pos >= node->size)
+		size = 0;
+	else
+		size = min(size, min(node->size - pos, PCACHE_READ_MAX));
 
-	if ((read && !file->open_read) || (!read && !file->open_write)) {
-		vfs_file_put(vfs_data, file);
-		return EINVAL;
+	size_t poff = pos % PAGE_SIZE;
+	uint8_t *buf = NULL;
+
+	/* Use a bounce buffer if the read spans more than one page. */
+	if (poff + size > PAGE_SIZE) {
+		buf = malloc(size);
+		if (buf == NULL)
+			size = PAGE_SIZE - poff;
+	}
+
+	if (buf == NULL) {
+		if (size == 0) {
+			*bytes = 0;
+			return async_data_read_finalize(&call, NULL, 0);
+		}
+
+		rc = vfs_pcache_get(exch, node, pos - poff, &page);
+		if (rc != EOK) {
+			async_answer_0(&call, rc);
+			return rc;
+		}
+
+		*bytes = min(size, page->size > poff ? page->size - poff : 0);
+		rc = async_data_read_finalize(&call, page->data + poff, *bytes);
+		vfs_pcache_put(page);
+		return rc;
+	}
+
+	size_t total = 0;
+	while (total < size) {
+		rc = vfs_pcache_get(exch, node, pos + total - poff, &page);
+		if (rc != EOK) {
+			free(buf);
+			async_answer_0(&call, rc);
+			return rc;
+		}
+
+		size_t avail = page->size > poff ? page->size - poff : 0;
+		size_t n = min(size - total, avail);
+		memcpy(buf + total, page->data + poff, n);
+		vfs_pcache_put(page);
+
+		total += n;
+		if (poff + n < PAGE_SIZE)
+			break;
+		poff = 0;
 	}
 
+	*bytes = total;
+	rc = async_data_read_finalize(&call, buf, total);
+	free(buf);
+	return rc;
+}
+
+static errno_t vfs_rdwr_file(vfs_file_t *file, aoff64_t pos, bool read,
+    rdwr_ipc_cb_t ipc_cb, void *ipc_cb_data)
+{
+	if ((read && !file->open_read) || (!read && !file->open_write))
+		return EINVAL;
+
 	vfs_info_t *fs_info = fs_handle_to_info(file->node->fs_handle);
 	assert(fs_info);
 
@@ -459,7 +533,6 @@ static errno_t vfs_rdwr(vfs_client_data_t *vfs_data, int fd, aoff64_t pos, bool
 				fibril_rwlock_write_unlock(
 				    &file->node->contents_rwlock);
 			}
-			vfs_file_put(vfs_data, file);
 			return EINVAL;
 		}
 
@@ -479,6 +552,19 @@ static errno_t vfs_rdwr(vfs_client_data_t *vfs_data, int fd, aoff64_t pos, bool
 
 	vfs_exchange_release(fs_exch);
 
+	if (!read) {
+		/*
+		 * Drop stale cached pages. This includes the page containing
+		 * the old end of file if the write extended the file. If the
+		 * write failed, we do not know how much has been written.
+		 */
+		aoff64_t end = UINT64_MAX;
+		if (rc == EOK)
+			end = pos + ipc_get_arg1(&answer);
+		vfs_pcache_invalidate(file->node, min(pos, file->node->size),
+		    end);
+	}
+
 	if (file->node->type == VFS_NODE_DIRECTORY)
 		fibril_rwlock_read_unlock(&namespace_rwlock);
 
@@ -494,19 +580,42 @@ static errno_t vfs_rdwr(vfs_client_data_t *vfs_data, int fd, aoff64_t pos, bool
 		fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	}
 
+	return rc;
+}
+
+static errno_t vfs_rdwr(vfs_client_data_t *vfs_data, int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
+    void *ipc_cb_data)
+{
+	/*
+	 * The following code strongly depends on the fact that the files data
+	 * structure can be only accessed by a single fibril and all file
+	 * operations are serialized (i.e. the reads and writes cannot
+	 * interleave and a file cannot be closed while it is being read).
+	 *
+	 * Additional synchronization needs to be added once the table of
+	 * open files supports parallel access!
+	 */
+
+	/* Lookup the file structure corresponding to the file descriptor. */
+	vfs_file_t *file = vfs_file_get(vfs_data, fd);
+	if (!file)
+		return EBADF;
+
+	errno_t rc = vfs_rdwr_file(file, pos, read, ipc_cb, ipc_cb_data);
+
 	vfs_file_put(vfs_data, file);
 
 	return rc;
 }
 
-errno_t vfs_rdwr_internal(vfs_client_data_t *vfs_data, int fd, aoff64_t pos, bool read, rdwr_io_chunk_t *chunk)
+errno_t vfs_rdwr_internal(vfs_file_t *file, aoff64_t pos, bool read, rdwr_io_chunk_t *chunk)
 {
-	return vfs_rdwr(vfs_data, fd, pos, read, rdwr_ipc_internal, chunk);
+	return vfs_rdwr_file(file, pos, read, rdwr_ipc_internal, chunk);
 }
 
 errno_t vfs_op_read(vfs_client_data_t *vfs_data, int fd, aoff64_t pos, size_t *out_bytes)
 {
-	return vfs_rdwr(vfs_data, fd, pos, true, rdwr_ipc_client, out_bytes);
+	return vfs_rdwr(vfs_data, fd, pos, true, rdwr_pcache_client, out_bytes);
 }
 
 errno_t vfs_op_rename(vfs_client_data_t *vfs_data, int basefd, char *old, char *new)
@@ -598,11 +707,14 @@ errno_t vfs_op_rename(vfs_client_data_t *vfs_data, int basefd, char *old, char *
 
 	/* If the node is not held by anyone, try to destroy it. */
 	if (orig_unlinked) {
+		vfs_pcache_forget(&new_lr_orig.triplet);
 		vfs_node_t *node = vfs_node_peek(&new_lr_orig);
-		if (!node)
+		if (!node) {
 			out_destroy(&new_lr_orig.triplet);
-		else
+		} else {
+			node->unlinked = true;
 			vfs_node_put(node);
+		}
 	}
 
 	vfs_node_put(base);
@@ -625,6 +737,11 @@ errno_t vfs_op_resize(vfs_client_data_t *vfs_data, int fd, int64_t size)
 
 	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
 	    file->node->service_id, file->node->index, size);
+
+	/* Pages past the smaller of the two sizes are no longer valid. */
+	vfs_pcache_invalidate(file->node, min(file->node->size,
+	    (aoff64_t) size), UINT64_MAX);
+
 	if (rc == EOK)
 		file->node->size = size;
 
@@ -766,11 +883,14 @@ errno_t vfs_op_unlink(vfs_client_data_t *vfs_data, int parentfd, int expectfd, c
 		goto exit;
 
 	/* If the node is not held by anyone, try to destroy it. */
+	vfs_pcache_forget(&lr.triplet);
 	vfs_node_t *node = vfs_node_peek(&lr);
-	if (!node)
+	if (!node) {
 		out_destroy(&lr.triplet);
-	else
+	} else {
+		node->unlinked = true;
 		vfs_node_put(node);
+	}
 
 exit:
 	if (path)
@@ -821,6 +941,10 @@ errno_t vfs_op_unmount(vfs_client_data_t *vfs_data, int mpfd)
 		return rc;
 	}
 
+	vfs_dcache_forget_fs(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
+	vfs_pcache_forget_fs(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;
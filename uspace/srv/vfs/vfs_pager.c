@@ -40,12 +40,16 @@
 #include <fibril_synch.h>
 #include <errno.h>
 #include <as.h>
+#include <libarch/config.h>
 
-void vfs_page_in(ipc_call_t *req)
+/** Page in a page of a file which cannot be cached.
+ *
+ * The page is read into a fresh address space area which is destroyed after
+ * the kernel has taken a reference to its frame.
+ */
+static void vfs_page_in_uncached(ipc_call_t *req, vfs_file_t *file,
+    aoff64_t offset, size_t page_size)
 {
-	aoff64_t offset = ipc_get_arg1(req);
-	size_t page_size = ipc_get_arg2(req);
-	int fd = ipc_get_arg3(req);
 	void *page;
 	errno_t rc;
 
@@ -66,7 +70,7 @@ void vfs_page_in(ipc_call_t *req)
 	size_t total = 0;
 	aoff64_t pos = offset;
 	do {
-		rc = vfs_rdwr_internal(async_get_client_data(), fd, pos, true, &chunk);
+		rc = vfs_rdwr_internal(file, pos, true, &chunk);
 		if (rc != EOK)
 			break;
 		if (chunk.size == 0)
@@ -80,14 +84,73 @@ void vfs_page_in(ipc_call_t *req)
 	async_answer_1(req, rc, (sysarg_t) page);
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * Not keeping the page around results in inherently non-coherent
+	 * private mappings, but the file system does not allow caching.
 	 */
 	as_area_destroy(page);
 }
 
+/** Page in a page of a file.
+ *
+ * The pager info of the area consists of the pager handle of the file, see
+ * vfs_op_pager_handle(), and the offset of the start of the area in the file,
+ * which makes it possible to map a part of a file, such as a segment of an
+ * executable.
+ */
+void vfs_page_in(ipc_call_t *req)
+{
+	size_t page_size = ipc_get_arg2(req);
+	int handle = ipc_get_arg3(req);
+	aoff64_t offset = ipc_get_arg1(req) + ipc_get_arg4(req);
+	vfs_client_data_t *vfs_data = async_get_client_data();
+	vfs_page_t *page;
+	errno_t rc;
+
+	vfs_file_t *file = vfs_pager_file_get(vfs_data, handle);
+	if (file == NULL) {
+		async_answer_0(req, EBADF);
+		return;
+	}
+
+	if (page_size != PAGE_SIZE || !vfs_pcache_enabled(file->node)) {
+		vfs_page_in_uncached(req, file, offset, page_size);
+		vfs_file_put(vfs_data, file);
+		return;
+	}
+
+	/* Cached pages can only be handed out whole. */
+	if (offset % PAGE_SIZE != 0) {
+		vfs_file_put(vfs_data, file);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	fibril_rwlock_read_lock(&file->node->contents_rwlock);
+
+	async_exch_t *exch = vfs_exchange_grab(file->node->fs_handle);
+	rc = vfs_pcache_get(exch, file->node, offset, &page);
+	vfs_exchange_release(exch);
+
+	if (rc != EOK) {
+		fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+		vfs_file_put(vfs_data, file);
+		async_answer_0(req, rc);
+		return;
+	}
+
+	/*
+	 * Hand out the cached page itself. The kernel adds a reference to the
+	 * frame, so all mappings of the page share it with the cache and the
+	 * mapping survives eviction of the page from the cache.
+	 */
+	vfs_pcache_mapped(page);
+	async_answer_1(req, EOK, (sysarg_t) page->data);
+
+	vfs_pcache_put(page);
+	fibril_rwlock_read_unlock(&file->node->contents_rwlock);
+	vfs_file_put(vfs_data, file);
+}
+
 /**
  * @}
  */
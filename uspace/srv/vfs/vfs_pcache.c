@@ -0,0 +1,583 @@
+/*
+ * Copyright (c) 2026 HelenOS contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file vfs_pcache.c
+ * @brief VFS page cache.
+ *
+ * Pages of regular files are cached in VFS, keyed by the file system node
+ * triplet and the page-aligned offset. The same cached page is used to satisfy
+ * read requests and page-in requests from the pager, so all mappings of a file
+ * share the page frames. Unused pages are kept on an LRU list and evicted when
+ * the cache grows beyond its limit.
+ *
+ * Pages which have been mapped by a client are refreshed in place when the
+ * file changes, so that writes keep reaching the frames of the mappings. VFS
+ * is not told when the mappings go away, so mapped pages are not pinned. They
+ * are counted against the cache limit and evicted like any other page. Once a
+ * mapped page is evicted, later writes to the file no longer reach the
+ * existing mappings of that page, while new page-ins read the file again.
+ *
+ * Every cached page lives in its own address space area. A page which has been
+ * handed out to the kernel as a backing frame of a client mapping can thus be
+ * destroyed in VFS without affecting the mapping.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <align.h>
+#include <as.h>
+#include <assert.h>
+#include <async.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <libarch/config.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+
+/** Maximum number of pages kept in the cache. */
+#define PCACHE_PAGES_MAX	1024
+
+/** Page cache lookup key. */
+typedef struct {
+	vfs_triplet_t triplet;
+	aoff64_t offset;
+} pcache_key_t;
+
+/** Mutex protecting the page cache. */
+static FIBRIL_MUTEX_INITIALIZE(pcache_mutex);
+
+/** Signalled when a page has been read in. */
+static FIBRIL_CONDVAR_INITIALIZE(pcache_cv);
+
+/** Hash table of cached pages. */
+static hash_table_t pcache;
+
+/** Pages that are not in use, least recently used first. */
+static LIST_INITIALIZE(pcache_lru);
+
+/** Number of allocated pages, including stale ones still in use. */
+static size_t pcache_pages;
+
+static size_t pcache_key_hash(const void *);
+static size_t pcache_hash(const ht_link_t *);
+static bool pcache_key_equal(const void *, size_t, const ht_link_t *);
+
+/** Page cache hash table operations. */
+static const hash_table_ops_t pcache_ops = {
+	.hash = pcache_hash,
+	.key_hash = pcache_key_hash,
+	.key_equal = pcache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL,
+};
+
+/** Initialize the page cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_pcache_init(void)
+{
+	return hash_table_create(&pcache, 0, 0, &pcache_ops);
+}
+
+/** Determine whether the contents of a node may be cached.
+ *
+ * @param node		VFS node.
+ *
+ * @return		True if the node is a regular file on a file system
+ *			which allows caching.
+ */
+bool vfs_pcache_enabled(vfs_node_t *node)
+{
+	if (node->type != VFS_NODE_FILE)
+		return false;
+
+	vfs_info_t *info = fs_handle_to_info(node->fs_handle);
+	return info != NULL && info->cacheable;
+}
+
+static void pcache_page_free(vfs_page_t *page)
+{
+	as_area_destroy(page->data);
+	free(page);
+	pcache_pages--;
+}
+
+/** Remove page from the cache.
+ *
+ * The page is freed immediately if it is not in use. Otherwise it is marked
+ * stale and freed by the last vfs_pcache_put().
+ *
+ * @param page		Cached page. The page cache mutex must be held.
+ */
+static void pcache_page_remove(vfs_page_t *page)
+{
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+	assert(!page->stale);
+
+	hash_table_remove_item(&pcache, &page->link);
+	page->stale = true;
+
+	if (page->refcnt == 0) {
+		list_remove(&page->lru_link);
+		pcache_page_free(page);
+	}
+}
+
+/** Read page contents from the file system.
+ *
+ * The page cache mutex must not be held as this blocks on IPC.
+ *
+ * @param exch		Exchange with the file system server.
+ * @param page		Page to read.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t pcache_page_read(async_exch_t *exch, vfs_page_t *page)
+{
+	size_t total = 0;
+	errno_t rc = EOK;
+
+	if (exch == NULL)
+		return ENOENT;
+
+	/*
+	 * File system servers may return less than requested, e.g. one block
+	 * at a time.
+	 */
+	while (total < PAGE_SIZE) {
+		aoff64_t pos = page->offset + total;
+		ipc_call_t answer;
+
+		aid_t msg = async_send_4(exch, VFS_OUT_READ,
+		    page->triplet.service_id, page->triplet.index,
+		    LOWER32(pos), UPPER32(pos), &answer);
+		if (msg == 0)
+			return EINVAL;
+
+		rc = async_data_read_start(exch, page->data + total,
+		    PAGE_SIZE - total);
+		if (rc != EOK) {
+			async_forget(msg);
+			return rc;
+		}
+
+		async_wait_for(msg, &rc);
+		if (rc != EOK)
+			return rc;
+
+		size_t bytes = ipc_get_arg1(&answer);
+		if (bytes == 0)
+			break;
+
+		total += bytes;
+	}
+
+	/*
+	 * Clear the rest of the page. This also makes sure the page is
+	 * backed by a frame before it is handed over to the kernel.
+	 */
+	memset(page->data + total, 0, PAGE_SIZE - total);
+	page->size = total;
+	return EOK;
+}
+
+/** Finish reading page contents.
+ *
+ * Wake up fibrils waiting for the page. If the read failed, the page is
+ * removed from the cache.
+ *
+ * @param page		Page which has been read.
+ * @param rc		Result of the read.
+ */
+static void pcache_page_read_done(vfs_page_t *page, errno_t rc)
+{
+	fibril_mutex_lock(&pcache_mutex);
+	page->reading = false;
+	page->rc = rc;
+	if (rc != EOK && !page->stale)
+		pcache_page_remove(page);
+	fibril_condvar_broadcast(&pcache_cv);
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+/** Get cached page.
+ *
+ * Look up the page of a node at the given offset, reading it from the file
+ * system if it is not cached. The page must be eventually released by calling
+ * vfs_pcache_put().
+ *
+ * The caller must hold the node's contents lock.
+ *
+ * @param exch		Exchange with the node's file system server.
+ * @param node		VFS node.
+ * @param offset	Page-aligned offset in the node.
+ * @param rpage		Place to store pointer to the page.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t vfs_pcache_get(async_exch_t *exch, vfs_node_t *node, aoff64_t offset,
+    vfs_page_t **rpage)
+{
+	pcache_key_t key = {
+		.triplet = {
+			.fs_handle = node->fs_handle,
+			.service_id = node->service_id,
+			.index = node->index
+		},
+		.offset = offset
+	};
+	vfs_page_t *page;
+	errno_t rc;
+
+	assert(offset % PAGE_SIZE == 0);
+
+	fibril_mutex_lock(&pcache_mutex);
+
+	ht_link_t *link = hash_table_find(&pcache, &key);
+	if (link != NULL) {
+		page = hash_table_get_inst(link, vfs_page_t, link);
+		if (page->refcnt++ == 0)
+			list_remove(&page->lru_link);
+
+		while (page->reading)
+			fibril_condvar_wait(&pcache_cv, &pcache_mutex);
+
+		rc = page->rc;
+		fibril_mutex_unlock(&pcache_mutex);
+
+		if (rc != EOK) {
+			vfs_pcache_put(page);
+			return rc;
+		}
+
+		*rpage = page;
+		return EOK;
+	}
+
+	/* Make room for the new page. */
+	if (pcache_pages >= PCACHE_PAGES_MAX && !list_empty(&pcache_lru)) {
+		vfs_page_t *victim = list_get_instance(list_first(&pcache_lru),
+		    vfs_page_t, lru_link);
+		pcache_page_remove(victim);
+	}
+
+	page = calloc(1, sizeof(vfs_page_t));
+	if (page == NULL) {
+		fibril_mutex_unlock(&pcache_mutex);
+		return ENOMEM;
+	}
+
+	page->data = as_area_create(AS_AREA_ANY, PAGE_SIZE,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (page->data == AS_MAP_FAILED) {
+		fibril_mutex_unlock(&pcache_mutex);
+		free(page);
+		return ENOMEM;
+	}
+
+	link_initialize(&page->lru_link);
+	page->triplet = key.triplet;
+	page->offset = offset;
+	page->refcnt = 1;
+	page->reading = true;
+	pcache_pages++;
+	hash_table_insert(&pcache, &page->link);
+
+	fibril_mutex_unlock(&pcache_mutex);
+
+	rc = pcache_page_read(exch, page);
+	pcache_page_read_done(page, rc);
+
+	if (rc != EOK) {
+		vfs_pcache_put(page);
+		return rc;
+	}
+
+	*rpage = page;
+	return EOK;
+}
+
+/** Release cached page.
+ *
+ * @param page		Page returned by vfs_pcache_get().
+ */
+void vfs_pcache_put(vfs_page_t *page)
+{
+	fibril_mutex_lock(&pcache_mutex);
+
+	assert(page->refcnt > 0);
+	if (--page->refcnt == 0) {
+		if (page->stale)
+			pcache_page_free(page);
+		else
+			list_append(&page->lru_link, &pcache_lru);
+	}
+
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+/** Mark cached page as mapped by a client.
+ *
+ * Mapped pages are refreshed in place rather than dropped when invalidated,
+ * so that the mappings remain coherent with the file contents for as long as
+ * the page stays cached.
+ *
+ * @param page		Cached page.
+ */
+void vfs_pcache_mapped(vfs_page_t *page)
+{
+	fibril_mutex_lock(&pcache_mutex);
+	page->mapped = true;
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+/** Page cache range filter. */
+typedef struct {
+	/** Node triplet */
+	vfs_triplet_t triplet;
+	/** Match only this node, otherwise the whole file system instance */
+	bool node;
+	/** Refresh mapped pages instead of removing them */
+	bool refresh_mapped;
+	/** Start of the range (page-aligned) */
+	aoff64_t start;
+	/** End of the range */
+	aoff64_t end;
+	/** Mapped pages which need to be refreshed */
+	list_t refresh;
+} pcache_range_t;
+
+static bool pcache_range_match(pcache_range_t *range, vfs_page_t *page)
+{
+	if (page->triplet.fs_handle != range->triplet.fs_handle ||
+	    page->triplet.service_id != range->triplet.service_id)
+		return false;
+
+	if (range->node && page->triplet.index != range->triplet.index)
+		return false;
+
+	return page->offset >= range->start && page->offset < range->end;
+}
+
+/** Invalidate one page.
+ *
+ * Mapped pages are put on the refresh list and marked as being read, so
+ * that readers wait for the new contents. Other pages, including pages
+ * which are just being read, are removed from the cache.
+ */
+static void pcache_range_page(pcache_range_t *range, vfs_page_t *page)
+{
+	if (range->refresh_mapped && page->mapped && !page->reading) {
+		if (page->refcnt++ == 0)
+			list_remove(&page->lru_link);
+		page->reading = true;
+		list_append(&page->refresh_link, &range->refresh);
+	} else {
+		pcache_page_remove(page);
+	}
+}
+
+static bool pcache_range_visitor(ht_link_t *item, void *arg)
+{
+	pcache_range_t *range = (pcache_range_t *) arg;
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, link);
+
+	if (pcache_range_match(range, page))
+		pcache_range_page(range, page);
+
+	return true;
+}
+
+/** Invalidate cached pages in a range.
+ *
+ * The page cache mutex must be held.
+ */
+static void pcache_range_invalidate(pcache_range_t *range)
+{
+	aoff64_t len = range->end - range->start;
+	aoff64_t npages = len / PAGE_SIZE + (len % PAGE_SIZE != 0 ? 1 : 0);
+
+	list_initialize(&range->refresh);
+
+	if (!range->node || npages > hash_table_size(&pcache)) {
+		/* Cheaper to walk the whole cache. */
+		hash_table_apply(&pcache, pcache_range_visitor, range);
+		return;
+	}
+
+	pcache_key_t key = {
+		.triplet = range->triplet
+	};
+
+	for (aoff64_t i = 0; i < npages; i++) {
+		key.offset = range->start + i * PAGE_SIZE;
+		ht_link_t *link = hash_table_find(&pcache, &key);
+		if (link != NULL) {
+			pcache_range_page(range,
+			    hash_table_get_inst(link, vfs_page_t, link));
+		}
+	}
+}
+
+/** Invalidate cached pages of a node after its contents have changed.
+ *
+ * Pages overlapping the range are dropped from the cache, except for pages
+ * mapped by clients, which are read again from the file system in place.
+ *
+ * The caller must hold the node's contents lock.
+ *
+ * @param node		VFS node.
+ * @param start		Start offset of the changed range.
+ * @param end		End offset of the changed range.
+ */
+void vfs_pcache_invalidate(vfs_node_t *node, aoff64_t start, aoff64_t end)
+{
+	pcache_range_t range = {
+		.triplet = {
+			.fs_handle = node->fs_handle,
+			.service_id = node->service_id,
+			.index = node->index
+		},
+		.node = true,
+		.refresh_mapped = true,
+		.start = ALIGN_DOWN(start, PAGE_SIZE),
+		.end = end
+	};
+
+	if (end <= start)
+		return;
+
+	fibril_mutex_lock(&pcache_mutex);
+	pcache_range_invalidate(&range);
+	fibril_mutex_unlock(&pcache_mutex);
+
+	if (list_empty(&range.refresh))
+		return;
+
+	async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
+
+	list_foreach_safe(range.refresh, cur, next) {
+		vfs_page_t *page = list_get_instance(cur, vfs_page_t,
+		    refresh_link);
+		list_remove(cur);
+
+		errno_t rc = pcache_page_read(exch, page);
+		pcache_page_read_done(page, rc);
+		vfs_pcache_put(page);
+	}
+
+	vfs_exchange_release(exch);
+}
+
+/** Drop all cached pages of a node.
+ *
+ * This is used when the node is going to be destroyed, so that its index
+ * can be reused.
+ *
+ * @param triplet	Node triplet.
+ */
+void vfs_pcache_forget(vfs_triplet_t *triplet)
+{
+	pcache_range_t range = {
+		.triplet = *triplet,
+		.node = true,
+		.refresh_mapped = false,
+		.start = 0,
+		.end = UINT64_MAX
+	};
+
+	fibril_mutex_lock(&pcache_mutex);
+	pcache_range_invalidate(&range);
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+/** Drop all cached pages of a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_pcache_forget_fs(fs_handle_t fs_handle, service_id_t service_id)
+{
+	pcache_range_t range = {
+		.triplet = {
+			.fs_handle = fs_handle,
+			.service_id = service_id
+		},
+		.node = false,
+		.refresh_mapped = false,
+		.start = 0,
+		.end = UINT64_MAX
+	};
+
+	fibril_mutex_lock(&pcache_mutex);
+	pcache_range_invalidate(&range);
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+static size_t pcache_key_hash(const void *key)
+{
+	const pcache_key_t *pkey = key;
+	size_t hash = hash_combine(pkey->triplet.fs_handle,
+	    pkey->triplet.index);
+	hash = hash_combine(hash, pkey->triplet.service_id);
+	return hash_combine(hash, (size_t) (pkey->offset / PAGE_SIZE));
+}
+
+static size_t pcache_hash(const ht_link_t *item)
+{
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, link);
+	pcache_key_t key = {
+		.triplet = page->triplet,
+		.offset = page->offset
+	};
+	return pcache_key_hash(&key);
+}
+
+static bool pcache_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const pcache_key_t *pkey = key;
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, link);
+	return page->triplet.fs_handle == pkey->triplet.fs_handle &&
+	    page->triplet.service_id == pkey->triplet.service_id &&
+	    page->triplet.index == pkey->triplet.index &&
+	    page->offset == pkey->offset;
+}
+
+/**
+ * @}
+ */